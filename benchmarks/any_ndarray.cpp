@@ -0,0 +1,59 @@
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <cnumpy/any_ndarray.hpp>
+#include <cnumpy/ndarray.hpp>
+#include <cnumpy/npy.hpp>
+#include "harness.hpp"
+
+using namespace std;
+using namespace cnumpy;
+
+// Runtime-typed arrays against their typed counterparts: loads that find the dtype in the header, sums dispatched
+// once through visit, and conversions. Items are elements.
+
+template<class T>
+void run(bench::harness &h, const string &dtype, size_t n) {
+    ndarray<T> arr(vector<size_t>{n});
+    for (size_t i = 0; i < n; i++)
+        arr.data()[i] = T(i % 127);
+    string suffix = "/" + dtype + "/" + to_string(n);
+    bench::work work{double(n * sizeof(T)), double(n)};
+    size_t nbytes = NPY::nbytes(arr);
+    shared_ptr<char[]> buffer(new char[nbytes]);
+    NPY(buffer, nbytes, 'w').save(arr);
+    {
+        NPY npy("bench_any.npy", 'w');
+        npy.save(arr);
+    }
+    any_ndarray any = arr;
+
+    h.run("load/typed" + suffix, [&]() {
+        bench::do_not_optimize(NPY("bench_any.npy", 'r').load<T>().data());
+    }, work);
+    h.run("load/any" + suffix, [&]() {
+        bench::do_not_optimize(NPY("bench_any.npy", 'r').load_any().data());
+    }, work);
+    h.run("load/any/buffer" + suffix, [&]() {
+        bench::do_not_optimize(NPY(buffer, nbytes, 'r').load_any().data());
+    }, work);
+    h.run("sum/typed" + suffix, [&]() {
+        double total = 0;
+        for (size_t i = 0; i < n; i++)
+            total += double(arr.data()[i]);
+        bench::do_not_optimize(total);
+    }, work);
+    h.run("sum/any" + suffix, [&]() { bench::do_not_optimize(any.sum()); }, work);
+    h.run("astype/float64" + suffix, [&]() { bench::do_not_optimize(any.astype<double>().data()); }, work);
+}
+
+int main(int argc, char **argv) {
+    bench::harness h(argc, argv, "any_ndarray");
+    for (size_t n: {size_t(1) << 10, size_t(1) << 16, size_t(1) << 22}) {
+        run<uint8_t>(h, "uint8", n);
+        run<int32_t>(h, "int32", n);
+        run<float>(h, "float32", n);
+        run<double>(h, "float64", n);
+    }
+    return h.finish();
+}
@@ -0,0 +1,39 @@
+#include <utility>
+#include <vector>
+#include <cnumpy/arithmetic.hpp>
+#include <cnumpy/ndarray.hpp>
+#include "harness.hpp"
+
+using namespace std;
+using namespace cnumpy;
+
+// One relaxation step x = 0.5 * x + y, with every intermediate allocated versus reusing the buffer of x.
+
+int main(int argc, char **argv) {
+    bench::harness h(argc, argv, "arithmetic");
+    for (size_t n: {1 << 10, 1 << 16, 1 << 22}) {
+        ndarray<double> x(vector<size_t>{n}), y(vector<size_t>{n});
+        for (size_t i = 0; i < n; i++) {
+            x.data()[i] = double(i);
+            y.data()[i] = 1;
+        }
+        string suffix = "/" + to_string(n);
+        double bytes = double(3 * n * sizeof(double));
+
+        h.run("step_copy" + suffix, [&]() {
+            ndarray<double> next = 0.5 * x + y;
+            x = next;
+            bench::do_not_optimize(x.data());
+        }, {bytes, double(n)});
+        h.run("step_rvalue" + suffix, [&]() {
+            x = std::move(x) * 0.5 + y;
+            bench::do_not_optimize(x.data());
+        }, {bytes, double(n)});
+        h.run("step_compound" + suffix, [&]() {
+            x *= 0.5;
+            x += y;
+            bench::do_not_optimize(x.data());
+        }, {bytes, double(n)});
+    }
+    return h.finish();
+}
@@ -0,0 +1,37 @@
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <cnumpy/checksum.hpp>
+#include <cnumpy/parallel.hpp>
+#include "harness.hpp"
+
+using namespace std;
+using namespace cnumpy;
+
+// Throughput of CRC-32 and CRC-32C, accelerated and with tables only, on one thread and in parallel.
+
+int main(int argc, char **argv) {
+    bench::harness h(argc, argv, "checksum");
+    for (size_t n: {size_t(4) << 10, size_t(1) << 20, size_t(64) << 20}) {
+        vector<unsigned char> data(n);
+        for (size_t i = 0; i < n; i++)
+            data[i] = uint8_t(i * 2654435761u >> 24);
+        string suffix = "/" + to_string(n);
+        bench::work bytes{double(n)};
+
+        h.run("crc32_table" + suffix, [&]() {
+            bench::do_not_optimize(crc_<crc32_polynomial>::software(~0u, data.data(), n));
+        }, bytes);
+        h.run("crc32c_table" + suffix, [&]() {
+            bench::do_not_optimize(crc_<crc32c_polynomial>::software(~0u, data.data(), n));
+        }, bytes);
+        size_t nthreads = get_num_threads();
+        set_num_threads(1);
+        h.run("crc32_serial" + suffix, [&]() { bench::do_not_optimize(crc32(0, data.data(), n)); }, bytes);
+        h.run("crc32c_serial" + suffix, [&]() { bench::do_not_optimize(crc32c(0, data.data(), n)); }, bytes);
+        set_num_threads(nthreads);
+        h.run("crc32" + suffix, [&]() { bench::do_not_optimize(crc32(0, data.data(), n)); }, bytes);
+        h.run("crc32c" + suffix, [&]() { bench::do_not_optimize(crc32c(0, data.data(), n)); }, bytes);
+    }
+    return h.finish();
+}
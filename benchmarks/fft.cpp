@@ -0,0 +1,45 @@
+#include <complex>
+#include <string>
+#include <vector>
+#include <cnumpy/fft.hpp>
+#include <cnumpy/ndarray.hpp>
+#include "harness.hpp"
+
+using namespace std;
+using namespace cnumpy;
+
+// 1-D transforms of power-of-two, mixed-radix and prime lengths, real transforms, and a 2-D transform whose second
+// pass runs along the strided axis. Items are transformed values.
+
+template<class T>
+ndarray<T> filled(const vector<size_t> &shape) {
+    ndarray<T> arr(shape);
+    for (size_t i = 0; i < arr.size(); i++)
+        arr.data()[i] = T(double(i % 1013) * 1e-3);
+    return arr;
+}
+
+int main(int argc, char **argv) {
+    bench::harness h(argc, argv, "fft");
+    for (size_t n: {size_t(1) << 10, size_t(1) << 20, size_t(1000), size_t(1000000), size_t(4099), size_t(1000003)}) {
+        auto x = filled<complex<double>>({n});
+        auto xf = filled<complex<float>>({n});
+        auto r = filled<double>({n});
+        string suffix = "/" + to_string(n);
+        bench::work work{double(2 * n * sizeof(complex<double>)), double(n)};
+        h.run("fft" + suffix, [&]() { bench::do_not_optimize(fft(x).data()); }, work);
+        h.run("fft_float" + suffix, [&]() { bench::do_not_optimize(fft(xf).data()); },
+              bench::work{double(2 * n * sizeof(complex<float>)), double(n)});
+        h.run("rfft" + suffix, [&]() { bench::do_not_optimize(rfft(r).data()); },
+              bench::work{double(n * (sizeof(double) + sizeof(complex<double>) / 2)), double(n)});
+    }
+
+    for (size_t n: {size_t(256), size_t(2048)}) {
+        auto x = filled<complex<double>>({n, n});
+        bench::work work{double(2 * n * n * sizeof(complex<double>)), double(n * n)};
+        h.run("fftn/" + to_string(n) + "x" + to_string(n), [&]() { bench::do_not_optimize(fftn(x).data()); }, work);
+        h.run("fft_axis0/" + to_string(n) + "x" + to_string(n),
+              [&]() { bench::do_not_optimize(fft(x, 0).data()); }, work);
+    }
+    return h.finish();
+}
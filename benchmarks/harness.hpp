@@ -0,0 +1,208 @@
+#pragma once
+
+#include <algorithm>    // max, min, sort
+#include <chrono>
+#include <cmath>        // ceil, floor
+#include <cstdio>       // snprintf
+#include <fstream>
+#include <iostream>
+#include <numeric>      // accumulate
+#include <stdexcept>    // runtime_error
+#include <string>       // stod, stoul
+#include <thread>       // hardware_concurrency
+#include <utility>      // move
+#include <vector>
+#include <cnumpy/parallel.hpp>
+
+namespace bench {
+
+    // Keeps the compiler from optimizing away the computation of value, or the stores to the memory it points to.
+    template<class T>
+    inline void do_not_optimize(const T &value) {
+#if defined(__GNUC__)
+        asm volatile("" : : "r,m"(value) : "memory");
+#else
+        const volatile T sink = value;
+        (void) sink;
+#endif
+    }
+
+    // amount of work done by one call, to report throughput
+    struct work {
+        double bytes = 0;
+        double items = 0;
+    };
+
+    struct result {
+        std::string name;
+        size_t samples{}, iterations{};     // iterations is the number of calls timed together in one sample
+        double min{}, p10{}, median{}, p90{}, max{}, mean{};     // seconds per call
+        work per_call;
+    };
+
+    // Runs named benchmarks and reports seconds per call over repeated samples, printing a summary line per
+    // benchmark and optionally writing all results as JSON. Each benchmark is first called repeatedly for the warmup
+    // time; the number of calls per sample is then chosen so a sample lasts at least min_time. Sampling stops after
+    // the requested number of samples, or early once max_time has passed with at least three samples.
+    //
+    // Options: --json FILE, --filter SUBSTRING, --samples N, --min-time SECONDS, --warmup SECONDS, --max-time SECONDS
+    class harness {
+    public:
+        harness(int argc, char **argv, std::string suite) : suite_(std::move(suite)) {
+            for (int i = 1; i < argc; i++) {
+                std::string arg = argv[i];
+                if (i + 1 == argc)
+                    throw std::runtime_error("harness: missing value for " + arg);
+                std::string value = argv[++i];
+                if (arg == "--json")
+                    json_ = value;
+                else if (arg == "--filter")
+                    filter_ = value;
+                else if (arg == "--samples")
+                    samples_ = std::max<size_t>(1, std::stoul(value));
+                else if (arg == "--min-time")
+                    min_time_ = std::stod(value);
+                else if (arg == "--warmup")
+                    warmup_ = std::stod(value);
+                else if (arg == "--max-time")
+                    max_time_ = std::stod(value);
+                else
+                    throw std::runtime_error("harness: unknown option " + arg);
+            }
+        }
+
+        template<class Function>
+        void run(const std::string &name, Function &&fn, work per_call = {}) {
+            if (name.find(filter_) == std::string::npos)
+                return;
+
+            using clock = std::chrono::steady_clock;
+            auto seconds = [](clock::duration d) { return std::chrono::duration<double>(d).count(); };
+
+            double single = 0;
+            auto start = clock::now();
+            do {
+                auto t0 = clock::now();
+                fn();
+                single = seconds(clock::now() - t0);
+            } while (seconds(clock::now() - start) < warmup_);
+            size_t iterations = single > 0 ? std::max<size_t>(1, size_t(std::ceil(min_time_ / single))) : 1;
+
+            std::vector<double> times;
+            start = clock::now();
+            while (times.size() < samples_ && (times.size() < 3 || seconds(clock::now() - start) < max_time_)) {
+                auto t0 = clock::now();
+                for (size_t it = 0; it < iterations; it++)
+                    fn();
+                times.push_back(seconds(clock::now() - t0) / double(iterations));
+            }
+
+            std::sort(times.begin(), times.end());
+            result r{name, times.size(), iterations, times.front(), percentile_(times, 10), percentile_(times, 50),
+                     percentile_(times, 90), times.back(),
+                     std::accumulate(times.begin(), times.end(), 0.0) / double(times.size()), per_call};
+            print_(r);
+            results_.push_back(r);
+        }
+
+        [[nodiscard]] const std::vector<result> &results() const noexcept { return results_; }
+
+        // writes the JSON file if requested, returns the exit code for main
+        int finish() const {
+            if (json_.empty())
+                return 0;
+            std::ofstream out(json_);
+            out << "{\n  \"suite\": " << quote_(suite_) << ",\n  \"threads\": " << cnumpy::get_num_threads()
+                << ",\n  \"hardware_concurrency\": " << std::thread::hardware_concurrency()
+                << ",\n  \"compiler\": " << quote_(compiler_()) << ",\n  \"unit\": \"seconds\",\n  \"benchmarks\": [";
+            for (size_t i = 0; i < results_.size(); i++) {
+                const result &r = results_[i];
+                out << (i ? ",\n" : "\n") << "    {\"name\": " << quote_(r.name) << ", \"samples\": " << r.samples
+                    << ", \"iterations\": " << r.iterations << ", \"min\": " << number_(r.min) << ", \"p10\": "
+                    << number_(r.p10) << ", \"median\": " << number_(r.median) << ", \"p90\": " << number_(r.p90)
+                    << ", \"max\": " << number_(r.max) << ", \"mean\": " << number_(r.mean);
+                if (r.per_call.bytes > 0)
+                    out << ", \"bytes_per_second\": " << number_(r.per_call.bytes / r.median);
+                if (r.per_call.items > 0)
+                    out << ", \"items_per_second\": " << number_(r.per_call.items / r.median);
+                out << "}";
+            }
+            out << "\n  ]\n}\n";
+            if (out.flush().fail()) {
+                std::cerr << "harness: failed to write " << json_ << std::endl;
+                return 1;
+            }
+            return 0;
+        }
+
+    private:
+        // linear interpolation between the closest ranks, like numpy.percentile
+        static double percentile_(const std::vector<double> &sorted, double q) {
+            double pos = q / 100 * double(sorted.size() - 1);
+            size_t lo = size_t(std::floor(pos)), hi = std::min(lo + 1, sorted.size() - 1);
+            return sorted[lo] + (sorted[hi] - sorted[lo]) * (pos - double(lo));
+        }
+
+        static std::string duration_(double seconds) {
+            char buffer[32];
+            if (seconds < 1e-6)
+                std::snprintf(buffer, sizeof(buffer), "%.1f ns", seconds * 1e9);
+            else if (seconds < 1e-3)
+                std::snprintf(buffer, sizeof(buffer), "%.2f us", seconds * 1e6);
+            else if (seconds < 1)
+                std::snprintf(buffer, sizeof(buffer), "%.2f ms", seconds * 1e3);
+            else
+                std::snprintf(buffer, sizeof(buffer), "%.3f s", seconds);
+            return buffer;
+        }
+
+        static void print_(const result &r) {
+            std::cout << r.name << ": median " << duration_(r.median) << " (p10 " << duration_(r.p10) << ", p90 "
+                      << duration_(r.p90) << ", " << r.samples << "x" << r.iterations << ")";
+            if (r.per_call.bytes > 0)
+                std::cout << ", " << r.per_call.bytes / r.median * 1e-9 << " GB/s";
+            if (r.per_call.items > 0)
+                std::cout << ", " << r.per_call.items / r.median * 1e-9 << " G/s";
+            std::cout << std::endl;
+        }
+
+        static std::string number_(double value) {
+            char buffer[32];
+            std::snprintf(buffer, sizeof(buffer), "%.9g", value);
+            return buffer;
+        }
+
+        static std::string quote_(const std::string &str) {
+            std::string out = "\"";
+            for (char c: str) {
+                if (c == '"' || c == '\\') {
+                    out += '\\';
+                    out += c;
+                } else if ((unsigned char) c < 0x20) {
+                    char buffer[8];
+                    std::snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+                    out += buffer;
+                } else {
+                    out += c;
+                }
+            }
+            return out + "\"";
+        }
+
+        static std::string compiler_() {
+#if defined(__clang__)
+            return "clang " __clang_version__;
+#elif defined(__GNUC__)
+            return "gcc " __VERSION__;
+#else
+            return "unknown";
+#endif
+        }
+
+        std::string suite_, json_, filter_;
+        size_t samples_ = 15;
+        double min_time_ = 0.01, warmup_ = 0.1, max_time_ = 2;
+        std::vector<result> results_;
+    };
+
+}
@@ -0,0 +1,76 @@
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <cnumpy/ndarray.hpp>
+#include <cnumpy/npy.hpp>
+#include "harness.hpp"
+
+using namespace std;
+using namespace cnumpy;
+
+// Access to arrays of more than 2^32 elements. The arrays live in address space reserved with mmap, read-only pages
+// map to the shared zero page, so the benchmark needs little memory.
+
+template<class T>
+shared_ptr<T[]> reserve(size_t bytes) {
+    void *p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (p == MAP_FAILED)
+        throw runtime_error("mmap failed");
+    return shared_ptr<T[]>((T *) p, [bytes](T *q) { munmap(q, bytes); });
+}
+
+// sums the last rows of arr, n elements per row
+template<class Array>
+uint64_t sum_tail(const Array &arr, size_t rows, size_t n) {
+    uint64_t sum = 0;
+    for (size_t i = n - rows; i < n; i++)
+        for (size_t j = 0; j < n; j++)
+            sum += arr(i, j);
+    return sum;
+}
+
+int main(int argc, char **argv) {
+    bench::harness h(argc, argv, "large_arrays");
+    size_t n = 65537, size = n * n, rows = 64;
+    auto memory = reserve<uint8_t>(size);
+    bench::work tail{double(rows * n), double(rows * n)};
+
+    ndarray<uint8_t, 2> fixed({n, n}, memory);
+    h.run("sum_tail/fixed/" + to_string(size), [&]() { bench::do_not_optimize(sum_tail(fixed, rows, n)); }, tail);
+    ndarray<uint8_t> variable(vector<size_t>{n, n}, memory);
+    h.run("sum_tail/variable/" + to_string(size), [&]() {
+        bench::do_not_optimize(sum_tail(variable, rows, n));
+    }, tail);
+    h.run("make_shared_offset/" + to_string(size), [&]() {
+        auto view = fixed.make_shared(array<size_t, 1>{n}, size - n);
+        bench::do_not_optimize(view.data());
+    });
+
+    // header parsing and aliasing of a 4 GiB .npy image in memory
+    string header = NPY::header(NPY::descr<uint8_t>(), vector<size_t>{n, n});
+    auto image = reserve<char>(header.size() + size);
+    copy(header.begin(), header.end(), image.get());
+    h.run("npy_load_aliased/" + to_string(size), [&]() {
+        NPY npy(image, header.size() + size, 'r');
+        auto arr = npy.load<uint8_t>();
+        bench::do_not_optimize(arr.data());
+    });
+
+    // inspecting a sparse 4 GiB .npy file
+    int fd = open("bench_large_arrays.npy", O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0 || pwrite(fd, header.data(), header.size(), 0) != ssize_t(header.size()) ||
+        ftruncate(fd, off_t(header.size() + size)) != 0)
+        throw runtime_error("can't write bench_large_arrays.npy");
+    close(fd);
+    h.run("npy_inspect_sparse/" + to_string(size), [&]() {
+        auto info = NPY::inspect("bench_large_arrays.npy");
+        bench::do_not_optimize(info.offset);
+    });
+    unlink("bench_large_arrays.npy");
+    return h.finish();
+}
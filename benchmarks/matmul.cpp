@@ -0,0 +1,57 @@
+#include <string>
+#include <cnumpy/linalg.hpp>
+#include <cnumpy/ndarray.hpp>
+#include "harness.hpp"
+
+using namespace std;
+using namespace cnumpy;
+
+template<class T>
+void naive(const ndarray<T, 2> &a, const ndarray<T, 2> &b, ndarray<T, 2> &c) {
+    size_t m = a.shape()[0], k = a.shape()[1], n = b.shape()[1];
+    for (size_t i = 0; i < m; i++) {
+        for (size_t j = 0; j < n; j++) {
+            T sum = 0;
+            for (size_t p = 0; p < k; p++)
+                sum += a(i, p) * b(p, j);
+            c(i, j) = sum;
+        }
+    }
+}
+
+// throughput is reported in floating-point operations per second
+template<class T>
+void run(bench::harness &h, const string &name) {
+    for (size_t n: {64, 256, 1024}) {
+        ndarray<T, 2> a(n, n), b(n, n), c(n, n);
+        for (size_t i = 0; i < a.size(); i++) {
+            a.data()[i] = T(i % 7) - T(3);
+            b.data()[i] = T(i % 5) - T(2);
+        }
+        bench::work flops{0, 2.0 * double(n) * double(n) * double(n)};
+        string suffix = "/" + name + "/" + to_string(n);
+        h.run("matmul" + suffix, [&]() { c = matmul(a, b); }, flops);
+        h.run("naive" + suffix, [&]() {
+            naive(a, b, c);
+            bench::do_not_optimize(c.data());
+        }, flops);
+    }
+
+    size_t batch = 256, n = 32;
+    ndarray<T, 3> a(batch, n, n), b(batch, n, n);
+    for (size_t i = 0; i < a.size(); i++) {
+        a.data()[i] = T(i % 7) - T(3);
+        b.data()[i] = T(i % 5) - T(2);
+    }
+    h.run("matmul_batched/" + name + "/" + to_string(batch) + "x" + to_string(n), [&]() {
+        auto c = matmul(a, b);
+        bench::do_not_optimize(c.data());
+    }, {0, 2.0 * double(batch) * double(n) * double(n) * double(n)});
+}
+
+int main(int argc, char **argv) {
+    bench::harness h(argc, argv, "matmul");
+    run<float>(h, "float");
+    run<double>(h, "double");
+    return h.finish();
+}
@@ -0,0 +1,50 @@
+#include <array>
+#include <utility>
+#include <vector>
+#include <cnumpy/ndarray.hpp>
+#include "harness.hpp"
+
+using namespace std;
+using namespace cnumpy;
+
+// Cost of constructing, copying, moving and viewing arrays of different sizes.
+
+template<class Array, class Shape>
+void run(bench::harness &h, const string &name, const Shape &shape) {
+    Array arr(shape);
+    for (size_t i = 0; i < arr.size(); i++)
+        arr.data()[i] = double(i);
+    string suffix = "/" + name + "/" + to_string(arr.size());
+    double bytes = double(arr.size() * sizeof(double));
+
+    h.run("construct" + suffix, [&]() {
+        Array other(shape);
+        bench::do_not_optimize(other.data());
+    });
+    h.run("copy" + suffix, [&]() {
+        Array other(arr);
+        bench::do_not_optimize(other.data());
+    }, {bytes});
+    h.run("move" + suffix, [&]() {
+        Array other(std::move(arr));
+        bench::do_not_optimize(other.data());
+        arr = std::move(other);
+    });
+    h.run("make_shared" + suffix, [&]() {
+        auto view = arr.make_shared(array<size_t, 2>{arr.size() / 4, 4});
+        bench::do_not_optimize(view.data());
+    });
+    h.run("make_shared_offset" + suffix, [&]() {
+        auto view = arr.make_shared(vector<size_t>{arr.size() / 2}, arr.size() / 4);
+        bench::do_not_optimize(view.data());
+    });
+}
+
+int main(int argc, char **argv) {
+    bench::harness h(argc, argv, "ndarray");
+    for (size_t n: {1 << 4, 1 << 10, 1 << 16, 1 << 22}) {
+        run<ndarray<double, 2>>(h, "fixed", array<size_t, 2>{n / 4, 4});
+        run<ndarray<double>>(h, "variable", vector<size_t>{n / 4, 4});
+    }
+    return h.finish();
+}
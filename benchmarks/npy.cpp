@@ -0,0 +1,82 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <cnumpy/ndarray.hpp>
+#include <cnumpy/npy.hpp>
+#include "harness.hpp"
+
+using namespace std;
+using namespace cnumpy;
+
+// Save and load throughput of .npy files and in-memory buffers across sizes and dtypes, in native and swapped byte
+// order. Loads from a buffer in native order alias the buffer, so they cost only the header parsing.
+
+template<class T>
+void run(bench::harness &h, const string &dtype, size_t n) {
+    ndarray<T, 1> arr(n);
+    for (size_t i = 0; i < n; i++)
+        arr(i) = T(i % 127);
+    string suffix = "/" + dtype + "/" + to_string(n), file = "bench_npy.npy", swapped_file = "bench_npy_swapped.npy";
+    bench::work work{double(n * sizeof(T))};
+    size_t nbytes = NPY::nbytes(arr);
+    shared_ptr<char[]> buffer(new char[nbytes]);
+
+    h.run("save/file" + suffix, [&]() {
+        NPY npy(file, 'w');
+        npy.save(arr);
+        npy.close();
+    }, work);
+    h.run("load/file/native" + suffix, [&]() {
+        NPY npy(file, 'r');
+        auto loaded = npy.load<T>();
+        bench::do_not_optimize(loaded.data());
+    }, work);
+    h.run("save/buffer" + suffix, [&]() {
+        NPY npy(buffer, nbytes, 'w');
+        npy.save(arr);
+    }, work);
+    h.run("load/buffer/native" + suffix, [&]() {
+        NPY npy(buffer, nbytes, 'r');
+        auto loaded = npy.load<T>();
+        bench::do_not_optimize(loaded.data());
+    }, work);
+
+    if (sizeof(T) > 1) {
+        // the same array in the opposite byte order
+        size_t header = NPY::header(arr).size();
+        shared_ptr<char[]> swapped(new char[nbytes]);
+        copy(buffer.get(), buffer.get() + nbytes, swapped.get());
+        char &order = swapped[string(swapped.get(), header).find("'descr': '") + 10];
+        order = order == '<' ? '>' : '<';
+        for (size_t i = 0; i < n; i++)
+            reverse(swapped.get() + header + i * sizeof(T), swapped.get() + header + (i + 1) * sizeof(T));
+        ofstream(swapped_file, ios::binary).write(swapped.get(), streamsize(nbytes));
+
+        h.run("load/file/swapped" + suffix, [&]() {
+            NPY npy(swapped_file, 'r');
+            auto loaded = npy.load<T>();
+            bench::do_not_optimize(loaded.data());
+        }, work);
+        h.run("load/buffer/swapped" + suffix, [&]() {
+            NPY npy(swapped, nbytes, 'r');
+            auto loaded = npy.load<T>();
+            bench::do_not_optimize(loaded.data());
+        }, work);
+    }
+    remove(file.c_str());
+    remove(swapped_file.c_str());
+}
+
+int main(int argc, char **argv) {
+    bench::harness h(argc, argv, "npy");
+    for (size_t n: {1 << 10, 1 << 16, 1 << 22}) {
+        run<uint8_t>(h, "u1", n);
+        run<int32_t>(h, "i4", n);
+        run<float>(h, "f4", n);
+        run<double>(h, "f8", n);
+    }
+    return h.finish();
+}
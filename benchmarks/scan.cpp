@@ -0,0 +1,41 @@
+#include <string>
+#include <vector>
+#include <cnumpy/ndarray.hpp>
+#include <cnumpy/parallel.hpp>
+#include <cnumpy/scan.hpp>
+#include "harness.hpp"
+
+using namespace std;
+using namespace cnumpy;
+
+// Cumulative sums of one long series on one thread and in parallel blocks, across rows, and differences.
+
+int main(int argc, char **argv) {
+    bench::harness h(argc, argv, "scan");
+    for (size_t n: {size_t(1) << 16, size_t(1) << 24}) {
+        ndarray<double> series(vector<size_t>{n});
+        ndarray<float> series_f(vector<size_t>{n});
+        for (size_t i = 0; i < n; i++) {
+            series.data()[i] = double(i % 1000) * 1e-3;
+            series_f.data()[i] = float(i % 1000) * 1e-3f;
+        }
+        string suffix = "/" + to_string(n);
+        bench::work work{double(2 * n * sizeof(double)), double(n)};
+        bench::work work_f{double(2 * n * sizeof(float)), double(n)};
+
+        size_t nthreads = get_num_threads();
+        set_num_threads(1);
+        h.run("cumsum_serial" + suffix, [&]() { bench::do_not_optimize(cumsum(series).data()); }, work);
+        h.run("cumsum_float_serial" + suffix, [&]() { bench::do_not_optimize(cumsum(series_f).data()); }, work_f);
+        set_num_threads(nthreads);
+        h.run("cumsum" + suffix, [&]() { bench::do_not_optimize(cumsum(series).data()); }, work);
+        h.run("cumsum_float" + suffix, [&]() { bench::do_not_optimize(cumsum(series_f).data()); }, work_f);
+        h.run("cummax" + suffix, [&]() { bench::do_not_optimize(cummax(series).data()); }, work);
+        h.run("diff" + suffix, [&]() { bench::do_not_optimize(diff(series).data()); }, work);
+
+        auto rows = series.make_shared(vector<size_t>{n / 1024, 1024});
+        h.run("cumsum_axis0" + suffix, [&]() { bench::do_not_optimize(cumsum(rows, 0).data()); }, work);
+        h.run("diff_axis0" + suffix, [&]() { bench::do_not_optimize(diff(rows, 1, 0).data()); }, work);
+    }
+    return h.finish();
+}
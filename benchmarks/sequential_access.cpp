@@ -1,100 +1,105 @@
-#include <cmath>
-#include <iostream>
+#include <cstddef>
 #include <vector>
-#include <chrono>
 #include <cnumpy/ndarray.hpp>
+#include "harness.hpp"
 
 using namespace std;
 using namespace cnumpy;
 
-void print(const vector<chrono::duration<double, std::micro>> &durations) {
-    int n = durations.size();
-    vector<double> t;
-    t.reserve(n);
-    for (auto dur : durations)
-        t.push_back(dur.count());
-
-    vector<double> sum = t;
-    while (sum.size() > 1) {
-        int m = sum.size();
-        for (int i = 0, j = (m+1) / 2; j < m; i++, j++) {
-            sum[i] += sum[j];
-        }
-        sum.resize((m+1)/2);
-    }
-    double mean = sum[0] / n;
-
-    vector<double> sumsq = t;
-    for (auto &s : sumsq)
-        s = (s - mean) * (s - mean);
-    while (sumsq.size() > 1) {
-        int m = sumsq.size();
-        for (int i = 0, j = (m+1) / 2; j < m; i++, j++) {
-            sumsq[i] += sumsq[j];
-        }
-        sumsq.resize((m+1) / 2);
-    }
-    double rms = sqrt(sumsq[0] / n);
-    cout << mean << " +/- " << rms << endl;
+// Element access through fixed-rank (shape in a std::array) and variable-rank (shape in a std::vector) arrays,
+// compared with nested vectors and a raw pointer, in memory order (contiguous) and with the last index varying
+// slowest (strided).
+
+template<class Array>
+void fill_contiguous(Array &arr, size_t n) {
+    for (size_t i = 0; i < n; i++)
+        for (size_t j = 0; j < n; j++)
+            for (size_t k = 0; k < n; k++)
+                arr(i, j, k) = double(k);
 }
 
-int main() {
-    int nit = 10;
-    int a = 1000, b = 1000, c = 1000;
-
-    {
-        vector<chrono::duration<double, std::micro>> cnpy_time;
-        ndarray<double, 3> arr1(a, b, c);
-        for (int it = 0; it < nit; it++) {
-            auto p1 = chrono::system_clock::now();
-            for (int i = 0; i < a; i++) {
-                for (int j = 0; j < b; j++) {
-                    for (int k = 0; k < c; k++) {
-                        arr1(i, j, k) = 0;
-                    }
-                }
-            }
-            auto p2 = chrono::system_clock::now();
-            cnpy_time.push_back(p2 - p1);
-        }
-        print(cnpy_time);
-    }
+template<class Array>
+void fill_strided(Array &arr, size_t n) {
+    for (size_t k = 0; k < n; k++)
+        for (size_t j = 0; j < n; j++)
+            for (size_t i = 0; i < n; i++)
+                arr(i, j, k) = double(k);
+}
 
-    {
-        vector<chrono::duration<double, std::micro>> vec_time;
-        vector<vector<vector<double>>> arr2(a, vector<vector<double>>(b, vector<double>(c)));
-        for (int it = 0; it < nit; it++) {
-            auto p1 = chrono::system_clock::now();
-            for (int i = 0; i < a; i++) {
-                for (int j = 0; j < b; j++) {
-                    for (int k = 0; k < c; k++) {
-                        arr2[i][j][k] = 0;
-                    }
-                }
-            }
-            auto p2 = chrono::system_clock::now();
-            vec_time.push_back(p2 - p1);
-        }
-        print(vec_time);
-    }
+template<class Array>
+double sum_contiguous(const Array &arr, size_t n) {
+    double sum = 0;
+    for (size_t i = 0; i < n; i++)
+        for (size_t j = 0; j < n; j++)
+            for (size_t k = 0; k < n; k++)
+                sum += arr(i, j, k);
+    return sum;
+}
 
-    {
-        vector<chrono::duration<double, std::micro>> cnpy_time;
-        ndarray<double, 3> arr1(a, b, c);
-        for (int it = 0; it < nit; it++) {
-            auto p1 = chrono::system_clock::now();
-            for (int i = 0; i < a; i++) {
-                for (int j = 0; j < b; j++) {
-                    for (int k = 0; k < c; k++) {
-                        arr1(i, j, k) = 0;
-                    }
-                }
-            }
-            auto p2 = chrono::system_clock::now();
-            cnpy_time.push_back(p2 - p1);
-        }
-        print(cnpy_time);
-    }
+template<class Array>
+double sum_strided(const Array &arr, size_t n) {
+    double sum = 0;
+    for (size_t k = 0; k < n; k++)
+        for (size_t j = 0; j < n; j++)
+            for (size_t i = 0; i < n; i++)
+                sum += arr(i, j, k);
+    return sum;
+}
+
+// nested vectors and raw memory with the same call syntax
+struct nested {
+    explicit nested(size_t n) : data(n, vector<vector<double>>(n, vector<double>(n))) {}
+
+    double &operator()(size_t i, size_t j, size_t k) { return data[i][j][k]; }
 
-    return 0;
-}
\ No newline at end of file
+    const double &operator()(size_t i, size_t j, size_t k) const { return data[i][j][k]; }
+
+    vector<vector<vector<double>>> data;
+};
+
+struct raw {
+    explicit raw(size_t n) : n(n), data(new double[n * n * n]) {}
+
+    ~raw() { delete[] data; }
+
+    double &operator()(size_t i, size_t j, size_t k) { return data[(i * n + j) * n + k]; }
+
+    const double &operator()(size_t i, size_t j, size_t k) const { return data[(i * n + j) * n + k]; }
+
+    size_t n;
+    double *data;
+};
+
+template<class Array>
+void run(bench::harness &h, const string &name, Array &arr, size_t n) {
+    bench::work work{double(n * n * n * sizeof(double)), double(n * n * n)};
+    h.run("fill/contiguous/" + name + "/" + to_string(n), [&]() {
+        fill_contiguous(arr, n);
+        bench::do_not_optimize(arr);
+    }, work);
+    h.run("fill/strided/" + name + "/" + to_string(n), [&]() {
+        fill_strided(arr, n);
+        bench::do_not_optimize(arr);
+    }, work);
+    h.run("sum/contiguous/" + name + "/" + to_string(n), [&]() {
+        bench::do_not_optimize(sum_contiguous(arr, n));
+    }, work);
+    h.run("sum/strided/" + name + "/" + to_string(n), [&]() {
+        bench::do_not_optimize(sum_strided(arr, n));
+    }, work);
+}
+
+int main(int argc, char **argv) {
+    bench::harness h(argc, argv, "sequential_access");
+    for (size_t n: {32, 256}) {
+        ndarray<double, 3> fixed(n, n, n);
+        run(h, "fixed", fixed, n);
+        ndarray<double> variable(n, n, n);
+        run(h, "variable", variable, n);
+        nested vectors(n);
+        run(h, "nested_vector", vectors, n);
+        raw pointer(n);
+        run(h, "raw", pointer, n);
+    }
+    return h.finish();
+}
@@ -0,0 +1,50 @@
+#include <algorithm>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+#include <cnumpy/ndarray.hpp>
+#include <cnumpy/sort.hpp>
+#include "harness.hpp"
+
+using namespace std;
+using namespace cnumpy;
+
+// std::sort over a copy of every row, the way rows were sorted before
+template<class T>
+void reference(const ndarray<T, 2> &arr, ndarray<T, 2> &out) {
+    size_t n = arr.shape()[0], m = arr.shape()[1];
+    vector<T> row(m);
+    for (size_t i = 0; i < n; i++) {
+        for (size_t j = 0; j < m; j++)
+            row[j] = arr(i, j);
+        sort(row.begin(), row.end());
+        for (size_t j = 0; j < m; j++)
+            out(i, j) = row[j];
+    }
+}
+
+template<class T>
+void run(bench::harness &h, const string &name) {
+    mt19937_64 rng(42);
+    for (auto [n, m]: {pair<size_t, size_t>{1 << 18, 8}, {1 << 16, 32}, {1 << 12, 1024}, {1, 1 << 24}}) {
+        ndarray<T, 2> arr(n, m), out(n, m);
+        for (size_t i = 0; i < arr.size(); i++)
+            arr.data()[i] = T(rng() % (1 << 30)) - T(1 << 29);
+        string suffix = "/" + name + "/" + to_string(n) + "x" + to_string(m);
+        bench::work work{double(arr.size() * sizeof(T)), double(arr.size())};
+        h.run("sort" + suffix, [&]() { out = cnumpy::sort(arr); }, work);
+        h.run("std_sort" + suffix, [&]() {
+            reference(arr, out);
+            bench::do_not_optimize(out.data());
+        }, work);
+    }
+}
+
+int main(int argc, char **argv) {
+    bench::harness h(argc, argv, "sort");
+    run<int>(h, "int32");
+    run<float>(h, "float32");
+    run<double>(h, "float64");
+    return h.finish();
+}
@@ -0,0 +1,228 @@
+#pragma once
+
+#include <algorithm>    // min
+#include <complex>
+#include <cstddef>      // size_t
+#include <cstdint>      // int8_t, int16_t, int32_t, int64_t, uint8_t, uint16_t, uint32_t, uint64_t
+#include <stdexcept>    // runtime_error
+#include <string>
+#include <type_traits>  // false_type, is_constructible_v, is_same_v, remove_cvref_t, true_type
+#include <utility>      // forward, move
+#include <variant>
+#include <vector>
+#include "ndarray.hpp"
+#include "parallel.hpp"
+
+namespace cnumpy {
+
+    inline constexpr size_t any_block_ = size_t(1) << 15;           // elements per task and per partial result
+
+    template<class T>
+    struct is_complex_ : std::false_type {};
+
+    template<class T>
+    struct is_complex_<std::complex<T>> : std::true_type {};
+
+    // numpy's name for the dtype of T
+    template<class T>
+    constexpr const char *dtype_name_() {
+        if constexpr (std::is_same_v<T, bool>) return "bool";
+        else if constexpr (std::is_same_v<T, int8_t>) return "int8";
+        else if constexpr (std::is_same_v<T, int16_t>) return "int16";
+        else if constexpr (std::is_same_v<T, int32_t>) return "int32";
+        else if constexpr (std::is_same_v<T, int64_t>) return "int64";
+        else if constexpr (std::is_same_v<T, uint8_t>) return "uint8";
+        else if constexpr (std::is_same_v<T, uint16_t>) return "uint16";
+        else if constexpr (std::is_same_v<T, uint32_t>) return "uint32";
+        else if constexpr (std::is_same_v<T, uint64_t>) return "uint64";
+        else if constexpr (std::is_same_v<T, float>) return "float32";
+        else if constexpr (std::is_same_v<T, double>) return "float64";
+        else if constexpr (std::is_same_v<T, long double>) return sizeof(long double) == 16 ? "float128" : "longdouble";
+        else if constexpr (std::is_same_v<T, std::complex<float>>) return "complex64";
+        else if constexpr (std::is_same_v<T, std::complex<double>>) return "complex128";
+        else return sizeof(long double) == 16 ? "complex256" : "clongdouble";
+    }
+
+    // x as To, like numpy's astype: complex to real keeps the real part, anything to bool tests for nonzero
+    template<class To, class From>
+    To convert_(const From &x) {
+        if constexpr (std::is_same_v<To, bool>)
+            return x != From(0);
+        else if constexpr (is_complex_<From>::value && !is_complex_<To>::value)
+            return To(x.real());
+        else
+            return To(x);
+    }
+
+    // An array whose element type is chosen at run time among those NPY reads and writes, e.g. loaded from a file of
+    // unknown dtype. visit(fn) calls fn with the typed ndarray<T>, so fn is compiled once per element type and its
+    // loops run on T directly; the type is dispatched once per call, not per element. The kernels below work that way.
+    class any_ndarray {
+    public:
+        using variant_type = std::variant<
+                ndarray<bool>,
+                ndarray<int8_t>, ndarray<int16_t>, ndarray<int32_t>, ndarray<int64_t>,
+                ndarray<uint8_t>, ndarray<uint16_t>, ndarray<uint32_t>, ndarray<uint64_t>,
+                ndarray<float>, ndarray<double>, ndarray<long double>,
+                ndarray<std::complex<float>>, ndarray<std::complex<double>>, ndarray<std::complex<long double>>>;
+
+        template<class T>
+        static constexpr bool holdable = std::is_constructible_v<variant_type, ndarray<T>>;
+
+        // an empty float64 array
+        any_ndarray() : array_(ndarray<double>(std::vector<size_t>{0})) {}
+
+        // Takes arr over; a fixed-rank array is viewed with a variable-rank shape, sharing its buffer.
+        template<class T, class Container>
+        requires holdable<T>
+        any_ndarray(ndarray_impl<T, Container> arr) : array_(variable_rank_(std::move(arr))) {}
+
+        template<class Visitor>
+        decltype(auto) visit(Visitor &&fn) { return std::visit(std::forward<Visitor>(fn), array_); }
+
+        template<class Visitor>
+        decltype(auto) visit(Visitor &&fn) const { return std::visit(std::forward<Visitor>(fn), array_); }
+
+        [[nodiscard]] const std::vector<size_t> &shape() const {
+            return visit([](const auto &arr) -> const std::vector<size_t> & { return arr.shape(); });
+        }
+
+        [[nodiscard]] size_t ndim() const { return shape().size(); }
+
+        [[nodiscard]] size_t size() const { return visit([](const auto &arr) { return arr.size(); }); }
+
+        [[nodiscard]] size_t itemsize() const {
+            return visit([](const auto &arr) {
+                return sizeof(typename std::remove_cvref_t<decltype(arr)>::value_type);
+            });
+        }
+
+        [[nodiscard]] size_t nbytes() const { return size() * itemsize(); }
+
+        // numpy's name for the element type, e.g. "float64"
+        [[nodiscard]] std::string dtype() const {
+            return visit([](const auto &arr) {
+                return std::string(dtype_name_<typename std::remove_cvref_t<decltype(arr)>::value_type>());
+            });
+        }
+
+        [[nodiscard]] const void *data() const {
+            return visit([](const auto &arr) { return static_cast<const void *>(arr.data()); });
+        }
+
+        template<class T>
+        [[nodiscard]] bool holds() const noexcept { return std::holds_alternative<ndarray<T>>(array_); }
+
+        template<class T>
+        ndarray<T> &get() {
+            if (auto *arr = std::get_if<ndarray<T>>(&array_))
+                return *arr;
+            throw std::runtime_error(std::string("any_ndarray::get(): holds ") + dtype() + ", not " + dtype_name_<T>());
+        }
+
+        template<class T>
+        const ndarray<T> &get() const {
+            if (const auto *arr = std::get_if<ndarray<T>>(&array_))
+                return *arr;
+            throw std::runtime_error(std::string("any_ndarray::get(): holds ") + dtype() + ", not " + dtype_name_<T>());
+        }
+
+        template<class T>
+        ndarray<T> *get_if() noexcept { return std::get_if<ndarray<T>>(&array_); }
+
+        template<class T>
+        const ndarray<T> *get_if() const noexcept { return std::get_if<ndarray<T>>(&array_); }
+
+        variant_type &variant() noexcept { return array_; }
+
+        const variant_type &variant() const noexcept { return array_; }
+
+        // A copy converted to T, like numpy's astype.
+        template<class T>
+        ndarray<T> astype() const {
+            return visit([](const auto &arr) {
+                using From = typename std::remove_cvref_t<decltype(arr)>::value_type;
+                ndarray<T> out(arr.shape());
+                const From *src = arr.data();
+                T *dst = out.data();
+                parallel_for(0, arr.size(), any_block_, [&](size_t begin, size_t end) {
+                    for (size_t i = begin; i < end; i++)
+                        dst[i] = convert_<T>(src[i]);
+                });
+                return out;
+            });
+        }
+
+        // The sum of all elements, accumulated in R. Blocks are summed in parallel and their sums added in order, so
+        // the result does not depend on the number of threads. Complex data needs a complex R.
+        template<class R = double>
+        R sum() const {
+            return visit([](const auto &arr) -> R {
+                using T = typename std::remove_cvref_t<decltype(arr)>::value_type;
+                if constexpr (is_complex_<T>::value && !is_complex_<R>::value) {
+                    throw std::runtime_error("any_ndarray::sum(): complex data needs a complex result type");
+                } else {
+                    return reduce_(arr, R(0), [](R acc, const T &x) { return R(acc + convert_<R>(x)); },
+                                   [](R a, R b) { return R(a + b); });
+                }
+            });
+        }
+
+        // The least and greatest elements as R; NaN propagates, as in numpy.min and numpy.max.
+        template<class R = double>
+        R min() const { return extremum_<R>(false, "any_ndarray::min"); }
+
+        template<class R = double>
+        R max() const { return extremum_<R>(true, "any_ndarray::max"); }
+
+    private:
+        template<class T, class Container>
+        static ndarray<T> variable_rank_(ndarray_impl<T, Container> &&arr) {
+            if constexpr (std::is_same_v<Container, std::vector<size_t>>)
+                return std::move(arr);
+            else
+                return arr.make_shared(std::vector<size_t>(arr.shape().begin(), arr.shape().end()));
+        }
+
+        // fold over fixed blocks, then over their results in order
+        template<class T, class R, class Fold, class Combine>
+        static R reduce_(const ndarray<T> &arr, R init, Fold fold, Combine combine) {
+            const T *src = arr.data();
+            size_t n = arr.size(), nblocks = (n + any_block_ - 1) / any_block_;
+            std::vector<R> partial(nblocks, init);
+            parallel_for(0, nblocks, 1, [&](size_t begin, size_t end) {
+                for (size_t b = begin; b < end; b++) {
+                    R acc = init;
+                    for (size_t i = b * any_block_, last = std::min(n, i + any_block_); i < last; i++)
+                        acc = fold(acc, src[i]);
+                    partial[b] = acc;
+                }
+            });
+            R result = init;
+            for (const R &p: partial)
+                result = combine(result, p);
+            return result;
+        }
+
+        template<class R>
+        R extremum_(bool greatest, const char *name) const {
+            return visit([&](const auto &arr) -> R {
+                using T = typename std::remove_cvref_t<decltype(arr)>::value_type;
+                if constexpr (is_complex_<T>::value) {
+                    throw std::runtime_error(std::string(name) + "(): complex data is not ordered");
+                } else {
+                    if (arr.size() == 0)
+                        throw std::runtime_error(std::string(name) + "(): zero-size array");
+                    auto pick = [greatest](const T &a, const T &b) {
+                        return (greatest ? b < a : a < b) || a != a ? a : b;
+                    };
+                    T first = arr.data()[0];
+                    return convert_<R>(reduce_(arr, first, pick, pick));
+                }
+            });
+        }
+
+        variant_type array_;
+    };
+
+}
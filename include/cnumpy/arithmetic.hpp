@@ -0,0 +1,256 @@
+#pragma once
+
+#include <algorithm>    // equal
+#include <cmath>        // abs, cos, exp, log, pow, sin, sqrt, tanh
+#include <cstddef>      // size_t
+#include <functional>   // divides, minus, multiplies, negate, plus
+#include <stdexcept>    // runtime_error
+#include <string>
+#include <type_traits>  // is_const_v, is_convertible, is_lvalue_reference_v, is_pointer_v, remove_cvref_t
+#include <utility>      // as_const, forward, move
+#include "ndarray.hpp"
+#include "parallel.hpp"
+
+// Element-wise arithmetic and math functions on arrays of the same shape, or an array and a scalar. An operand passed
+// as an rvalue (a temporary or std::move(arr)) that alone owns its buffer is reused for the result, so chains like
+// x = std::move(x) * a + b allocate nothing; otherwise the result gets its own memory.
+namespace cnumpy {
+
+    inline constexpr size_t elementwise_grain_ = size_t(1) << 15;
+
+    template<class T>
+    struct is_ndarray_ : std::false_type {};
+
+    template<class T, class Container>
+    struct is_ndarray_<ndarray_impl<T, Container>> : std::true_type {};
+
+    template<class A>
+    inline constexpr bool is_array_ = is_ndarray_<std::remove_cvref_t<A>>::value;
+
+    // a forwarded operand whose buffer may be taken over
+    template<class A>
+    inline constexpr bool expiring_ = is_array_<A> && !std::is_lvalue_reference_v<A> &&
+                                      !std::is_const_v<std::remove_reference_t<A>>;
+
+    // two arrays of the same type, or an array and a scalar convertible to its value type
+    template<class A, class B, bool = is_array_<A>, bool = is_array_<B>>
+    struct operands_ : std::false_type {};
+
+    template<class A, class B>
+    struct operands_<A, B, true, true> : std::is_same<std::remove_cvref_t<A>, std::remove_cvref_t<B>> {};
+
+    template<class A, class B>
+    struct operands_<A, B, true, false> : std::is_convertible<B, typename std::remove_cvref_t<A>::value_type> {};
+
+    template<class A, class B>
+    struct operands_<A, B, false, true> : std::is_convertible<A, typename std::remove_cvref_t<B>::value_type> {};
+
+    // what the loops read: the data of an array, or a scalar converted to the value type
+    template<class T, class A>
+    auto operand_(const A &a) {
+        if constexpr (is_array_<A>)
+            return a.data();
+        else
+            return T(a);
+    }
+
+    template<class T, class A, class B, class Function>
+    void transform_(T *out, size_t n, A a, B b, Function fn) {
+        parallel_for(0, n, elementwise_grain_, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                if constexpr (std::is_pointer_v<A> && std::is_pointer_v<B>)
+                    out[i] = T(fn(a[i], b[i]));
+                else if constexpr (std::is_pointer_v<A>)
+                    out[i] = T(fn(a[i], b));
+                else
+                    out[i] = T(fn(a, b[i]));
+            }
+        });
+    }
+
+    template<class T, class Function>
+    void transform_(T *out, size_t n, const T *a, Function fn) {
+        parallel_for(0, n, elementwise_grain_, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++)
+                out[i] = T(fn(a[i]));
+        });
+    }
+
+    // the array to hold the result: an expiring operand that alone owns its buffer, else a new one
+    template<class A, class B>
+    auto output_(A &a, B &b) {
+        using array_type = std::remove_cvref_t<std::conditional_t<is_array_<A>, A, B>>;
+        if constexpr (expiring_<A>)
+            if (a.unique())
+                return array_type(std::move(a));
+        if constexpr (expiring_<B>)
+            if (b.unique())
+                return array_type(std::move(b));
+        if constexpr (is_array_<A>)
+            return array_type(a.shape());
+        else
+            return array_type(b.shape());
+    }
+
+    template<class A, class B, class Function>
+    auto elementwise_(A &&a, B &&b, Function fn, const char *name) {
+        using T = typename std::remove_cvref_t<std::conditional_t<is_array_<A>, A, B>>::value_type;
+        if constexpr (is_array_<A> && is_array_<B>)
+            if (!std::equal(a.shape().begin(), a.shape().end(), b.shape().begin(), b.shape().end()))
+                throw std::runtime_error(std::string(name) + "(): shapes do not match");
+        // taken before output_ may move a buffer away; the pointers stay valid in the result
+        auto pa = operand_<T>(std::as_const(a));
+        auto pb = operand_<T>(std::as_const(b));
+        auto out = output_<A, B>(a, b);
+        transform_(out.data(), out.size(), pa, pb, fn);
+        return out;
+    }
+
+    template<class A, class Function>
+    auto map_(A &&a, Function fn) {
+        using T = typename std::remove_cvref_t<A>::value_type;
+        const T *pa = std::as_const(a).data();
+        int none = 0;
+        auto out = output_<A, int>(a, none);
+        transform_(out.data(), out.size(), pa, fn);
+        return out;
+    }
+
+    // in place, so views of a see the result
+    template<class A, class B, class Function>
+    A &update_(A &a, const B &b, Function fn, const char *name) {
+        using T = typename A::value_type;
+        if constexpr (is_array_<B>)
+            if (!std::equal(a.shape().begin(), a.shape().end(), b.shape().begin(), b.shape().end()))
+                throw std::runtime_error(std::string(name) + "(): shapes do not match");
+        auto pb = operand_<T>(b);
+        T *out = a.data();
+        transform_(out, a.size(), static_cast<const T *>(out), pb, fn);
+        return a;
+    }
+
+    template<class A, class B>
+    requires operands_<A, B>::value
+    auto operator+(A &&a, B &&b) {
+        return elementwise_(std::forward<A>(a), std::forward<B>(b), std::plus<>(), "operator+");
+    }
+
+    template<class A, class B>
+    requires operands_<A, B>::value
+    auto operator-(A &&a, B &&b) {
+        return elementwise_(std::forward<A>(a), std::forward<B>(b), std::minus<>(), "operator-");
+    }
+
+    template<class A, class B>
+    requires operands_<A, B>::value
+    auto operator*(A &&a, B &&b) {
+        return elementwise_(std::forward<A>(a), std::forward<B>(b), std::multiplies<>(), "operator*");
+    }
+
+    template<class A, class B>
+    requires operands_<A, B>::value
+    auto operator/(A &&a, B &&b) {
+        return elementwise_(std::forward<A>(a), std::forward<B>(b), std::divides<>(), "operator/");
+    }
+
+    template<class A>
+    requires is_array_<A>
+    auto operator-(A &&a) {
+        return map_(std::forward<A>(a), std::negate<>());
+    }
+
+    template<class A, class B>
+    requires (operands_<A &, B>::value && !std::is_const_v<A>)
+    A &operator+=(A &a, const B &b) {
+        return update_(a, b, std::plus<>(), "operator+=");
+    }
+
+    template<class A, class B>
+    requires (operands_<A &, B>::value && !std::is_const_v<A>)
+    A &operator-=(A &a, const B &b) {
+        return update_(a, b, std::minus<>(), "operator-=");
+    }
+
+    template<class A, class B>
+    requires (operands_<A &, B>::value && !std::is_const_v<A>)
+    A &operator*=(A &a, const B &b) {
+        return update_(a, b, std::multiplies<>(), "operator*=");
+    }
+
+    template<class A, class B>
+    requires (operands_<A &, B>::value && !std::is_const_v<A>)
+    A &operator/=(A &a, const B &b) {
+        return update_(a, b, std::divides<>(), "operator/=");
+    }
+
+    template<class A>
+    requires is_array_<A>
+    auto abs(A &&a) {
+        using T = typename std::remove_cvref_t<A>::value_type;
+        return map_(std::forward<A>(a), [](const T &x) {
+            if constexpr (std::is_unsigned_v<T>)
+                return x;
+            else
+                return T(std::abs(x));
+        });
+    }
+
+    template<class A>
+    requires is_array_<A>
+    auto sqrt(A &&a) {
+        return map_(std::forward<A>(a), [](const auto &x) { return std::sqrt(x); });
+    }
+
+    template<class A>
+    requires is_array_<A>
+    auto exp(A &&a) {
+        return map_(std::forward<A>(a), [](const auto &x) { return std::exp(x); });
+    }
+
+    template<class A>
+    requires is_array_<A>
+    auto log(A &&a) {
+        return map_(std::forward<A>(a), [](const auto &x) { return std::log(x); });
+    }
+
+    template<class A>
+    requires is_array_<A>
+    auto sin(A &&a) {
+        return map_(std::forward<A>(a), [](const auto &x) { return std::sin(x); });
+    }
+
+    template<class A>
+    requires is_array_<A>
+    auto cos(A &&a) {
+        return map_(std::forward<A>(a), [](const auto &x) { return std::cos(x); });
+    }
+
+    template<class A>
+    requires is_array_<A>
+    auto tanh(A &&a) {
+        return map_(std::forward<A>(a), [](const auto &x) { return std::tanh(x); });
+    }
+
+    template<class A, class B>
+    requires operands_<A, B>::value
+    auto pow(A &&a, B &&b) {
+        return elementwise_(std::forward<A>(a), std::forward<B>(b),
+                            [](const auto &x, const auto &y) { return std::pow(x, y); }, "pow");
+    }
+
+    // like numpy.maximum and numpy.minimum, NaN in either operand propagates
+    template<class A, class B>
+    requires operands_<A, B>::value
+    auto maximum(A &&a, B &&b) {
+        return elementwise_(std::forward<A>(a), std::forward<B>(b),
+                            [](const auto &x, const auto &y) { return y < x || x != x ? x : y; }, "maximum");
+    }
+
+    template<class A, class B>
+    requires operands_<A, B>::value
+    auto minimum(A &&a, B &&b) {
+        return elementwise_(std::forward<A>(a), std::forward<B>(b),
+                            [](const auto &x, const auto &y) { return x < y || x != x ? x : y; }, "minimum");
+    }
+
+}
@@ -0,0 +1,221 @@
+#pragma once
+
+#include <algorithm>    // min, sort
+#include <array>
+#include <chrono>       // steady_clock
+#include <cstdint>      // uint32_t, uint64_t
+#include <filesystem>   // create_directories, resize_file
+#include <fstream>      // fstream, ofstream
+#include <numeric>      // iota
+#include <stdexcept>    // runtime_error
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include "checksum.hpp"
+#include "ndarray.hpp"
+#include "npy.hpp"
+#include "npz.hpp"
+#include "parallel.hpp"
+
+#if __has_include(<fcntl.h>) && __has_include(<unistd.h>)
+#include <fcntl.h>      // open, posix_fallocate
+#include <unistd.h>     // close
+#define CNUMPY_HAS_FALLOCATE 1
+#endif
+
+namespace cnumpy {
+
+    struct batch_stats {
+        size_t files{};
+        size_t bytes{};
+        double seconds{};
+
+        // bytes per second
+        [[nodiscard]] double throughput() const noexcept { return seconds > 0 ? double(bytes) / seconds : 0; }
+    };
+
+    // Collects (name, array) pairs and writes all of them at once, either as one .npy file per array or as members of
+    // a single uncompressed .npz archive. Files are preallocated and written concurrently by a bounded number of
+    // threads. Arrays are not copied; they must stay alive and unmodified until save() or savez() returns.
+    class NPYBatch {
+    public:
+        explicit NPYBatch(size_t nthreads = 0) : nthreads_(nthreads) {}
+
+        template<class NDArray>
+        void add(const std::string &name, const NDArray &arr, std::array<char, 2> version = {0, 0}) {
+            if (name.empty() || names_.count(name))
+                throw std::runtime_error("NPYBatch::add(): empty or duplicate name");
+            entries_.push_back({name, NPY::header(arr, version), (const char *) arr.data(),
+                                arr.size() * sizeof(typename NDArray::value_type)});
+            names_.insert(name);
+        }
+
+        [[nodiscard]] size_t size() const noexcept { return entries_.size(); }
+
+        void clear() noexcept {
+            entries_.clear();
+            names_.clear();
+        }
+
+        // writes each array to directory/<name>.npy
+        batch_stats save(const std::string &directory) const {
+            auto start = std::chrono::steady_clock::now();
+            std::filesystem::path dir(directory);
+            std::filesystem::create_directories(dir);
+
+            std::vector<std::string> paths;
+            paths.reserve(entries_.size());
+            for (const auto &entry : entries_) {
+                auto path = dir / (entry.name + ".npy");
+                std::filesystem::create_directories(path.parent_path());
+                paths.push_back(path.string());
+            }
+
+            batch_stats stats;
+            auto order = largest_first_();
+            parallel_for(0, order.size(), 1, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; i++) {
+                    const auto &entry = entries_[order[i]];
+                    size_t bytes = entry.header.length() + entry.size;
+                    preallocate_(paths[order[i]], bytes);
+                    std::fstream fstrm(paths[order[i]], std::ios::binary | std::ios::in | std::ios::out);
+                    if (fstrm.fail())
+                        throw std::runtime_error("NPYBatch::save(): can't open file");
+                    write_(fstrm, entry.header.c_str(), entry.header.length());
+                    write_(fstrm, entry.data, entry.size);
+                }
+            }, nthreads_);
+
+            stats.files = entries_.size();
+            for (const auto &entry : entries_)
+                stats.bytes += entry.header.length() + entry.size;
+            stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            return stats;
+        }
+
+        // writes all arrays as stored (uncompressed) members <name>.npy of a zip archive readable by numpy.load()
+        batch_stats savez(const std::string &filename) const {
+            auto start = std::chrono::steady_clock::now();
+
+            // Member offsets only depend on the names and sizes, so the whole layout is fixed before any data is
+            // written and every member can be written independently.
+            size_t n = entries_.size();
+            std::vector<uint64_t> offsets(n);
+            std::vector<bool> zip64(n);
+            uint64_t offset = 0;
+            for (size_t i = 0; i < n; i++) {
+                uint64_t bytes = bytes_(entries_[i]);
+                offsets[i] = offset;
+                zip64[i] = bytes >= 0xFFFFFFFF || offset >= 0xFFFFFFFF;
+                offset += 30 + entries_[i].name.length() + 4 + (zip64[i] ? 20 : 0) + bytes;
+            }
+
+            std::vector<uint32_t> crcs(n);
+            std::string central;
+            uint64_t central_offset = offset;
+            for (size_t i = 0; i < n; i++)
+                central += zip_::central_header(entries_[i].name + ".npy", bytes_(entries_[i]), 0, offsets[i],
+                                                zip64[i]);
+            std::string records = zip_::end_records(n, central.length(), central_offset);
+            uint64_t total = central_offset + central.length() + records.length();
+
+            preallocate_(filename, total);
+            auto order = largest_first_();
+            parallel_for(0, order.size(), 1, [&](size_t begin, size_t end) {
+                std::fstream fstrm(filename, std::ios::binary | std::ios::in | std::ios::out);
+                if (fstrm.fail())
+                    throw std::runtime_error("NPYBatch::savez(): can't open file");
+                for (size_t i = begin; i < end; i++) {
+                    size_t idx = order[i];
+                    const auto &entry = entries_[idx];
+
+                    // write the member data first so its CRC-32 is accumulated while the bytes are hot in cache
+                    std::string local = zip_::local_header(entry.name + ".npy", bytes_(entry), 0, zip64[idx]);
+                    fstrm.seekp(std::streamoff(offsets[idx] + local.length()));
+                    uint32_t crc = crc32(0, entry.header.c_str(), entry.header.length());
+                    write_(fstrm, entry.header.c_str(), entry.header.length());
+                    for (size_t pos = 0; pos < entry.size; pos += chunk_) {
+                        size_t len = std::min(chunk_, entry.size - pos);
+                        crc = crc32(crc, entry.data + pos, len);
+                        write_(fstrm, entry.data + pos, len);
+                    }
+                    crcs[idx] = crc;
+
+                    local = zip_::local_header(entry.name + ".npy", bytes_(entry), crc, zip64[idx]);
+                    fstrm.seekp(std::streamoff(offsets[idx]));
+                    write_(fstrm, local.c_str(), local.length());
+                }
+            }, nthreads_);
+
+            central.clear();
+            for (size_t i = 0; i < n; i++)
+                central += zip_::central_header(entries_[i].name + ".npy", bytes_(entries_[i]), crcs[i], offsets[i],
+                                                zip64[i]);
+            std::fstream fstrm(filename, std::ios::binary | std::ios::in | std::ios::out);
+            if (fstrm.fail())
+                throw std::runtime_error("NPYBatch::savez(): can't open file");
+            fstrm.seekp(std::streamoff(central_offset));
+            write_(fstrm, central.c_str(), central.length());
+            write_(fstrm, records.c_str(), records.length());
+            fstrm.close();
+
+            batch_stats stats;
+            stats.files = 1;
+            stats.bytes = total;
+            stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            return stats;
+        }
+
+    private:
+        struct entry_type_ {
+            std::string name;
+            std::string header;
+            const char *data;
+            size_t size;
+        };
+
+        // schedule the largest arrays first so that a single big array does not end up last on one thread
+        [[nodiscard]] std::vector<size_t> largest_first_() const {
+            std::vector<size_t> order(entries_.size());
+            std::iota(order.begin(), order.end(), size_t(0));
+            std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+                return entries_[a].size > entries_[b].size;
+            });
+            return order;
+        }
+
+        [[nodiscard]] static uint64_t bytes_(const entry_type_ &entry) { return entry.header.length() + entry.size; }
+
+        static void write_(std::fstream &fstrm, const char *data, size_t size) {
+            if (fstrm.write(data, std::streamsize(size)).fail())
+                throw std::runtime_error("NPYBatch: failed write");
+        }
+
+        // Creates or truncates the file and reserves size bytes of disk space for it.
+        static void preallocate_(const std::string &filename, uint64_t size) {
+#ifdef CNUMPY_HAS_FALLOCATE
+            int fd = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+            if (fd < 0)
+                throw std::runtime_error("NPYBatch: can't open file");
+            int err = size ? ::posix_fallocate(fd, 0, off_t(size)) : 0;
+            ::close(fd);
+            if (err == 0)
+                return;
+#else
+            std::ofstream ofstrm(filename, std::ios::binary | std::ios::trunc);
+            if (ofstrm.fail())
+                throw std::runtime_error("NPYBatch: can't open file");
+            ofstrm.close();
+#endif
+            // the file system can't reserve space, at least fix the final size
+            std::filesystem::resize_file(filename, size);
+        }
+
+        inline static const size_t chunk_ = size_t(1) << 20;
+
+        std::vector<entry_type_> entries_;
+        std::unordered_set<std::string> names_;
+        size_t nthreads_;
+    };
+
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <cstddef>      // size_t
+#include <list>
+#include <stdexcept>    // runtime_error
+#include <string>
+#include <unordered_map>
+#include <utility>      // move
+#include <vector>
+
+namespace cnumpy {
+
+    // Helpers for the containers that keep an array as separately stored blocks (chunked_array, compressed_array):
+    // boxes of the array, walks over them, and a cache of decoded blocks.
+
+    // The number of elements along each axis of the box [start, stop) of an array of the given shape.
+    inline std::vector<size_t> region_extent_(const std::vector<size_t> &shape, const std::vector<size_t> &start,
+                                              const std::vector<size_t> &stop, const std::string &name) {
+        if (start.size() != shape.size() || stop.size() != shape.size())
+            throw std::runtime_error(name + ": dimensions do not match");
+        std::vector<size_t> count(shape.size());
+        for (size_t d = 0; d < shape.size(); d++) {
+            if (start[d] > stop[d] || stop[d] > shape[d])
+                throw std::runtime_error(name + ": region out of bounds");
+            count[d] = stop[d] - start[d];
+        }
+        return count;
+    }
+
+    // The box that an array of shape count fills when written at start, checked against shape.
+    template<class Container>
+    std::vector<size_t> region_count_(const std::vector<size_t> &shape, const std::vector<size_t> &start,
+                                      const Container &count, const std::string &name) {
+        if (count.size() != shape.size() || start.size() != shape.size())
+            throw std::runtime_error(name + ": dimensions do not match");
+        std::vector<size_t> stop(start);
+        for (size_t d = 0; d < shape.size(); d++)
+            stop[d] += count[d];
+        return region_extent_(shape, start, stop, name);
+    }
+
+    // Calls fn(index) for every index in [lo, hi) over the first axes axes, in C order; the other entries of index
+    // stay at lo. lo must be below hi along those axes.
+    template<class Fn>
+    void for_each_index_(const std::vector<size_t> &lo, const std::vector<size_t> &hi, size_t axes, Fn fn) {
+        std::vector<size_t> index(lo);
+        while (true) {
+            fn(static_cast<const std::vector<size_t> &>(index));
+            size_t d = axes;
+            while (d-- > 0 && ++index[d] == hi[d])
+                index[d] = lo[d];
+            if (d == size_t(-1))
+                break;
+        }
+    }
+
+    // An LRU cache of decoded blocks, keyed by block number and bounded to capacity bytes of entry_bytes each (but
+    // holding at least one). Dirty blocks are handed back to be stored when evicted and on flush().
+    template<class Value>
+    class lru_cache_ {
+    public:
+        lru_cache_() = default;
+
+        lru_cache_(size_t capacity, size_t entry_bytes) : capacity_(capacity), entry_bytes_(entry_bytes) {}
+
+        [[nodiscard]] size_t hits() const noexcept { return hits_; }
+
+        [[nodiscard]] size_t misses() const noexcept { return misses_; }
+
+        // the cached block or nullptr, without counting an access
+        [[nodiscard]] const Value *find(size_t key) const {
+            auto it = entries_.find(key);
+            return it == entries_.end() ? nullptr : &it->second.value;
+        }
+
+        // Returns block key, marking it dirty if asked. On a miss, least recently used blocks are evicted to make
+        // room, dirty ones after store(key, value), and the block is read with load(key).
+        template<class Load, class Store>
+        Value &get(size_t key, bool dirty, Load load, Store store) {
+            auto it = entries_.find(key);
+            if (it != entries_.end()) {
+                hits_++;
+                lru_.splice(lru_.begin(), lru_, it->second.lru);
+                it->second.dirty |= dirty;
+                return it->second.value;
+            }
+
+            misses_++;
+            while (!lru_.empty() && (entries_.size() + 1) * entry_bytes_ > capacity_) {
+                auto victim = entries_.find(lru_.back());
+                if (victim->second.dirty)
+                    store(victim->first, victim->second.value);
+                entries_.erase(victim);
+                lru_.pop_back();
+            }
+
+            Value value = load(key);
+            lru_.push_front(key);
+            auto &entry = entries_[key];
+            entry.value = std::move(value);
+            entry.dirty = dirty;
+            entry.lru = lru_.begin();
+            return entry.value;
+        }
+
+        // calls store(key, value) for every dirty block, which is clean afterwards
+        template<class Store>
+        void flush(Store store) {
+            for (auto &[key, entry]: entries_) {
+                if (entry.dirty) {
+                    store(key, entry.value);
+                    entry.dirty = false;
+                }
+            }
+        }
+
+        void clear() noexcept {
+            entries_.clear();
+            lru_.clear();
+        }
+
+    private:
+        struct entry_type_ {
+            Value value;
+            bool dirty;
+            std::list<size_t>::iterator lru;
+        };
+
+        size_t capacity_{}, entry_bytes_{};
+        std::unordered_map<size_t, entry_type_> entries_;
+        std::list<size_t> lru_;
+        size_t hits_{}, misses_{};
+    };
+
+}
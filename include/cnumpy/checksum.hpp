@@ -0,0 +1,211 @@
+#pragma once
+
+#include <algorithm>    // min
+#include <array>
+#include <cstddef>      // size_t
+#include <cstdint>      // uint32_t, uint64_t
+#include <cstring>      // memcpy
+#include <vector>
+#include "parallel.hpp"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>  // _mm_clmulepi64_si128, _mm_crc32_u64
+#endif
+
+// CRC-32 (zip, zlib, PNG) and CRC-32C (Castagnoli, iSCSI, ext4), compatible with zlib.crc32 and the usual crc32c
+// libraries: pass the CRC of the preceding data, or 0 to start. On x86-64 they use PCLMULQDQ and SSE4.2 when the CPU
+// has them, otherwise slicing-by-8 tables. Large inputs are split into chunks checksummed in parallel, whose CRCs are
+// then combined.
+namespace cnumpy {
+
+    inline constexpr uint32_t crc32_polynomial = 0xEDB88320;     // both reflected
+    inline constexpr uint32_t crc32c_polynomial = 0x82F63B78;
+
+    template<uint32_t Poly>
+    struct crc_ {
+        static constexpr auto tables = []() {
+            std::array<std::array<uint32_t, 256>, 8> t{};
+            for (uint32_t i = 0; i < 256; i++) {
+                uint32_t c = i;
+                for (int k = 0; k < 8; k++)
+                    c = c & 1 ? Poly ^ (c >> 1) : c >> 1;
+                t[0][i] = c;
+            }
+            for (size_t k = 1; k < 8; k++)
+                for (size_t i = 0; i < 256; i++)
+                    t[k][i] = (t[k - 1][i] >> 8) ^ t[0][t[k - 1][i] & 255];
+            return t;
+        }();
+
+        // slicing-by-8 on the inverted state
+        static uint32_t software(uint32_t state, const unsigned char *p, size_t size) noexcept {
+            for (; size >= 8; p += 8, size -= 8) {
+                uint32_t lo = (p[0] | p[1] << 8 | p[2] << 16 | uint32_t(p[3]) << 24) ^ state;
+                state = tables[7][lo & 255] ^ tables[6][lo >> 8 & 255] ^ tables[5][lo >> 16 & 255] ^
+                        tables[4][lo >> 24] ^ tables[3][p[4]] ^ tables[2][p[5]] ^ tables[1][p[6]] ^ tables[0][p[7]];
+            }
+            for (; size; p++, size--)
+                state = tables[0][(state ^ *p) & 255] ^ (state >> 8);
+            return state;
+        }
+
+        // a * b modulo the polynomial, both representing polynomials with x^0 in the top bit
+        static constexpr uint32_t multiply(uint32_t a, uint32_t b) noexcept {
+            uint32_t product = 0;
+            for (uint32_t m = uint32_t(1) << 31; m; m >>= 1) {
+                if (a & m)
+                    product ^= b;
+                b = b & 1 ? (b >> 1) ^ Poly : b >> 1;
+            }
+            return product;
+        }
+
+        // x^(8 * bytes) modulo the polynomial, by squaring
+        static constexpr uint32_t shift(uint64_t bytes) noexcept {
+            uint32_t power = uint32_t(1) << 23, result = uint32_t(1) << 31;    // x^8, 1
+            for (; bytes; bytes >>= 1) {
+                if (bytes & 1)
+                    result = multiply(power, result);
+                power = multiply(power, power);
+            }
+            return result;
+        }
+
+        // CRC of the concatenation of two blocks, the second one len2 bytes long
+        static constexpr uint32_t combine(uint32_t crc1, uint32_t crc2, uint64_t len2) noexcept {
+            return multiply(shift(len2), crc1) ^ crc2;
+        }
+    };
+
+#if defined(__x86_64__) && defined(__GNUC__)
+
+    __attribute__((target("sse4.2,pclmul")))
+    inline __m128i crc_fold_(__m128i x, __m128i k, __m128i next) noexcept {
+        return _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x, k, 0x00), _mm_clmulepi64_si128(x, k, 0x11)), next);
+    }
+
+    // Folds 64-byte blocks with carry-less multiplication, then reduces to 32 bits (Intel, "Fast CRC Computation for
+    // Generic Polynomials Using PCLMULQDQ Instruction"). Needs size >= 64 and a multiple of 16, works on the inverted
+    // state.
+    __attribute__((target("sse4.2,pclmul")))
+    inline uint32_t crc32_pclmul_(uint32_t state, const unsigned char *p, size_t size) noexcept {
+        alignas(16) static const uint64_t k1k2[] = {0x0154442bd4, 0x01c6e41596};
+        alignas(16) static const uint64_t k3k4[] = {0x01751997d0, 0x00ccaa009e};
+        alignas(16) static const uint64_t k5k0[] = {0x0163cd6124, 0x0000000000};
+        alignas(16) static const uint64_t poly[] = {0x01db710641, 0x01f7011641};
+        auto load = [](const unsigned char *q) { return _mm_loadu_si128(reinterpret_cast<const __m128i *>(q)); };
+
+        __m128i x1 = _mm_xor_si128(load(p), _mm_cvtsi32_si128(int(state)));
+        __m128i x2 = load(p + 16), x3 = load(p + 32), x4 = load(p + 48);
+        __m128i k = _mm_load_si128(reinterpret_cast<const __m128i *>(k1k2));
+        for (p += 64, size -= 64; size >= 64; p += 64, size -= 64) {
+            x1 = crc_fold_(x1, k, load(p));
+            x2 = crc_fold_(x2, k, load(p + 16));
+            x3 = crc_fold_(x3, k, load(p + 32));
+            x4 = crc_fold_(x4, k, load(p + 48));
+        }
+
+        k = _mm_load_si128(reinterpret_cast<const __m128i *>(k3k4));
+        x1 = crc_fold_(x1, k, x2);
+        x1 = crc_fold_(x1, k, x3);
+        x1 = crc_fold_(x1, k, x4);
+        for (; size >= 16; p += 16, size -= 16)
+            x1 = crc_fold_(x1, k, load(p));
+
+        // 128 to 64 bits, then Barrett reduction to 32
+        __m128i mask = _mm_setr_epi32(~0, 0, ~0, 0);
+        x2 = _mm_clmulepi64_si128(x1, k, 0x10);
+        x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+        k = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(k5k0));
+        x2 = _mm_srli_si128(x1, 4);
+        x1 = _mm_xor_si128(_mm_clmulepi64_si128(_mm_and_si128(x1, mask), k, 0x00), x2);
+        k = _mm_load_si128(reinterpret_cast<const __m128i *>(poly));
+        x2 = _mm_and_si128(_mm_clmulepi64_si128(_mm_and_si128(x1, mask), k, 0x10), mask);
+        x2 = _mm_clmulepi64_si128(x2, k, 0x00);
+        return uint32_t(_mm_extract_epi32(_mm_xor_si128(x1, x2), 1));
+    }
+
+    __attribute__((target("sse4.2")))
+    inline uint32_t crc32c_sse42_(uint32_t state, const unsigned char *p, size_t size) noexcept {
+        uint64_t c = state;
+        for (; size >= 8; p += 8, size -= 8) {
+            uint64_t word;
+            std::memcpy(&word, p, 8);
+            c = _mm_crc32_u64(c, word);
+        }
+        state = uint32_t(c);
+        for (; size; p++, size--)
+            state = _mm_crc32_u8(state, *p);
+        return state;
+    }
+
+    inline bool has_pclmul_() noexcept {
+        static const bool has = __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("sse4.2");
+        return has;
+    }
+
+    inline bool has_sse42_() noexcept {
+        static const bool has = __builtin_cpu_supports("sse4.2");
+        return has;
+    }
+
+#endif
+
+    // the inverted state after size bytes on the calling thread
+    template<uint32_t Poly>
+    uint32_t crc_serial_(uint32_t state, const unsigned char *p, size_t size) noexcept {
+#if defined(__x86_64__) && defined(__GNUC__)
+        if constexpr (Poly == crc32_polynomial) {
+            if (size >= 64 && has_pclmul_()) {
+                size_t folded = size & ~size_t(15);
+                state = crc32_pclmul_(state, p, folded);
+                p += folded;
+                size -= folded;
+            }
+        } else if constexpr (Poly == crc32c_polynomial) {
+            if (has_sse42_())
+                return crc32c_sse42_(state, p, size);
+        }
+#endif
+        return crc_<Poly>::software(state, p, size);
+    }
+
+    inline constexpr size_t crc_chunk_ = size_t(1) << 20;
+
+    template<uint32_t Poly>
+    uint32_t crc_parallel_(uint32_t crc, const void *data, size_t size) {
+        auto p = static_cast<const unsigned char *>(data);
+        size_t nchunks = (size + crc_chunk_ - 1) / crc_chunk_;
+        if (nchunks < 4 || get_num_threads() == 1)
+            return ~crc_serial_<Poly>(~crc, p, size);
+
+        std::vector<uint32_t> crcs(nchunks);
+        parallel_for(0, nchunks, 1, [&](size_t begin, size_t end) {
+            for (size_t c = begin; c < end; c++) {
+                size_t len = std::min(crc_chunk_, size - c * crc_chunk_);
+                crcs[c] = ~crc_serial_<Poly>(~uint32_t(0), p + c * crc_chunk_, len);
+            }
+        });
+        for (size_t c = 0; c < nchunks; c++)
+            crc = crc_<Poly>::combine(crc, crcs[c], std::min(crc_chunk_, size - c * crc_chunk_));
+        return crc;
+    }
+
+    inline uint32_t crc32(uint32_t crc, const void *data, size_t size) {
+        return crc_parallel_<crc32_polynomial>(crc, data, size);
+    }
+
+    inline uint32_t crc32c(uint32_t crc, const void *data, size_t size) {
+        return crc_parallel_<crc32c_polynomial>(crc, data, size);
+    }
+
+    // The CRC of two consecutive blocks from their CRCs and the length of the second, like zlib's crc32_combine.
+    inline constexpr uint32_t crc32_combine(uint32_t crc1, uint32_t crc2, uint64_t len2) noexcept {
+        return crc_<crc32_polynomial>::combine(crc1, crc2, len2);
+    }
+
+    inline constexpr uint32_t crc32c_combine(uint32_t crc1, uint32_t crc2, uint64_t len2) noexcept {
+        return crc_<crc32c_polynomial>::combine(crc1, crc2, len2);
+    }
+
+}
@@ -0,0 +1,296 @@
+#pragma once
+
+#include <algorithm>    // fill, find, max, min
+#include <cstring>      // memcpy
+#include <filesystem>   // create_directories, exists
+#include <functional>   // multiplies
+#include <numeric>      // accumulate
+#include <stdexcept>    // runtime_error
+#include <string>
+#include <type_traits>  // conditional_t
+#include <utility>      // move
+#include <vector>
+#include "block_cache.hpp"
+#include "ndarray.hpp"
+#include "npy.hpp"
+
+namespace cnumpy {
+
+    // An N-dimensional array stored on disk as fixed-shape tiles, for data sets larger than memory. Each tile is a
+    // .npy file c.<i>.<j>...npy in a directory next to meta.npy, which holds the array shape and the tile shape; tiles
+    // that were never written read as zeros. Tiles are accessed through an LRU cache bounded to cache_bytes, and dirty
+    // tiles are written back when evicted, on flush() and on destruction. Not thread-safe.
+    template<class T>
+    class chunked_array {
+    public:
+        using value_type = T;
+
+        inline static const size_t default_cache_bytes = size_t(256) << 20;
+
+        // creates a new array, tiles of an earlier array in the same directory are discarded
+        chunked_array(const std::string &directory, const std::vector<size_t> &shape, const std::vector<size_t> &chunks,
+                      size_t cache_bytes = default_cache_bytes) :
+                directory_(directory), shape_(shape), chunks_(chunks), cache_bytes_(cache_bytes) {
+            if (shape_.empty() || shape_.size() != chunks_.size())
+                throw std::runtime_error("chunked_array::chunked_array(): dimensions do not match");
+            if (std::find(chunks_.begin(), chunks_.end(), size_t(0)) != chunks_.end())
+                throw std::runtime_error("chunked_array::chunked_array(): empty chunks");
+            std::filesystem::create_directories(directory_);
+            for (const auto &file : std::filesystem::directory_iterator(directory_))
+                if (file.path().filename().string().starts_with("c."))
+                    std::filesystem::remove(file.path());
+
+            ndarray<unsigned long long, 2> meta(2, shape_.size());
+            for (size_t d = 0; d < shape_.size(); d++) {
+                meta(0, d) = shape_[d];
+                meta(1, d) = chunks_[d];
+            }
+            NPY npy(meta_path_(), 'w');
+            npy.save(meta);
+            npy.close();
+            init_();
+        }
+
+        // opens an existing array
+        explicit chunked_array(const std::string &directory, size_t cache_bytes = default_cache_bytes) :
+                directory_(directory), cache_bytes_(cache_bytes) {
+            NPY npy(meta_path_(), 'r');
+            auto meta = npy.load<unsigned long long>();
+            npy.close();
+            if (meta.ndim() != 2 || meta.shape()[0] != 2 || meta.shape()[1] == 0)
+                throw std::runtime_error("chunked_array::chunked_array(): malformed meta.npy");
+            for (size_t d = 0; d < meta.shape()[1]; d++) {
+                shape_.push_back(meta(0, d));
+                chunks_.push_back(meta(1, d));
+            }
+            init_();
+        }
+
+        chunked_array(const chunked_array &) = delete;
+
+        chunked_array(chunked_array &&) noexcept = default;
+
+        chunked_array &operator=(const chunked_array &) = delete;
+
+        // writes back the dirty tiles of this array before taking over other
+        chunked_array &operator=(chunked_array &&other) {
+            if (this != &other) {
+                flush();
+                directory_ = std::move(other.directory_);
+                shape_ = std::move(other.shape_);
+                chunks_ = std::move(other.chunks_);
+                grid_ = std::move(other.grid_);
+                cache_bytes_ = other.cache_bytes_;
+                tiles_ = std::move(other.tiles_);
+                other.tiles_.clear();
+            }
+            return *this;
+        }
+
+        ~chunked_array() {
+            try {
+                flush();
+            } catch (...) {
+            }
+        }
+
+        [[nodiscard]] const std::vector<size_t> &shape() const noexcept { return shape_; }
+
+        [[nodiscard]] const std::vector<size_t> &chunks() const noexcept { return chunks_; }
+
+        [[nodiscard]] size_t ndim() const noexcept { return shape_.size(); }
+
+        [[nodiscard]] size_t size() const noexcept {
+            return std::accumulate(shape_.begin(), shape_.end(), size_t(1), std::multiplies<>());
+        }
+
+        [[nodiscard]] size_t hits() const noexcept { return tiles_.hits(); }
+
+        [[nodiscard]] size_t misses() const noexcept { return tiles_.misses(); }
+
+        // Reads the box [start, stop) into a new array, fetching only the tiles it touches.
+        ndarray<value_type> read(const std::vector<size_t> &start, const std::vector<size_t> &stop) {
+            std::vector<size_t> count = region_extent_(shape_, start, stop, "chunked_array::read()");
+            ndarray<value_type> arr(count);
+            copy_region_<false>(start, count, arr.data());
+            return arr;
+        }
+
+        // Writes arr into the box starting at start.
+        template<class Container>
+        void write(const std::vector<size_t> &start, const ndarray_impl<value_type, Container> &arr) {
+            std::vector<size_t> count = region_count_(shape_, start, arr.shape(), "chunked_array::write()");
+            copy_region_<true>(start, count, arr.data());
+        }
+
+        value_type get(const std::vector<size_t> &index) {
+            size_t offset;
+            return tile_(locate_(index, offset), false).data()[offset];
+        }
+
+        void set(const std::vector<size_t> &index, const value_type &value) {
+            size_t offset;
+            tile_(locate_(index, offset), true).data()[offset] = value;
+        }
+
+        // writes all dirty tiles back to disk
+        void flush() {
+            tiles_.flush([this](size_t key, const ndarray<value_type> &data) { save_tile_(key, data); });
+        }
+
+        // A window [start, stop) of a chunked_array with local indices; tiles are fetched as elements are accessed.
+        class view {
+        public:
+            view(chunked_array &arr, std::vector<size_t> start, std::vector<size_t> stop) :
+                    arr_(&arr), start_(std::move(start)),
+                    shape_(region_extent_(arr.shape_, start_, stop, "chunked_array::slice()")) {}
+
+            [[nodiscard]] const std::vector<size_t> &shape() const noexcept { return shape_; }
+
+            template<typename... Ints>
+            value_type operator()(Ints... ints) const {
+                return arr_->get(global_({size_t(ints)...}));
+            }
+
+            template<typename... Ints>
+            void set(const value_type &value, Ints... ints) const {
+                arr_->set(global_({size_t(ints)...}), value);
+            }
+
+            // copies the whole window into memory
+            [[nodiscard]] ndarray<value_type> read() const {
+                std::vector<size_t> stop(start_);
+                for (size_t d = 0; d < stop.size(); d++)
+                    stop[d] += shape_[d];
+                return arr_->read(start_, stop);
+            }
+
+        private:
+            [[nodiscard]] std::vector<size_t> global_(std::vector<size_t> index) const {
+                if (index.size() != shape_.size())
+                    throw std::runtime_error("chunked_array::view: wrong number of indices");
+                for (size_t d = 0; d < index.size(); d++) {
+                    if (index[d] >= shape_[d])
+                        throw std::runtime_error("chunked_array::view: index out of bounds");
+                    index[d] += start_[d];
+                }
+                return index;
+            }
+
+            chunked_array *arr_;
+            std::vector<size_t> start_, shape_;
+        };
+
+        view slice(const std::vector<size_t> &start, const std::vector<size_t> &stop) {
+            return view(*this, start, stop);
+        }
+
+    private:
+        void init_() {
+            grid_.resize(shape_.size());
+            for (size_t d = 0; d < shape_.size(); d++)
+                grid_[d] = (shape_[d] + chunks_[d] - 1) / chunks_[d];
+            size_t tile_bytes = std::accumulate(chunks_.begin(), chunks_.end(), size_t(1), std::multiplies<>()) *
+                                sizeof(value_type);
+            tiles_ = lru_cache_<ndarray<value_type>>(cache_bytes_, tile_bytes);
+        }
+
+        [[nodiscard]] std::string meta_path_() const {
+            return (std::filesystem::path(directory_) / "meta.npy").string();
+        }
+
+        [[nodiscard]] std::string tile_path_(size_t key) const {
+            std::string name;
+            for (size_t d = shape_.size(); d-- > 0;) {
+                name.insert(0, "." + std::to_string(key % grid_[d]));
+                key /= grid_[d];
+            }
+            return (std::filesystem::path(directory_) / ("c" + name + ".npy")).string();
+        }
+
+        // returns the key of the tile holding index and the offset of the element within it
+        size_t locate_(const std::vector<size_t> &index, size_t &offset) const {
+            if (index.size() != shape_.size())
+                throw std::runtime_error("chunked_array: wrong number of indices");
+            size_t key = 0;
+            offset = 0;
+            for (size_t d = 0; d < shape_.size(); d++) {
+                if (index[d] >= shape_[d])
+                    throw std::runtime_error("chunked_array: index out of bounds");
+                key = key * grid_[d] + index[d] / chunks_[d];
+                offset = offset * chunks_[d] + index[d] % chunks_[d];
+            }
+            return key;
+        }
+
+        void save_tile_(size_t key, const ndarray<value_type> &data) const {
+            NPY npy(tile_path_(key), 'w');
+            npy.save(data);
+            npy.close();
+        }
+
+        ndarray<value_type> &tile_(size_t key, bool dirty) {
+            auto load = [this](size_t key) {
+                std::string path = tile_path_(key);
+                if (!std::filesystem::exists(path)) {
+                    ndarray<value_type> data(chunks_);
+                    std::fill(data.data(), data.data() + data.size(), value_type());
+                    return data;
+                }
+                NPY npy(path, 'r');
+                auto data = npy.load<value_type>();
+                npy.close();
+                if (data.shape() != chunks_)
+                    throw std::runtime_error("chunked_array: tile shape does not match");
+                return data;
+            };
+            return tiles_.get(key, dirty, load, [this](size_t key, const ndarray<value_type> &data) {
+                save_tile_(key, data);
+            });
+        }
+
+        // Copies between the tiles and a C-contiguous buffer holding the box of the given count at start, one
+        // contiguous run along the last axis at a time.
+        template<bool Write>
+        void copy_region_(const std::vector<size_t> &start, const std::vector<size_t> &count,
+                          std::conditional_t<Write, const value_type *, value_type *> buffer) {
+            size_t ndim = shape_.size();
+            if (std::find(count.begin(), count.end(), size_t(0)) != count.end())
+                return;
+
+            std::vector<size_t> first(ndim), last(ndim), lo(ndim), hi(ndim);
+            for (size_t d = 0; d < ndim; d++) {
+                first[d] = start[d] / chunks_[d];
+                last[d] = (start[d] + count[d] - 1) / chunks_[d] + 1;
+            }
+            for_each_index_(first, last, ndim, [&](const std::vector<size_t> &tile) {
+                size_t key = 0;
+                for (size_t d = 0; d < ndim; d++) {
+                    key = key * grid_[d] + tile[d];
+                    lo[d] = std::max(start[d], tile[d] * chunks_[d]);
+                    hi[d] = std::min(start[d] + count[d], (tile[d] + 1) * chunks_[d]);
+                }
+                value_type *data = tile_(key, Write).data();
+
+                size_t run = hi[ndim - 1] - lo[ndim - 1];
+                for_each_index_(lo, hi, ndim - 1, [&](const std::vector<size_t> &row) {
+                    size_t tile_offset = 0, buffer_offset = 0;
+                    for (size_t d = 0; d < ndim; d++) {
+                        tile_offset = tile_offset * chunks_[d] + row[d] - tile[d] * chunks_[d];
+                        buffer_offset = buffer_offset * count[d] + row[d] - start[d];
+                    }
+                    if constexpr (Write)
+                        std::memcpy(data + tile_offset, buffer + buffer_offset, run * sizeof(value_type));
+                    else
+                        std::memcpy(buffer + buffer_offset, data + tile_offset, run * sizeof(value_type));
+                });
+            });
+        }
+
+        std::string directory_;
+        std::vector<size_t> shape_, chunks_, grid_;
+        size_t cache_bytes_;
+        lru_cache_<ndarray<value_type>> tiles_;
+    };
+
+}
@@ -0,0 +1,451 @@
+#pragma once
+
+#include <algorithm>    // copy, fill, find, min
+#include <cstdint>      // uint8_t, uint16_t, uint32_t, uint64_t
+#include <cstring>      // memcmp, memcpy
+#include <fstream>
+#include <functional>   // multiplies
+#include <limits>       // numeric_limits
+#include <memory>       // unique_ptr
+#include <numeric>      // accumulate
+#include <stdexcept>    // runtime_error
+#include <string>
+#include <type_traits>  // conditional_t, is_floating_point_v
+#include <utility>      // move
+#include <vector>
+#include "block_cache.hpp"
+#include "ndarray.hpp"
+#include "npy.hpp"
+#include "parallel.hpp"
+
+namespace cnumpy {
+
+    // Appends an LZ77 encoding of in[0, n) to out. The format follows LZ4 blocks: each sequence is a token (literal
+    // length << 4 | match length - 4), extra length bytes for either nibble equal to 15, the literals, a 16-bit
+    // little-endian match offset and extra match length bytes; the last sequence has literals only.
+    inline void lz_compress_(const uint8_t *in, size_t n, std::vector<uint8_t> &out) {
+        constexpr size_t hash_bits = 14, min_match = 4, max_offset = 65535;
+        std::vector<uint32_t> table(size_t(1) << hash_bits);
+        out.reserve(out.size() + n + n / 255 + 16);
+
+        auto emit_length = [&out](size_t len) {
+            for (; len >= 255; len -= 255)
+                out.push_back(255);
+            out.push_back(uint8_t(len));
+        };
+        size_t anchor = 0;
+        auto emit = [&](size_t literal_end, size_t match, size_t offset) {
+            size_t literals = literal_end - anchor, extra = match ? match - min_match : 0;
+            out.push_back(uint8_t(std::min<size_t>(literals, 15) << 4 | std::min<size_t>(extra, 15)));
+            if (literals >= 15)
+                emit_length(literals - 15);
+            out.insert(out.end(), in + anchor, in + literal_end);
+            if (match) {
+                out.push_back(uint8_t(offset));
+                out.push_back(uint8_t(offset >> 8));
+                if (extra >= 15)
+                    emit_length(extra - 15);
+            }
+        };
+
+        size_t i = 0;
+        while (i + min_match <= n) {
+            uint32_t word;
+            std::memcpy(&word, in + i, 4);
+            uint32_t &slot = table[(word * 2654435761u) >> (32 - hash_bits)];
+            size_t candidate = slot;
+            slot = uint32_t(i);
+            if (candidate < i && i - candidate <= max_offset && std::memcmp(in + candidate, in + i, 4) == 0) {
+                size_t len = min_match;
+                while (i + len < n && in[candidate + len] == in[i + len])
+                    len++;
+                emit(i, len, i - candidate);
+                i += len;
+                anchor = i;
+            } else {
+                // skip faster through data that does not compress
+                i += 1 + ((i - anchor) >> 6);
+            }
+        }
+        emit(n, 0, 0);
+    }
+
+    // Decodes the output of lz_compress_, which must expand to exactly out_size bytes.
+    inline void lz_decompress_(const uint8_t *in, size_t n, uint8_t *out, size_t out_size) {
+        size_t ip = 0, op = 0;
+        auto length = [&](size_t len) {
+            if (len == 15) {
+                uint8_t byte;
+                do {
+                    if (ip == n)
+                        throw std::runtime_error("lz_decompress_(): truncated input");
+                    byte = in[ip++];
+                    len += byte;
+                } while (byte == 255);
+            }
+            return len;
+        };
+
+        while (true) {
+            if (ip == n)
+                throw std::runtime_error("lz_decompress_(): truncated input");
+            uint8_t token = in[ip++];
+            size_t literals = length(token >> 4);
+            if (literals > n - ip || literals > out_size - op)
+                throw std::runtime_error("lz_decompress_(): corrupt input");
+            if (literals)
+                std::memcpy(out + op, in + ip, literals);
+            ip += literals;
+            op += literals;
+            if (ip == n)
+                break;
+
+            if (n - ip < 2)
+                throw std::runtime_error("lz_decompress_(): truncated input");
+            size_t offset = size_t(in[ip]) | size_t(in[ip + 1]) << 8;
+            ip += 2;
+            size_t len = length(token & 15) + 4;
+            if (offset == 0 || offset > op || len > out_size - op)
+                throw std::runtime_error("lz_decompress_(): corrupt input");
+            if (offset >= len) {
+                std::memcpy(out + op, out + op - offset, len);
+            } else {
+                for (size_t k = 0; k < len; k++)
+                    out[op + k] = out[op + k - offset];
+            }
+            op += len;
+        }
+        if (op != out_size)
+            throw std::runtime_error("lz_decompress_(): wrong output size");
+    }
+
+    // How blocks are transformed before LZ compression: shuffle groups byte b of every element together, which turns
+    // the slowly changing high bytes of numeric data into long runs; delta also replaces every element but the first
+    // by its difference to the previous one (of the bit patterns for floating types), for smooth or sorted data.
+    enum class compressed_codec {
+        shuffle, delta
+    };
+
+    struct compression {
+        compressed_codec codec = compressed_codec::shuffle;
+        // floating types only: mantissa bits kept, rounding to nearest; -1 keeps all and is lossless
+        int mantissa_bits = -1;
+        size_t block_elements = size_t(1) << 16;
+    };
+
+    // An N-dimensional array kept in memory as independently compressed blocks of block_elements consecutive elements
+    // (in C order), for large arrays that are accessed rarely. Blocks are decompressed on demand into an LRU cache
+    // bounded to cache_bytes; modified blocks are compressed again when evicted and on flush(). Blocks that were never
+    // written take no space. With mantissa_bits set, values are rounded when their block is compressed. Not
+    // thread-safe.
+    template<class T>
+    class compressed_array {
+        static_assert(sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8);
+
+    public:
+        using value_type = T;
+
+        inline static const size_t default_cache_bytes = size_t(64) << 20;
+
+        // creates an array of zeros
+        explicit compressed_array(const std::vector<size_t> &shape, compression options = {},
+                                  size_t cache_bytes = default_cache_bytes) :
+                shape_(shape), options_(options), cache_bytes_(cache_bytes) {
+            init_();
+        }
+
+        // compresses a copy of arr, blocks in parallel
+        template<class Container>
+        explicit compressed_array(const ndarray_impl<value_type, Container> &arr, compression options = {},
+                                  size_t cache_bytes = default_cache_bytes) :
+                shape_(arr.shape().begin(), arr.shape().end()), options_(options), cache_bytes_(cache_bytes) {
+            init_();
+            parallel_for(0, blocks_.size(), 1, [&](size_t begin, size_t end) {
+                std::unique_ptr<value_type[]> scratch(new value_type[options_.block_elements]);
+                for (size_t b = begin; b < end; b++) {
+                    size_t n = block_size_(b);
+                    std::copy(arr.data() + b * options_.block_elements, arr.data() + b * options_.block_elements + n,
+                              scratch.get());
+                    blocks_[b] = encode_(scratch.get(), n);
+                }
+            });
+        }
+
+        // Compresses a .npy file a few blocks at a time, without reading the whole array into memory.
+        static compressed_array load(const std::string &filename, compression options = {},
+                                     size_t cache_bytes = default_cache_bytes) {
+            NPY::header_info info = NPY::inspect(filename);
+            std::string descr = NPY::descr<value_type>();
+            if (info.descr != descr && !(sizeof(value_type) == 1 && info.descr == "|" + descr.substr(1)))
+                throw std::runtime_error("compressed_array::load(): dtype does not match");
+            if (info.fortran_order)
+                throw std::runtime_error("compressed_array::load(): Fortran order is not supported");
+
+            compressed_array arr(info.shape, options, cache_bytes);
+            std::ifstream ifstrm(filename, std::ios::binary);
+            ifstrm.seekg(std::streamoff(info.offset));
+            size_t batch = get_num_threads(), block_elements = arr.options_.block_elements;
+            std::unique_ptr<value_type[]> buffer(new value_type[batch * block_elements]);
+            for (size_t first = 0; first < arr.blocks_.size(); first += batch) {
+                size_t last = std::min(first + batch, arr.blocks_.size());
+                size_t n = std::min(arr.size() - first * block_elements, (last - first) * block_elements);
+                if (ifstrm.read((char *) buffer.get(), std::streamsize(n * sizeof(value_type))).fail())
+                    throw std::runtime_error("compressed_array::load(): failed read");
+                parallel_for(first, last, 1, [&](size_t begin, size_t end) {
+                    for (size_t b = begin; b < end; b++)
+                        arr.blocks_[b] = arr.encode_(buffer.get() + (b - first) * block_elements, arr.block_size_(b));
+                });
+            }
+            return arr;
+        }
+
+        compressed_array(const compressed_array &) = delete;
+
+        compressed_array(compressed_array &&) noexcept = default;
+
+        compressed_array &operator=(const compressed_array &) = delete;
+
+        compressed_array &operator=(compressed_array &&) noexcept = default;
+
+        [[nodiscard]] const std::vector<size_t> &shape() const noexcept { return shape_; }
+
+        [[nodiscard]] size_t ndim() const noexcept { return shape_.size(); }
+
+        [[nodiscard]] size_t size() const noexcept { return size_; }
+
+        [[nodiscard]] const compression &options() const noexcept { return options_; }
+
+        // bytes held by the compressed blocks, not counting the cache
+        [[nodiscard]] size_t compressed_bytes() const noexcept {
+            size_t bytes = 0;
+            for (const auto &block: blocks_)
+                bytes += block.size();
+            return bytes;
+        }
+
+        [[nodiscard]] size_t hits() const noexcept { return cache_.hits(); }
+
+        [[nodiscard]] size_t misses() const noexcept { return cache_.misses(); }
+
+        value_type get(const std::vector<size_t> &index) {
+            size_t flat = ravel_(index);
+            return block_(flat / options_.block_elements, false)[flat % options_.block_elements];
+        }
+
+        void set(const std::vector<size_t> &index, const value_type &value) {
+            size_t flat = ravel_(index);
+            block_(flat / options_.block_elements, true)[flat % options_.block_elements] = value;
+        }
+
+        // Reads the box [start, stop) into a new array, decompressing only the blocks it touches.
+        ndarray<value_type> read(const std::vector<size_t> &start, const std::vector<size_t> &stop) {
+            std::vector<size_t> count = region_extent_(shape_, start, stop, "compressed_array::read()");
+            ndarray<value_type> arr(count);
+            copy_region_<false>(start, count, arr.data());
+            return arr;
+        }
+
+        // Writes arr into the box starting at start.
+        template<class Container>
+        void write(const std::vector<size_t> &start, const ndarray_impl<value_type, Container> &arr) {
+            std::vector<size_t> count = region_count_(shape_, start, arr.shape(), "compressed_array::write()");
+            copy_region_<true>(start, count, arr.data());
+        }
+
+        // decompresses the whole array, blocks in parallel
+        [[nodiscard]] ndarray<value_type> to_ndarray() const {
+            ndarray<value_type> arr(shape_);
+            parallel_for(0, blocks_.size(), 1, [&](size_t begin, size_t end) {
+                for (size_t b = begin; b < end; b++)
+                    copy_block_(b, arr.data() + b * options_.block_elements);
+            });
+            return arr;
+        }
+
+        // Writes the array as a .npy file one block at a time, so at most one decompressed block is held besides the
+        // cache. Modified blocks in the cache are written as they are, without compressing them.
+        void save(const std::string &filename) const {
+            std::ofstream ofstrm(filename, std::ios::binary);
+            if (ofstrm.fail())
+                throw std::runtime_error("compressed_array::save(): can't open file");
+            std::string header = NPY::header(NPY::descr<value_type>(), shape_);
+            ofstrm.write(header.data(), std::streamsize(header.size()));
+            std::unique_ptr<value_type[]> scratch(new value_type[options_.block_elements]);
+            for (size_t b = 0; b < blocks_.size(); b++) {
+                copy_block_(b, scratch.get());
+                ofstrm.write((const char *) scratch.get(), std::streamsize(block_size_(b) * sizeof(value_type)));
+            }
+            if (ofstrm.flush().fail())
+                throw std::runtime_error("compressed_array::save(): failed write");
+        }
+
+        // compresses all modified blocks in the cache
+        void flush() {
+            cache_.flush([this](size_t b, std::unique_ptr<value_type[]> &data) {
+                blocks_[b] = encode_(data.get(), block_size_(b));
+            });
+        }
+
+    private:
+        using bits_type = std::conditional_t<sizeof(T) == 1, uint8_t, std::conditional_t<sizeof(T) == 2, uint16_t,
+                std::conditional_t<sizeof(T) == 4, uint32_t, uint64_t>>>;
+
+        void init_() {
+            if (shape_.empty())
+                throw std::runtime_error("compressed_array::compressed_array(): empty shape");
+            if (options_.block_elements == 0 || options_.block_elements * sizeof(value_type) > UINT32_MAX)
+                throw std::runtime_error("compressed_array::compressed_array(): invalid block size");
+            if constexpr (std::is_floating_point_v<value_type>) {
+                if (options_.mantissa_bits < -1 || options_.mantissa_bits >= std::numeric_limits<value_type>::digits)
+                    throw std::runtime_error("compressed_array::compressed_array(): invalid mantissa_bits");
+            } else if (options_.mantissa_bits != -1) {
+                throw std::runtime_error("compressed_array::compressed_array(): mantissa_bits needs a floating type");
+            }
+            size_ = std::accumulate(shape_.begin(), shape_.end(), size_t(1), std::multiplies<>());
+            blocks_.resize((size_ + options_.block_elements - 1) / options_.block_elements);
+            cache_ = lru_cache_<std::unique_ptr<value_type[]>>(cache_bytes_,
+                                                               options_.block_elements * sizeof(value_type));
+        }
+
+        [[nodiscard]] size_t block_size_(size_t b) const {
+            return std::min(options_.block_elements, size_ - b * options_.block_elements);
+        }
+
+        // Rounds (if requested), transforms and compresses n elements; data is modified in place. The first byte tells
+        // whether the rest is LZ-compressed (1) or stored (0), the latter when compression would not save space.
+        std::vector<uint8_t> encode_(value_type *data, size_t n) const {
+            if constexpr (std::is_floating_point_v<value_type>) {
+                int drop = std::numeric_limits<value_type>::digits - 1 - options_.mantissa_bits;
+                if (options_.mantissa_bits >= 0 && drop > 0) {
+                    constexpr int digits = std::numeric_limits<value_type>::digits;
+                    constexpr bits_type exponent = bits_type(bits_type(~bits_type(0)) >> 1 &
+                                                             ~((bits_type(1) << (digits - 1)) - 1));
+                    bits_type mask = bits_type(~((bits_type(1) << drop) - 1)), half = bits_type(1) << (drop - 1);
+                    for (size_t i = 0; i < n; i++) {
+                        bits_type u;
+                        std::memcpy(&u, data + i, sizeof(u));
+                        if ((u & exponent) != exponent) {
+                            // round half to even, carrying into the exponent
+                            u = bits_type(u + half - 1 + (u >> drop & 1)) & mask;
+                            std::memcpy(data + i, &u, sizeof(u));
+                        }
+                    }
+                }
+            }
+
+            std::vector<bits_type> words(n);
+            std::memcpy(words.data(), data, n * sizeof(value_type));
+            if (options_.codec == compressed_codec::delta)
+                for (size_t i = n; i-- > 1;)
+                    words[i] = bits_type(words[i] - words[i - 1]);
+
+            std::vector<uint8_t> bytes(n * sizeof(value_type));
+            const auto *src = (const uint8_t *) words.data();
+            for (size_t k = 0; k < n; k++)
+                for (size_t b = 0; b < sizeof(value_type); b++)
+                    bytes[b * n + k] = src[k * sizeof(value_type) + b];
+
+            std::vector<uint8_t> out(1, 1);
+            lz_compress_(bytes.data(), bytes.size(), out);
+            if (out.size() > bytes.size()) {
+                out.assign(1, 0);
+                out.insert(out.end(), bytes.begin(), bytes.end());
+            }
+            out.shrink_to_fit();
+            return out;
+        }
+
+        void decode_(const std::vector<uint8_t> &block, value_type *data, size_t n) const {
+            std::vector<uint8_t> bytes(n * sizeof(value_type));
+            if (block.empty() || block[0] > 1 || (block[0] == 0 && block.size() != bytes.size() + 1))
+                throw std::runtime_error("compressed_array: corrupt block");
+            if (block[0] == 1)
+                lz_decompress_(block.data() + 1, block.size() - 1, bytes.data(), bytes.size());
+            else
+                std::memcpy(bytes.data(), block.data() + 1, bytes.size());
+
+            std::vector<bits_type> words(n);
+            auto *dst = (uint8_t *) words.data();
+            for (size_t k = 0; k < n; k++)
+                for (size_t b = 0; b < sizeof(value_type); b++)
+                    dst[k * sizeof(value_type) + b] = bytes[b * n + k];
+            if (options_.codec == compressed_codec::delta)
+                for (size_t i = 1; i < n; i++)
+                    words[i] = bits_type(words[i] + words[i - 1]);
+            std::memcpy(data, words.data(), n * sizeof(value_type));
+        }
+
+        // copies block b, from the cache if it is there, to out
+        void copy_block_(size_t b, value_type *out) const {
+            size_t n = block_size_(b);
+            if (const auto *cached = cache_.find(b))
+                std::copy(cached->get(), cached->get() + n, out);
+            else if (blocks_[b].empty())
+                std::fill(out, out + n, value_type());
+            else
+                decode_(blocks_[b], out, n);
+        }
+
+        value_type *block_(size_t b, bool dirty) {
+            auto load = [this](size_t b) {
+                std::unique_ptr<value_type[]> data(new value_type[block_size_(b)]);
+                copy_block_(b, data.get());
+                return data;
+            };
+            return cache_.get(b, dirty, load, [this](size_t b, std::unique_ptr<value_type[]> &data) {
+                blocks_[b] = encode_(data.get(), block_size_(b));
+            }).get();
+        }
+
+        size_t ravel_(const std::vector<size_t> &index) const {
+            if (index.size() != shape_.size())
+                throw std::runtime_error("compressed_array: wrong number of indices");
+            size_t flat = 0;
+            for (size_t d = 0; d < shape_.size(); d++) {
+                if (index[d] >= shape_[d])
+                    throw std::runtime_error("compressed_array: index out of bounds");
+                flat = flat * shape_[d] + index[d];
+            }
+            return flat;
+        }
+
+        // Copies between the blocks and a C-contiguous buffer holding the box of the given count at start, one
+        // contiguous run along the last axis at a time; a run may span several blocks.
+        template<bool Write>
+        void copy_region_(const std::vector<size_t> &start, const std::vector<size_t> &count,
+                          std::conditional_t<Write, const value_type *, value_type *> buffer) {
+            size_t ndim = shape_.size();
+            if (std::find(count.begin(), count.end(), size_t(0)) != count.end())
+                return;
+
+            size_t run = count[ndim - 1];
+            std::vector<size_t> stop(ndim);
+            for (size_t d = 0; d < ndim; d++)
+                stop[d] = start[d] + count[d];
+            for_each_index_(start, stop, ndim - 1, [&](const std::vector<size_t> &row) {
+                size_t flat = 0, offset = 0;
+                for (size_t d = 0; d < ndim; d++) {
+                    flat = flat * shape_[d] + row[d];
+                    offset = offset * count[d] + row[d] - start[d];
+                }
+                for (size_t done = 0; done < run;) {
+                    size_t b = (flat + done) / options_.block_elements, pos = (flat + done) % options_.block_elements;
+                    size_t n = std::min(run - done, block_size_(b) - pos);
+                    value_type *data = block_(b, Write) + pos;
+                    if constexpr (Write)
+                        std::copy(buffer + offset + done, buffer + offset + done + n, data);
+                    else
+                        std::copy(data, data + n, buffer + offset + done);
+                    done += n;
+                }
+            });
+        }
+
+        std::vector<size_t> shape_;
+        compression options_;
+        size_t cache_bytes_, size_{};
+        std::vector<std::vector<uint8_t>> blocks_;
+        lru_cache_<std::unique_ptr<value_type[]>> cache_;
+    };
+
+}
@@ -0,0 +1,393 @@
+#pragma once
+
+#include <algorithm>    // find, max, min, sort
+#include <array>
+#include <cctype>       // isalpha
+#include <cstddef>      // ptrdiff_t, size_t
+#include <cstdlib>      // abs
+#include <functional>   // multiplies
+#include <memory>       // shared_ptr
+#include <mutex>
+#include <numeric>      // accumulate, iota
+#include <stdexcept>    // runtime_error
+#include <string>
+#include <unordered_map>
+#include <utility>      // pair
+#include <vector>
+#include "instrument.hpp"
+#include "linalg.hpp"
+#include "ndarray.hpp"
+#include "parallel.hpp"
+
+namespace cnumpy {
+
+    // Parsed subscripts and the order in which the operands are contracted pairwise.
+    struct einsum_plan_ {
+        std::vector<std::string> inputs;
+        std::string output;
+        std::vector<std::pair<size_t, size_t>> path;    // positions in the list of remaining operands
+    };
+
+    // An operand or intermediate result: one label, extent and stride (in elements) per axis.
+    template<class T>
+    struct einsum_term_ {
+        std::shared_ptr<T[]> owner;
+        const T *data;
+        std::string labels;
+        std::vector<size_t> dims;
+        std::vector<ptrdiff_t> strides;
+
+        [[nodiscard]] size_t size() const {
+            return std::accumulate(dims.begin(), dims.end(), size_t(1), std::multiplies<>());
+        }
+
+        [[nodiscard]] size_t dim(char label) const { return dims[labels.find(label)]; }
+
+        // whether the axes, taken in the given order, are laid out C-contiguously
+        [[nodiscard]] bool dense(const std::string &order) const {
+            ptrdiff_t expected = 1;
+            for (size_t i = order.length(); i-- > 0;) {
+                size_t d = labels.find(order[i]);
+                if (dims[d] != 1 && strides[d] != expected)
+                    return false;
+                expected *= ptrdiff_t(dims[d]);
+            }
+            return true;
+        }
+    };
+
+    inline einsum_plan_ einsum_parse_(const std::string &subscripts, const std::vector<std::vector<size_t>> &shapes) {
+        einsum_plan_ plan;
+        std::string spec;
+        for (char c : subscripts)
+            if (c != ' ')
+                spec += c;
+        if (spec.find('.') != std::string::npos)
+            throw std::runtime_error("einsum(): ellipsis is not supported");
+
+        size_t arrow = spec.find("->");
+        std::string lhs = spec.substr(0, arrow);
+        for (size_t begin = 0, end; begin <= lhs.length(); begin = end + 1) {
+            end = std::min(lhs.find(',', begin), lhs.length());
+            plan.inputs.push_back(lhs.substr(begin, end - begin));
+        }
+        if (plan.inputs.size() != shapes.size())
+            throw std::runtime_error("einsum(): number of operands does not match the subscripts");
+
+        std::array<size_t, 128> dims{}, count{};
+        for (size_t t = 0; t < plan.inputs.size(); t++) {
+            const std::string &labels = plan.inputs[t];
+            if (labels.length() != shapes[t].size())
+                throw std::runtime_error("einsum(): number of subscripts does not match the operand dimensions");
+            for (size_t d = 0; d < labels.length(); d++) {
+                unsigned char c = labels[d];
+                if (!std::isalpha(c))
+                    throw std::runtime_error("einsum(): invalid subscript");
+                if (count[c]++ && dims[c] != shapes[t][d])
+                    throw std::runtime_error("einsum(): operand dimensions do not match");
+                dims[c] = shapes[t][d];
+            }
+        }
+
+        if (arrow == std::string::npos) {
+            // implicit mode: labels appearing exactly once, in alphabetical order
+            for (unsigned char c = 0; c < 128; c++)
+                if (count[c] == 1)
+                    plan.output += char(c);
+        } else {
+            plan.output = spec.substr(arrow + 2);
+            for (size_t i = 0; i < plan.output.length(); i++) {
+                unsigned char c = plan.output[i];
+                if (c >= 128 || !count[c] || plan.output.find(c, i + 1) != std::string::npos)
+                    throw std::runtime_error("einsum(): invalid output subscripts");
+            }
+        }
+
+        // greedy order: repeatedly contract the pair giving the smallest intermediate result
+        std::vector<std::string> terms;
+        for (const auto &labels : plan.inputs) {
+            std::string unique;
+            for (char c : labels)
+                if (unique.find(c) == std::string::npos)
+                    unique += c;
+            terms.push_back(unique);
+        }
+        while (terms.size() > 1) {
+            size_t best_i = 0, best_j = 1;
+            double best_size = -1, best_cost = -1;
+            for (size_t i = 0; i < terms.size(); i++) {
+                for (size_t j = i + 1; j < terms.size(); j++) {
+                    std::string keep = plan.output;
+                    for (size_t t = 0; t < terms.size(); t++)
+                        if (t != i && t != j)
+                            keep += terms[t];
+                    double size = 1, cost = 1;
+                    std::string both = terms[i];
+                    for (char c : terms[j])
+                        if (both.find(c) == std::string::npos)
+                            both += c;
+                    for (char c : both) {
+                        cost *= double(dims[(unsigned char) c]);
+                        if (keep.find(c) != std::string::npos)
+                            size *= double(dims[(unsigned char) c]);
+                    }
+                    if (best_size < 0 || size < best_size || (size == best_size && cost < best_cost))
+                        best_i = i, best_j = j, best_size = size, best_cost = cost;
+                }
+            }
+            std::string keep = plan.output;
+            for (size_t t = 0; t < terms.size(); t++)
+                if (t != best_i && t != best_j)
+                    keep += terms[t];
+            std::string result;
+            for (char c : terms[best_i] + terms[best_j])
+                if (keep.find(c) != std::string::npos && result.find(c) == std::string::npos)
+                    result += c;
+            plan.path.emplace_back(best_i, best_j);
+            terms.erase(terms.begin() + ptrdiff_t(best_j));
+            terms.erase(terms.begin() + ptrdiff_t(best_i));
+            terms.push_back(result);
+        }
+        return plan;
+    }
+
+    // Sums term over the axes whose labels are not in labels and writes the result C-contiguously with its axes in
+    // the order of labels into out. The innermost loop runs along the input axis with the smallest stride, and the
+    // positions are updated incrementally, without building an index per element.
+    template<class T>
+    void einsum_reduce_(const einsum_term_<T> &term, const std::string &labels, T *out) {
+        size_t size = 1;
+        std::vector<ptrdiff_t> out_strides(term.labels.size(), 0);
+        for (size_t i = labels.length(); i-- > 0;) {
+            size_t d = term.labels.find(labels[i]);
+            out_strides[d] = ptrdiff_t(size);
+            size *= term.dims[d];
+        }
+        std::fill(out, out + size, T(0));
+        if (term.size() == 0)
+            return;
+        if (term.labels.empty()) {
+            out[0] = term.data[0];
+            return;
+        }
+
+        std::vector<size_t> order(term.labels.size());
+        std::iota(order.begin(), order.end(), size_t(0));
+        std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+            return std::abs(term.strides[a]) > std::abs(term.strides[b]);
+        });
+        size_t ndim = order.size(), inner = order[ndim - 1];
+        size_t n = term.dims[inner];
+        ptrdiff_t is = term.strides[inner], os = out_strides[inner];
+        std::vector<size_t> idx(ndim, 0);
+        const T *in = term.data;
+        T *o = out;
+        while (true) {
+            if (os == 0) {
+                T sum = *o;
+                for (size_t i = 0; i < n; i++)
+                    sum += in[ptrdiff_t(i) * is];
+                *o = sum;
+            } else {
+                for (size_t i = 0; i < n; i++)
+                    o[ptrdiff_t(i) * os] += in[ptrdiff_t(i) * is];
+            }
+            size_t k = ndim - 1;
+            while (k-- > 0) {
+                size_t d = order[k];
+                in += term.strides[d];
+                o += out_strides[d];
+                if (++idx[k] < term.dims[d])
+                    break;
+                in -= term.strides[d] * ptrdiff_t(term.dims[d]);
+                o -= out_strides[d] * ptrdiff_t(term.dims[d]);
+                idx[k] = 0;
+            }
+            if (k == size_t(-1))
+                break;
+        }
+    }
+
+    template<class T>
+    einsum_term_<T> einsum_reduce_(const einsum_term_<T> &term, const std::string &labels) {
+        einsum_term_<T> out;
+        out.labels = labels;
+        for (char c : labels)
+            out.dims.push_back(term.dim(c));
+        out.strides.resize(labels.size());
+        ptrdiff_t stride = 1;
+        for (size_t i = labels.size(); i-- > 0;) {
+            out.strides[i] = stride;
+            stride *= ptrdiff_t(out.dims[i]);
+        }
+        out.owner = std::shared_ptr<T[]>(new T[std::max(out.size(), size_t(1))]);
+        out.data = out.owner.get();
+        instrument::add(instrument::counter::allocations, 1);
+        instrument::add(instrument::counter::allocated_bytes, std::max(out.size(), size_t(1)) * sizeof(T));
+        einsum_reduce_(term, labels, out.owner.get());
+        return out;
+    }
+
+    // Contracts two terms over their shared labels that are not in keep, as a batched matrix product.
+    template<class T>
+    einsum_term_<T> einsum_contract_(einsum_term_<T> x, einsum_term_<T> y, const std::string &keep) {
+        auto in = [](const std::string &labels, char c) { return labels.find(c) != std::string::npos; };
+
+        // labels that only one side has and nobody needs afterwards are summed out first
+        std::string xs, ys;
+        for (char c : x.labels)
+            if (in(y.labels, c) || in(keep, c))
+                xs += c;
+        for (char c : y.labels)
+            if (in(x.labels, c) || in(keep, c))
+                ys += c;
+        if (xs != x.labels)
+            x = einsum_reduce_(x, xs);
+        if (ys != y.labels)
+            y = einsum_reduce_(y, ys);
+
+        std::string batch, left, contracted, right;
+        for (char c : x.labels) {
+            if (in(y.labels, c))
+                (in(keep, c) ? batch : contracted) += c;
+            else
+                left += c;
+        }
+        for (char c : y.labels)
+            if (!in(x.labels, c))
+                right += c;
+        auto extent = [](const einsum_term_<T> &term, const std::string &labels) {
+            size_t size = 1;
+            for (char c : labels)
+                size *= term.dim(c);
+            return size;
+        };
+        size_t nb = extent(x, batch), m = extent(x, left), k = extent(x, contracted), n = extent(y, right);
+
+        // use the operands in place when they are laid out as (batch, rows, columns) in either order of the
+        // matrix axes, and gather them otherwise
+        ptrdiff_t rsx, csx, rsy, csy;
+        if (x.dense(batch + left + contracted)) {
+            rsx = ptrdiff_t(k), csx = 1;
+        } else if (x.dense(batch + contracted + left)) {
+            rsx = 1, csx = ptrdiff_t(m);
+        } else {
+            x = einsum_reduce_(x, batch + left + contracted);
+            rsx = ptrdiff_t(k), csx = 1;
+        }
+        if (y.dense(batch + contracted + right)) {
+            rsy = ptrdiff_t(n), csy = 1;
+        } else if (y.dense(batch + right + contracted)) {
+            rsy = 1, csy = ptrdiff_t(k);
+        } else {
+            y = einsum_reduce_(y, batch + contracted + right);
+            rsy = ptrdiff_t(n), csy = 1;
+        }
+
+        einsum_term_<T> out;
+        out.labels = batch + left + right;
+        for (char c : out.labels)
+            out.dims.push_back(in(x.labels, c) ? x.dim(c) : y.dim(c));
+        out.strides.resize(out.labels.size());
+        ptrdiff_t stride = 1;
+        for (size_t i = out.labels.size(); i-- > 0;) {
+            out.strides[i] = stride;
+            stride *= ptrdiff_t(out.dims[i]);
+        }
+        out.owner = std::shared_ptr<T[]>(new T[std::max(out.size(), size_t(1))]);
+        out.data = out.owner.get();
+        instrument::add(instrument::counter::allocations, 1);
+        instrument::add(instrument::counter::allocated_bytes, std::max(out.size(), size_t(1)) * sizeof(T));
+
+        auto multiply = [&](size_t begin, size_t end) {
+            for (size_t b = begin; b < end; b++)
+                gemm<T>(m, n, k, T(1), x.data + b * m * k, rsx, csx, y.data + b * k * n, rsy, csy,
+                        T(0), out.owner.get() + b * m * n, ptrdiff_t(n), 1);
+        };
+        if (nb >= get_num_threads())
+            parallel_for(0, nb, 1, multiply);
+        else
+            multiply(0, nb);
+        return out;
+    }
+
+    // Evaluates the Einstein summation convention on the operands, like numpy.einsum without ellipsis. Repeated
+    // subscripts in one operand take its diagonal. The subscripts are parsed and the contraction order chosen once per
+    // combination of subscripts and operand shapes; multi-operand expressions are contracted pairwise in a greedy
+    // order that keeps intermediate results small, and every pairwise contraction runs as a batched gemm().
+    template<class T, class... Containers>
+    ndarray<T> einsum(const std::string &subscripts, const ndarray_impl<T, Containers> &... operands) {
+        static_assert(sizeof...(Containers) > 0);
+        std::vector<std::vector<size_t>> shapes = {
+                std::vector<size_t>(operands.shape().begin(), operands.shape().end())...};
+        std::vector<const T *> data = {operands.data()...};
+
+        std::string key = subscripts;
+        for (const auto &shape : shapes) {
+            key += ';';
+            for (size_t dim : shape)
+                key += std::to_string(dim) + ',';
+        }
+        static std::mutex mutex;
+        static std::unordered_map<std::string, einsum_plan_> cache;
+        einsum_plan_ plan;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = cache.find(key);
+            if (it != cache.end()) {
+                plan = it->second;
+            } else {
+                plan = einsum_parse_(subscripts, shapes);
+                if (cache.size() >= 1024)
+                    cache.clear();
+                cache.emplace(key, plan);
+            }
+        }
+
+        std::vector<einsum_term_<T>> terms;
+        for (size_t t = 0; t < shapes.size(); t++) {
+            einsum_term_<T> term;
+            term.data = data[t];
+            ptrdiff_t stride = 1;
+            std::vector<ptrdiff_t> strides(shapes[t].size());
+            for (size_t d = shapes[t].size(); d-- > 0;) {
+                strides[d] = stride;
+                stride *= ptrdiff_t(shapes[t][d]);
+            }
+            // a repeated label walks the diagonal: its strides add up
+            for (size_t d = 0; d < shapes[t].size(); d++) {
+                size_t first = term.labels.find(plan.inputs[t][d]);
+                if (first == std::string::npos) {
+                    term.labels += plan.inputs[t][d];
+                    term.dims.push_back(shapes[t][d]);
+                    term.strides.push_back(strides[d]);
+                } else {
+                    term.strides[first] += strides[d];
+                }
+            }
+            terms.push_back(std::move(term));
+        }
+
+        for (auto [i, j] : plan.path) {
+            std::string keep = plan.output;
+            for (size_t t = 0; t < terms.size(); t++)
+                if (t != i && t != j)
+                    keep += terms[t].labels;
+            auto result = einsum_contract_(std::move(terms[i]), std::move(terms[j]), keep);
+            terms.erase(terms.begin() + ptrdiff_t(j));
+            terms.erase(terms.begin() + ptrdiff_t(i));
+            terms.push_back(std::move(result));
+        }
+
+        const einsum_term_<T> &last = terms.front();
+        std::vector<size_t> shape;
+        for (char c : plan.output)
+            shape.push_back(last.dim(c));
+        if (last.owner && last.labels == plan.output)
+            return ndarray<T>(shape, last.owner);
+        ndarray<T> out(shape);
+        einsum_reduce_(last, plan.output, out.data());
+        return out;
+    }
+
+}
@@ -0,0 +1,581 @@
+#pragma once
+
+#include <algorithm>    // copy, fill, max, max_element, min, sort
+#include <cmath>        // cos, sin, sqrt
+#include <complex>
+#include <cstddef>      // ptrdiff_t, size_t
+#include <cstdint>      // uint64_t
+#include <functional>   // greater
+#include <memory>       // make_shared, shared_ptr
+#include <mutex>        // lock_guard, mutex
+#include <numbers>      // pi_v
+#include <stdexcept>    // runtime_error
+#include <string>
+#include <type_traits>  // is_floating_point_v, is_same_v
+#include <unordered_map>
+#include <utility>      // swap
+#include <vector>
+#include "ndarray.hpp"
+#include "parallel.hpp"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>  // _mm_add_pd, _mm_mul_pd, _mm_shuffle_pd, _mm_xor_pd
+#endif
+
+// Discrete Fourier transforms with the conventions of numpy.fft: forward transforms are unscaled, inverse ones scale
+// by 1/n. Lengths with prime factors up to fft_max_radix_ use a mixed-radix Stockham FFT, other lengths Bluestein's
+// algorithm on top of one. Plans are built once per length and type and cached. Transforms of many lines along an axis
+// run in parallel over the lines.
+namespace cnumpy {
+
+    inline constexpr size_t fft_max_radix_ = 64;                    // larger prime factors go to Bluestein
+    inline constexpr size_t fft_cache_size_ = 64;                   // plans kept per type
+    inline constexpr size_t fft_lanes_ = 16;                        // lines gathered at a time from a strided axis
+    inline constexpr size_t fft_grain_ = size_t(1) << 15;           // least elements per task
+
+    // a * b, without the NaN and infinity recovery of std::complex multiplication
+    template<class T>
+    std::complex<T> cmul_(const std::complex<T> &a, const std::complex<T> &b) {
+        return {a.real() * b.real() - a.imag() * b.imag(), a.real() * b.imag() + a.imag() * b.real()};
+    }
+
+    // -i * a
+    template<class T>
+    std::complex<T> rot_(const std::complex<T> &a) { return {a.imag(), -a.real()}; }
+
+    template<class T>
+    std::complex<T> fft_load_(const std::complex<T> *p) { return *p; }
+
+    template<class T>
+    void fft_store_(std::complex<T> *p, const std::complex<T> &v) { *p = v; }
+
+    // exp(-2 pi i k / n), rounded from long double
+    template<class T>
+    std::complex<T> fft_root_(size_t k, size_t n) {
+        long double angle = -2 * std::numbers::pi_v<long double> * static_cast<long double>(k % n) /
+                            static_cast<long double>(n);
+        return {T(std::cos(angle)), T(std::sin(angle))};
+    }
+
+#if defined(__SSE2__)
+
+    // one complex double in a register, so butterflies and twiddle multiplications are packed
+    struct fft_vec_ {
+        __m128d v;
+
+        friend fft_vec_ operator+(fft_vec_ a, fft_vec_ b) { return {_mm_add_pd(a.v, b.v)}; }
+
+        friend fft_vec_ operator-(fft_vec_ a, fft_vec_ b) { return {_mm_sub_pd(a.v, b.v)}; }
+
+        friend fft_vec_ operator*(fft_vec_ a, double s) { return {_mm_mul_pd(a.v, _mm_set1_pd(s))}; }
+    };
+
+    inline fft_vec_ cmul_(fft_vec_ a, fft_vec_ b) {
+        __m128d re = _mm_mul_pd(a.v, _mm_unpacklo_pd(b.v, b.v));                        // ar br, ai br
+        __m128d im = _mm_mul_pd(_mm_shuffle_pd(a.v, a.v, 1), _mm_unpackhi_pd(b.v, b.v)); // ai bi, ar bi
+        return {_mm_add_pd(re, _mm_xor_pd(im, _mm_set_pd(0.0, -0.0)))};
+    }
+
+    inline fft_vec_ rot_(fft_vec_ a) {
+        return {_mm_xor_pd(_mm_shuffle_pd(a.v, a.v, 1), _mm_set_pd(-0.0, 0.0))};
+    }
+
+    inline fft_vec_ fft_load_(const std::complex<double> *p) {
+        return {_mm_loadu_pd(reinterpret_cast<const double *>(p))};
+    }
+
+    inline void fft_store_(std::complex<double> *p, fft_vec_ v) {
+        _mm_storeu_pd(reinterpret_cast<double *>(p), v.v);
+    }
+
+#endif
+
+    // In-place DFT of P values held in registers, a[k] = sum of a[r] exp(-2 pi i r k / P).
+    template<size_t P, class V, class T>
+    void fft_butterfly_(V *a, T) {
+        if constexpr (P == 2) {
+            V t = a[0] - a[1];
+            a[0] = a[0] + a[1];
+            a[1] = t;
+        } else if constexpr (P == 3) {
+            const T s = T(0.866025403784438646763723170752936183L);    // sin(2 pi / 3)
+            V t1 = a[1] + a[2], t2 = a[0] - t1 * T(0.5), t3 = rot_(a[1] - a[2]) * s;
+            a[0] = a[0] + t1;
+            a[1] = t2 + t3;
+            a[2] = t2 - t3;
+        } else if constexpr (P == 4) {
+            V t0 = a[0] + a[2], t1 = a[0] - a[2], t2 = a[1] + a[3], t3 = rot_(a[1] - a[3]);
+            a[0] = t0 + t2;
+            a[1] = t1 + t3;
+            a[2] = t0 - t2;
+            a[3] = t1 - t3;
+        } else if constexpr (P == 5) {
+            const T c1 = T(0.309016994374947424102293417182819059L), c2 = T(-0.809016994374947424102293417182819059L);
+            const T s1 = T(0.951056516295153572116439333379382143L), s2 = T(0.587785252292473129168705954639072769L);
+            V t1 = a[1] + a[4], t2 = a[2] + a[3], t3 = a[1] - a[4], t4 = a[2] - a[3];
+            V b1 = a[0] + t1 * c1 + t2 * c2, b2 = a[0] + t1 * c2 + t2 * c1;
+            V d1 = rot_(t3 * s1 + t4 * s2), d2 = rot_(t3 * s2 - t4 * s1);
+            a[0] = a[0] + t1 + t2;
+            a[1] = b1 + d1;
+            a[4] = b1 - d1;
+            a[2] = b2 + d2;
+            a[3] = b2 - d2;
+        }
+    }
+
+    // A plan for transforms of one length: the factorization and twiddle factors, or for Bluestein's algorithm the
+    // chirp, the transformed convolution kernel and a plan for the padded length. Immutable once built, so one plan
+    // serves any number of threads, each with its own scratch space.
+    template<class T>
+    class fft_plan {
+        static_assert(std::is_floating_point_v<T>, "fft_plan<T>: T must be a floating-point type");
+
+    public:
+        using complex_type = std::complex<T>;
+
+        explicit fft_plan(size_t n) : n_(n) {
+            if (n == 0)
+                throw std::runtime_error("fft_plan<T>::fft_plan(): invalid number of data points (0)");
+            real_twiddles_.resize(n + 1);
+            for (size_t k = 0; k <= n; k++)
+                real_twiddles_[k] = fft_root_<T>(k, 2 * n);
+
+            std::vector<size_t> radices;
+            size_t rest = n;
+            for (; rest % 4 == 0; rest /= 4)
+                radices.push_back(4);
+            for (; rest % 2 == 0; rest /= 2)
+                radices.push_back(2);
+            for (size_t p = 3; p * p <= rest; p += 2)
+                for (; rest % p == 0; rest /= p)
+                    radices.push_back(p);
+            if (rest > 1)
+                radices.push_back(rest);
+            if (!radices.empty() && *std::max_element(radices.begin(), radices.end()) > fft_max_radix_)
+                init_bluestein_();
+            else
+                init_stockham_(radices);
+        }
+
+        // The cached plan for length n, built on first use.
+        static std::shared_ptr<const fft_plan> get(size_t n) {
+            static std::mutex mutex;
+            static std::unordered_map<size_t, std::shared_ptr<const fft_plan>> cache;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                auto it = cache.find(n);
+                if (it != cache.end())
+                    return it->second;
+            }
+            // built unlocked: a Bluestein plan gets the plan of its padded length from here
+            auto plan = std::make_shared<const fft_plan>(n);
+            std::lock_guard<std::mutex> lock(mutex);
+            if (cache.size() >= fft_cache_size_)
+                cache.clear();
+            return cache.emplace(n, std::move(plan)).first->second;
+        }
+
+        [[nodiscard]] size_t size() const noexcept { return n_; }
+
+        // complex values of scratch space forward() and backward() need
+        [[nodiscard]] size_t scratch_size() const noexcept {
+            return inner_ ? inner_->size() + inner_->scratch_size() : n_;
+        }
+
+        // exp(-2 pi i k / (2 n)) for k in [0, n], to split a transform of 2 n real values into one of n complex ones
+        [[nodiscard]] const complex_type *real_twiddles() const noexcept { return real_twiddles_.data(); }
+
+        // The DFT of data[0, n) in place, unscaled.
+        void forward(complex_type *data, complex_type *scratch) const {
+            if (inner_) {
+                bluestein_(data, scratch);
+                return;
+            }
+            complex_type *in = data, *out = scratch;
+            size_t s = 1;
+            for (const stage_ &stage: stages_) {
+                switch (stage.radix) {
+                    case 2: pass_<2>(stage, in, out, s); break;
+                    case 3: pass_<3>(stage, in, out, s); break;
+                    case 4: pass_<4>(stage, in, out, s); break;
+                    case 5: pass_<5>(stage, in, out, s); break;
+                    default: generic_pass_(stage, in, out, s); break;
+                }
+                std::swap(in, out);
+                s *= stage.radix;
+            }
+            if (in != data)
+                std::copy(in, in + n_, data);
+        }
+
+        // The inverse DFT of data[0, n) in place, unscaled: n times numpy.fft.ifft.
+        void backward(complex_type *data, complex_type *scratch) const {
+            for (size_t k = 0; k < n_; k++)
+                data[k] = std::conj(data[k]);
+            forward(data, scratch);
+            for (size_t k = 0; k < n_; k++)
+                data[k] = std::conj(data[k]);
+        }
+
+    private:
+        struct stage_ {
+            size_t radix, m, twiddles, roots;
+        };
+
+        void init_stockham_(const std::vector<size_t> &radices) {
+            // stage j splits lines of length len into radix interleaved ones, twiddled by exp(-2 pi i j k / len)
+            size_t len = n_;
+            for (size_t p: radices) {
+                stage_ stage{p, len / p, twiddles_.size(), roots_.size()};
+                for (size_t j = 0; j < stage.m; j++)
+                    for (size_t k = 1; k < p; k++)
+                        twiddles_.push_back(fft_root_<T>(j * k, len));
+                if (p > 5)
+                    for (size_t k = 0; k < p; k++)
+                        roots_.push_back(fft_root_<T>(k, p));
+                stages_.push_back(stage);
+                len /= p;
+            }
+        }
+
+        // smallest 2^a 3^b 5^c >= n
+        static size_t good_size_(size_t n) {
+            for (;; n++) {
+                size_t rest = n;
+                for (size_t p: {2, 3, 5})
+                    for (; rest % p == 0; rest /= p) {}
+                if (rest == 1)
+                    return n;
+            }
+        }
+
+        // X[k] = c[k] sum of x[j] c[j] conj(c[k - j]) with the chirp c[k] = exp(-pi i k^2 / n): a circular
+        // convolution, zero-padded to a length with small factors
+        void init_bluestein_() {
+            size_t m = good_size_(2 * n_ - 1);
+            inner_ = get(m);
+            chirp_.resize(n_);
+            for (size_t k = 0; k < n_; k++)
+                chirp_[k] = fft_root_<T>(size_t(uint64_t(k) * k % (2 * uint64_t(n_))), 2 * n_);
+            kernel_.assign(m, complex_type());
+            kernel_[0] = std::conj(chirp_[0]);
+            for (size_t k = 1; k < n_; k++)
+                kernel_[k] = kernel_[m - k] = std::conj(chirp_[k]);
+            std::vector<complex_type> scratch(inner_->scratch_size());
+            inner_->forward(kernel_.data(), scratch.data());
+            for (auto &v: kernel_)
+                v *= T(1) / T(m);
+        }
+
+        void bluestein_(complex_type *data, complex_type *scratch) const {
+            size_t m = inner_->size();
+            complex_type *buffer = scratch;
+            for (size_t k = 0; k < n_; k++)
+                buffer[k] = cmul_(data[k], chirp_[k]);
+            std::fill(buffer + n_, buffer + m, complex_type());
+            inner_->forward(buffer, scratch + m);
+            for (size_t k = 0; k < m; k++)
+                buffer[k] = cmul_(buffer[k], kernel_[k]);
+            inner_->backward(buffer, scratch + m);
+            for (size_t k = 0; k < n_; k++)
+                data[k] = cmul_(buffer[k], chirp_[k]);
+        }
+
+        // One Stockham step: with s the product of the radices before it, out[q + s (P j + k)] is the k-th output of
+        // the butterfly on in[q + s (j + r m)], r in [0, P), times the twiddle exp(-2 pi i j k / (P m)).
+        template<size_t P>
+        void pass_(const stage_ &stage, const complex_type *in, complex_type *out, size_t s) const {
+            using vector_type = decltype(fft_load_(in));
+            size_t m = stage.m;
+            const complex_type *twiddles = twiddles_.data() + stage.twiddles;
+            for (size_t j = 0; j < m; j++) {
+                vector_type w[P - 1];
+                for (size_t k = 1; k < P; k++)
+                    w[k - 1] = fft_load_(twiddles + j * (P - 1) + k - 1);
+                for (size_t q = 0; q < s; q++) {
+                    vector_type a[P];
+                    for (size_t r = 0; r < P; r++)
+                        a[r] = fft_load_(in + q + s * (j + r * m));
+                    fft_butterfly_<P>(a, T());
+                    complex_type *dst = out + q + s * P * j;
+                    fft_store_(dst, a[0]);
+                    if (j == 0) {
+                        for (size_t k = 1; k < P; k++)
+                            fft_store_(dst + s * k, a[k]);
+                    } else {
+                        for (size_t k = 1; k < P; k++)
+                            fft_store_(dst + s * k, cmul_(a[k], w[k - 1]));
+                    }
+                }
+            }
+        }
+
+        // the same for an odd prime radix, with the butterfly as a direct DFT
+        void generic_pass_(const stage_ &stage, const complex_type *in, complex_type *out, size_t s) const {
+            size_t p = stage.radix, m = stage.m;
+            const complex_type *twiddles = twiddles_.data() + stage.twiddles, *roots = roots_.data() + stage.roots;
+            complex_type a[fft_max_radix_];
+            for (size_t j = 0; j < m; j++) {
+                for (size_t q = 0; q < s; q++) {
+                    for (size_t r = 0; r < p; r++)
+                        a[r] = in[q + s * (j + r * m)];
+                    complex_type *dst = out + q + s * p * j;
+                    for (size_t k = 0; k < p; k++) {
+                        complex_type sum = a[0];
+                        for (size_t r = 1, rk = k; r < p; r++, rk = rk + k < p ? rk + k : rk + k - p)
+                            sum += cmul_(a[r], roots[rk]);
+                        dst[s * k] = k == 0 ? sum : cmul_(sum, twiddles[j * (p - 1) + k - 1]);
+                    }
+                }
+            }
+        }
+
+        size_t n_;
+        std::vector<stage_> stages_;
+        std::vector<complex_type> twiddles_, roots_, real_twiddles_;
+        std::shared_ptr<const fft_plan> inner_;
+        std::vector<complex_type> chirp_, kernel_;
+    };
+
+    // Calls fn(in_line, out_line, scratch) for each of count lines along an axis, stride elements apart, of length
+    // in_length in in and out_length in out, with both lines contiguous. Lines of a strided axis are gathered
+    // fft_lanes_ at a time, so each row is read and written in whole cache lines. in and out may be the same array.
+    template<class T, class In, class Out, class Function>
+    void fft_lines_(const In *in, Out *out, size_t count, size_t stride, size_t in_length, size_t out_length,
+                    size_t scratch_size, Function fn) {
+        size_t length = std::max(in_length, out_length);
+        if (stride == 1) {
+            parallel_for(0, count, std::max(size_t(1), fft_grain_ / length), [&](size_t begin, size_t end) {
+                std::vector<std::complex<T>> scratch(scratch_size);
+                for (size_t line = begin; line < end; line++)
+                    fn(in + line * in_length, out + line * out_length, scratch.data());
+            });
+            return;
+        }
+
+        // padded, so that the gathered lines don't map to the same cache sets when the length is a power of two
+        size_t in_pitch = in_length + 64 / sizeof(In) + 1, out_pitch = out_length + 64 / sizeof(Out) + 1;
+        size_t chunks = (stride + fft_lanes_ - 1) / fft_lanes_;
+        size_t grain = std::max(size_t(1), fft_grain_ / (fft_lanes_ * length));
+        parallel_for(0, count / stride * chunks, grain, [&](size_t begin, size_t end) {
+            std::vector<In> ins(fft_lanes_ * in_pitch);
+            std::vector<Out> outs(fft_lanes_ * out_pitch);
+            std::vector<std::complex<T>> scratch(scratch_size);
+            for (size_t task = begin; task < end; task++) {
+                size_t first = task % chunks * fft_lanes_, lanes = std::min(fft_lanes_, stride - first);
+                const In *src = in + task / chunks * in_length * stride + first;
+                for (size_t i = 0; i < in_length; i++)
+                    for (size_t b = 0; b < lanes; b++)
+                        ins[b * in_pitch + i] = src[i * stride + b];
+                for (size_t b = 0; b < lanes; b++)
+                    fn(ins.data() + b * in_pitch, outs.data() + b * out_pitch, scratch.data());
+                Out *dst = out + task / chunks * out_length * stride + first;
+                for (size_t i = 0; i < out_length; i++)
+                    for (size_t b = 0; b < lanes; b++)
+                        dst[i * stride + b] = outs[b * out_pitch + i];
+            }
+        });
+    }
+
+    // Transforms the lines of in along axis a into out, which has the same shape and may be in.
+    template<class T, class Shape>
+    void fft_axis_(const std::complex<T> *in, std::complex<T> *out, const Shape &shape, size_t a, bool inverse,
+                   const char *name) {
+        auto lines = axis_lines_of_(shape, ptrdiff_t(a), name);
+        if (lines.length == 0)
+            throw std::runtime_error(std::string(name) + "(): invalid number of data points (0)");
+        if (lines.count == 0)
+            return;
+        auto plan = fft_plan<T>::get(lines.length);
+        size_t n = lines.length;
+        T scale = T(1) / T(n);
+        fft_lines_<T>(in, out, lines.count, lines.stride, n, n, plan->scratch_size(),
+                      [&](const std::complex<T> *src, std::complex<T> *dst, std::complex<T> *scratch) {
+                          if (src != dst)
+                              std::copy(src, src + n, dst);
+                          if (inverse) {
+                              plan->backward(dst, scratch);
+                              for (size_t k = 0; k < n; k++)
+                                  dst[k] *= scale;
+                          } else {
+                              plan->forward(dst, scratch);
+                          }
+                      });
+    }
+
+    // the axes of an N-D transform, all by default, innermost first: the first transform then reads the input along
+    // its contiguous axis
+    inline std::vector<size_t> fft_axes_(const std::vector<ptrdiff_t> &axes, size_t ndim, const char *name) {
+        std::vector<size_t> order;
+        if (axes.empty()) {
+            for (size_t d = 0; d < ndim; d++)
+                order.push_back(d);
+        } else {
+            for (ptrdiff_t axis: axes)
+                order.push_back(normalize_axis_(axis, ndim, name));
+        }
+        std::sort(order.begin(), order.end(), std::greater<>());
+        return order;
+    }
+
+    template<class T, class Container>
+    ndarray_impl<std::complex<T>, Container> fftn_(const ndarray_impl<std::complex<T>, Container> &arr,
+                                                   const std::vector<ptrdiff_t> &axes, bool inverse, const char *name) {
+        auto order = fft_axes_(axes, arr.ndim(), name);
+        ndarray_impl<std::complex<T>, Container> out(arr.shape());
+        const std::complex<T> *src = arr.data();
+        if (order.empty())
+            std::copy(src, src + arr.size(), out.data());
+        for (size_t a: order) {
+            fft_axis_(src, out.data(), arr.shape(), a, inverse, name);
+            src = out.data();
+        }
+        return out;
+    }
+
+    // The DFT along axis, like numpy.fft.fft.
+    template<class T, class Container>
+    ndarray_impl<std::complex<T>, Container> fft(const ndarray_impl<std::complex<T>, Container> &arr,
+                                                 ptrdiff_t axis = -1) {
+        ndarray_impl<std::complex<T>, Container> out(arr.shape());
+        fft_axis_(arr.data(), out.data(), arr.shape(), normalize_axis_(axis, arr.ndim(), "fft"), false, "fft");
+        return out;
+    }
+
+    // The inverse DFT along axis, scaled by 1/n, like numpy.fft.ifft.
+    template<class T, class Container>
+    ndarray_impl<std::complex<T>, Container> ifft(const ndarray_impl<std::complex<T>, Container> &arr,
+                                                  ptrdiff_t axis = -1) {
+        ndarray_impl<std::complex<T>, Container> out(arr.shape());
+        fft_axis_(arr.data(), out.data(), arr.shape(), normalize_axis_(axis, arr.ndim(), "ifft"), true, "ifft");
+        return out;
+    }
+
+    // The DFT over several axes, all by default, like numpy.fft.fftn. Repeated axes are transformed repeatedly.
+    template<class T, class Container>
+    ndarray_impl<std::complex<T>, Container> fftn(const ndarray_impl<std::complex<T>, Container> &arr,
+                                                  const std::vector<ptrdiff_t> &axes = {}) {
+        return fftn_(arr, axes, false, "fftn");
+    }
+
+    template<class T, class Container>
+    ndarray_impl<std::complex<T>, Container> ifftn(const ndarray_impl<std::complex<T>, Container> &arr,
+                                                   const std::vector<ptrdiff_t> &axes = {}) {
+        return fftn_(arr, axes, true, "ifftn");
+    }
+
+    // The DFT of real input along axis, like numpy.fft.rfft: the n / 2 + 1 non-negative frequencies. An even length
+    // is transformed as n / 2 complex values and split.
+    template<class T, class Container>
+    ndarray_impl<std::complex<T>, Container> rfft(const ndarray_impl<T, Container> &arr, ptrdiff_t axis = -1) {
+        static_assert(std::is_floating_point_v<T>, "rfft(): real input expected");
+        using complex_type = std::complex<T>;
+        size_t a = normalize_axis_(axis, arr.ndim(), "rfft");
+        auto lines = axis_lines_of_(arr.shape(), ptrdiff_t(a), "rfft");
+        size_t n = lines.length;
+        if (n == 0)
+            throw std::runtime_error("rfft(): invalid number of data points (0)");
+        auto shape = arr.shape();
+        shape[a] = n / 2 + 1;
+        ndarray_impl<complex_type, Container> out(shape);
+        if (lines.count == 0)
+            return out;
+
+        if (n % 2 == 1) {
+            auto plan = fft_plan<T>::get(n);
+            fft_lines_<T>(arr.data(), out.data(), lines.count, lines.stride, n, n / 2 + 1, n + plan->scratch_size(),
+                          [&](const T *src, complex_type *dst, complex_type *scratch) {
+                              for (size_t j = 0; j < n; j++)
+                                  scratch[j] = src[j];
+                              plan->forward(scratch, scratch + n);
+                              std::copy(scratch, scratch + n / 2 + 1, dst);
+                          });
+            return out;
+        }
+
+        size_t m = n / 2;
+        auto plan = fft_plan<T>::get(m);
+        const complex_type *w = plan->real_twiddles();
+        fft_lines_<T>(arr.data(), out.data(), lines.count, lines.stride, n, m + 1, plan->scratch_size(),
+                      [&](const T *src, complex_type *dst, complex_type *scratch) {
+                          // z[j] = x[2 j] + i x[2 j + 1], Z = E + i O from the DFTs E and O of even and odd samples
+                          for (size_t j = 0; j < m; j++)
+                              dst[j] = complex_type(src[2 * j], src[2 * j + 1]);
+                          plan->forward(dst, scratch);
+                          complex_type z0 = dst[0];
+                          dst[0] = complex_type(z0.real() + z0.imag(), 0);
+                          dst[m] = complex_type(z0.real() - z0.imag(), 0);
+                          for (size_t k = 1; k <= m - k; k++) {
+                              complex_type zk = dst[k], zc = std::conj(dst[m - k]);
+                              complex_type e = (zk + zc) * T(0.5), o = rot_(zk - zc) * T(0.5);
+                              dst[k] = e + cmul_(w[k], o);
+                              dst[m - k] = std::conj(e) + cmul_(w[m - k], std::conj(o));
+                          }
+                      });
+        return out;
+    }
+
+    // The inverse of rfft, like numpy.fft.irfft: n real values along axis, by default 2 (m - 1) for m input values.
+    // Input beyond n / 2 + 1 values is ignored, missing values are zeros, and the imaginary parts of the zero and
+    // (for even n) Nyquist frequencies are discarded.
+    template<class T, class Container>
+    ndarray_impl<T, Container> irfft(const ndarray_impl<std::complex<T>, Container> &arr, size_t n = 0,
+                                     ptrdiff_t axis = -1) {
+        using complex_type = std::complex<T>;
+        size_t a = normalize_axis_(axis, arr.ndim(), "irfft");
+        auto lines = axis_lines_of_(arr.shape(), ptrdiff_t(a), "irfft");
+        if (n == 0)
+            n = lines.length > 1 ? 2 * (lines.length - 1) : 0;
+        if (n == 0)
+            throw std::runtime_error("irfft(): invalid number of data points (0)");
+        auto shape = arr.shape();
+        shape[a] = n;
+        ndarray_impl<T, Container> out(shape);
+        if (lines.count == 0)
+            return out;
+        size_t kept = std::min(lines.length, n / 2 + 1);
+
+        if (n % 2 == 1) {
+            auto plan = fft_plan<T>::get(n);
+            T scale = T(1) / T(n);
+            fft_lines_<T>(arr.data(), out.data(), lines.count, lines.stride, lines.length, n,
+                          n + plan->scratch_size(), [&](const complex_type *src, T *dst, complex_type *scratch) {
+                        // the full Hermitian spectrum
+                        std::fill(scratch, scratch + n, complex_type());
+                        scratch[0] = kept > 0 ? src[0].real() : T(0);
+                        for (size_t k = 1; k < kept; k++) {
+                            scratch[k] = src[k];
+                            scratch[n - k] = std::conj(src[k]);
+                        }
+                        plan->backward(scratch, scratch + n);
+                        for (size_t j = 0; j < n; j++)
+                            dst[j] = scratch[j].real() * scale;
+                    });
+            return out;
+        }
+
+        size_t m = n / 2;
+        auto plan = fft_plan<T>::get(m);
+        const complex_type *w = plan->real_twiddles();
+        T scale = T(1) / T(m);
+        fft_lines_<T>(arr.data(), out.data(), lines.count, lines.stride, lines.length, n, m + plan->scratch_size(),
+                      [&](const complex_type *src, T *dst, complex_type *scratch) {
+                          auto x = [&](size_t k) { return k < kept ? src[k] : complex_type(); };
+                          // E = (X[k] + conj X[m - k]) / 2, O = (X[k] - conj X[m - k]) / (2 w[k]), Z = E + i O
+                          T x0 = x(0).real(), xm = x(m).real();
+                          scratch[0] = complex_type(x0 + xm, x0 - xm) * T(0.5);
+                          for (size_t k = 1; k < m; k++) {
+                              complex_type xk = x(k), xc = std::conj(x(m - k));
+                              complex_type e = xk + xc, o = cmul_(xk - xc, std::conj(w[k]));
+                              scratch[k] = (e - rot_(o)) * T(0.5);
+                          }
+                          plan->backward(scratch, scratch + m);
+                          for (size_t j = 0; j < m; j++) {
+                              dst[2 * j] = scratch[j].real() * scale;
+                              dst[2 * j + 1] = scratch[j].imag() * scale;
+                          }
+                      });
+        return out;
+    }
+
+}
@@ -0,0 +1,268 @@
+#pragma once
+
+#include <algorithm>    // copy, max, max_element, min, min_element
+#include <cmath>        // isfinite, isinf
+#include <cstddef>      // ptrdiff_t, size_t
+#include <limits>       // infinity, quiet_NaN
+#include <stdexcept>    // runtime_error
+#include <type_traits>  // is_integral_v
+#include <utility>      // move, pair
+#include <vector>
+#include "ndarray.hpp"
+#include "parallel.hpp"
+
+namespace cnumpy {
+
+    // Bins of a histogram: either count equal bins spanning [lo, hi], or the bins between increasing edges. Every bin
+    // includes its left edge, the last one also its right edge, as in numpy.histogram.
+    class histogram_bins {
+    public:
+        histogram_bins(size_t count, double lo, double hi) : count_(count), lo_(lo), hi_(hi), uniform_(true) {
+            if (count == 0 || !(lo < hi) || std::isinf(lo) || std::isinf(hi))
+                throw std::runtime_error("histogram_bins::histogram_bins(): invalid bins");
+            scale_ = double(count) / (hi - lo);
+            edges_.resize(count + 1);
+            for (size_t i = 0; i <= count; i++)
+                edges_[i] = lo + (hi - lo) * double(i) / double(count);
+            edges_[count] = hi;
+        }
+
+        explicit histogram_bins(std::vector<double> edges) : edges_(std::move(edges)) {
+            if (edges_.size() < 2)
+                throw std::runtime_error("histogram_bins::histogram_bins(): need at least two edges");
+            for (size_t i = 1; i < edges_.size(); i++)
+                if (!(edges_[i - 1] < edges_[i]))
+                    throw std::runtime_error("histogram_bins::histogram_bins(): edges must increase");
+            count_ = edges_.size() - 1;
+            lo_ = edges_.front();
+            hi_ = edges_.back();
+        }
+
+        // count equal bins spanning the finite values of arr; a single value gets the range [value - 0.5, value + 0.5]
+        template<class T, class Container>
+        static histogram_bins range(const ndarray_impl<T, Container> &arr, size_t count) {
+            double inf = std::numeric_limits<double>::infinity();
+            size_t nchunks = std::max(size_t(1), std::min(get_num_threads(), arr.size() / 65536));
+            std::vector<std::pair<double, double>> ranges(nchunks, {inf, -inf});
+            parallel_for(0, nchunks, 1, [&](size_t begin, size_t end) {
+                for (size_t c = begin; c < end; c++) {
+                    auto &[lo, hi] = ranges[c];
+                    for (size_t i = c * arr.size() / nchunks; i < (c + 1) * arr.size() / nchunks; i++) {
+                        auto value = double(arr.data()[i]);
+                        if (std::isfinite(value)) {
+                            lo = std::min(lo, value);
+                            hi = std::max(hi, value);
+                        }
+                    }
+                }
+            }, nchunks);
+            double lo = inf, hi = -inf;
+            for (auto [l, h] : ranges)
+                lo = std::min(lo, l), hi = std::max(hi, h);
+            if (lo > hi)
+                lo = 0, hi = 1;
+            else if (lo == hi)
+                lo -= 0.5, hi += 0.5;
+            return {count, lo, hi};
+        }
+
+        [[nodiscard]] size_t size() const noexcept { return count_; }
+
+        [[nodiscard]] const std::vector<double> &edges() const noexcept { return edges_; }
+
+        // Writes the bin of each of the n values to bin, size() for values outside the bins or NaN. Uniform bins are
+        // computed directly and then corrected against the edges, so both kinds of bins agree on values at the edges.
+        // Arbitrary edges use a branchless binary search that takes the same steps for every value, run on a block of
+        // values at a time so that the compiler can vectorize it.
+        template<class T>
+        void locate(const T *x, size_t n, size_t *bin) const {
+            const double *edges = edges_.data();
+            for (size_t first = 0; first < n; first += block_) {
+                size_t m = std::min(block_, n - first);
+                double values[block_];
+                bool inside[block_];
+                for (size_t i = 0; i < m; i++) {
+                    auto value = double(x[first + i]);
+                    inside[i] = value >= lo_ && value <= hi_;
+                    values[i] = inside[i] ? value : lo_;
+                }
+                size_t *b = bin + first;
+                if (uniform_) {
+                    for (size_t i = 0; i < m; i++) {
+                        double f = std::min((values[i] - lo_) * scale_, double(count_ - 1));
+                        size_t k = size_t(std::max(f, 0.0));
+                        k -= values[i] < edges[k];
+                        k += values[i] >= edges[k + 1] && k != count_ - 1;
+                        b[i] = k;
+                    }
+                } else {
+                    for (size_t i = 0; i < m; i++)
+                        b[i] = 0;
+                    for (size_t length = count_, half; length > 1; length -= half) {
+                        half = length / 2;
+                        for (size_t i = 0; i < m; i++)
+                            b[i] = edges[b[i] + half] <= values[i] ? b[i] + half : b[i];
+                    }
+                }
+                for (size_t i = 0; i < m; i++)
+                    b[i] = inside[i] ? b[i] : count_;
+            }
+        }
+
+        static constexpr size_t block_ = 256;
+
+    private:
+        size_t count_{};
+        double lo_{}, hi_{}, scale_{};
+        bool uniform_{};
+        std::vector<double> edges_;
+    };
+
+    // Splits [0, n) into one range per thread, lets fn(first, last, local) accumulate each range into a private
+    // array of nbins + 1 zero-initialized accumulators (the last one collects values outside the bins) and sums the
+    // private arrays into out, which has nbins elements.
+    template<class Acc, class Function>
+    void private_histograms_(size_t n, size_t nbins, Acc *out, Function &&fn) {
+        size_t nchunks = std::max(size_t(1), std::min(get_num_threads(), n / 65536));
+        std::vector<std::vector<Acc>> locals(nchunks);
+        parallel_for(0, nchunks, 1, [&](size_t begin, size_t end) {
+            for (size_t c = begin; c < end; c++) {
+                locals[c].assign(nbins + 1, Acc(0));
+                fn(c * n / nchunks, (c + 1) * n / nchunks, locals[c].data());
+            }
+        }, nchunks);
+        parallel_for(0, nbins, 4096, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                Acc sum = locals[0][i];
+                for (size_t c = 1; c < nchunks; c++)
+                    sum += locals[c][i];
+                out[i] = sum;
+            }
+        });
+    }
+
+    // Number of elements of the flattened array in each bin.
+    template<class T, class Container>
+    ndarray<size_t, 1> histogram(const ndarray_impl<T, Container> &arr, const histogram_bins &bins) {
+        ndarray<size_t, 1> out(bins.size());
+        private_histograms_(arr.size(), bins.size(), out.data(), [&](size_t first, size_t last, size_t *counts) {
+            size_t bin[histogram_bins::block_];
+            for (size_t i = first; i < last; i += histogram_bins::block_) {
+                size_t m = std::min(histogram_bins::block_, last - i);
+                bins.locate(arr.data() + i, m, bin);
+                for (size_t j = 0; j < m; j++)
+                    counts[bin[j]]++;
+            }
+        });
+        return out;
+    }
+
+    // Same as numpy.histogram(arr, count): count equal bins spanning the values, returned with the bin edges.
+    template<class T, class Container>
+    std::pair<ndarray<size_t, 1>, ndarray<double, 1>> histogram(const ndarray_impl<T, Container> &arr,
+                                                                size_t count = 10) {
+        auto bins = histogram_bins::range(arr, count);
+        ndarray<double, 1> edges(bins.edges().size());
+        std::copy(bins.edges().begin(), bins.edges().end(), edges.data());
+        return {histogram(arr, bins), std::move(edges)};
+    }
+
+    // Number of pairs (x[i], y[i]) of the flattened arrays in each bin of xbins times ybins.
+    template<class T, class Container1, class U, class Container2>
+    ndarray<size_t, 2> histogram2d(const ndarray_impl<T, Container1> &x, const ndarray_impl<U, Container2> &y,
+                                   const histogram_bins &xbins, const histogram_bins &ybins) {
+        if (x.size() != y.size())
+            throw std::runtime_error("histogram2d(): sizes do not match");
+        size_t nx = xbins.size(), ny = ybins.size();
+        ndarray<size_t, 2> out(nx, ny);
+        private_histograms_(x.size(), nx * ny, out.data(), [&](size_t first, size_t last, size_t *counts) {
+            size_t xbin[histogram_bins::block_], ybin[histogram_bins::block_];
+            for (size_t i = first; i < last; i += histogram_bins::block_) {
+                size_t m = std::min(histogram_bins::block_, last - i);
+                xbins.locate(x.data() + i, m, xbin);
+                ybins.locate(y.data() + i, m, ybin);
+                for (size_t j = 0; j < m; j++)
+                    counts[xbin[j] == nx || ybin[j] == ny ? nx * ny : xbin[j] * ny + ybin[j]]++;
+            }
+        });
+        return out;
+    }
+
+    // largest value of a non-negative integer array, or -1 if it is empty
+    template<class T, class Container>
+    ptrdiff_t bincount_max_(const ndarray_impl<T, Container> &arr) {
+        static_assert(std::is_integral_v<T>, "bincount() needs integers");
+        size_t nchunks = std::max(size_t(1), std::min(get_num_threads(), arr.size() / 65536));
+        std::vector<T> maxima(nchunks, T(0)), minima(nchunks, T(0));
+        parallel_for(0, nchunks, 1, [&](size_t begin, size_t end) {
+            for (size_t c = begin; c < end; c++)
+                for (size_t i = c * arr.size() / nchunks; i < (c + 1) * arr.size() / nchunks; i++) {
+                    maxima[c] = std::max(maxima[c], arr.data()[i]);
+                    minima[c] = std::min(minima[c], arr.data()[i]);
+                }
+        }, nchunks);
+        if (*std::min_element(minima.begin(), minima.end()) < T(0))
+            throw std::runtime_error("bincount(): negative values");
+        return arr.size() ? ptrdiff_t(*std::max_element(maxima.begin(), maxima.end())) : -1;
+    }
+
+    // Number of occurrences of every value of a non-negative integer array, at least minlength of them.
+    template<class T, class Container>
+    ndarray<size_t, 1> bincount(const ndarray_impl<T, Container> &arr, size_t minlength = 0) {
+        size_t nbins = std::max(size_t(bincount_max_(arr) + 1), minlength);
+        ndarray<size_t, 1> out(nbins);
+        private_histograms_(arr.size(), nbins, out.data(), [&](size_t first, size_t last, size_t *counts) {
+            for (size_t i = first; i < last; i++)
+                counts[size_t(arr.data()[i])]++;
+        });
+        return out;
+    }
+
+    // Sum of the weights of every value of a non-negative integer array, at least minlength of them.
+    template<class T, class Container1, class W, class Container2>
+    ndarray<double, 1> bincount(const ndarray_impl<T, Container1> &arr, const ndarray_impl<W, Container2> &weights,
+                                size_t minlength = 0) {
+        if (arr.size() != weights.size())
+            throw std::runtime_error("bincount(): sizes do not match");
+        size_t nbins = std::max(size_t(bincount_max_(arr) + 1), minlength);
+        ndarray<double, 1> out(nbins);
+        private_histograms_(arr.size(), nbins, out.data(), [&](size_t first, size_t last, double *sums) {
+            for (size_t i = first; i < last; i++)
+                sums[size_t(arr.data()[i])] += double(weights.data()[i]);
+        });
+        return out;
+    }
+
+    // Sum of values[i] over the elements x[i] of the flattened arrays in each bin.
+    template<class T, class Container1, class V, class Container2>
+    ndarray<double, 1> binned_sum(const ndarray_impl<T, Container1> &x, const ndarray_impl<V, Container2> &values,
+                                  const histogram_bins &bins) {
+        if (x.size() != values.size())
+            throw std::runtime_error("binned_sum(): sizes do not match");
+        ndarray<double, 1> out(bins.size());
+        private_histograms_(x.size(), bins.size(), out.data(), [&](size_t first, size_t last, double *sums) {
+            size_t bin[histogram_bins::block_];
+            for (size_t i = first; i < last; i += histogram_bins::block_) {
+                size_t m = std::min(histogram_bins::block_, last - i);
+                bins.locate(x.data() + i, m, bin);
+                for (size_t j = 0; j < m; j++)
+                    sums[bin[j]] += double(values.data()[i + j]);
+            }
+        });
+        return out;
+    }
+
+    // Mean of values[i] over the elements x[i] of the flattened arrays in each bin, NaN for empty bins.
+    template<class T, class Container1, class V, class Container2>
+    ndarray<double, 1> binned_mean(const ndarray_impl<T, Container1> &x, const ndarray_impl<V, Container2> &values,
+                                   const histogram_bins &bins) {
+        if (x.size() != values.size())
+            throw std::runtime_error("binned_mean(): sizes do not match");
+        auto sums = binned_sum(x, values, bins);
+        auto counts = histogram(x, bins);
+        for (size_t i = 0; i < bins.size(); i++)
+            sums(i) = counts(i) ? sums(i) / double(counts(i)) : std::numeric_limits<double>::quiet_NaN();
+        return sums;
+    }
+
+}
@@ -0,0 +1,288 @@
+#pragma once
+
+#include <algorithm>    // copy, min
+#include <array>
+#include <cstddef>      // ptrdiff_t, size_t
+#include <stdexcept>    // runtime_error
+#include <string>
+#include <type_traits>  // conditional_t, is_integral_v, is_signed_v
+#include <vector>
+#include "ndarray.hpp"
+#include "parallel.hpp"
+
+#if defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+namespace cnumpy {
+
+    inline constexpr size_t prefetch_distance_ = 16;   // elements gathered ahead
+    inline constexpr size_t mask_chunk_ = 1 << 16;     // elements per chunk of a mask compaction
+
+    inline void prefetch_(const void *address) {
+#if defined(__GNUC__)
+        __builtin_prefetch(address);
+#endif
+    }
+
+    // index in [0, n), counting from the end if negative
+    template<class I>
+    size_t wrap_index_(I index, size_t n, const char *name) {
+        static_assert(std::is_integral_v<I>);
+        if constexpr (std::is_signed_v<I>) {
+            auto i = ptrdiff_t(index);
+            if (i < 0)
+                i += ptrdiff_t(n);
+            if (i < 0 || size_t(i) >= n)
+                throw std::runtime_error(std::string(name) + "(): index out of range");
+            return size_t(i);
+        } else {
+            if (size_t(index) >= n)
+                throw std::runtime_error(std::string(name) + "(): index out of range");
+            return size_t(index);
+        }
+    }
+
+    template<class Container1, class Container2>
+    using take_container_ = std::conditional_t<rank_<Container1>::value != size_t(-1) &&
+                                               rank_<Container2>::value != size_t(-1),
+                                               std::array<size_t, rank_<Container1>::value - 1 +
+                                                                  rank_<Container2>::value>,
+                                               std::vector<size_t>>;
+
+    // Copies the rows src[o, index[j], :] to dst[o, j, :] for o < outer and j < m, where a row has inner elements and
+    // src has n of them per o. Rows are spread over threads; single elements are prefetched ahead.
+    template<class T, class I>
+    void gather_(const T *src, T *dst, const I *index, size_t outer, size_t n, size_t m, size_t inner,
+                 const char *name) {
+        if (inner == 1) {
+            parallel_for(0, outer * m, 4096, [&](size_t begin, size_t end) {
+                for (size_t r = begin; r < end; r++) {
+                    size_t o = r / m, j = r % m;
+                    if (j + prefetch_distance_ < m && size_t(index[j + prefetch_distance_]) < n)
+                        prefetch_(src + o * n + size_t(index[j + prefetch_distance_]));
+                    dst[r] = src[o * n + wrap_index_(index[j], n, name)];
+                }
+            });
+        } else {
+            parallel_for(0, outer * m, std::max(size_t(1), size_t(4096) / inner), [&](size_t begin, size_t end) {
+                for (size_t r = begin; r < end; r++) {
+                    size_t o = r / m, j = r % m;
+                    const T *row = src + (o * n + wrap_index_(index[j], n, name)) * inner;
+                    std::copy(row, row + inner, dst + r * inner);
+                }
+            });
+        }
+    }
+
+    // Elements of the flattened array at the given indices, in the shape of indices. Negative indices count from the
+    // end.
+    template<class T, class Container, class I, class IContainer>
+    ndarray_impl<T, IContainer> take(const ndarray_impl<T, Container> &arr,
+                                     const ndarray_impl<I, IContainer> &indices) {
+        ndarray_impl<T, IContainer> out(indices.shape());
+        gather_(arr.data(), out.data(), indices.data(), 1, arr.size(), indices.size(), 1, "take");
+        return out;
+    }
+
+    // Same as numpy.take along an axis: the result has the shape of arr with the axis replaced by the shape of
+    // indices.
+    template<class T, class Container, class I, class IContainer>
+    ndarray_impl<T, take_container_<Container, IContainer>>
+    take(const ndarray_impl<T, Container> &arr, const ndarray_impl<I, IContainer> &indices, ptrdiff_t axis) {
+        size_t a = normalize_axis_(axis, arr.ndim(), "take");
+        using container_type = take_container_<Container, IContainer>;
+        container_type shape{};
+        if constexpr (std::is_same<container_type, std::vector<size_t>>())
+            shape.resize(arr.ndim() - 1 + indices.ndim());
+        size_t outer = 1, inner = 1, r = 0;
+        for (size_t d = 0; d < a; d++)
+            outer *= shape[r++] = arr.shape()[d];
+        for (size_t d = 0; d < indices.ndim(); d++)
+            shape[r++] = indices.shape()[d];
+        for (size_t d = a + 1; d < arr.ndim(); d++)
+            inner *= shape[r++] = arr.shape()[d];
+        ndarray_impl<T, container_type> out(shape);
+        gather_(arr.data(), out.data(), indices.data(), outer, arr.shape()[a], indices.size(), inner, "take");
+        return out;
+    }
+
+    // Sets the elements of the flattened array at the given indices to values, which are repeated if there are fewer
+    // of them than indices. With repeated indices the last assignment wins, as in numpy.put.
+    template<class T, class Container, class I, class IContainer, class VContainer>
+    void put(ndarray_impl<T, Container> &arr, const ndarray_impl<I, IContainer> &indices,
+             const ndarray_impl<T, VContainer> &values) {
+        if (values.size() == 0 && indices.size() != 0)
+            throw std::runtime_error("put(): no values");
+        T *data = arr.data();
+        const I *index = indices.data();
+        size_t n = arr.size(), m = indices.size(), nv = values.size();
+        for (size_t j = 0, v = 0; j < m; j++, v = v + 1 == nv ? 0 : v + 1) {
+            if (j + prefetch_distance_ < m && size_t(index[j + prefetch_distance_]) < n)
+                prefetch_(data + size_t(index[j + prefetch_distance_]));
+            data[wrap_index_(index[j], n, "put")] = values.data()[v];
+        }
+    }
+
+    // Inverse of take() along an axis: arr[..., indices[j], ...] = values[..., j, ...], where values has the shape
+    // that take(arr, indices, axis) would return. Threads work on disjoint slices of the other axes, so the last
+    // assignment to a repeated index still wins.
+    template<class T, class Container, class I, class IContainer, class VContainer>
+    void put(ndarray_impl<T, Container> &arr, const ndarray_impl<I, IContainer> &indices,
+             const ndarray_impl<T, VContainer> &values, ptrdiff_t axis) {
+        size_t a = normalize_axis_(axis, arr.ndim(), "put");
+        bool match = values.ndim() == arr.ndim() - 1 + indices.ndim();
+        size_t outer = 1, inner = 1, r = 0;
+        for (size_t d = 0; match && d < a; d++)
+            outer *= arr.shape()[d], match = values.shape()[r++] == arr.shape()[d];
+        for (size_t d = 0; match && d < indices.ndim(); d++)
+            match = values.shape()[r++] == indices.shape()[d];
+        for (size_t d = a + 1; match && d < arr.ndim(); d++)
+            inner *= arr.shape()[d], match = values.shape()[r++] == arr.shape()[d];
+        if (!match)
+            throw std::runtime_error("put(): shape of values does not match");
+
+        size_t n = arr.shape()[a], m = indices.size();
+        T *data = arr.data();
+        auto scatter = [&](size_t o, size_t first, size_t last) {
+            for (size_t j = 0; j < m; j++) {
+                const T *row = values.data() + (o * m + j) * inner;
+                T *dst = data + (o * n + wrap_index_(indices.data()[j], n, "put")) * inner;
+                std::copy(row + first, row + last, dst + first);
+            }
+        };
+        if (outer >= get_num_threads()) {
+            parallel_for(0, outer, 1, [&](size_t begin, size_t end) {
+                for (size_t o = begin; o < end; o++)
+                    scatter(o, 0, inner);
+            });
+        } else {
+            for (size_t o = 0; o < outer; o++)
+                parallel_for(0, inner, 1024, [&](size_t begin, size_t end) { scatter(o, begin, end); });
+        }
+    }
+
+    // Writes src[i] for every i < n whose mask is nonzero to consecutive elements of dst, returns how many.
+    template<class T, class M>
+    size_t compress_kernel_(const M *mask, const T *src, size_t n, T *dst) {
+        size_t i = 0, count = 0;
+#if defined(__AVX512F__)
+        if constexpr (sizeof(M) == 1 && sizeof(T) == 4 && std::is_trivially_copyable_v<T>) {
+            for (; i + 16 <= n; i += 16) {
+                __m512i m = _mm512_cvtepu8_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(mask + i)));
+                __mmask16 k = _mm512_test_epi32_mask(m, m);
+                _mm512_mask_compressstoreu_epi32(dst + count, k, _mm512_loadu_si512(src + i));
+                count += size_t(__builtin_popcount(k));
+            }
+        } else if constexpr (sizeof(M) == 1 && sizeof(T) == 8 && std::is_trivially_copyable_v<T>) {
+            for (; i + 8 <= n; i += 8) {
+                __m512i m = _mm512_cvtepu8_epi64(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(mask + i)));
+                __mmask8 k = _mm512_test_epi64_mask(m, m);
+                _mm512_mask_compressstoreu_epi64(dst + count, k, _mm512_loadu_si512(src + i));
+                count += size_t(__builtin_popcount(k));
+            }
+        }
+#endif
+        for (; i < n; i++)
+            if (mask[i] != M(0))
+                dst[count++] = src[i];
+        return count;
+    }
+
+    // Writes first + i for every i < n whose mask is nonzero to consecutive elements of dst, returns how many.
+    template<class M>
+    size_t index_kernel_(const M *mask, size_t first, size_t n, size_t *dst) {
+        size_t i = 0, count = 0;
+#if defined(__AVX512F__)
+        if constexpr (sizeof(M) == 1 && sizeof(size_t) == 8) {
+            const __m512i lanes = _mm512_set_epi64(7, 6, 5, 4, 3, 2, 1, 0);
+            for (; i + 8 <= n; i += 8) {
+                __m512i m = _mm512_cvtepu8_epi64(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(mask + i)));
+                __mmask8 k = _mm512_test_epi64_mask(m, m);
+                __m512i index = _mm512_add_epi64(_mm512_set1_epi64(ptrdiff_t(first + i)), lanes);
+                _mm512_mask_compressstoreu_epi64(dst + count, k, index);
+                count += size_t(__builtin_popcount(k));
+            }
+        }
+#endif
+        for (; i < n; i++)
+            if (mask[i] != M(0))
+                dst[count++] = first + i;
+        return count;
+    }
+
+    // Two-pass compaction: counts the nonzero mask elements of every chunk in parallel, then lets every chunk write
+    // its selection from the offset given by the counts of the chunks before it. kernel(first, last, dst) writes the
+    // selection of [first, last) to dst.
+    template<class T, class M, class Kernel>
+    ndarray<T, 1> compact_(const M *mask, size_t n, Kernel &&kernel) {
+        size_t nchunks = (n + mask_chunk_ - 1) / mask_chunk_;
+        std::vector<size_t> offsets(nchunks + 1, 0);
+        parallel_for(0, nchunks, 1, [&](size_t begin, size_t end) {
+            for (size_t c = begin; c < end; c++) {
+                size_t count = 0;
+                for (size_t i = c * mask_chunk_; i < std::min(n, (c + 1) * mask_chunk_); i++)
+                    count += mask[i] != M(0);
+                offsets[c + 1] = count;
+            }
+        });
+        for (size_t c = 0; c < nchunks; c++)
+            offsets[c + 1] += offsets[c];
+
+        ndarray<T, 1> out(offsets[nchunks]);
+        parallel_for(0, nchunks, 1, [&](size_t begin, size_t end) {
+            for (size_t c = begin; c < end; c++)
+                kernel(c * mask_chunk_, std::min(n, (c + 1) * mask_chunk_), out.data() + offsets[c]);
+        });
+        return out;
+    }
+
+    // Elements of the flattened array whose flattened mask element is nonzero, like arr[mask] in numpy when both
+    // have the same shape. The mask may be shorter than the array.
+    template<class M, class MContainer, class T, class Container>
+    ndarray<T, 1> compress(const ndarray_impl<M, MContainer> &mask, const ndarray_impl<T, Container> &arr) {
+        if (mask.size() > arr.size())
+            throw std::runtime_error("compress(): mask is longer than the array");
+        return compact_<T>(mask.data(), mask.size(), [&](size_t first, size_t last, T *dst) {
+            compress_kernel_(mask.data() + first, arr.data() + first, last - first, dst);
+        });
+    }
+
+    // Flattened indices of the nonzero elements.
+    template<class T, class Container>
+    ndarray<size_t, 1> flatnonzero(const ndarray_impl<T, Container> &arr) {
+        return compact_<size_t>(arr.data(), arr.size(), [&](size_t first, size_t last, size_t *dst) {
+            index_kernel_(arr.data() + first, first, last - first, dst);
+        });
+    }
+
+    // Slices of arr along axis whose element of the one-dimensional mask is nonzero, like numpy.compress.
+    template<class M, class MContainer, class T, class Container>
+    ndarray_impl<T, Container>
+    compress(const ndarray_impl<M, MContainer> &mask, const ndarray_impl<T, Container> &arr, ptrdiff_t axis) {
+        size_t a = normalize_axis_(axis, arr.ndim(), "compress");
+        if (mask.ndim() != 1 || mask.size() > arr.shape()[a])
+            throw std::runtime_error("compress(): mask must be one-dimensional and not longer than the axis");
+        return take(arr, flatnonzero(mask), ptrdiff_t(a));
+    }
+
+    // Indices of the nonzero elements, one array per dimension, like numpy.nonzero.
+    template<class T, class Container>
+    std::vector<ndarray<size_t, 1>> nonzero(const ndarray_impl<T, Container> &arr) {
+        auto flat = flatnonzero(arr);
+        std::vector<ndarray<size_t, 1>> out;
+        for (size_t d = 0; d < arr.ndim(); d++)
+            out.emplace_back(flat.size());
+        parallel_for(0, flat.size(), 4096, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                size_t index = flat.data()[i];
+                for (size_t d = arr.ndim(); d-- > 0;) {
+                    out[d].data()[i] = index % arr.shape()[d];
+                    index /= arr.shape()[d];
+                }
+            }
+        });
+        return out;
+    }
+
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>      // size_t
+#include <cstdint>      // uint64_t
+#include <type_traits>  // is_same_v
+#include <utility>      // move
+
+// Opt-in instrumentation: compile with CNUMPY_INSTRUMENTATION defined (in every translation unit) to count
+// allocations, copies and NPY I/O. Without it, the counters and timers compile to nothing.
+namespace cnumpy::instrument {
+
+#ifdef CNUMPY_INSTRUMENTATION
+    inline constexpr bool enabled = true;
+#else
+    inline constexpr bool enabled = false;
+#endif
+
+    enum class counter : size_t {
+        allocations,            // arrays given their own memory
+        allocated_bytes,
+        deep_copies,            // copy construction and copy assignment
+        copied_bytes,
+        shares,                 // arrays aliasing existing memory: make_shared and wrapped pointers
+        npy_loads,
+        npy_load_bytes,         // array data only, headers excluded
+        npy_load_ns,
+        npy_saves,
+        npy_save_bytes,
+        npy_save_ns,
+        byteswaps,              // loads converting the byte order
+        byteswap_bytes,
+        byteswap_ns,
+        count_
+    };
+
+    inline constexpr const char *counter_names_[size_t(counter::count_)] = {
+            "allocations", "allocated_bytes", "deep_copies", "copied_bytes", "shares", "npy_loads", "npy_load_bytes",
+            "npy_load_ns", "npy_saves", "npy_save_bytes", "npy_save_ns", "byteswaps", "byteswap_bytes",
+            "byteswap_ns"};
+
+    inline std::atomic<uint64_t> *counters_() noexcept {
+        static std::atomic<uint64_t> counters[size_t(counter::count_)]{};
+        return counters;
+    }
+
+    inline void add(counter c, uint64_t value) noexcept {
+        if constexpr (enabled)
+            counters_()[size_t(c)].fetch_add(value, std::memory_order_relaxed);
+    }
+
+    // The values of all counters at one point in time; subtract two snapshots to get the activity in between.
+    struct counters {
+        uint64_t values[size_t(counter::count_)]{};
+
+        uint64_t operator[](counter c) const noexcept { return values[size_t(c)]; }
+
+        counters operator-(const counters &other) const noexcept {
+            counters diff;
+            for (size_t i = 0; i < size_t(counter::count_); i++)
+                diff.values[i] = values[i] - other.values[i];
+            return diff;
+        }
+
+        // calls fn(name, value) for every counter, e.g. to export them to a metrics system
+        template<class Function>
+        void for_each(Function &&fn) const {
+            for (size_t i = 0; i < size_t(counter::count_); i++)
+                fn(counter_names_[i], values[i]);
+        }
+    };
+
+    // Counters are updated with relaxed atomics, so a snapshot taken while other threads work is not a consistent cut.
+    inline counters snapshot() noexcept {
+        counters out;
+        if constexpr (enabled)
+            for (size_t i = 0; i < size_t(counter::count_); i++)
+                out.values[i] = counters_()[i].load(std::memory_order_relaxed);
+        return out;
+    }
+
+    inline void reset() noexcept {
+        if constexpr (enabled)
+            for (size_t i = 0; i < size_t(counter::count_); i++)
+                counters_()[i].store(0, std::memory_order_relaxed);
+    }
+
+    // Measures the time from construction to destruction and adds it in nanoseconds to a counter, or passes it as
+    // std::chrono::nanoseconds to a callback. Like the counters, does nothing without CNUMPY_INSTRUMENTATION.
+    template<class Callback = counter>
+    class scoped_timer {
+    public:
+        explicit scoped_timer(Callback callback) : callback_(std::move(callback)) {
+            if constexpr (enabled)
+                start_ = std::chrono::steady_clock::now();
+        }
+
+        scoped_timer(const scoped_timer &) = delete;
+
+        scoped_timer &operator=(const scoped_timer &) = delete;
+
+        ~scoped_timer() {
+            if constexpr (enabled) {
+                auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now() - start_);
+                if constexpr (std::is_same_v<Callback, counter>)
+                    add(callback_, uint64_t(elapsed.count()));
+                else
+                    callback_(elapsed);
+            }
+        }
+
+    private:
+        Callback callback_;
+        std::chrono::steady_clock::time_point start_;
+    };
+
+}
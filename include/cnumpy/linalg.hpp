@@ -0,0 +1,272 @@
+#pragma once
+
+#include <algorithm>    // fill, min
+#include <array>
+#include <cstddef>      // ptrdiff_t, size_t
+#include <cstring>      // memcpy
+#include <stdexcept>    // runtime_error
+#include <type_traits>  // conditional_t, is_same
+#include <vector>
+#include "ndarray.hpp"
+#include "parallel.hpp"
+
+#ifndef CNUMPY_SIMD_BYTES
+#if defined(__AVX512F__)
+#define CNUMPY_SIMD_BYTES 64
+#elif defined(__AVX__)
+#define CNUMPY_SIMD_BYTES 32
+#else
+#define CNUMPY_SIMD_BYTES 16
+#endif
+#endif
+
+namespace cnumpy {
+
+    // Register tile and cache block sizes of gemm(). The micro-kernel keeps an mr x nr block of C in registers, a
+    // kc x nr sliver of B is meant to stay in L1, an mc x kc block of A in L2 and a kc x nc panel of B in L3.
+    template<class T>
+    struct gemm_traits {
+#if defined(__GNUC__) || defined(__clang__)
+        static constexpr bool simd = std::is_same<T, float>() || std::is_same<T, double>();
+#else
+        static constexpr bool simd = false;
+#endif
+        static constexpr size_t lanes = simd ? CNUMPY_SIMD_BYTES / sizeof(T) : 1;
+        static constexpr size_t mr = 4;
+        static constexpr size_t nr = simd ? 2 * lanes : 4;
+        static constexpr size_t kc = 256;
+        static constexpr size_t mc = 128;
+        static constexpr size_t nc = 2048 / nr * nr;
+    };
+
+    // Computes C = alpha * A * B + beta * C where A is m x k, B is k x n and C is m x n. Every matrix is addressed
+    // through a row stride and a column stride in elements, so transposed or otherwise strided operands are read in
+    // place; swapping the strides of an operand transposes it. C is not read when beta is zero. Blocks of C are
+    // distributed over at most nthreads threads (get_num_threads() if zero).
+    template<class T>
+    void gemm(size_t m, size_t n, size_t k, T alpha,
+              const T *a, ptrdiff_t rsa, ptrdiff_t csa,
+              const T *b, ptrdiff_t rsb, ptrdiff_t csb,
+              T beta, T *c, ptrdiff_t rsc, ptrdiff_t csc, size_t nthreads = 0) {
+        using traits = gemm_traits<T>;
+        constexpr size_t MR = traits::mr, NR = traits::nr, KC = traits::kc, MC = traits::mc, NC = traits::nc;
+
+        if (m == 0 || n == 0)
+            return;
+        if (k == 0 || alpha == T(0)) {
+            for (size_t i = 0; i < m; i++)
+                for (size_t j = 0; j < n; j++) {
+                    T &cij = c[ptrdiff_t(i) * rsc + ptrdiff_t(j) * csc];
+                    cij = beta == T(0) ? T(0) : beta * cij;
+                }
+            return;
+        }
+
+        // updates an mr x nr block of C from the packed slivers of A and B
+        auto kernel = [&](size_t kc, const T *ap, const T *bp, T *cp, size_t mr, size_t nr, T beta_) {
+            alignas(64) T tile[MR][NR];
+#if defined(__GNUC__) || defined(__clang__)
+            if constexpr (traits::simd) {
+                typedef T vec __attribute__((vector_size(CNUMPY_SIMD_BYTES)));
+                constexpr size_t NV = NR / traits::lanes;
+                vec acc[MR][NV] = {};
+                for (size_t p = 0; p < kc; p++) {
+                    vec bv[NV];
+                    std::memcpy(bv, bp + p * NR, sizeof(bv));
+                    for (size_t i = 0; i < MR; i++) {
+                        vec ai = vec{} + ap[p * MR + i];
+                        for (size_t v = 0; v < NV; v++)
+                            acc[i][v] += ai * bv[v];
+                    }
+                }
+                std::memcpy(tile, acc, sizeof(tile));
+            } else
+#endif
+            {
+                for (size_t i = 0; i < MR; i++)
+                    for (size_t j = 0; j < NR; j++)
+                        tile[i][j] = T(0);
+                for (size_t p = 0; p < kc; p++)
+                    for (size_t i = 0; i < MR; i++)
+                        for (size_t j = 0; j < NR; j++)
+                            tile[i][j] += ap[p * MR + i] * bp[p * NR + j];
+            }
+            for (size_t i = 0; i < mr; i++)
+                for (size_t j = 0; j < nr; j++) {
+                    T &cij = cp[ptrdiff_t(i) * rsc + ptrdiff_t(j) * csc];
+                    cij = beta_ == T(0) ? alpha * tile[i][j] : alpha * tile[i][j] + beta_ * cij;
+                }
+        };
+
+        size_t mblocks = (m + MC - 1) / MC;
+        nthreads = nthreads ? nthreads : get_num_threads();
+        std::vector<T> bpack;
+
+        for (size_t jc = 0; jc < n; jc += NC) {
+            size_t nc = std::min(NC, n - jc);
+            size_t npanels = (nc + NR - 1) / NR;
+            for (size_t pc = 0; pc < k; pc += KC) {
+                size_t kc = std::min(KC, k - pc);
+                T beta_ = pc == 0 ? beta : T(1);
+
+                // pack B into kc x nr slivers, zero-padded at the right edge
+                bpack.resize(npanels * kc * NR);
+                parallel_for(0, npanels, 16, [&](size_t begin, size_t end) {
+                    for (size_t jr = begin; jr < end; jr++) {
+                        T *dst = bpack.data() + jr * kc * NR;
+                        size_t nr = std::min(NR, nc - jr * NR);
+                        const T *src = b + ptrdiff_t(pc) * rsb + ptrdiff_t(jc + jr * NR) * csb;
+                        for (size_t p = 0; p < kc; p++, dst += NR) {
+                            for (size_t j = 0; j < nr; j++)
+                                dst[j] = src[ptrdiff_t(p) * rsb + ptrdiff_t(j) * csb];
+                            for (size_t j = nr; j < NR; j++)
+                                dst[j] = T(0);
+                        }
+                    }
+                }, nthreads);
+
+                // split the columns as well when there are fewer blocks of rows than threads
+                size_t nparts = std::min(npanels, std::max(size_t(1), nthreads / mblocks));
+                size_t part_panels = (npanels + nparts - 1) / nparts;
+                parallel_for(0, mblocks * nparts, 1, [&](size_t begin, size_t end) {
+                    thread_local std::vector<T> apack;
+                    for (size_t task = begin; task < end; task++) {
+                        size_t ic = task / nparts * MC, part = task % nparts;
+                        size_t mc = std::min(MC, m - ic);
+
+                        // pack A into kc x mr slivers, zero-padded at the bottom edge
+                        apack.resize((mc + MR - 1) / MR * MR * kc);
+                        for (size_t ir = 0; ir < mc; ir += MR) {
+                            T *dst = apack.data() + ir * kc;
+                            size_t mr = std::min(MR, mc - ir);
+                            const T *src = a + ptrdiff_t(ic + ir) * rsa + ptrdiff_t(pc) * csa;
+                            for (size_t p = 0; p < kc; p++, dst += MR) {
+                                for (size_t i = 0; i < mr; i++)
+                                    dst[i] = src[ptrdiff_t(i) * rsa + ptrdiff_t(p) * csa];
+                                for (size_t i = mr; i < MR; i++)
+                                    dst[i] = T(0);
+                            }
+                        }
+
+                        size_t jr_end = std::min(npanels, (part + 1) * part_panels);
+                        for (size_t jr = part * part_panels; jr < jr_end; jr++) {
+                            size_t nr = std::min(NR, nc - jr * NR);
+                            for (size_t ir = 0; ir < mc; ir += MR) {
+                                T *cp = c + ptrdiff_t(ic + ir) * rsc + ptrdiff_t(jc + jr * NR) * csc;
+                                kernel(kc, apack.data() + ir * kc, bpack.data() + jr * kc * NR, cp,
+                                       std::min(MR, mc - ir), nr, beta_);
+                            }
+                        }
+                    }
+                }, nthreads);
+            }
+        }
+    }
+
+    template<class Container1, class Container2>
+    using matmul_container_ = std::conditional_t<rank_<Container1>::value != size_t(-1) &&
+                                                 rank_<Container1>::value == rank_<Container2>::value,
+                                                 Container1, std::vector<size_t>>;
+
+    // Matrix product of the last two axes, batched over the leading axes, which must be equal for both operands.
+    // transpose_a and transpose_b swap the last two axes of the corresponding operand without copying it.
+    template<class T, class Container1, class Container2>
+    ndarray_impl<T, matmul_container_<Container1, Container2>>
+    matmul(const ndarray_impl<T, Container1> &a, const ndarray_impl<T, Container2> &b,
+           bool transpose_a = false, bool transpose_b = false) {
+        size_t ndim = a.ndim();
+        if (ndim < 2 || b.ndim() != ndim)
+            throw std::runtime_error("matmul(): operands must have the same number of dimensions, at least two");
+        for (size_t d = 0; d + 2 < ndim; d++)
+            if (a.shape()[d] != b.shape()[d])
+                throw std::runtime_error("matmul(): batch dimensions do not match");
+
+        size_t ra = a.shape()[ndim - 2], ca = a.shape()[ndim - 1];
+        size_t rb = b.shape()[ndim - 2], cb = b.shape()[ndim - 1];
+        size_t m = transpose_a ? ca : ra, k = transpose_a ? ra : ca;
+        size_t n = transpose_b ? rb : cb;
+        if ((transpose_b ? cb : rb) != k)
+            throw std::runtime_error("matmul(): inner dimensions do not match");
+
+        using container_type = matmul_container_<Container1, Container2>;
+        container_type shape{};
+        if constexpr (std::is_same<container_type, std::vector<size_t>>())
+            shape.resize(ndim);
+        for (size_t d = 0; d + 2 < ndim; d++)
+            shape[d] = a.shape()[d];
+        shape[ndim - 2] = m;
+        shape[ndim - 1] = n;
+        ndarray_impl<T, container_type> out(shape);
+
+        size_t batch = out.size() / std::max(m * n, size_t(1));
+        if (m * n == 0)
+            return out;
+        ptrdiff_t rsa = transpose_a ? 1 : ptrdiff_t(ca), csa = transpose_a ? ptrdiff_t(ca) : 1;
+        ptrdiff_t rsb = transpose_b ? 1 : ptrdiff_t(cb), csb = transpose_b ? ptrdiff_t(cb) : 1;
+        auto multiply = [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++)
+                gemm<T>(m, n, k, T(1), a.data() + i * ra * ca, rsa, csa, b.data() + i * rb * cb, rsb, csb,
+                        T(0), out.data() + i * m * n, ptrdiff_t(n), 1);
+        };
+        // many small products are spread over threads as a whole, few large ones are parallelized inside gemm
+        if (batch >= get_num_threads())
+            parallel_for(0, batch, 1, multiply);
+        else
+            multiply(0, batch);
+        return out;
+    }
+
+    constexpr size_t dot_rank_(size_t na, size_t nb) {
+        if (na == size_t(-1) || nb == size_t(-1) || na == 0 || nb == 0)
+            return size_t(-1);
+        return nb == 1 ? na - 1 : na + nb - 2;
+    }
+
+    template<class Container1, class Container2>
+    using dot_container_ = std::conditional_t<dot_rank_(rank_<Container1>::value, rank_<Container2>::value) !=
+                                              size_t(-1),
+                                              std::array<size_t, dot_rank_(rank_<Container1>::value,
+                                                                           rank_<Container2>::value)>,
+                                              std::vector<size_t>>;
+
+    // Same as numpy.dot: the sum product over the last axis of a and the second-to-last axis of b (the only axis if b
+    // is one-dimensional). Both operands must have at least one dimension.
+    template<class T, class Container1, class Container2>
+    ndarray_impl<T, dot_container_<Container1, Container2>>
+    dot(const ndarray_impl<T, Container1> &a, const ndarray_impl<T, Container2> &b) {
+        size_t na = a.ndim(), nb = b.ndim();
+        if (na == 0 || nb == 0)
+            throw std::runtime_error("dot(): operands must have at least one dimension");
+        size_t k = a.shape()[na - 1];
+        size_t kb = nb == 1 ? b.shape()[0] : b.shape()[nb - 2];
+        if (k != kb)
+            throw std::runtime_error("dot(): inner dimensions do not match");
+        size_t n = nb == 1 ? 1 : b.shape()[nb - 1];
+        size_t m = 1;
+        for (size_t d = 0; d + 1 < na; d++)
+            m *= a.shape()[d];
+        size_t batch = 1;
+        for (size_t d = 0; d + 2 < nb; d++)
+            batch *= b.shape()[d];
+
+        using container_type = dot_container_<Container1, Container2>;
+        container_type shape{};
+        if constexpr (std::is_same<container_type, std::vector<size_t>>())
+            shape.resize(na - 1 + (nb == 1 ? 0 : nb - 1));
+        size_t r = 0;
+        for (size_t d = 0; d + 1 < na; d++)
+            shape[r++] = a.shape()[d];
+        for (size_t d = 0; d + 2 < nb; d++)
+            shape[r++] = b.shape()[d];
+        if (nb > 1)
+            shape[r++] = n;
+        ndarray_impl<T, container_type> out(shape);
+
+        // out[i, j, l] = sum_p a[i, p] * b[j, p, l], one product per leading index j of b
+        for (size_t j = 0; j < batch; j++)
+            gemm<T>(m, n, k, T(1), a.data(), ptrdiff_t(k), 1, b.data() + j * k * n, ptrdiff_t(n), 1,
+                    T(0), out.data() + j * n, ptrdiff_t(batch * n), 1);
+        return out;
+    }
+
+}
@@ -0,0 +1,184 @@
+#pragma once
+
+#include <algorithm>    // copy, max, min
+#include <array>
+#include <cstddef>      // ptrdiff_t, size_t
+#include <stdexcept>    // runtime_error
+#include <type_traits>  // conditional_t, is_same
+#include <utility>      // as_const, pair
+#include <vector>
+#include "ndarray.hpp"
+#include "parallel.hpp"
+
+namespace cnumpy {
+
+    template<class Container>
+    using stack_container_ = std::conditional_t<rank_<Container>::value != size_t(-1),
+                                                std::array<size_t, rank_<Container>::value + 1>,
+                                                std::vector<size_t>>;
+
+    // Copies, for every o < outer, the blocks arrays[i].data()[o * lengths[i], ...) of lengths[i] elements one after
+    // the other into the row o of dst. The copies are spread over threads by input and by rows, each task moving at
+    // least a few hundred kilobytes when there is that much.
+    template<class T, class Container>
+    void concatenate_blocks_(const std::vector<ndarray_impl<T, Container>> &arrays, size_t outer,
+                             const std::vector<size_t> &lengths, T *dst) {
+        std::vector<size_t> offsets(arrays.size() + 1, 0);
+        for (size_t i = 0; i < arrays.size(); i++)
+            offsets[i + 1] = offsets[i] + lengths[i];
+        size_t row = offsets.back();
+        size_t average = std::max(row / std::max(arrays.size(), size_t(1)), size_t(1));
+        size_t grain = std::max(size_t(1), (size_t(1) << 16) / average);
+        parallel_for(0, arrays.size() * outer, grain, [&](size_t begin, size_t end) {
+            for (size_t r = begin; r < end; r++) {
+                size_t i = r / outer, o = r % outer;
+                const T *src = arrays[i].data() + o * lengths[i];
+                std::copy(src, src + lengths[i], dst + o * row + offsets[i]);
+            }
+        });
+    }
+
+    // Joins arrays along an existing axis. All arrays must have the same shape except along the axis.
+    template<class T, class Container>
+    ndarray_impl<T, Container> concatenate(const std::vector<ndarray_impl<T, Container>> &arrays, ptrdiff_t axis = 0) {
+        if (arrays.empty())
+            throw std::runtime_error("concatenate(): need at least one array");
+        const Container &first = arrays.front().shape();
+        size_t a = normalize_axis_(axis, first.size(), "concatenate");
+        Container shape = first;
+        shape[a] = 0;
+        std::vector<size_t> lengths;
+        for (const auto &arr : arrays) {
+            if (arr.ndim() != first.size())
+                throw std::runtime_error("concatenate(): arrays must have the same number of dimensions");
+            for (size_t d = 0; d < first.size(); d++)
+                if (d != a && arr.shape()[d] != first[d])
+                    throw std::runtime_error("concatenate(): shapes do not match");
+            shape[a] += arr.shape()[a];
+            lengths.push_back(arr.shape()[a]);
+        }
+        size_t outer = 1, inner = 1;
+        for (size_t d = 0; d < a; d++)
+            outer *= first[d];
+        for (size_t d = a + 1; d < first.size(); d++)
+            inner *= first[d];
+        for (auto &length : lengths)
+            length *= inner;
+
+        ndarray_impl<T, Container> out(shape);
+        concatenate_blocks_(arrays, outer, lengths, out.data());
+        return out;
+    }
+
+    // Joins arrays of the same shape along a new axis.
+    template<class T, class Container>
+    ndarray_impl<T, stack_container_<Container>>
+    stack(const std::vector<ndarray_impl<T, Container>> &arrays, ptrdiff_t axis = 0) {
+        if (arrays.empty())
+            throw std::runtime_error("stack(): need at least one array");
+        const Container &first = arrays.front().shape();
+        for (const auto &arr : arrays)
+            if (arr.ndim() != first.size() || !std::equal(first.begin(), first.end(), arr.shape().begin()))
+                throw std::runtime_error("stack(): shapes do not match");
+        size_t a = normalize_axis_(axis, first.size() + 1, "stack");
+
+        using container_type = stack_container_<Container>;
+        container_type shape{};
+        if constexpr (std::is_same<container_type, std::vector<size_t>>())
+            shape.resize(first.size() + 1);
+        size_t outer = 1, inner = 1;
+        for (size_t d = 0, r = 0; d <= first.size(); d++) {
+            if (d == a) {
+                shape[d] = arrays.size();
+                continue;
+            }
+            shape[d] = first[r++];
+            (d < a ? outer : inner) *= shape[d];
+        }
+
+        ndarray_impl<T, container_type> out(shape);
+        concatenate_blocks_(arrays, outer, std::vector<size_t>(arrays.size(), inner), out.data());
+        return out;
+    }
+
+    // Pieces [start, stop) of arr along axis. When the axis is the first one that is longer than one, every piece is
+    // contiguous and is returned as a view sharing the memory of arr; otherwise the pieces are copied in parallel.
+    template<class T, class Container>
+    std::vector<ndarray_impl<T, Container>>
+    split_pieces_(ndarray_impl<T, Container> &arr, const std::vector<std::pair<size_t, size_t>> &pieces, size_t a) {
+        size_t outer = 1, inner = 1, n = arr.shape()[a];
+        for (size_t d = 0; d < a; d++)
+            outer *= arr.shape()[d];
+        for (size_t d = a + 1; d < arr.ndim(); d++)
+            inner *= arr.shape()[d];
+
+        std::vector<ndarray_impl<T, Container>> out;
+        out.reserve(pieces.size());
+        for (auto [start, stop] : pieces) {
+            Container shape = arr.shape();
+            shape[a] = stop - start;
+            if (outer == 1)
+                out.push_back(arr.make_shared(shape, start * inner));
+            else
+                out.emplace_back(shape);
+        }
+        if (outer == 1)
+            return out;
+
+        // only reads, so a buffer shared with copies is not detached
+        const T *data = std::as_const(arr).data();
+        parallel_for(0, pieces.size() * outer, std::max(size_t(1), (size_t(1) << 16) / std::max(n * inner, size_t(1))),
+                     [&](size_t begin, size_t end) {
+                         for (size_t r = begin; r < end; r++) {
+                             size_t i = r / outer, o = r % outer;
+                             auto [start, stop] = pieces[i];
+                             const T *src = data + (o * n + start) * inner;
+                             std::copy(src, src + (stop - start) * inner, out[i].data() + o * (stop - start) * inner);
+                         }
+                     });
+        return out;
+    }
+
+    // Splits arr along axis into pieces as equal as possible: the first n % sections pieces get one element more.
+    template<class T, class Container>
+    std::vector<ndarray_impl<T, Container>>
+    array_split(ndarray_impl<T, Container> &arr, size_t sections, ptrdiff_t axis = 0) {
+        size_t a = normalize_axis_(axis, arr.ndim(), "array_split");
+        if (sections == 0)
+            throw std::runtime_error("array_split(): number of sections must be larger than 0");
+        size_t n = arr.shape()[a];
+        std::vector<std::pair<size_t, size_t>> pieces;
+        for (size_t i = 0, start = 0; i < sections; i++) {
+            size_t length = n / sections + (i < n % sections);
+            pieces.emplace_back(start, start + length);
+            start += length;
+        }
+        return split_pieces_(arr, pieces, a);
+    }
+
+    // Splits arr along axis into equal pieces; throws if that is not possible.
+    template<class T, class Container>
+    std::vector<ndarray_impl<T, Container>>
+    split(ndarray_impl<T, Container> &arr, size_t sections, ptrdiff_t axis = 0) {
+        size_t a = normalize_axis_(axis, arr.ndim(), "split");
+        if (sections == 0 || arr.shape()[a] % sections)
+            throw std::runtime_error("split(): array split does not result in an equal division");
+        return array_split(arr, sections, axis);
+    }
+
+    // Splits arr along axis before each of the given indices, like numpy.split with a list of indices.
+    template<class T, class Container>
+    std::vector<ndarray_impl<T, Container>>
+    split(ndarray_impl<T, Container> &arr, const std::vector<size_t> &indices, ptrdiff_t axis = 0) {
+        size_t a = normalize_axis_(axis, arr.ndim(), "split");
+        size_t n = arr.shape()[a];
+        std::vector<std::pair<size_t, size_t>> pieces;
+        for (size_t i = 0, start = 0; i <= indices.size(); i++) {
+            size_t stop = i < indices.size() ? std::min(indices[i], n) : n;
+            pieces.emplace_back(start, std::max(start, stop));
+            start = stop;
+        }
+        return split_pieces_(arr, pieces, a);
+    }
+
+}
@@ -2,15 +2,45 @@
 
 #include <algorithm>    // copy, swap
 #include <array>
+#include <cstddef>      // ptrdiff_t, size_t
 #include <functional>   // multiplies
+#include <limits>       // numeric_limits
 #include <memory>       // shared_ptr
-#include <numeric>      // accumulate, exclusive_scan
+#include <numeric>      // exclusive_scan
 #include <stdexcept>    // runtime_error
+#include <string>
 #include <type_traits>  // conditional_t, is_integral, is_same
+#include <utility>      // move
 #include <vector>
+#include "instrument.hpp"
 
 namespace cnumpy {
 
+    // Compile with CNUMPY_COPY_ON_WRITE defined (in every translation unit) to make copies of arrays share their buffer
+    // until one of them is modified.
+#ifdef CNUMPY_COPY_ON_WRITE
+    inline constexpr bool copy_on_write = true;
+#else
+    inline constexpr bool copy_on_write = false;
+#endif
+
+    // Number of elements of an array of the given shape. Throws if the array would take more than PTRDIFF_MAX bytes
+    // (the most a pointer difference can span), so sizes never wrap around; an empty dimension makes any shape valid.
+    template<class Container>
+    size_t shape_size_(const Container &shape, size_t itemsize, const char *name) {
+        size_t limit = size_t(std::numeric_limits<std::ptrdiff_t>::max()) / std::max(itemsize, size_t(1)), size = 1;
+        bool overflow = false;
+        for (size_t dim: shape) {
+            if (dim == 0)
+                return 0;
+            overflow |= size > limit / dim;
+            size *= dim;
+        }
+        if (overflow)
+            throw std::runtime_error(std::string(name) + "(): array is too big");
+        return size;
+    }
+
     template<class T, class Container = std::vector<size_t>>
     class ndarray_impl {
         template<class T_, class Container_>
@@ -23,12 +53,29 @@ namespace cnumpy {
 
         static_assert(std::is_same<typename container_type::value_type, size_t>());
 
+#ifdef CNUMPY_COPY_ON_WRITE
+        // Copy constructor: shares the buffer, which the first mutable access of either array then copies. Buffers
+        // that views or external owners alias (make_shared, wrapped pointers) are copied right away instead.
+        ndarray_impl(const ndarray_impl<value_type, container_type> &arr) :
+                size_(arr.size_), shape_(arr.shape_), strides_(arr.strides_), data_(arr.data_),
+                shared_data_(arr.shared_data_) {
+            if (arr.viewed_)
+                detach_(true);
+            else
+                instrument::add(instrument::counter::shares, 1);
+        };
+#else
         // copy constructor
         ndarray_impl(const ndarray_impl<value_type, container_type> &arr) :
                 size_(arr.size_), shape_(arr.shape_), strides_(arr.strides_), data_(new value_type[size_]),
                 shared_data_(data_) {
+            instrument::add(instrument::counter::allocations, 1);
+            instrument::add(instrument::counter::allocated_bytes, size_ * sizeof(value_type));
+            instrument::add(instrument::counter::deep_copies, 1);
+            instrument::add(instrument::counter::copied_bytes, size_ * sizeof(value_type));
             std::copy(arr.data_, arr.data_ + size_, data_);
         };
+#endif
 
         // move constructor
         ndarray_impl(ndarray_impl<value_type, container_type> &&arr) noexcept:
@@ -37,8 +84,9 @@ namespace cnumpy {
         }
 
         // copy-assignment operator
-        ndarray_impl &operator=(ndarray_impl<value_type, container_type> arr) {
-            swap(*this, arr);
+        ndarray_impl &operator=(const ndarray_impl<value_type, container_type> &arr) {
+            ndarray_impl<value_type, container_type> copy(arr);
+            swap(*this, copy);
             return *this;
         }
 
@@ -52,9 +100,11 @@ namespace cnumpy {
         ~ndarray_impl() = default;
 
         explicit ndarray_impl(const container_type &shape) :
-                size_(std::accumulate(shape.begin(), shape.end(), 1, std::multiplies<>())),
+                size_(shape_size_(shape, sizeof(value_type), "ndarray_impl<T, Container>::ndarray_impl")),
                 shape_(shape), strides_(shape), data_(new value_type[size_]), shared_data_(data_) {
-            std::exclusive_scan(shape.rbegin(), shape.rend(), strides_.rbegin(), 1, std::multiplies<>());
+            instrument::add(instrument::counter::allocations, 1);
+            instrument::add(instrument::counter::allocated_bytes, size_ * sizeof(value_type));
+            std::exclusive_scan(shape.rbegin(), shape.rend(), strides_.rbegin(), size_t(1), std::multiplies<>());
         }
 
         template<typename... Ints>
@@ -62,9 +112,23 @@ namespace cnumpy {
             static_assert((std::is_integral<Ints>() && ...));
         }
 
+        // wraps existing memory holding at least the number of elements given by shape, without copying
+        ndarray_impl(const container_type &shape, std::shared_ptr<value_type[]> data) :
+                size_(shape_size_(shape, sizeof(value_type), "ndarray_impl<T, Container>::ndarray_impl")),
+                shape_(shape), strides_(shape), data_(data.get()), shared_data_(std::move(data)) {
+#ifdef CNUMPY_COPY_ON_WRITE
+            viewed_ = true;
+#endif
+            instrument::add(instrument::counter::shares, 1);
+            std::exclusive_scan(shape.rbegin(), shape.rend(), strides_.rbegin(), size_t(1), std::multiplies<>());
+        }
+
         const value_type *data() const noexcept { return data_; }
 
-        value_type *data() noexcept { return data_; }
+        value_type *data() noexcept(!copy_on_write) {
+            detach_();
+            return data_;
+        }
 
         [[nodiscard]] size_t size() const noexcept { return size_; }
 
@@ -74,13 +138,16 @@ namespace cnumpy {
 
         [[maybe_unused]] const container_type &strides() const noexcept { return strides_; }
 
+        // true if no other array (copy or view) or external owner shares the buffer, which may then be reused
+        [[nodiscard]] bool unique() const noexcept { return shared_data_.use_count() == 1; }
+
         [[maybe_unused]] void reshape(const container_type &shape) {
-            size_t size = std::accumulate(shape.begin(), shape.end(), 1, std::multiplies<>());
+            size_t size = shape_size_(shape, sizeof(value_type), "ndarray_impl<T, Container>::reshape");
             if (size != size_)
                 throw std::runtime_error("ndarray_impl<T, Container>::reshape(): sizes do not match");
             shape_ = shape;
             strides_ = shape;
-            std::exclusive_scan(shape.rbegin(), shape.rend(), strides_.rbegin(), 1, std::multiplies<>());
+            std::exclusive_scan(shape.rbegin(), shape.rend(), strides_.rbegin(), size_t(1), std::multiplies<>());
         }
 
         template<typename... Ints>
@@ -98,6 +165,7 @@ namespace cnumpy {
         }
 
         value_type &operator[](const container_type &ndindex) {
+            detach_();
             return const_cast<value_type &>(
                     static_cast<const ndarray_impl<value_type, container_type> &>(*this)[ndindex]);
         }
@@ -110,6 +178,7 @@ namespace cnumpy {
 
         template<typename... Ints>
         value_type &operator()(Ints... ints) {
+            detach_();
             return const_cast<value_type &>(
                     static_cast<const ndarray_impl<value_type, container_type> &>(*this)(ints...));
         }
@@ -117,20 +186,32 @@ namespace cnumpy {
         // utilities
         template<class Container_>
         ndarray_impl<value_type, Container_> make_shared(const Container_ &shape) {
-            size_t size = std::accumulate(shape.begin(), shape.end(), 1, std::multiplies<>());
+            size_t size = shape_size_(shape, sizeof(value_type), "ndarray_impl<T, Container>::make_shared");
             if (size != size_)
                 throw std::runtime_error("ndarray_impl<T, Container>::make_shared(): sizes do not match");
 
-            ndarray_impl<value_type, Container_> arr;
-            arr.size_ = size;
-            arr.shape_ = shape;
-            arr.strides_ = shape;
-            std::exclusive_scan(shape.rbegin(), shape.rend(), arr.strides_.rbegin(), 1, std::multiplies<>());
-
-            arr.data_ = data_;
-            arr.shared_data_ = shared_data_;
+            detach_();
+#ifdef CNUMPY_COPY_ON_WRITE
+            viewed_ = true;
+#endif
+            // aliases shared_data_, so the view keeps the whole buffer alive without allocating one of its own
+            return ndarray_impl<value_type, Container_>(shape, std::shared_ptr<value_type[]>(shared_data_, data_));
+        }
 
-            return arr;
+        // view of the elements starting at offset, in the given shape
+        template<class Container_>
+        ndarray_impl<value_type, Container_> make_shared(const Container_ &shape, size_t offset) {
+            size_t size = shape_size_(shape, sizeof(value_type), "ndarray_impl<T, Container>::make_shared");
+            if (offset > size_ || size > size_ - offset)
+                throw std::runtime_error("ndarray_impl<T, Container>::make_shared(): view exceeds the array");
+
+            detach_();
+#ifdef CNUMPY_COPY_ON_WRITE
+            viewed_ = true;
+#endif
+            // aliases shared_data_, so the view keeps the whole buffer alive without allocating one of its own
+            return ndarray_impl<value_type, Container_>(shape,
+                                                        std::shared_ptr<value_type[]>(shared_data_, data_ + offset));
         }
 
         template<class NDArray, typename... Ints>
@@ -150,17 +231,79 @@ namespace cnumpy {
             swap(first.strides_, second.strides_);
             swap(first.data_, second.data_);
             swap(first.shared_data_, second.shared_data_);
+#ifdef CNUMPY_COPY_ON_WRITE
+            swap(first.viewed_, second.viewed_);
+#endif
         }
 
     private:
+        // Gives the array a buffer of its own before it is modified, if it shares one with copies (or always, when
+        // forced). Does nothing without CNUMPY_COPY_ON_WRITE.
+        void detach_([[maybe_unused]] bool force = false) {
+#ifdef CNUMPY_COPY_ON_WRITE
+            if (force || (!viewed_ && shared_data_.use_count() > 1)) {
+                std::shared_ptr<value_type[]> copy(new value_type[size_]);
+                std::copy(data_, data_ + size_, copy.get());
+                data_ = copy.get();
+                shared_data_ = std::move(copy);
+                viewed_ = false;
+                instrument::add(instrument::counter::allocations, 1);
+                instrument::add(instrument::counter::allocated_bytes, size_ * sizeof(value_type));
+                instrument::add(instrument::counter::deep_copies, 1);
+                instrument::add(instrument::counter::copied_bytes, size_ * sizeof(value_type));
+            }
+#endif
+        }
+
         size_t size_{};
         container_type shape_, strides_;
 
         value_type *data_;
         std::shared_ptr<value_type[]> shared_data_;
+#ifdef CNUMPY_COPY_ON_WRITE
+        bool viewed_ = false;       // views or external owners alias the buffer, which is then never detached
+#endif
     };
 
     template<class T, size_t N = size_t(-1)>
     using ndarray = ndarray_impl<T, std::conditional_t<N == -1, std::vector<size_t>, std::array<size_t, N>>>;
 
+    // number of dimensions of arrays with the given shape container, size_t(-1) if only known at run time
+    template<class Container>
+    struct rank_ {
+        static constexpr size_t value = size_t(-1);
+    };
+
+    template<size_t N>
+    struct rank_<std::array<size_t, N>> {
+        static constexpr size_t value = N;
+    };
+
+    // axis in [0, ndim), counting from the end if negative
+    inline size_t normalize_axis_(ptrdiff_t axis, size_t ndim, const char *name) {
+        if (axis < -ptrdiff_t(ndim) || axis >= ptrdiff_t(ndim))
+            throw std::runtime_error(std::string(name) + "(): axis out of range");
+        return size_t(axis < 0 ? axis + ptrdiff_t(ndim) : axis);
+    }
+
+    // The lines of an array along one axis: line l starts at offset(l) and has length elements, stride apart.
+    struct axis_lines_ {
+        size_t count{}, length{}, stride{};
+
+        [[nodiscard]] size_t offset(size_t line) const { return line / stride * length * stride + line % stride; }
+    };
+
+    template<class Container>
+    axis_lines_ axis_lines_of_(const Container &shape, ptrdiff_t axis, const char *name) {
+        size_t a = normalize_axis_(axis, shape.size(), name);
+        axis_lines_ lines{1, shape[a], 1};
+        for (size_t d = 0; d < shape.size(); d++) {
+            if (d != a)
+                lines.count *= shape[d];
+            if (d > a)
+                lines.stride *= shape[d];
+        }
+        return lines;
+    }
+
 }
@@ -1,10 +1,24 @@
 #pragma once
 
+#include <algorithm>    // min, reverse
+#include <charconv>     // from_chars
 #include <complex>
+#include <cstdint>      // uint16_t, uint32_t, uintptr_t
+#include <cstdio>       // snprintf
+#include <cstring>      // memcpy, strncmp
 #include <fstream>      // fstream
 #include <iostream>     // iostream
-#include <memory>       // unique_ptr
+#include <memory>       // shared_ptr, unique_ptr
+#include <span>
 #include <stdexcept>    // runtime_error
+#include <string>
+#include <string_view>
+#include <system_error> // errc
+#include <variant>      // variant_alternative_t, variant_size_v
+#include <vector>
+#include "any_ndarray.hpp"
+#include "checksum.hpp"
+#include "instrument.hpp"
 #include "ndarray.hpp"
 
 namespace cnumpy {
@@ -30,164 +44,353 @@ namespace cnumpy {
             iostrm_.rdbuf(fstrm_.rdbuf());
         }
 
+        // Reads from or writes to the first size bytes of buffer instead of a file. Arrays loaded from a buffer alias
+        // its memory whenever the data needs neither byte swapping nor realignment, and keep it alive through the
+        // shared pointer. Arrays are saved into the buffer with a single copy of the data.
+        NPY(std::shared_ptr<char[]> buffer, size_t size, const char mode) :
+                mode_(mode), iostrm_(nullptr), buffer_(std::move(buffer)), size_(size) {
+            if (mode_ != 'r' && mode_ != 'w')
+                throw std::runtime_error("NPY::NPY(): unexpected mode");
+            if (!buffer_ && size_)
+                throw std::runtime_error("NPY::NPY(): null buffer");
+        }
+
         void close() {
             mode_ = 0;
             fstrm_.close();
+            buffer_.reset();
+            size_ = pos_ = 0;
         }
 
         template<class T>
         ndarray <T> load() {
             if (mode_ && mode_ != 'r')
                 throw std::runtime_error("NPY::load(): file not opened in 'r' mode");
+            instrument::scoped_timer timer(instrument::counter::npy_load_ns);
+            checksum_ = 0;
 
-            auto read_stream = []<class T_>(std::iostream &iostrm, T_ &out) {
-                char buffer[sizeof(T_)];
-                if (iostrm.read(buffer, sizeof(T_)).fail())
-                    throw std::runtime_error("NPY::load(): failed read");
-                out = 0;
-                for (size_t b = 0; b < sizeof(T_); b++)
-                    out |= buffer[b] << (b << 3);
-            };
+            header_info info = read_header_();
+            if (info.descr.length() < 3 || info.descr[1] != dtype<T>())
+                throw std::runtime_error("NPY::load(): data type does not match");
+            if (itemsize_(info.descr) != sizeof(T))
+                throw std::runtime_error("NPY::load(): type size does not match");
+            return load_data_<T>(info);
+        }
 
-            // The first 6 bytes are a magic string: exactly \x93NUMPY.
-            char buffer[6];
-            if (iostrm_.read(buffer, 6).fail())
-                throw std::runtime_error("NPY::load(): failed read");
-            if (strncmp(magic_, buffer, 6) != 0)
-                throw std::runtime_error("NPY::load(): magic does not match");
+        // Loads like load<T>(), then throws if the CRC-32 of the bytes read differs from expected, e.g. a value kept by
+        // save_checksum(). Enables checksums.
+        template<class T>
+        ndarray<T> load(uint32_t expected) {
+            enable_checksum();
+            ndarray<T> arr = load<T>();
+            if (checksum_ != expected)
+                throw std::runtime_error("NPY::load(): CRC-32 does not match");
+            return arr;
+        }
 
-            // The next 1 byte is an unsigned byte: the major version number of the file format, e.g. \x01.
-            // The next 1 byte is an unsigned byte: the minor version number of the file format, e.g. \x00. Note: the
-            // version of the file format is not tied to the version of the numpy package.
-            char major, minor;
-            read_stream(iostrm_, major);
-            read_stream(iostrm_, minor);
-            if (!((major == 1 && minor == 0) || (major == 2 && minor == 0)))
-                throw std::runtime_error("NPY::load(): unsupported npy version");
+        // Loads an array of any type any_ndarray holds, the one the header names, reading the file once.
+        any_ndarray load_any() {
+            if (mode_ && mode_ != 'r')
+                throw std::runtime_error("NPY::load_any(): file not opened in 'r' mode");
+            instrument::scoped_timer timer(instrument::counter::npy_load_ns);
+            checksum_ = 0;
 
-            // v1.0: The next 2 bytes form a little-endian unsigned short int: the length of the header data HEADER_LEN.
-            // v2.0: The next 4 bytes form a little-endian unsigned int: the length of the header data HEADER_LEN.
-            // The next HEADER_LEN bytes form the header data describing the array's format. It is an ASCII string which
-            // contains a Python literal expression of a dictionary. It is terminated by a newline (\n) and padded with
-            // spaces (\x20) to make the total of len(magic string) + 2 + len(length) + HEADER_LEN be evenly divisible
-            // by 64 for alignment purposes.
-            size_t headerlen;
-            if (major == 1 && minor == 0) {
-                uint16_t len;
-                read_stream(iostrm_, len);
-                headerlen = len;
-                if ((6 + 2 + 2 + headerlen) & 63)
-                    throw std::runtime_error("NPY::load(): unexpected header length");
-            } else if (major == 2 && minor == 0) {
-                uint32_t len;
-                read_stream(iostrm_, len);
-                headerlen = len;
-                if ((6 + 2 + 4 + headerlen) & 63)
-                    throw std::runtime_error("NPY::load(): unexpected header length");
+            header_info info = read_header_();
+            return load_any_(info);
+        }
+
+        any_ndarray load_any(uint32_t expected) {
+            enable_checksum();
+            any_ndarray arr = load_any();
+            if (checksum_ != expected)
+                throw std::runtime_error("NPY::load_any(): CRC-32 does not match");
+            return arr;
+        }
+
+        // With checksums enabled, load() and save() compute the CRC-32 of all bytes they read or write, header
+        // included, piece by piece as the bytes pass through. checksum() returns it for the last array: the value zip
+        // records for the same .npy member, or zlib.crc32 of the whole file.
+        void enable_checksum(bool enable = true) noexcept { checksum_enabled_ = enable; }
+
+        [[nodiscard]] uint32_t checksum() const noexcept { return checksum_; }
+
+        // Records crc in a sidecar file, filename + ".crc32", as eight hex digits.
+        static void save_checksum(const std::string &filename, uint32_t crc) {
+            char text[16];
+            std::snprintf(text, sizeof(text), "%08x\n", crc);
+            std::ofstream out(filename + ".crc32");
+            if (out.write(text, 9).flush().fail())
+                throw std::runtime_error("NPY::save_checksum(): can't write " + filename + ".crc32");
+        }
+
+        static uint32_t load_checksum(const std::string &filename) {
+            std::ifstream in(filename + ".crc32");
+            std::string text;
+            if (!(in >> text))
+                throw std::runtime_error("NPY::load_checksum(): can't read " + filename + ".crc32");
+            uint32_t crc;
+            auto [end, ec] = std::from_chars(text.data(), text.data() + text.length(), crc, 16);
+            if (ec != std::errc() || end != text.data() + text.length() || text.length() != 8)
+                throw std::runtime_error("NPY::load_checksum(): malformed " + filename + ".crc32");
+            return crc;
+        }
+
+        struct header_info {
+            std::string descr;
+            bool fortran_order{};
+            std::vector<size_t> shape;
+            size_t offset{};        // position of the array data in the file
+        };
+
+        // Reads only the header of a file, normally within its first 4 KiB, without loading any data.
+        static header_info inspect(const std::string &filename) {
+            std::ifstream ifstrm(filename, std::ios::binary);
+            if (ifstrm.fail())
+                throw std::runtime_error("NPY::inspect(): can't open file");
+            size_t capacity = 4096;
+            std::shared_ptr<char[]> buffer(new char[capacity]);
+            ifstrm.read(buffer.get(), std::streamsize(capacity));
+            size_t size = ifstrm.gcount();
+
+            // Longer headers are possible with version 2.0 and above. The length is only trusted after the magic and
+            // version, and no further than the end of the file; read_header_ reports anything else.
+            auto byte = [&](size_t i) { return size_t((unsigned char) buffer[i]); };
+            bool valid = size >= 12 && strncmp(magic_, buffer.get(), 6) == 0 && byte(6) >= 1 && byte(6) <= 3;
+            size_t preamble = !valid ? 0 : byte(6) == 1 ? 10 + (byte(8) | byte(9) << 8)
+                                                        : 12 + (byte(8) | byte(9) << 8 | byte(10) << 16 |
+                                                                byte(11) << 24);
+            if (size == capacity && preamble > capacity) {
+                ifstrm.clear();
+                ifstrm.seekg(0, std::ios::end);
+                if (preamble > size_t(ifstrm.tellg()))
+                    throw std::runtime_error("NPY::inspect(): header longer than the file");
+                buffer.reset(new char[preamble]);
+                ifstrm.seekg(0);
+                ifstrm.read(buffer.get(), std::streamsize(preamble));
+                size = ifstrm.gcount();
             }
+            return NPY(buffer, size, 'r').read_header_();
+        }
 
-            char header[headerlen];
-            if (iostrm_.read(header, std::streamsize(headerlen)).fail())
-                throw std::runtime_error("NPY::load(): failed read");
+        // Reads the header of the .npy data held in the first size bytes of buffer.
+        static header_info inspect(std::shared_ptr<char[]> buffer, size_t size) {
+            return NPY(std::move(buffer), size, 'r').read_header_();
+        }
 
-            // The dictionary contains three keys:
-            //
-            // "descr" dtype.descr
-            // An object that can be passed as an argument to the numpy.dtype constructor to create the array's dtype.
-            //
-            // "fortran_order" bool
-            // Whether the array data is Fortran-contiguous or not. Since Fortran-contiguous arrays are a common form of
-            // non-C-contiguity, we allow them to be written directly to disk for efficiency.
-            //
-            // "shape" tuple of int
-            // The shape of the array.
-            // For repeatability and readability, the dictionary keys are sorted in alphabetic order. This is for
-            // convenience only. A writer SHOULD implement this if possible. A reader MUST NOT depend on this.
-            auto parse_header = [](const std::string &header) {
-                size_t d = header.find("'descr'");
-                size_t ds = header.find('\'', d + 7);
-                size_t de = header.find('\'', ds + 1);
-                std::string descr = header.substr(ds + 1, de - ds - 1);
-
-                size_t f = header.find("'fortran_order'");
-                bool fortran_order = header[header.find_first_of("TF", f + 15)] == 'T';
-
-                size_t s = header.find("'shape'");
-                size_t ss = header.find('(', s + 7);
-                size_t se = header.find(')', ss + 1);
-                std::string shape_str = header.substr(ss + 1, se - ss - 1);
-                if (!shape_str.empty() && shape_str.back() != ',')
-                    shape_str += ',';
-                size_t last = 0;
-                std::vector<size_t> shape;
-                while (true) {
-                    size_t pos = shape_str.find(',', last);
-                    if (pos == std::string::npos)
+        // The dictionary contains three keys:
+        //
+        // "descr" dtype.descr
+        // An object that can be passed as an argument to the numpy.dtype constructor to create the array's dtype.
+        //
+        // "fortran_order" bool
+        // Whether the array data is Fortran-contiguous or not. Since Fortran-contiguous arrays are a common form of
+        // non-C-contiguity, we allow them to be written directly to disk for efficiency.
+        //
+        // "shape" tuple of int
+        // The shape of the array.
+        // For repeatability and readability, the dictionary keys are sorted in alphabetic order. This is for
+        // convenience only. A writer SHOULD implement this if possible. A reader MUST NOT depend on this.
+        //
+        // The dictionary is parsed in a single pass: keys may come in any order and be separated by any whitespace.
+        // A structured descr (a list of tuples) is returned as its literal text.
+        static header_info parse_header(std::string_view header) {
+            size_t pos = 0;
+            auto fail = []() {
+                throw std::runtime_error("NPY::parse_header(): malformed header");
+            };
+            auto skip_whitespace = [&]() {
+                while (pos < header.length() && (header[pos] == ' ' || header[pos] == '\t' || header[pos] == '\n' ||
+                                                 header[pos] == '\r'))
+                    pos++;
+            };
+            auto expect = [&](char c) {
+                skip_whitespace();
+                if (pos >= header.length() || header[pos] != c)
+                    fail();
+                pos++;
+            };
+            auto parse_string = [&]() {
+                skip_whitespace();
+                if (pos >= header.length() || (header[pos] != '\'' && header[pos] != '"'))
+                    fail();
+                char quote = header[pos++];
+                size_t begin = pos;
+                while (pos < header.length() && header[pos] != quote)
+                    pos += header[pos] == '\\' ? 2 : 1;
+                if (pos >= header.length())
+                    fail();
+                return header.substr(begin, pos++ - begin);
+            };
+            // skips a Python literal, including nested lists and tuples, and returns its text
+            auto skip_value = [&]() {
+                skip_whitespace();
+                size_t begin = pos;
+                int depth = 0;
+                while (pos < header.length()) {
+                    char c = header[pos];
+                    if (c == '\'' || c == '"') {
+                        parse_string();
+                        continue;
+                    }
+                    if (c == '(' || c == '[' || c == '{') {
+                        depth++;
+                    } else if (c == ')' || c == ']' || c == '}') {
+                        if (depth == 0)
+                            break;
+                        depth--;
+                    } else if (c == ',' && depth == 0) {
                         break;
-                    shape.push_back(stoi(shape_str.substr(last, pos - last)));
-                    last = pos + 1;
+                    }
+                    pos++;
                 }
-
-                return make_tuple(descr, fortran_order, shape);
+                if (depth != 0 || pos == begin)
+                    fail();
+                size_t end = pos;
+                while (end > begin && (header[end - 1] == ' ' || header[end - 1] == '\n'))
+                    end--;
+                return header.substr(begin, end - begin);
             };
 
-            auto[descr, fortran_order, shape] = parse_header(std::string(header, headerlen));
-            if (descr[1] != dtype<T>())
-                throw std::runtime_error("NPY::load(): data type does not match");
-            if (stoi(descr.substr(2)) != sizeof(T))
-                throw std::runtime_error("NPY::load(): type size does not match");
-            if (fortran_order) {
-                fortran_order = false;
-                reverse(shape.begin(), shape.end());
+            header_info info;
+            bool has_descr = false, has_fortran_order = false, has_shape = false;
+            expect('{');
+            while (true) {
+                skip_whitespace();
+                if (pos < header.length() && header[pos] == '}')
+                    break;
+                std::string_view key = parse_string();
+                expect(':');
+                skip_whitespace();
+                if (key == "descr") {
+                    if (pos < header.length() && (header[pos] == '\'' || header[pos] == '"'))
+                        info.descr = parse_string();
+                    else
+                        info.descr = skip_value();
+                    has_descr = true;
+                } else if (key == "fortran_order") {
+                    if (header.substr(pos, 4) == "True")
+                        info.fortran_order = true, pos += 4;
+                    else if (header.substr(pos, 5) == "False")
+                        info.fortran_order = false, pos += 5;
+                    else
+                        fail();
+                    has_fortran_order = true;
+                } else if (key == "shape") {
+                    expect('(');
+                    info.shape.clear();
+                    while (true) {
+                        skip_whitespace();
+                        if (pos < header.length() && header[pos] == ')')
+                            break;
+                        size_t dim;
+                        auto [ptr, ec] = std::from_chars(header.data() + pos, header.data() + header.length(), dim);
+                        if (ec == std::errc::result_out_of_range)
+                            throw std::runtime_error("NPY::parse_header(): dimension out of range");
+                        if (ec != std::errc())
+                            fail();
+                        pos = ptr - header.data();
+                        if (pos < header.length() && header[pos] == 'L')   // written by Python 2
+                            pos++;
+                        info.shape.push_back(dim);
+                        skip_whitespace();
+                        if (pos < header.length() && header[pos] == ',')
+                            pos++;
+                        else if (pos >= header.length() || header[pos] != ')')
+                            fail();
+                    }
+                    pos++;
+                    has_shape = true;
+                } else {
+                    skip_value();
+                }
+                skip_whitespace();
+                if (pos < header.length() && header[pos] == ',')
+                    pos++;
+                else if (pos >= header.length() || header[pos] != '}')
+                    fail();
             }
+            if (!has_descr || !has_fortran_order || !has_shape)
+                throw std::runtime_error("NPY::parse_header(): missing key");
+            shape_size_(info.shape, 1, "NPY::parse_header");
+            return info;
+        }
+
+        template<class NDArray>
+        void save(const NDArray &arr, std::array<char, 2> version = {0, 0}) {
+            static_assert(std::is_same<ndarray_impl<typename NDArray::value_type, typename NDArray::container_type>,
+                    NDArray>());
+            static_assert(dtype<typename NDArray::value_type>() != '?');
+
+            if (mode_ && mode_ != 'w')
+                throw std::runtime_error("NPY::save(): file not opened in 'w' mode");
+            instrument::scoped_timer timer(instrument::counter::npy_save_ns);
+            checksum_ = 0;
+
+            std::string preamble = header(arr, version);
+            write_(preamble.c_str(), preamble.length());
 
             // Following the header comes the array data. If the dtype contains Python objects (i.e. dtype.hasobject is
             // True), then the data is a Python pickle of the array. Otherwise the data is the contiguous (either C- or
             // Fortran-, depending on fortran_order) bytes of the array. Consumers can figure out the number of bytes by
             // multiplying the number of elements given by the shape (noting that shape=() means there is 1 element) by
             // dtype.itemsize.
-            ndarray<T> arr(shape);
-            T *ptr = arr.data();
-            size_t sz = arr.size() * sizeof(T);
-            if (iostrm_.read((char *) ptr, std::streamsize(sz)).fail())
-                throw std::runtime_error("NPY::load(): failed read");
+            const typename NDArray::value_type *ptr = arr.data();
+            size_t sz = arr.size() * sizeof(typename NDArray::value_type);
+            write_((const char *) ptr, sz);
+            instrument::add(instrument::counter::npy_saves, 1);
+            instrument::add(instrument::counter::npy_save_bytes, sz);
+        }
 
-            size_t tsz = typesize<T>();
-            size_t htsz = tsz >> 1;
-            if (descr[0] != endianness_() && htsz) {
-                for (size_t i = 0; i < sz; i += tsz) {
-                    char *ptr_l = (char *) ptr + i;
-                    char *ptr_r = ptr_l + tsz - 1;
-                    for (size_t b = 0; b < htsz; b++) {
-                        using std::swap;
-                        swap(*(ptr_l + b), *(ptr_r - b));
-                    }
-                }
-            }
+        void save(const any_ndarray &arr, std::array<char, 2> version = {0, 0}) {
+            arr.visit([&](const auto &typed) { save(typed, version); });
+        }
 
-            return arr;
+        // Number of bytes save() writes for arr, e.g. to size a buffer up front.
+        template<class NDArray>
+        static size_t nbytes(const NDArray &arr, std::array<char, 2> version = {0, 0}) {
+            return header(arr, version).length() + arr.size() * sizeof(typename NDArray::value_type);
         }
 
+        struct segments {
+            std::string header;
+            std::span<const char> data;
+        };
+
+        // Returns the serialized header together with a view of the array data, for scatter-gather output (e.g.
+        // writev or sendmsg) without copying the data. The view is valid as long as arr's memory is.
         template<class NDArray>
-        void save(const NDArray &arr, std::array<char, 2> version = {0, 0}) {
+        static segments serialize(const NDArray &arr, std::array<char, 2> version = {0, 0}) {
+            return {header(arr, version), std::span<const char>((const char *) arr.data(),
+                                                                arr.size() * sizeof(typename NDArray::value_type))};
+        }
+
+        // Returns everything written before the array data: magic string, version, HEADER_LEN and the padded header.
+        template<class NDArray>
+        static std::string header(const NDArray &arr, std::array<char, 2> version = {0, 0}) {
             static_assert(std::is_same<ndarray_impl<typename NDArray::value_type, typename NDArray::container_type>,
                     NDArray>());
             static_assert(dtype<typename NDArray::value_type>() != '?');
+            return header(descr<typename NDArray::value_type>(), arr.shape(), version);
+        }
 
-            if (mode_ && mode_ != 'w')
-                throw std::runtime_error("NPY::save(): file not opened in 'w' mode");
+        // The native-endian descr of T, e.g. "<f8" for double.
+        template<class T>
+        static std::string descr() {
+            static_assert(dtype<T>() != '?');
+            return std::string() + endianness_() + dtype<T>() + std::to_string(sizeof(T));
+        }
 
-            auto write_stream = []<typename T_>(std::iostream &iostrm, T_ out) {
-                char buffer[sizeof(T_)];
+        // Same for an array of any dtype descr given as a string, e.g. "|S3" for a bytes scalar.
+        template<class Container>
+        static std::string header(const std::string &descr, const Container &shape,
+                                  std::array<char, 2> version = {0, 0}) {
+            auto write_string = []<typename T_>(std::string &str, T_ out) {
                 for (size_t b = 0; b < sizeof(T_); b++)
-                    buffer[b] = out >> (b << 3) & 255;
-                if (iostrm.write(buffer, sizeof(T_)).fail())
-                    throw std::runtime_error("NPY::save(): failed write");
+                    str += char(out >> (b << 3) & 255);
             };
 
             // The first 6 bytes are a magic string: exactly \x93NUMPY.
-            if (iostrm_.write(magic_, 6).fail())
-                throw std::runtime_error("NPY::save(): failed write");
+            std::string preamble(magic_, 6);
 
             // The next 1 byte is an unsigned byte: the major version number of the file format, e.g. \x01.
             // The next 1 byte is an unsigned byte: the minor version number of the file format, e.g. \x00. Note: the
@@ -211,8 +414,7 @@ namespace cnumpy {
             // The shape of the array.
             // For repeatability and readability, the dictionary keys are sorted in alphabetic order. This is for
             // convenience only. A writer SHOULD implement this if possible. A reader MUST NOT depend on this.
-            auto make_header = [](const std::string &descr, bool fortran_order,
-                                  const typename NDArray::container_type &shape) {
+            auto make_header = [](const std::string &descr, bool fortran_order, const Container &shape) {
                 std::string header;
                 header += "{'descr': '";
                 header += descr;
@@ -230,9 +432,7 @@ namespace cnumpy {
             };
 
             char major = version[0], minor = version[1];
-            std::string header = make_header(std::string() + endianness_() + dtype<typename NDArray::value_type>()
-                                             + std::to_string(sizeof(typename NDArray::value_type)), false,
-                                             arr.shape());
+            std::string header = make_header(descr, false, shape);
             if (major == 0 && minor == 0) {
                 size_t padding = 63 - ((6 + 2 + 2 + header.length()) & 63);
                 if (header.length() + padding + 1 < 65536)
@@ -243,37 +443,27 @@ namespace cnumpy {
             size_t padding;
             if (major == 1 && minor == 0)
                 padding = 63 - ((6 + 2 + 2 + header.length()) & 63);
-            else if (major == 2 && minor == 0)
+            else if ((major == 2 || major == 3) && minor == 0)
                 padding = 63 - ((6 + 2 + 4 + header.length()) & 63);
             else
-                throw std::runtime_error("NPY::save(): unsupported npy version");
+                throw std::runtime_error("NPY::header(): unsupported npy version");
             header.append(padding, ' ');
             header += '\n';
 
-            write_stream(iostrm_, major);
-            write_stream(iostrm_, minor);
+            write_string(preamble, major);
+            write_string(preamble, minor);
             if (major == 1 && minor == 0) {
                 if (header.length() >= 65536)
-                    throw std::runtime_error("NPY::save(): header size too large for version 1.0");
+                    throw std::runtime_error("NPY::header(): header size too large for version 1.0");
                 uint16_t len = header.length();
-                write_stream(iostrm_, len);
-            } else if (major == 2 && minor == 0) {
+                write_string(preamble, len);
+            } else {
                 uint32_t len = header.length();
-                write_stream(iostrm_, len);
+                write_string(preamble, len);
             }
 
-            if (iostrm_.write(header.c_str(), std::streamsize(header.length())).fail())
-                throw std::runtime_error("NPY::save(): failed write");
-
-            // Following the header comes the array data. If the dtype contains Python objects (i.e. dtype.hasobject is
-            // True), then the data is a Python pickle of the array. Otherwise the data is the contiguous (either C- or
-            // Fortran-, depending on fortran_order) bytes of the array. Consumers can figure out the number of bytes by
-            // multiplying the number of elements given by the shape (noting that shape=() means there is 1 element) by
-            // dtype.itemsize.
-            const typename NDArray::value_type *ptr = arr.data();
-            size_t sz = arr.size() * sizeof(typename NDArray::value_type);
-            if (iostrm_.write((char *) ptr, std::streamsize(sz)).fail())
-                throw std::runtime_error("NPY::save(): failed write");
+            preamble += header;
+            return preamble;
         }
 
         template<class T>
@@ -285,6 +475,143 @@ namespace cnumpy {
         }
 
     private:
+        // reads the data following the header info describes, as T
+        template<class T>
+        ndarray<T> load_data_(header_info &info) {
+            auto &[descr, fortran_order, shape, offset] = info;
+            if (fortran_order) {
+                fortran_order = false;
+                std::reverse(shape.begin(), shape.end());
+            }
+
+            // Following the header comes the array data. If the dtype contains Python objects (i.e. dtype.hasobject is
+            // True), then the data is a Python pickle of the array. Otherwise the data is the contiguous (either C- or
+            // Fortran-, depending on fortran_order) bytes of the array. Consumers can figure out the number of bytes by
+            // multiplying the number of elements given by the shape (noting that shape=() means there is 1 element) by
+            // dtype.itemsize.
+            size_t tsz = typesize<T>();
+            size_t htsz = tsz >> 1;
+            bool swap_bytes = descr[0] != endianness_() && descr[0] != '|' && descr[0] != '=' && htsz;
+            size_t sz = shape_size_(shape, sizeof(T), "NPY::load") * sizeof(T);
+            if (sz > remaining_())
+                throw std::runtime_error("NPY::load(): data is shorter than the header says");
+
+            if (buffer_ && !swap_bytes && (uintptr_t(buffer_.get() + pos_) % alignof(T)) == 0) {
+                auto data = std::shared_ptr<T[]>(buffer_, (T *) take_(sz));
+                instrument::add(instrument::counter::npy_loads, 1);
+                instrument::add(instrument::counter::npy_load_bytes, sz);
+                return ndarray<T>(shape, std::move(data));
+            }
+
+            ndarray<T> arr(shape);
+            T *ptr = arr.data();
+            read_((char *) ptr, sz);
+            instrument::add(instrument::counter::npy_loads, 1);
+            instrument::add(instrument::counter::npy_load_bytes, sz);
+
+            if (swap_bytes) {
+                instrument::scoped_timer swap_timer(instrument::counter::byteswap_ns);
+                instrument::add(instrument::counter::byteswaps, 1);
+                instrument::add(instrument::counter::byteswap_bytes, sz);
+                for (size_t i = 0; i < sz; i += tsz) {
+                    char *ptr_l = (char *) ptr + i;
+                    char *ptr_r = ptr_l + tsz - 1;
+                    for (size_t b = 0; b < htsz; b++) {
+                        using std::swap;
+                        swap(*(ptr_l + b), *(ptr_r - b));
+                    }
+                }
+            }
+
+            return arr;
+        }
+
+        // the item size in a descr like "<f8", 0 if there is none
+        static size_t itemsize_(const std::string &descr) {
+            size_t itemsize = 0;
+            if (descr.length() < 3)
+                return 0;
+            auto [ptr_end, ec] = std::from_chars(descr.data() + 2, descr.data() + descr.length(), itemsize);
+            return ec == std::errc() && ptr_end == descr.data() + descr.length() ? itemsize : 0;
+        }
+
+        // load_data_ with the first alternative of any_ndarray from I on whose type matches the descr
+        template<size_t I = 0>
+        any_ndarray load_any_(header_info &info) {
+            if constexpr (I == std::variant_size_v<any_ndarray::variant_type>) {
+                throw std::runtime_error("NPY::load_any(): unsupported data type " + info.descr);
+            } else {
+                using T = typename std::variant_alternative_t<I, any_ndarray::variant_type>::value_type;
+                if (info.descr.length() >= 3 && info.descr[1] == dtype<T>() && itemsize_(info.descr) == sizeof(T))
+                    return any_ndarray(load_data_<T>(info));
+                return load_any_<I + 1>(info);
+            }
+        }
+
+        header_info read_header_() {
+            auto read_stream = [this]<class T_>(T_ &out) {
+                unsigned char buffer[sizeof(T_)];
+                read_((char *) buffer, sizeof(T_));
+                out = 0;
+                for (size_t b = 0; b < sizeof(T_); b++)
+                    out |= T_(buffer[b]) << (b << 3);
+            };
+
+            // The first 6 bytes are a magic string: exactly \x93NUMPY.
+            char buffer[6];
+            read_(buffer, 6);
+            if (strncmp(magic_, buffer, 6) != 0)
+                throw std::runtime_error("NPY::load(): magic does not match");
+
+            // The next 1 byte is an unsigned byte: the major version number of the file format, e.g. \x01.
+            // The next 1 byte is an unsigned byte: the minor version number of the file format, e.g. \x00. Note: the
+            // version of the file format is not tied to the version of the numpy package.
+            char major, minor;
+            read_stream(major);
+            read_stream(minor);
+            if (!((major == 1 || major == 2 || major == 3) && minor == 0))
+                throw std::runtime_error("NPY::load(): unsupported npy version");
+
+            // v1.0: The next 2 bytes form a little-endian unsigned short int: the length of the header data HEADER_LEN.
+            // v2.0: The next 4 bytes form a little-endian unsigned int: the length of the header data HEADER_LEN.
+            // v3.0: Same as v2.0 except that the header is encoded in utf8 instead of latin1.
+            // The next HEADER_LEN bytes form the header data describing the array's format. It is an ASCII string which
+            // contains a Python literal expression of a dictionary. It is terminated by a newline (\n) and padded with
+            // spaces (\x20) to make the total of len(magic string) + 2 + len(length) + HEADER_LEN be evenly divisible
+            // by 64 for alignment purposes.
+            size_t headerlen;
+            if (major == 1) {
+                uint16_t len;
+                read_stream(len);
+                headerlen = len;
+                if ((6 + 2 + 2 + headerlen) & 63)
+                    throw std::runtime_error("NPY::load(): unexpected header length");
+            } else {
+                uint32_t len;
+                read_stream(len);
+                headerlen = len;
+                if ((6 + 2 + 4 + headerlen) & 63)
+                    throw std::runtime_error("NPY::load(): unexpected header length");
+            }
+
+            // typical headers fit on the stack, only unusually long ones are read into the heap
+            char stack_buffer[1024];
+            std::string heap_buffer;
+            const char *header = buffer_ ? take_(headerlen) : nullptr;
+            if (!header) {
+                char *dst = stack_buffer;
+                if (headerlen > sizeof(stack_buffer)) {
+                    heap_buffer.resize(headerlen);
+                    dst = heap_buffer.data();
+                }
+                read_(dst, headerlen);
+                header = dst;
+            }
+            header_info info = parse_header(std::string_view(header, headerlen));
+            info.offset = (major == 1 ? 6 + 2 + 2 : 6 + 2 + 4) + headerlen;
+            return info;
+        }
+
         static char endianness_() {
             union {
                 uint16_t s;
@@ -293,11 +620,71 @@ namespace cnumpy {
             return e.c[0];
         }
 
+        // bytes left to read, SIZE_MAX if the stream can't tell
+        size_t remaining_() {
+            if (buffer_)
+                return size_ - pos_;
+            auto here = iostrm_.tellg();
+            if (here < 0)
+                return SIZE_MAX;
+            auto end = iostrm_.seekg(0, std::ios::end).tellg();
+            iostrm_.seekg(here);
+            return end < here ? 0 : size_t(end - here);
+        }
+
+        // With checksums, streams are read and written a chunk at a time, each checksummed while it is in cache.
+        void read_(char *data, size_t size) {
+            if (buffer_) {
+                std::memcpy(data, take_(size), size);
+                return;
+            }
+            size_t step = checksum_enabled_ ? crc_chunk_ : size;
+            for (size_t pos = 0; pos < size; pos += step) {
+                size_t len = std::min(step, size - pos);
+                if (iostrm_.read(data + pos, std::streamsize(len)).fail())
+                    throw std::runtime_error("NPY::load(): failed read");
+                if (checksum_enabled_)
+                    checksum_ = crc32(checksum_, data + pos, len);
+            }
+        }
+
+        // returns the next size bytes of the buffer in place
+        const char *take_(size_t size) {
+            if (size > size_ - pos_)
+                throw std::runtime_error("NPY::load(): failed read");
+            const char *data = buffer_.get() + pos_;
+            pos_ += size;
+            if (checksum_enabled_)
+                checksum_ = crc32(checksum_, data, size);
+            return data;
+        }
+
+        void write_(const char *data, size_t size) {
+            if (buffer_ && size > size_ - pos_)
+                throw std::runtime_error("NPY::save(): buffer too small");
+            size_t step = checksum_enabled_ ? crc_chunk_ : size;
+            for (size_t pos = 0; pos < size; pos += step) {
+                size_t len = std::min(step, size - pos);
+                if (checksum_enabled_)
+                    checksum_ = crc32(checksum_, data + pos, len);
+                if (buffer_) {
+                    std::memcpy(buffer_.get() + pos_, data + pos, len);
+                    pos_ += len;
+                } else if (iostrm_.write(data + pos, std::streamsize(len)).fail()) {
+                    throw std::runtime_error("NPY::save(): failed write");
+                }
+            }
+        }
+
         inline static char magic_[6] = {-109, 'N', 'U', 'M', 'P', 'Y'};
 
         char mode_;
         std::fstream fstrm_;
         std::iostream iostrm_;
+        std::shared_ptr<char[]> buffer_;
+        size_t size_{}, pos_{};
+        bool checksum_enabled_ = false;
+        uint32_t checksum_{};
     };
 
     template<>
@@ -306,6 +693,9 @@ namespace cnumpy {
     template<>
     constexpr char NPY::dtype<char>() { return 'i'; }
 
+    template<>
+    constexpr char NPY::dtype<signed char>() { return 'i'; }
+
     template<>
     constexpr char NPY::dtype<short>() { return 'i'; }
 
@@ -0,0 +1,191 @@
+#pragma once
+
+#include <algorithm>    // min
+#include <cstdint>      // int64_t, uint64_t
+#include <filesystem>   // recursive_directory_iterator, last_write_time
+#include <fstream>      // ifstream, ofstream
+#include <map>
+#include <set>
+#include <sstream>      // istringstream
+#include <stdexcept>    // exception, runtime_error
+#include <string>
+#include <vector>
+#include "npy.hpp"
+#include "parallel.hpp"
+
+namespace cnumpy {
+
+    // Index of the headers of many .npy files, to plan which arrays to load without touching their data. The index
+    // can be saved to and loaded from disk; scan() only re-inspects files whose modification time or size changed.
+    class NPYIndex {
+    public:
+        struct entry_type {
+            int64_t mtime{};        // last write time in ticks of std::filesystem::file_time_type
+            uint64_t size{};        // file size in bytes
+            NPY::header_info info;
+        };
+
+        NPYIndex() = default;
+
+        // loads a previously saved index; a missing file gives an empty index
+        explicit NPYIndex(const std::string &filename) {
+            if (std::filesystem::exists(filename))
+                load(filename);
+        }
+
+        // Brings the entries of all .npy files below directory up to date, using at most nthreads threads (the
+        // library default if zero). Entries of files that disappeared are removed, files that are not valid .npy
+        // files are ignored. Returns the number of files that were (re-)inspected.
+        size_t scan(const std::string &directory, bool recursive = true, size_t nthreads = 0) {
+            std::vector<std::string> stale;
+            std::vector<entry_type> stats;
+            std::set<std::string> seen;
+            auto visit = [&](const std::filesystem::directory_entry &file) {
+                if (!file.is_regular_file() || file.path().extension() != ".npy")
+                    return;
+                std::string path = file.path().string();
+                entry_type stat;
+                stat.mtime = file.last_write_time().time_since_epoch().count();
+                stat.size = file.file_size();
+                seen.insert(path);
+                auto it = entries_.find(path);
+                if (it == entries_.end() || it->second.mtime != stat.mtime || it->second.size != stat.size) {
+                    stale.push_back(path);
+                    stats.push_back(stat);
+                }
+            };
+            if (recursive) {
+                for (const auto &file : std::filesystem::recursive_directory_iterator(directory))
+                    visit(file);
+            } else {
+                for (const auto &file : std::filesystem::directory_iterator(directory))
+                    visit(file);
+            }
+
+            std::vector<bool> valid(stale.size());
+            parallel_for(0, stale.size(), 16, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; i++) {
+                    try {
+                        stats[i].info = NPY::inspect(stale[i]);
+                        valid[i] = true;
+                    } catch (const std::exception &) {
+                        valid[i] = false;
+                    }
+                }
+            }, nthreads);
+
+            std::string prefix = (std::filesystem::path(directory) / "").string();
+            for (auto it = entries_.lower_bound(prefix); it != entries_.end() && it->first.starts_with(prefix);) {
+                bool below = it->first.find(std::filesystem::path::preferred_separator, prefix.length()) !=
+                             std::string::npos;
+                if (seen.count(it->first) || (below && !recursive))
+                    ++it;
+                else
+                    it = entries_.erase(it);
+            }
+            for (size_t i = 0; i < stale.size(); i++) {
+                if (valid[i])
+                    entries_[stale[i]] = std::move(stats[i]);
+                else
+                    entries_.erase(stale[i]);
+            }
+            return stale.size();
+        }
+
+        [[nodiscard]] const entry_type *find(const std::string &path) const {
+            auto it = entries_.find(path);
+            return it == entries_.end() ? nullptr : &it->second;
+        }
+
+        [[nodiscard]] const std::map<std::string, entry_type> &entries() const noexcept { return entries_; }
+
+        [[nodiscard]] size_t size() const noexcept { return entries_.size(); }
+
+        // One line per file: path, mtime, size, descr, fortran_order, shape and data offset separated by tabs.
+        void save(const std::string &filename) const {
+            std::ofstream ofstrm(filename, std::ios::binary | std::ios::trunc);
+            if (ofstrm.fail())
+                throw std::runtime_error("NPYIndex::save(): can't open file");
+            ofstrm << magic_ << '\n';
+            for (const auto &[path, entry] : entries_) {
+                ofstrm << escape_(path) << '\t' << entry.mtime << '\t' << entry.size << '\t'
+                       << escape_(entry.info.descr) << '\t' << entry.info.fortran_order << '\t';
+                for (size_t d = 0; d < entry.info.shape.size(); d++)
+                    ofstrm << (d ? "," : "") << entry.info.shape[d];
+                ofstrm << '\t' << entry.info.offset << '\n';
+            }
+            if (ofstrm.flush().fail())
+                throw std::runtime_error("NPYIndex::save(): failed write");
+        }
+
+        void load(const std::string &filename) {
+            std::ifstream ifstrm(filename, std::ios::binary);
+            if (ifstrm.fail())
+                throw std::runtime_error("NPYIndex::load(): can't open file");
+            std::string line;
+            if (!std::getline(ifstrm, line) || line != magic_)
+                throw std::runtime_error("NPYIndex::load(): not an index file");
+
+            std::map<std::string, entry_type> entries;
+            while (std::getline(ifstrm, line)) {
+                std::vector<std::string> fields;
+                for (size_t begin = 0, end; begin <= line.length(); begin = end + 1) {
+                    end = std::min(line.find('\t', begin), line.length());
+                    fields.push_back(line.substr(begin, end - begin));
+                }
+                if (fields.size() != 7)
+                    throw std::runtime_error("NPYIndex::load(): malformed entry");
+
+                entry_type entry;
+                try {
+                    entry.mtime = std::stoll(fields[1]);
+                    entry.size = std::stoull(fields[2]);
+                    entry.info.descr = unescape_(fields[3]);
+                    entry.info.fortran_order = fields[4] == "1";
+                    std::istringstream shape(fields[5]);
+                    for (std::string dim; std::getline(shape, dim, ',');)
+                        entry.info.shape.push_back(std::stoull(dim));
+                    entry.info.offset = std::stoull(fields[6]);
+                } catch (const std::logic_error &) {
+                    throw std::runtime_error("NPYIndex::load(): malformed entry");
+                }
+                entries[unescape_(fields[0])] = std::move(entry);
+            }
+            entries_ = std::move(entries);
+        }
+
+    private:
+        static std::string escape_(const std::string &str) {
+            std::string out;
+            for (char c : str) {
+                if (c == '\\')
+                    out += "\\\\";
+                else if (c == '\t')
+                    out += "\\t";
+                else if (c == '\n')
+                    out += "\\n";
+                else
+                    out += c;
+            }
+            return out;
+        }
+
+        static std::string unescape_(const std::string &str) {
+            std::string out;
+            for (size_t i = 0; i < str.length(); i++) {
+                if (str[i] == '\\' && i + 1 < str.length()) {
+                    char c = str[++i];
+                    out += c == 't' ? '\t' : c == 'n' ? '\n' : c;
+                } else {
+                    out += str[i];
+                }
+            }
+            return out;
+        }
+
+        inline static const char *magic_ = "# cnumpy npy index v1";
+
+        std::map<std::string, entry_type> entries_;
+    };
+
+}
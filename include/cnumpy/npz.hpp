@@ -0,0 +1,554 @@
+#pragma once
+
+#include <algorithm>    // fill_n, find_if, max, min
+#include <array>
+#include <cstdint>      // uint16_t, uint32_t, uint64_t
+#include <cstring>      // memcpy
+#include <fstream>      // fstream
+#include <memory>       // shared_ptr
+#include <stdexcept>    // runtime_error
+#include <string>
+#include <utility>      // move, pair
+#include <vector>
+#include "any_ndarray.hpp"
+#include "checksum.hpp"
+#include "ndarray.hpp"
+#include "npy.hpp"
+
+namespace cnumpy {
+
+    // Zip records used by .npz archives: members are written stored (uncompressed), with the zip64 extensions for
+    // members or offsets beyond 4 GiB, and read either stored or deflated.
+    struct zip_ {
+        struct member {
+            std::string name;
+            uint16_t method{};          // 0: stored, 8: deflated
+            uint32_t crc{};
+            uint64_t compressed{};
+            uint64_t size{};
+            uint64_t offset{};          // position of the local file header
+        };
+
+        template<typename T_>
+        static void append(std::string &str, T_ value) {
+            for (size_t b = 0; b < sizeof(T_); b++)
+                str += char(value >> (b << 3) & 255);
+        }
+
+        template<typename T_>
+        static T_ read(const char *data) {
+            T_ value = 0;
+            for (size_t b = 0; b < sizeof(T_); b++)
+                value |= T_((unsigned char) data[b]) << (b << 3);
+            return value;
+        }
+
+        [[nodiscard]] static std::string local_header(const std::string &name, uint64_t bytes, uint32_t crc,
+                                                      bool zip64) {
+            std::string local;
+            append(local, uint32_t(0x04034b50));                    // local file header signature
+            append(local, uint16_t(zip64 ? 45 : 20));               // version needed to extract
+            append(local, uint16_t(0));                             // general purpose bit flag
+            append(local, uint16_t(0));                             // compression method: stored
+            append(local, uint16_t(0));                             // last mod file time
+            append(local, uint16_t(0x21));                          // last mod file date: 1980-01-01
+            append(local, crc);
+            append(local, uint32_t(zip64 ? 0xFFFFFFFF : bytes));    // compressed size
+            append(local, uint32_t(zip64 ? 0xFFFFFFFF : bytes));    // uncompressed size
+            append(local, uint16_t(name.length()));
+            append(local, uint16_t(zip64 ? 20 : 0));                // extra field length
+            local += name;
+            if (zip64) {
+                append(local, uint16_t(0x0001));                    // zip64 extended information
+                append(local, uint16_t(16));
+                append(local, bytes);
+                append(local, bytes);
+            }
+            return local;
+        }
+
+        [[nodiscard]] static std::string central_header(const std::string &name, uint64_t bytes, uint32_t crc,
+                                                        uint64_t offset, bool zip64) {
+            std::string central;
+            append(central, uint32_t(0x02014b50));                  // central file header signature
+            append(central, uint16_t(zip64 ? 45 : 20));             // version made by
+            append(central, uint16_t(zip64 ? 45 : 20));             // version needed to extract
+            append(central, uint16_t(0));                           // general purpose bit flag
+            append(central, uint16_t(0));                           // compression method: stored
+            append(central, uint16_t(0));                           // last mod file time
+            append(central, uint16_t(0x21));                        // last mod file date: 1980-01-01
+            append(central, crc);
+            append(central, uint32_t(zip64 ? 0xFFFFFFFF : bytes));  // compressed size
+            append(central, uint32_t(zip64 ? 0xFFFFFFFF : bytes));  // uncompressed size
+            append(central, uint16_t(name.length()));
+            append(central, uint16_t(zip64 ? 28 : 0));              // extra field length
+            append(central, uint16_t(0));                           // file comment length
+            append(central, uint16_t(0));                           // disk number start
+            append(central, uint16_t(0));                           // internal file attributes
+            append(central, uint32_t(0));                           // external file attributes
+            append(central, uint32_t(zip64 ? 0xFFFFFFFF : offset));
+            central += name;
+            if (zip64) {
+                append(central, uint16_t(0x0001));                  // zip64 extended information
+                append(central, uint16_t(24));
+                append(central, bytes);
+                append(central, bytes);
+                append(central, offset);
+            }
+            return central;
+        }
+
+        [[nodiscard]] static std::string end_records(uint64_t entries, uint64_t size, uint64_t offset) {
+            std::string end;
+            bool zip64 = entries >= 0xFFFF || size >= 0xFFFFFFFF || offset >= 0xFFFFFFFF;
+            if (zip64) {
+                append(end, uint32_t(0x06064b50));                  // zip64 end of central directory record
+                append(end, uint64_t(44));
+                append(end, uint16_t(45));
+                append(end, uint16_t(45));
+                append(end, uint32_t(0));
+                append(end, uint32_t(0));
+                append(end, entries);
+                append(end, entries);
+                append(end, size);
+                append(end, offset);
+                append(end, uint32_t(0x07064b50));                  // zip64 end of central directory locator
+                append(end, uint32_t(0));
+                append(end, offset + size);
+                append(end, uint32_t(1));
+            }
+            append(end, uint32_t(0x06054b50));                      // end of central directory record
+            append(end, uint16_t(0));
+            append(end, uint16_t(0));
+            append(end, uint16_t(zip64 ? 0xFFFF : entries));
+            append(end, uint16_t(zip64 ? 0xFFFF : entries));
+            append(end, uint32_t(zip64 ? 0xFFFFFFFF : size));
+            append(end, uint32_t(zip64 ? 0xFFFFFFFF : offset));
+            append(end, uint16_t(0));                               // comment length
+            return end;
+        }
+
+        // Reads the central directory of the archive open in fstrm.
+        static std::vector<member> directory(std::fstream &fstrm) {
+            auto fail = []() { throw std::runtime_error("zip: not a valid zip archive"); };
+            auto read_at = [&](uint64_t offset, size_t size) {
+                std::string bytes(size, '\0');
+                fstrm.clear();
+                fstrm.seekg(std::streamoff(offset));
+                if (fstrm.read(bytes.data(), std::streamsize(size)).fail())
+                    fail();
+                return bytes;
+            };
+
+            // the end of central directory record is followed by a comment of at most 65535 bytes
+            fstrm.seekg(0, std::ios::end);
+            auto length = uint64_t(fstrm.tellg());
+            if (length < 22)
+                fail();
+            uint64_t tail_offset = length - std::min(length, uint64_t(22 + 65535));
+            std::string tail = read_at(tail_offset, length - tail_offset);
+            size_t end = tail.length() - 22;
+            while (read<uint32_t>(tail.data() + end) != 0x06054b50)
+                if (end-- == 0)
+                    fail();
+            uint64_t entries = read<uint16_t>(tail.data() + end + 10);
+            uint64_t size = read<uint32_t>(tail.data() + end + 12);
+            uint64_t offset = read<uint32_t>(tail.data() + end + 16);
+            if (entries == 0xFFFF || size == 0xFFFFFFFF || offset == 0xFFFFFFFF) {
+                if (tail_offset + end < 20)
+                    fail();
+                std::string locator = read_at(tail_offset + end - 20, 20);
+                if (read<uint32_t>(locator.data()) != 0x07064b50)
+                    fail();
+                std::string record = read_at(read<uint64_t>(locator.data() + 8), 56);
+                if (read<uint32_t>(record.data()) != 0x06064b50)
+                    fail();
+                entries = read<uint64_t>(record.data() + 32);
+                size = read<uint64_t>(record.data() + 40);
+                offset = read<uint64_t>(record.data() + 48);
+            }
+
+            std::string central = read_at(offset, size);
+            std::vector<member> members;
+            for (size_t pos = 0; members.size() < entries; ) {
+                if (pos + 46 > central.length() || read<uint32_t>(central.data() + pos) != 0x02014b50)
+                    fail();
+                const char *header = central.data() + pos;
+                member m;
+                m.method = read<uint16_t>(header + 10);
+                m.crc = read<uint32_t>(header + 16);
+                m.compressed = read<uint32_t>(header + 20);
+                m.size = read<uint32_t>(header + 24);
+                m.offset = read<uint32_t>(header + 42);
+                size_t name_length = read<uint16_t>(header + 28), extra_length = read<uint16_t>(header + 30);
+                size_t next = pos + 46 + name_length + extra_length + read<uint16_t>(header + 32);
+                if (next > central.length())
+                    fail();
+                m.name.assign(header + 46, name_length);
+
+                // the zip64 field holds, in this order, only the values that did not fit
+                for (const char *extra = header + 46 + name_length, *extra_end = extra + extra_length;
+                     extra + 4 <= extra_end; extra += 4 + read<uint16_t>(extra + 2)) {
+                    if (read<uint16_t>(extra) != 0x0001)
+                        continue;
+                    const char *value = extra + 4;
+                    for (uint64_t *field: {&m.size, &m.compressed, &m.offset})
+                        if (*field == 0xFFFFFFFF && value + 8 <= extra_end) {
+                            *field = read<uint64_t>(value);
+                            value += 8;
+                        }
+                }
+                members.push_back(std::move(m));
+                pos = next;
+            }
+            return members;
+        }
+
+        // Decompresses the raw deflate stream (RFC 1951) in in[0, in_size) into exactly out_size bytes of out.
+        // Huffman codes are decoded canonically, one bit at a time.
+        static void inflate(const char *in, size_t in_size, char *out, size_t out_size) {
+            auto fail = []() { throw std::runtime_error("zip: invalid deflate data"); };
+            size_t pos = 0, written = 0;
+            uint64_t buffer = 0;
+            unsigned count = 0;
+            auto bits = [&](unsigned n) {
+                while (count < n) {
+                    if (pos == in_size)
+                        fail();
+                    buffer |= uint64_t((unsigned char) in[pos++]) << count;
+                    count += 8;
+                }
+                auto value = unsigned(buffer & ((uint64_t(1) << n) - 1));
+                buffer >>= n;
+                count -= n;
+                return value;
+            };
+
+            // numbers of codes of each length and the symbols ordered by code
+            struct huffman {
+                std::array<uint16_t, 16> counts{};
+                std::array<uint16_t, 288> symbols{};
+            };
+            auto build = [&](huffman &h, const uint8_t *lengths, size_t n) {
+                h.counts.fill(0);
+                for (size_t s = 0; s < n; s++)
+                    h.counts[lengths[s]]++;
+                std::array<uint16_t, 16> offsets{};
+                for (size_t len = 1; len < 15; len++)
+                    offsets[len + 1] = offsets[len] + h.counts[len];
+                for (size_t s = 0; s < n; s++)
+                    if (lengths[s])
+                        h.symbols[offsets[lengths[s]]++] = uint16_t(s);
+            };
+            auto decode = [&](const huffman &h) {
+                int code = 0, first = 0, index = 0;
+                for (size_t len = 1; len < 16; len++) {
+                    code |= int(bits(1));
+                    int n = h.counts[len];
+                    if (code - n < first)
+                        return int(h.symbols[size_t(index + code - first)]);
+                    index += n;
+                    first = (first + n) << 1;
+                    code <<= 1;
+                }
+                fail();
+                return 0;
+            };
+
+            static constexpr uint16_t length_base[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35,
+                                                         43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+            static constexpr uint8_t length_extra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3,
+                                                         4, 4, 4, 4, 5, 5, 5, 5, 0};
+            static constexpr uint16_t distance_base[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+                                                           257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+                                                           8193, 12289, 16385, 24577};
+            static constexpr uint8_t distance_extra[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8,
+                                                           8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+            static constexpr uint8_t order[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+            huffman lengths, distances;
+            for (bool last = false; !last; ) {
+                last = bits(1);
+                unsigned type = bits(2);
+                if (type == 0) {
+                    // stored block: byte aligned LEN and its complement NLEN, then LEN bytes
+                    buffer = count = 0;
+                    if (in_size - pos < 4)
+                        fail();
+                    size_t len = read<uint16_t>(in + pos);
+                    if (uint16_t(~len) != read<uint16_t>(in + pos + 2) || in_size - pos - 4 < len ||
+                        out_size - written < len)
+                        fail();
+                    std::memcpy(out + written, in + pos + 4, len);
+                    pos += 4 + len;
+                    written += len;
+                    continue;
+                }
+
+                uint8_t code_lengths[320]{};
+                if (type == 1) {
+                    for (size_t s = 0; s < 288; s++)
+                        code_lengths[s] = s < 144 ? 8 : s < 256 ? 9 : s < 280 ? 7 : 8;
+                    for (size_t s = 0; s < 30; s++)
+                        code_lengths[288 + s] = 5;
+                    build(lengths, code_lengths, 288);
+                    build(distances, code_lengths + 288, 30);
+                } else if (type == 2) {
+                    size_t nlen = bits(5) + 257, ndist = bits(5) + 1, ncode = bits(4) + 4;
+                    if (nlen > 286 || ndist > 30)
+                        fail();
+                    uint8_t code_code_lengths[19]{};
+                    for (size_t i = 0; i < ncode; i++)
+                        code_code_lengths[order[i]] = uint8_t(bits(3));
+                    huffman codes;
+                    build(codes, code_code_lengths, 19);
+                    for (size_t i = 0; i < nlen + ndist; ) {
+                        int symbol = decode(codes);
+                        if (symbol < 16) {
+                            code_lengths[i++] = uint8_t(symbol);
+                            continue;
+                        }
+                        uint8_t value = 0;
+                        size_t repeat;
+                        if (symbol == 16) {
+                            if (i == 0)
+                                fail();
+                            value = code_lengths[i - 1];
+                            repeat = 3 + bits(2);
+                        } else {
+                            repeat = symbol == 17 ? 3 + bits(3) : 11 + bits(7);
+                        }
+                        if (i + repeat > nlen + ndist)
+                            fail();
+                        std::fill_n(code_lengths + i, repeat, value);
+                        i += repeat;
+                    }
+                    build(lengths, code_lengths, nlen);
+                    build(distances, code_lengths + nlen, ndist);
+                } else {
+                    fail();
+                }
+
+                for (int symbol; (symbol = decode(lengths)) != 256; ) {
+                    if (symbol < 256) {
+                        if (written == out_size)
+                            fail();
+                        out[written++] = char(symbol);
+                        continue;
+                    }
+                    symbol -= 257;
+                    if (symbol >= 29)
+                        fail();
+                    size_t len = length_base[symbol] + bits(length_extra[symbol]);
+                    int d = decode(distances);
+                    if (d >= 30)
+                        fail();
+                    size_t distance = distance_base[d] + bits(distance_extra[d]);
+                    if (distance > written || out_size - written < len)
+                        fail();
+                    // the source may overlap the destination, so copy forward byte by byte
+                    for (char *dst = out + written, *src = dst - distance, *stop = dst + len; dst != stop; )
+                        *dst++ = *src++;
+                    written += len;
+                }
+            }
+            if (written != out_size)
+                fail();
+        }
+    };
+
+    // Reads and writes .npz archives, the zip files of .npy members written by numpy.savez and
+    // numpy.savez_compressed. Members are named without the .npy suffix, as in numpy.load(). Reading supports
+    // stored and deflated members; members are written stored, one after the other, and the central directory is
+    // written by close(), which the destructor calls if needed.
+    class NPZ {
+    public:
+        NPZ(const std::string &filename, const char mode) : mode_(mode) {
+            auto iosmode = std::ios::binary;
+            switch (mode_) {
+                case 'r':
+                    iosmode |= std::ios::in;
+                    break;
+                case 'w':
+                    iosmode |= std::ios::out | std::ios::trunc;
+                    break;
+                default:
+                    throw std::runtime_error("NPZ::NPZ(): unexpected mode");
+            }
+            fstrm_.open(filename, iosmode);
+            if (fstrm_.fail())
+                throw std::runtime_error("NPZ::NPZ(): can't open file");
+            if (mode_ == 'r')
+                members_ = zip_::directory(fstrm_);
+        }
+
+        NPZ(const NPZ &) = delete;
+
+        NPZ &operator=(const NPZ &) = delete;
+
+        ~NPZ() {
+            try {
+                close();
+            } catch (...) {
+            }
+        }
+
+        void close() {
+            if (mode_ == 'w') {
+                std::string central;
+                for (const auto &m: members_)
+                    central += zip_::central_header(m.name, m.size, m.crc, m.offset,
+                                                    m.size >= 0xFFFFFFFF || m.offset >= 0xFFFFFFFF);
+                central += zip_::end_records(members_.size(), central.length(), offset_);
+                write_(central.c_str(), central.length());
+            }
+            mode_ = 0;
+            members_.clear();
+            fstrm_.close();
+        }
+
+        [[nodiscard]] std::vector<std::string> files() const {
+            std::vector<std::string> names;
+            for (const auto &m: members_)
+                names.push_back(strip_(m.name));
+            return names;
+        }
+
+        [[nodiscard]] bool contains(const std::string &name) const {
+            return find_(name) != members_.end();
+        }
+
+        // The .npy bytes of member name, decompressed if needed and checked against the CRC-32 of the archive.
+        std::pair<std::shared_ptr<char[]>, size_t> read(const std::string &name) {
+            if (mode_ != 'r')
+                throw std::runtime_error("NPZ::read(): file not opened in 'r' mode");
+            auto it = find_(name);
+            if (it == members_.end())
+                throw std::runtime_error("NPZ::read(): no member named " + name);
+            if (it->method != 0 && it->method != 8)
+                throw std::runtime_error("NPZ::read(): unsupported compression method");
+
+            char local[30];
+            fstrm_.clear();
+            fstrm_.seekg(std::streamoff(it->offset));
+            if (fstrm_.read(local, 30).fail() || zip_::read<uint32_t>(local) != 0x04034b50)
+                throw std::runtime_error("NPZ::read(): invalid local header");
+            fstrm_.seekg(zip_::read<uint16_t>(local + 26) + zip_::read<uint16_t>(local + 28), std::ios::cur);
+
+            std::shared_ptr<char[]> data(new char[it->compressed]);
+            if (fstrm_.read(data.get(), std::streamsize(it->compressed)).fail())
+                throw std::runtime_error("NPZ::read(): failed read");
+            if (it->method == 8) {
+                std::shared_ptr<char[]> out(new char[it->size]);
+                zip_::inflate(data.get(), it->compressed, out.get(), it->size);
+                data = std::move(out);
+            }
+            if (crc32(0, data.get(), it->size) != it->crc)
+                throw std::runtime_error("NPZ::read(): CRC-32 does not match");
+            return {std::move(data), it->size};
+        }
+
+        // Loads member name; the array shares the memory of the member data.
+        template<class T>
+        ndarray<T> load(const std::string &name) {
+            auto [data, size] = read(name);
+            return NPY(std::move(data), size, 'r').load<T>();
+        }
+
+        // Loads member name whatever its element type, sharing the memory of the member data like load<T>().
+        any_ndarray load_any(const std::string &name) {
+            auto [data, size] = read(name);
+            return NPY(std::move(data), size, 'r').load_any();
+        }
+
+        NPY::header_info inspect(const std::string &name) {
+            auto [data, size] = read(name);
+            return NPY::inspect(std::move(data), size);
+        }
+
+        // Loads a zero-dimensional bytes ('S') or ASCII str ('U') member, such as the format of scipy.sparse files.
+        std::string load_string(const std::string &name) {
+            auto [data, size] = read(name);
+            NPY::header_info info = NPY::inspect(data, size);
+            const std::string &descr = info.descr;
+            if (!info.shape.empty() || descr.length() < 3 || (descr[1] != 'S' && descr[1] != 'U'))
+                throw std::runtime_error("NPZ::load_string(): member is not a string scalar");
+            size_t length = std::stoul(descr.substr(2)), width = descr[1] == 'U' ? 4 : 1;
+            if (length * width > size - info.offset)
+                throw std::runtime_error("NPZ::load_string(): failed read");
+            std::string str;
+            for (size_t i = 0; i < length; i++) {
+                const char *c = data.get() + info.offset + i * width;
+                uint32_t code = width == 1 ? (unsigned char) *c : descr[0] == '>' ? uint32_t((unsigned char) c[3])
+                                                                : zip_::read<uint32_t>(c);
+                if (code == 0)
+                    break;
+                if (code > 127 && width == 4)
+                    throw std::runtime_error("NPZ::load_string(): only ASCII strings are supported");
+                str += char(code);
+            }
+            return str;
+        }
+
+        template<class NDArray>
+        void save(const std::string &name, const NDArray &arr) {
+            std::string header = NPY::header(arr);
+            write_member_(name, header, (const char *) arr.data(), arr.size() * sizeof(typename NDArray::value_type));
+        }
+
+        void save(const std::string &name, const any_ndarray &arr) {
+            arr.visit([&](const auto &typed) { save(name, typed); });
+        }
+
+        // Saves str as a zero-dimensional bytes array, like numpy.array(b'...').
+        void save(const std::string &name, const std::string &str) {
+            std::string header = NPY::header("|S" + std::to_string(std::max(str.length(), size_t(1))),
+                                             std::array<size_t, 0>{});
+            write_member_(name, header, str.empty() ? "" : str.c_str(), std::max(str.length(), size_t(1)));
+        }
+
+        void save(const std::string &name, const char *str) { save(name, std::string(str)); }
+
+    private:
+        [[nodiscard]] static std::string strip_(const std::string &name) {
+            bool npy = name.length() > 4 && name.compare(name.length() - 4, 4, ".npy") == 0;
+            return npy ? name.substr(0, name.length() - 4) : name;
+        }
+
+        [[nodiscard]] std::vector<zip_::member>::const_iterator find_(const std::string &name) const {
+            return std::find_if(members_.begin(), members_.end(), [&](const zip_::member &m) {
+                return strip_(m.name) == name;
+            });
+        }
+
+        void write_member_(const std::string &name, const std::string &header, const char *data, size_t size) {
+            if (mode_ != 'w')
+                throw std::runtime_error("NPZ::save(): file not opened in 'w' mode");
+            if (name.empty() || contains(name))
+                throw std::runtime_error("NPZ::save(): empty or duplicate name");
+            zip_::member m;
+            m.name = name + ".npy";
+            m.size = m.compressed = header.length() + size;
+            m.crc = crc32(crc32(0, header.c_str(), header.length()), data, size);
+            m.offset = offset_;
+            std::string local = zip_::local_header(m.name, m.size, m.crc,
+                                                   m.size >= 0xFFFFFFFF || m.offset >= 0xFFFFFFFF);
+            write_(local.c_str(), local.length());
+            write_(header.c_str(), header.length());
+            write_(data, size);
+            members_.push_back(std::move(m));
+        }
+
+        void write_(const char *data, size_t size) {
+            if (fstrm_.write(data, std::streamsize(size)).fail())
+                throw std::runtime_error("NPZ::save(): failed write");
+            offset_ += size;
+        }
+
+        char mode_;
+        std::fstream fstrm_;
+        std::vector<zip_::member> members_;
+        uint64_t offset_{};
+    };
+
+}
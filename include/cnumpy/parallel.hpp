@@ -0,0 +1,83 @@
+#pragma once
+
+#include <algorithm>    // min
+#include <atomic>
+#include <cstddef>      // size_t
+#include <exception>    // exception_ptr, rethrow_exception
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace cnumpy {
+
+    // Number of threads used by the parallel algorithms of this library. Zero selects
+    // std::thread::hardware_concurrency().
+    inline std::atomic<size_t> &num_threads_() {
+        static std::atomic<size_t> num_threads{0};
+        return num_threads;
+    }
+
+    inline void set_num_threads(size_t nthreads) noexcept {
+        num_threads_() = nthreads;
+    }
+
+    [[nodiscard]] inline size_t get_num_threads() noexcept {
+        size_t nthreads = num_threads_();
+        if (nthreads == 0)
+            nthreads = std::thread::hardware_concurrency();
+        return nthreads ? nthreads : 1;
+    }
+
+    inline bool &in_parallel_() noexcept {
+        thread_local bool in_parallel = false;
+        return in_parallel;
+    }
+
+    // Calls fn(begin, end) for consecutive chunks of at most grain indices covering [first, last). Chunks are handed
+    // out dynamically to at most nthreads threads (get_num_threads() if zero), the calling thread being one of them.
+    // Nested calls run serially on the calling thread. The first exception thrown by fn is rethrown after all threads
+    // have joined.
+    template<class Function>
+    void parallel_for(size_t first, size_t last, size_t grain, Function &&fn, size_t nthreads = 0) {
+        if (first >= last)
+            return;
+        grain = std::max(grain, size_t(1));
+        size_t nchunks = (last - first - 1) / grain + 1;
+        nthreads = std::min(nthreads ? nthreads : get_num_threads(), nchunks);
+        if (nthreads <= 1 || in_parallel_()) {
+            for (size_t begin = first; begin < last; begin += std::min(grain, last - begin))
+                fn(begin, begin + std::min(grain, last - begin));
+            return;
+        }
+
+        std::atomic<size_t> next{0};
+        std::exception_ptr error;
+        std::mutex error_mutex;
+        auto worker = [&]() {
+            in_parallel_() = true;
+            for (size_t chunk = next++; chunk < nchunks; chunk = next++) {
+                size_t begin = first + chunk * grain;
+                try {
+                    fn(begin, begin + std::min(grain, last - begin));
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(error_mutex);
+                    if (!error)
+                        error = std::current_exception();
+                    next = nchunks;
+                }
+            }
+            in_parallel_() = false;
+        };
+
+        std::vector<std::thread> threads;
+        threads.reserve(nthreads - 1);
+        for (size_t t = 1; t < nthreads; t++)
+            threads.emplace_back(worker);
+        worker();
+        for (auto &thread : threads)
+            thread.join();
+        if (error)
+            std::rethrow_exception(error);
+    }
+
+}
@@ -0,0 +1,396 @@
+#pragma once
+
+#include <algorithm>    // min
+#include <array>
+#include <cmath>        // exp, log1p
+#include <cstddef>      // size_t
+#include <cstdint>      // uint32_t, uint64_t
+#include <limits>       // numeric_limits
+#include <stdexcept>    // runtime_error
+#include <type_traits>  // conditional_t, is_floating_point, is_integral, is_same, is_unsigned, make_unsigned_t
+#include <vector>
+#include "ndarray.hpp"
+#include "parallel.hpp"
+#include "ziggurat.hpp"
+
+namespace cnumpy::random {
+
+    // low 64 bits of a * b, with the high 64 bits in hi
+    inline uint64_t mulhilo_(uint64_t a, uint64_t b, uint64_t &hi) noexcept {
+#ifdef __SIZEOF_INT128__
+        unsigned __int128 product = (unsigned __int128) a * b;
+        hi = uint64_t(product >> 64);
+        return uint64_t(product);
+#else
+        uint64_t a_lo = a & 0xFFFFFFFF, a_hi = a >> 32, b_lo = b & 0xFFFFFFFF, b_hi = b >> 32;
+        uint64_t lo_lo = a_lo * b_lo, hi_lo = a_hi * b_lo, lo_hi = a_lo * b_hi;
+        uint64_t cross = (lo_lo >> 32) + (hi_lo & 0xFFFFFFFF) + lo_hi;
+        hi = a_hi * b_hi + (hi_lo >> 32) + (cross >> 32);
+        return a * b;
+#endif
+    }
+
+    // Draws in [0, rng] for an unsigned type U like numpy's buffered bounded Lemire functions, from a generator with
+    // next_uint32() and next_uint64(). Types narrower than 32 bits take their draws from the bits of one 32-bit
+    // output, which are kept for the next draws.
+    template<class U>
+    struct bounded_ {
+        static_assert(std::is_unsigned<U>());
+        U rng;
+        uint32_t buf = 0;
+        int bcnt = 0;
+
+        explicit bounded_(U rng) : rng(rng) {}
+
+        template<class Generator>
+        U draw(Generator &gen) {
+            if constexpr (sizeof(U) == 8) {
+                return gen.next_uint64();
+            } else if constexpr (sizeof(U) == 4) {
+                return gen.next_uint32();
+            } else {
+                if (bcnt == 0) {
+                    buf = gen.next_uint32();
+                    bcnt = 4 / int(sizeof(U)) - 1;
+                } else {
+                    buf >>= 8 * sizeof(U);
+                    bcnt--;
+                }
+                return U(buf);
+            }
+        }
+
+        template<class Generator>
+        U operator()(Generator &gen) {
+            if (rng == 0)
+                return 0;
+            // only the 64-bit types draw 64 bits, and only when the range needs them
+            if constexpr (sizeof(U) == 8) {
+                if (rng <= 0xFFFFFFFF) {
+                    if (rng == 0xFFFFFFFF)
+                        return gen.next_uint32();
+                    return lemire_(uint32_t(rng), [&]() { return gen.next_uint32(); });
+                }
+            }
+            if (rng == std::numeric_limits<U>::max())
+                return draw(gen);
+            return lemire_(rng, [&]() { return draw(gen); });
+        }
+
+        // Lemire's multiply and reject method: the high half of draw() * (rng + 1), rejecting the few products
+        // whose low half would bias the result
+        template<class V, class Draw>
+        static V lemire_(V rng, Draw &&draw) {
+            const V rng_excl = V(rng + 1);
+            auto multiply = [&](V &leftover) {
+                if constexpr (sizeof(V) == 8) {
+                    uint64_t hi;
+                    leftover = mulhilo_(draw(), rng_excl, hi);
+                    return hi;
+                } else {
+                    using product = std::conditional_t<sizeof(V) == 4, uint64_t, uint32_t>;
+                    product m = product(draw()) * rng_excl;
+                    leftover = V(m);
+                    return V(m >> 8 * sizeof(V));
+                }
+            };
+            V leftover;
+            V result = multiply(leftover);
+            if (leftover < rng_excl) {
+                const V threshold = V(V(std::numeric_limits<V>::max() - rng) % rng_excl);
+                while (leftover < threshold)
+                    result = multiply(leftover);
+            }
+            return result;
+        }
+    };
+
+    // Philox4x64-10, a counter-based generator: block c of four 64-bit outputs is a keyed bijection of the 256-bit
+    // counter c, so any part of the stream can be computed directly. The state follows numpy.random.Philox: seeded
+    // with the same integer, the raw outputs and the scalar draws below are those of numpy.random.Philox and of
+    // numpy.random.Generator(numpy.random.Philox(seed)).
+    class philox {
+    public:
+        using counter_type = std::array<uint64_t, 4>;
+        using key_type = std::array<uint64_t, 2>;
+
+        // key derived from seed by numpy.random.SeedSequence, counter 0
+        explicit philox(uint64_t seed) : philox(seed_key_(seed)) {}
+
+        explicit philox(const key_type &key, const counter_type &counter = {}) : counter_(counter), key_(key) {}
+
+        [[nodiscard]] const counter_type &counter() const noexcept { return counter_; }
+
+        [[nodiscard]] const key_type &key() const noexcept { return key_; }
+
+        // the four outputs for counter
+        [[nodiscard]] static counter_type block(counter_type counter, key_type key) noexcept {
+            for (int round = 0; round < 10; round++) {
+                if (round > 0) {
+                    key[0] += 0x9E3779B97F4A7C15;
+                    key[1] += 0xBB67AE8584CAA73B;
+                }
+                uint64_t hi0, lo0 = mulhilo_(0xD2E7470EE14C6C93, counter[0], hi0);
+                uint64_t hi1, lo1 = mulhilo_(0xCA5A826395121157, counter[2], hi1);
+                counter = {hi1 ^ counter[1] ^ key[0], lo1, hi0 ^ counter[3] ^ key[1], lo0};
+            }
+            return counter;
+        }
+
+        uint64_t next_uint64() noexcept {
+            if (buffer_pos_ < 4)
+                return buffer_[buffer_pos_++];
+            add_(counter_, 1);
+            buffer_ = block(counter_, key_);
+            buffer_pos_ = 1;
+            return buffer_[0];
+        }
+
+        // low half of a 64-bit output first, then its high half
+        uint32_t next_uint32() noexcept {
+            if (has_uint32_) {
+                has_uint32_ = false;
+                return uinteger_;
+            }
+            uint64_t next = next_uint64();
+            has_uint32_ = true;
+            uinteger_ = uint32_t(next >> 32);
+            return uint32_t(next);
+        }
+
+        // in [0, 1), with 53 random bits
+        double next_double() noexcept { return double(next_uint64() >> 11) * (1.0 / 9007199254740992.0); }
+
+        // in [0, 1), with 24 random bits
+        float next_float() noexcept { return float(next_uint32() >> 8) * (1.0f / 16777216.0f); }
+
+        // Generator.standard_normal(): 256-layer ziggurat on 64-bit draws
+        double standard_normal() {
+            for (;;) {
+                uint64_t r = next_uint64();
+                auto idx = size_t(r & 0xff);
+                r >>= 8;
+                uint64_t sign = r & 1, rabs = (r >> 1) & 0x000fffffffffffff;
+                double x = double(rabs) * ziggurat_wi_[idx];
+                if (sign)
+                    x = -x;
+                if (rabs < ziggurat_ki_[idx])
+                    return x;
+                if (idx == 0) {
+                    // tail beyond r
+                    for (;;) {
+                        double xx = -ziggurat_inv_r_ * std::log1p(-next_double());
+                        double yy = -std::log1p(-next_double());
+                        if (yy + yy > xx * xx)
+                            return (rabs >> 8) & 1 ? -(ziggurat_r_ + xx) : ziggurat_r_ + xx;
+                    }
+                }
+                double f = (ziggurat_fi_[idx - 1] - ziggurat_fi_[idx]) * next_double() + ziggurat_fi_[idx];
+                if (f < std::exp(-0.5 * x * x))
+                    return x;
+            }
+        }
+
+        // Generator.integers(low, high, dtype=T): uniform in [low, high) by Lemire's multiply and reject method
+        template<class T>
+        T integers(T low, T high) {
+            static_assert(std::is_integral<T>() && !std::is_same<T, bool>());
+            if (high <= low)
+                throw std::runtime_error("philox::integers(): low must be less than high");
+            using U = std::make_unsigned_t<T>;
+            bounded_<U> bounded(U(U(high) - U(low) - 1));
+            return T(U(low) + bounded(*this));
+        }
+
+        // as if delta blocks had been drawn, discarding any buffered output like numpy's Philox.advance()
+        void advance(uint64_t delta) noexcept {
+            add_(counter_, delta);
+            buffer_pos_ = 4;
+            has_uint32_ = false;
+        }
+
+    private:
+        template<class T, class Container>
+        friend void random(philox &, ndarray_impl<T, Container> &);
+
+        template<class T, class Container, class Make>
+        friend void fill_blocks_(philox &, ndarray_impl<T, Container> &, Make &&);
+
+        // numpy.random.SeedSequence(seed).generate_state(2, numpy.uint64)
+        static key_type seed_key_(uint64_t seed) noexcept {
+            constexpr uint32_t init_a = 0x43b0d7e5, mult_a = 0x931e8875, init_b = 0x8b51f9dd, mult_b = 0x58f38ded;
+            constexpr uint32_t mix_mult_l = 0xca01f9dd, mix_mult_r = 0x4973f715;
+            uint32_t hash_const = init_a;
+            auto hashmix = [&](uint32_t value) {
+                value ^= hash_const;
+                hash_const *= mult_a;
+                value *= hash_const;
+                return value ^ value >> 16;
+            };
+            auto mix = [](uint32_t x, uint32_t y) {
+                uint32_t result = mix_mult_l * x - mix_mult_r * y;
+                return result ^ result >> 16;
+            };
+
+            // the entropy as 32-bit words, least significant first
+            std::vector<uint32_t> entropy{uint32_t(seed)};
+            if (seed >> 32)
+                entropy.push_back(uint32_t(seed >> 32));
+            std::array<uint32_t, 4> pool{};
+            for (size_t i = 0; i < pool.size(); i++)
+                pool[i] = hashmix(i < entropy.size() ? entropy[i] : 0);
+            for (size_t src = 0; src < pool.size(); src++)
+                for (size_t dst = 0; dst < pool.size(); dst++)
+                    if (src != dst)
+                        pool[dst] = mix(pool[dst], hashmix(pool[src]));
+
+            uint32_t state[4];
+            hash_const = init_b;
+            for (size_t i = 0; i < 4; i++) {
+                uint32_t value = pool[i % pool.size()] ^ hash_const;
+                hash_const *= mult_b;
+                value *= hash_const;
+                state[i] = value ^ value >> 16;
+            }
+            return {uint64_t(state[0]) | uint64_t(state[1]) << 32, uint64_t(state[2]) | uint64_t(state[3]) << 32};
+        }
+
+        // counter += delta << (64 * word), with carry
+        static void add_(counter_type &counter, uint64_t delta, size_t word = 0) noexcept {
+            for (size_t i = word; i < 4 && delta; i++) {
+                counter[i] += delta;
+                delta = counter[i] < delta;
+            }
+        }
+
+        counter_type counter_;
+        key_type key_;
+        counter_type buffer_{};
+        size_t buffer_pos_ = 4;
+        bool has_uint32_ = false;
+        uint32_t uinteger_ = 0;
+    };
+
+    // elements per block of the fills whose draws per element vary
+    inline constexpr size_t block_ = size_t(1) << 14;
+
+    // counters per parallel task of random()
+    inline constexpr size_t random_grain_ = size_t(1) << 10;
+
+    // Fills arr block by block, block_ elements at a time and in parallel, with draw(local) where draw = make() is
+    // created for every block and local serves that block only, so the result only depends on gen and never on the
+    // number of threads. The first block continues gen itself, so a fill of at most block_ elements is the same as
+    // numpy's; block b > 0 draws from gen's counter advanced by b * 2^64. Afterwards gen continues the stream of the
+    // first block if there was a single block, and starts from its counter advanced by blocks * 2^64 otherwise.
+    template<class T, class Container, class Make>
+    void fill_blocks_(philox &gen, ndarray_impl<T, Container> &arr, Make &&make) {
+        size_t n = arr.size(), blocks = (n + block_ - 1) / block_;
+        philox first = gen;
+        T *data = arr.data();
+        parallel_for(0, blocks, 1, [&](size_t begin, size_t end) {
+            for (size_t b = begin; b < end; b++) {
+                philox local = gen;
+                if (b > 0) {
+                    philox::add_(local.counter_, b, 1);
+                    local.buffer_pos_ = 4;
+                    local.has_uint32_ = false;
+                }
+                auto draw = make();
+                T *out = data + b * block_;
+                for (size_t i = 0, count = std::min(block_, n - b * block_); i < count; i++)
+                    out[i] = draw(local);
+                if (b == 0)
+                    first = local;
+            }
+        });
+        if (blocks <= 1) {
+            gen = first;
+        } else {
+            philox::add_(gen.counter_, blocks, 1);
+            gen.buffer_pos_ = 4;
+            gen.has_uint32_ = false;
+        }
+    }
+
+    // Generator.random(): uniform in [0, 1) for double or float. Every element takes one 64-bit output (two
+    // elements per output for float), so block c of the counter is computed straight into the elements it serves,
+    // in parallel, and the result and the state of gen afterwards are the same as numpy's for any size.
+    template<class T, class Container>
+    void random(philox &gen, ndarray_impl<T, Container> &arr) {
+        static_assert(std::is_same<T, double>() || std::is_same<T, float>());
+        constexpr size_t per_word = std::is_same<T, double>() ? 1 : 2, per_block = 4 * per_word;
+        auto convert = [](uint64_t word, T *out) {
+            if constexpr (std::is_same<T, double>()) {
+                out[0] = double(word >> 11) * (1.0 / 9007199254740992.0);
+            } else {
+                out[0] = float(uint32_t(word) >> 8) * (1.0f / 16777216.0f);
+                out[1] = float(uint32_t(word >> 32) >> 8) * (1.0f / 16777216.0f);
+            }
+        };
+
+        // elements served by what gen has buffered, up to the start of the next block
+        T *out = arr.data();
+        size_t n = arr.size(), head = 0;
+        auto buffered = [&]() { return gen.buffer_pos_ < 4 || (std::is_same<T, float>() && gen.has_uint32_); };
+        for (; head < n && buffered(); head++)
+            out[head] = std::is_same<T, double>() ? T(gen.next_double()) : T(gen.next_float());
+        if (head == n)
+            return;
+
+        size_t blocks = (n - head) / per_block;
+        philox::counter_type base = gen.counter_;
+        parallel_for(0, blocks, random_grain_, [&](size_t begin, size_t end) {
+            philox::counter_type counter = base;
+            philox::add_(counter, begin + 1);
+            for (size_t c = begin; c < end; c++, philox::add_(counter, 1)) {
+                philox::counter_type words = philox::block(counter, gen.key_);
+                T *dst = out + head + c * per_block;
+                for (size_t w = 0; w < 4; w++)
+                    convert(words[w], dst + w * per_word);
+            }
+        });
+        philox::add_(gen.counter_, blocks);
+        for (size_t i = head + blocks * per_block; i < n; i++)
+            out[i] = std::is_same<T, double>() ? T(gen.next_double()) : T(gen.next_float());
+    }
+
+    // Generator.uniform(low, high): uniform in [low, high)
+    template<class T, class Container>
+    void uniform(philox &gen, ndarray_impl<T, Container> &arr, T low, T high) {
+        random(gen, arr);
+        T scale = high - low, *out = arr.data();
+        parallel_for(0, arr.size(), size_t(1) << 16, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++)
+                out[i] = low + scale * out[i];
+        });
+    }
+
+    // Generator.standard_normal(), computed in double precision; see fill_blocks_ for the use of gen.
+    template<class T, class Container>
+    void standard_normal(philox &gen, ndarray_impl<T, Container> &arr) {
+        static_assert(std::is_floating_point<T>());
+        fill_blocks_(gen, arr, []() { return [](philox &local) { return T(local.standard_normal()); }; });
+    }
+
+    // Generator.normal(loc, scale)
+    template<class T, class Container>
+    void normal(philox &gen, ndarray_impl<T, Container> &arr, T loc, T scale) {
+        fill_blocks_(gen, arr, [&]() {
+            return [loc, scale](philox &local) { return T(loc + scale * local.standard_normal()); };
+        });
+    }
+
+    // Generator.integers(low, high, dtype=T): uniform in [low, high); see fill_blocks_ for the use of gen.
+    template<class T, class Container>
+    void integers(philox &gen, ndarray_impl<T, Container> &arr, T low, T high) {
+        static_assert(std::is_integral<T>() && !std::is_same<T, bool>());
+        if (high <= low)
+            throw std::runtime_error("integers(): low must be less than high");
+        using U = std::make_unsigned_t<T>;
+        auto off = U(low), rng = U(U(high) - U(low) - 1);
+        fill_blocks_(gen, arr, [&]() {
+            return [off, bounded = bounded_<U>(rng)](philox &local) mutable { return T(U(off + bounded(local))); };
+        });
+    }
+
+}
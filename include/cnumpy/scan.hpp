@@ -0,0 +1,249 @@
+#pragma once
+
+#include <algorithm>    // min
+#include <cstddef>      // ptrdiff_t, size_t
+#include <limits>       // infinity, lowest
+#include <type_traits>  // integral_constant, is_floating_point_v, is_same_v
+#include <vector>
+#include "ndarray.hpp"
+#include "parallel.hpp"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>  // _mm_add_pd, _mm_add_ps, _mm_slli_si128
+#endif
+
+namespace cnumpy {
+
+    template<class T>
+    struct scan_sum_ {
+        static constexpr T identity() { return T(0); }
+
+        T operator()(const T &a, const T &b) const { return T(a + b); }
+    };
+
+    template<class T>
+    struct scan_prod_ {
+        static constexpr T identity() { return T(1); }
+
+        T operator()(const T &a, const T &b) const { return T(a * b); }
+    };
+
+    // NaN propagates, as in numpy.maximum.accumulate
+    template<class T>
+    struct scan_max_ {
+        static constexpr T identity() {
+            if constexpr (std::is_floating_point_v<T>)
+                return -std::numeric_limits<T>::infinity();
+            else
+                return std::numeric_limits<T>::lowest();
+        }
+
+        T operator()(const T &a, const T &b) const { return b < a || a != a ? a : b; }
+    };
+
+    inline constexpr size_t scan_width_ = 8;                        // accumulators of a reduction
+    inline constexpr size_t scan_block_ = size_t(1) << 16;          // least elements per block of a parallel scan
+    inline constexpr size_t scan_lanes_ = 1024;                     // lanes per task when scanning across rows
+
+#if defined(__SSE2__)
+
+    // Prefix sums in registers, two vectors per step: each vector gets its prefix by shifted additions, and only the
+    // running total carried from step to step forms a dependency chain. Returns the number of elements done.
+    inline size_t scan_sum_simd_(const double *in, double *out, size_t n, double &carry) {
+        auto prefix = [](__m128d v) { return _mm_add_pd(v, _mm_castsi128_pd(_mm_slli_si128(_mm_castpd_si128(v), 8))); };
+        __m128d c = _mm_set1_pd(carry);
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            __m128d a = prefix(_mm_loadu_pd(in + i)), b = prefix(_mm_loadu_pd(in + i + 2));
+            b = _mm_add_pd(b, _mm_unpackhi_pd(a, a));
+            _mm_storeu_pd(out + i, _mm_add_pd(c, a));
+            _mm_storeu_pd(out + i + 2, _mm_add_pd(c, b));
+            c = _mm_add_pd(c, _mm_unpackhi_pd(b, b));
+        }
+        carry = _mm_cvtsd_f64(c);
+        return i;
+    }
+
+    inline size_t scan_sum_simd_(const float *in, float *out, size_t n, float &carry) {
+        auto shift = [](__m128 v, auto bytes) {
+            return _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(v), decltype(bytes)::value));
+        };
+        auto prefix = [&](__m128 v) {
+            v = _mm_add_ps(v, shift(v, std::integral_constant<int, 4>()));
+            return _mm_add_ps(v, shift(v, std::integral_constant<int, 8>()));
+        };
+        __m128 c = _mm_set1_ps(carry);
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            __m128 a = prefix(_mm_loadu_ps(in + i)), b = prefix(_mm_loadu_ps(in + i + 4));
+            b = _mm_add_ps(b, _mm_shuffle_ps(a, a, 0xFF));
+            _mm_storeu_ps(out + i, _mm_add_ps(c, a));
+            _mm_storeu_ps(out + i + 4, _mm_add_ps(c, b));
+            c = _mm_add_ps(c, _mm_shuffle_ps(b, b, 0xFF));
+        }
+        carry = _mm_cvtss_f32(c);
+        return i;
+    }
+
+#endif
+
+    // out[i] = carry op in[0] op ... op in[i]
+    template<class T, class Op>
+    void scan_line_(const T *in, T *out, size_t n, T carry, Op op) {
+        size_t i = 0;
+#if defined(__SSE2__)
+        if constexpr (std::is_same_v<Op, scan_sum_<T>> && (std::is_same_v<T, double> || std::is_same_v<T, float>))
+            i = scan_sum_simd_(in, out, n, carry);
+#endif
+        for (; i < n; i++)
+            out[i] = carry = op(carry, in[i]);
+    }
+
+    // in[0] op ... op in[n - 1], with independent accumulators
+    template<class T, class Op>
+    T reduce_line_(const T *in, size_t n, Op op) {
+        T acc[scan_width_];
+        for (size_t k = 0; k < scan_width_; k++)
+            acc[k] = Op::identity();
+        size_t i = 0;
+        for (; i + scan_width_ <= n; i += scan_width_)
+            for (size_t k = 0; k < scan_width_; k++)
+                acc[k] = op(acc[k], in[i + k]);
+        T total = Op::identity();
+        for (size_t k = 0; k < scan_width_; k++)
+            total = op(total, acc[k]);
+        for (; i < n; i++)
+            total = op(total, in[i]);
+        return total;
+    }
+
+    // Scans the lines of in along one axis into out, which has the same shape.
+    template<class T, class Op>
+    void scan_(const T *in, T *out, const axis_lines_ &lines, Op op) {
+        if (lines.count == 0 || lines.length == 0)
+            return;
+        size_t nthreads = get_num_threads();
+
+        // across rows: every element of a row continues the lane below it, rows stay contiguous
+        if (lines.stride > 1) {
+            size_t stride = lines.stride, outer = lines.count / stride, row = lines.length * stride;
+            size_t chunks = (stride + scan_lanes_ - 1) / scan_lanes_;
+            parallel_for(0, outer * chunks, 1, [&](size_t begin, size_t end) {
+                for (size_t task = begin; task < end; task++) {
+                    size_t first = task % chunks * scan_lanes_, last = std::min(first + scan_lanes_, stride);
+                    const T *src = in + task / chunks * row;
+                    T *dst = out + task / chunks * row;
+                    for (size_t j = first; j < last; j++)
+                        dst[j] = src[j];
+                    for (size_t i = 1; i < lines.length; i++)
+                        for (size_t j = first; j < last; j++)
+                            dst[i * stride + j] = op(dst[(i - 1) * stride + j], src[i * stride + j]);
+                }
+            });
+            return;
+        }
+
+        // few long lines: reduce blocks in parallel, combine their totals, then scan blocks from their carries
+        if (nthreads > 1 && lines.count < nthreads && lines.length >= 2 * scan_block_) {
+            size_t nblocks = std::min(nthreads * 4, lines.length / scan_block_);
+            size_t block = (lines.length + nblocks - 1) / nblocks;
+            std::vector<T> carries(nblocks);
+            for (size_t line = 0; line < lines.count; line++) {
+                const T *src = in + line * lines.length;
+                T *dst = out + line * lines.length;
+                parallel_for(0, nblocks, 1, [&](size_t begin, size_t end) {
+                    for (size_t b = begin; b < end; b++)
+                        carries[b] = reduce_line_(src + b * block, std::min(block, lines.length - b * block), op);
+                });
+                T carry = Op::identity();
+                for (size_t b = 0; b < nblocks; b++) {
+                    T total = carries[b];
+                    carries[b] = carry;
+                    carry = op(carry, total);
+                }
+                parallel_for(0, nblocks, 1, [&](size_t begin, size_t end) {
+                    for (size_t b = begin; b < end; b++)
+                        scan_line_(src + b * block, dst + b * block, std::min(block, lines.length - b * block),
+                                   carries[b], op);
+                });
+            }
+            return;
+        }
+
+        size_t grain = std::max(size_t(1), scan_block_ / lines.length);
+        parallel_for(0, lines.count, grain, [&](size_t begin, size_t end) {
+            for (size_t line = begin; line < end; line++)
+                scan_line_(in + line * lines.length, out + line * lines.length, lines.length, Op::identity(), op);
+        });
+    }
+
+    // Cumulative sum of arr along axis, in T. Long lines are scanned in parallel blocks, so floating-point results
+    // may differ from a sequential sum in the last bits.
+    template<class T, class Container>
+    ndarray_impl<T, Container> cumsum(const ndarray_impl<T, Container> &arr, ptrdiff_t axis = -1) {
+        ndarray_impl<T, Container> out(arr.shape());
+        scan_(arr.data(), out.data(), axis_lines_of_(arr.shape(), axis, "cumsum"), scan_sum_<T>());
+        return out;
+    }
+
+    template<class T, class Container>
+    ndarray_impl<T, Container> cumprod(const ndarray_impl<T, Container> &arr, ptrdiff_t axis = -1) {
+        ndarray_impl<T, Container> out(arr.shape());
+        scan_(arr.data(), out.data(), axis_lines_of_(arr.shape(), axis, "cumprod"), scan_prod_<T>());
+        return out;
+    }
+
+    // Running maximum along axis, like numpy.maximum.accumulate: NaN propagates.
+    template<class T, class Container>
+    ndarray_impl<T, Container> cummax(const ndarray_impl<T, Container> &arr, ptrdiff_t axis = -1) {
+        ndarray_impl<T, Container> out(arr.shape());
+        scan_(arr.data(), out.data(), axis_lines_of_(arr.shape(), axis, "cummax"), scan_max_<T>());
+        return out;
+    }
+
+    template<class T, class Container>
+    ndarray_impl<T, Container> diff_once_(const ndarray_impl<T, Container> &arr, size_t a) {
+        auto lines = axis_lines_of_(arr.shape(), ptrdiff_t(a), "diff");
+        auto shape = arr.shape();
+        shape[a] = lines.length > 0 ? lines.length - 1 : 0;
+        ndarray_impl<T, Container> out(shape);
+        if (out.size() == 0)
+            return out;
+
+        const T *in = arr.data();
+        T *dst = out.data();
+        size_t length = lines.length - 1, stride = lines.stride;
+        if (stride == 1) {
+            parallel_for(0, lines.count, std::max(size_t(1), scan_block_ / length), [&](size_t begin, size_t end) {
+                for (size_t line = begin; line < end; line++)
+                    for (size_t i = 0; i < length; i++)
+                        dst[line * length + i] = T(in[line * (length + 1) + i + 1] - in[line * (length + 1) + i]);
+            });
+        } else {
+            // one row of stride contiguous elements at a time
+            size_t rows = lines.count / stride * length;
+            parallel_for(0, rows, std::max(size_t(1), scan_block_ / stride), [&](size_t begin, size_t end) {
+                for (size_t r = begin; r < end; r++) {
+                    const T *src = in + (r / length * (length + 1) + r % length) * stride;
+                    for (size_t j = 0; j < stride; j++)
+                        dst[r * stride + j] = T(src[stride + j] - src[j]);
+                }
+            });
+        }
+        return out;
+    }
+
+    // The nth discrete difference along axis, out[i] = arr[i + 1] - arr[i] applied n times, as numpy.diff. The axis
+    // shrinks by n, to zero if it is not longer than n.
+    template<class T, class Container>
+    ndarray_impl<T, Container> diff(const ndarray_impl<T, Container> &arr, size_t n = 1, ptrdiff_t axis = -1) {
+        size_t a = normalize_axis_(axis, arr.ndim(), "diff");
+        if (n == 0)
+            return arr;
+        ndarray_impl<T, Container> out = diff_once_(arr, a);
+        for (size_t k = 1; k < n && out.shape()[a] > 0; k++)
+            out = diff_once_(out, a);
+        return out;
+    }
+
+}
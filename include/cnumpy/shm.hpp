@@ -0,0 +1,197 @@
+#pragma once
+
+#include <atomic>
+#include <cerrno>       // errno
+#include <cstdint>      // uint64_t
+#include <cstring>      // memcpy, strerror
+#include <memory>       // shared_ptr
+#include <new>          // placement new
+#include <stdexcept>    // runtime_error
+#include <string>
+#include <thread>       // yield
+#include <type_traits>  // invoke_result_t, is_void_v
+#include <utility>      // as_const, move
+#include <vector>
+#include <fcntl.h>      // O_CREAT, O_EXCL, O_RDONLY, O_RDWR
+#include <sys/mman.h>   // mmap, munmap, shm_open, shm_unlink
+#include <sys/stat.h>   // fstat, mode_t
+#include <unistd.h>     // close, ftruncate
+#include "ndarray.hpp"
+#include "npy.hpp"
+
+namespace cnumpy {
+
+    // Precedes the array in a segment. The .npy header and data follow at byte 64, so the rest of the segment is a
+    // valid .npy file.
+    struct shm_control_ {
+        std::atomic<uint64_t> magic;        // set last by the creator, once the header is complete
+        std::atomic<uint64_t> sequence;     // seqlock: odd while a write is in progress
+        uint64_t size;                      // bytes of the whole segment
+        char reserved[40];
+    };
+
+    static_assert(sizeof(shm_control_) == 64 && std::atomic<uint64_t>::is_always_lock_free);
+
+    // An array in a named POSIX shared memory segment (shm_open), for processes on one node to exchange data without
+    // copies or serialization. One process creates the segment with a type and shape, others attach to it by name and
+    // recover both from the header. The array aliases the mapping, which stays valid while any shm_array or array
+    // obtained from it is alive, even after unlink().
+    //
+    // Copying an ndarray copies its data, so shm_array is move-only; array().make_shared(shape) gives further arrays
+    // aliasing the segment. Accessing array() directly is not synchronized. write() and read() add seqlock-style
+    // versioning: writers are serialized, and a reader repeats its function until no write overlapped it, so it must
+    // only copy or compute from the data, not act on it.
+    template<class T>
+    class shm_array {
+    public:
+        static shm_array create(const std::string &name, const std::vector<size_t> &shape, mode_t mode = 0600) {
+            std::string header = NPY::header(NPY::descr<T>(), shape);
+            size_t bytes = shape_size_(shape, sizeof(T), "shm_array<T>::create") * sizeof(T);
+            size_t size = sizeof(shm_control_) + header.length() + bytes;
+
+            int fd = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, mode);
+            if (fd < 0)
+                throw std::runtime_error("shm_array<T>::create(): can't create " + name + ": " + std::strerror(errno));
+            std::shared_ptr<char[]> mapping;
+            if (::ftruncate(fd, off_t(size)) == 0)
+                mapping = map_(fd, size, true);
+            int error = errno;
+            ::close(fd);
+            if (!mapping) {
+                ::shm_unlink(name.c_str());
+                throw std::runtime_error("shm_array<T>::create(): can't map " + name + ": " + std::strerror(error));
+            }
+
+            std::memcpy(mapping.get() + sizeof(shm_control_), header.data(), header.length());
+            auto *control = new(mapping.get()) shm_control_{};
+            control->size = size;
+            control->magic.store(magic_, std::memory_order_release);
+            return shm_array(name, std::move(mapping), sizeof(shm_control_) + header.length(), shape);
+        }
+
+        // A read-only attachment maps the segment without write access: writing to its array faults, write() throws.
+        static shm_array attach(const std::string &name, bool writable = true) {
+            int fd = ::shm_open(name.c_str(), writable ? O_RDWR : O_RDONLY, 0);
+            if (fd < 0)
+                throw std::runtime_error("shm_array<T>::attach(): can't open " + name + ": " + std::strerror(errno));
+            struct stat st{};
+            std::shared_ptr<char[]> mapping;
+            if (::fstat(fd, &st) == 0 && size_t(st.st_size) >= 2 * sizeof(shm_control_))
+                mapping = map_(fd, size_t(st.st_size), writable);
+            ::close(fd);
+            if (!mapping)
+                throw std::runtime_error("shm_array<T>::attach(): can't map " + name);
+
+            auto *control = reinterpret_cast<shm_control_ *>(mapping.get());
+            if (control->magic.load(std::memory_order_acquire) != magic_ || control->size != size_t(st.st_size))
+                throw std::runtime_error("shm_array<T>::attach(): " + name + " is not an initialized array segment");
+            size_t remaining = control->size - sizeof(shm_control_);
+            auto info = NPY::inspect(std::shared_ptr<char[]>(mapping, mapping.get() + sizeof(shm_control_)),
+                                     remaining);
+            if (info.descr != NPY::descr<T>() || info.fortran_order)
+                throw std::runtime_error("shm_array<T>::attach(): data type does not match");
+            if (shape_size_(info.shape, sizeof(T), "shm_array<T>::attach") * sizeof(T) > remaining - info.offset)
+                throw std::runtime_error("shm_array<T>::attach(): data is shorter than the header says");
+            shm_array arr(name, std::move(mapping), sizeof(shm_control_) + info.offset, info.shape);
+            arr.writable_ = writable;
+            return arr;
+        }
+
+        // Removes the name; existing mappings stay valid until their last user is gone.
+        static void unlink(const std::string &name) {
+            if (::shm_unlink(name.c_str()) != 0)
+                throw std::runtime_error("shm_array<T>::unlink(): can't remove " + name + ": " + std::strerror(errno));
+        }
+
+        shm_array(const shm_array &) = delete;
+
+        shm_array(shm_array &&) noexcept = default;
+
+        shm_array &operator=(const shm_array &) = delete;
+
+        shm_array &operator=(shm_array &&) noexcept = default;
+
+        [[nodiscard]] const std::string &name() const noexcept { return name_; }
+
+        ndarray<T> &array() noexcept { return array_; }
+
+        const ndarray<T> &array() const noexcept { return array_; }
+
+        // number of completed write() calls, from any process
+        [[nodiscard]] uint64_t version() const noexcept {
+            return control_()->sequence.load(std::memory_order_acquire) / 2;
+        }
+
+        // Calls fn(array()) with other write() calls excluded and read() calls retrying.
+        template<class Function>
+        void write(Function &&fn) {
+            if (!writable_)
+                throw std::runtime_error("shm_array<T>::write(): segment attached read-only");
+            auto &sequence = control_()->sequence;
+            uint64_t seq = sequence.load(std::memory_order_relaxed);
+            for (;;) {
+                if (seq & 1) {
+                    std::this_thread::yield();
+                    seq = sequence.load(std::memory_order_relaxed);
+                } else if (sequence.compare_exchange_weak(seq, seq + 1, std::memory_order_acquire,
+                                                          std::memory_order_relaxed)) {
+                    break;
+                }
+            }
+            std::atomic_thread_fence(std::memory_order_release);
+            try {
+                fn(array_);
+            } catch (...) {
+                sequence.store(seq + 2, std::memory_order_release);
+                throw;
+            }
+            sequence.store(seq + 2, std::memory_order_release);
+        }
+
+        // Returns fn(array()) from a call that no write overlapped, calling fn again as often as needed.
+        template<class Function>
+        auto read(Function &&fn) const {
+            const auto &sequence = control_()->sequence;
+            for (;;) {
+                uint64_t before = sequence.load(std::memory_order_acquire);
+                if (before & 1) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                if constexpr (std::is_void_v<std::invoke_result_t<Function &, const ndarray<T> &>>) {
+                    fn(std::as_const(array_));
+                    std::atomic_thread_fence(std::memory_order_acquire);
+                    if (sequence.load(std::memory_order_relaxed) == before)
+                        return;
+                } else {
+                    auto result = fn(std::as_const(array_));
+                    std::atomic_thread_fence(std::memory_order_acquire);
+                    if (sequence.load(std::memory_order_relaxed) == before)
+                        return result;
+                }
+            }
+        }
+
+    private:
+        shm_array(std::string name, std::shared_ptr<char[]> mapping, size_t offset, const std::vector<size_t> &shape) :
+                name_(std::move(name)), mapping_(std::move(mapping)),
+                array_(shape, std::shared_ptr<T[]>(mapping_, reinterpret_cast<T *>(mapping_.get() + offset))) {}
+
+        static std::shared_ptr<char[]> map_(int fd, size_t size, bool writable) {
+            void *ptr = ::mmap(nullptr, size, PROT_READ | (writable ? PROT_WRITE : 0), MAP_SHARED, fd, 0);
+            if (ptr == MAP_FAILED)
+                return nullptr;
+            return std::shared_ptr<char[]>(static_cast<char *>(ptr), [size](char *p) { ::munmap(p, size); });
+        }
+
+        shm_control_ *control_() const noexcept { return reinterpret_cast<shm_control_ *>(mapping_.get()); }
+
+        static constexpr uint64_t magic_ = 0x3130'4d48'5359'504e;    // "NPYSHM01" in little-endian order
+
+        std::string name_;
+        std::shared_ptr<char[]> mapping_;
+        ndarray<T> array_;
+        bool writable_ = true;
+    };
+
+}
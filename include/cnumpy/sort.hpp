@@ -0,0 +1,409 @@
+#pragma once
+
+#include <algorithm>    // min, min_element, nth_element, partial_sort, partition, sort, stable_sort
+#include <array>
+#include <cmath>        // floor, isnan
+#include <cstddef>      // ptrdiff_t, size_t
+#include <cstdint>      // uint8_t, uint16_t, uint32_t, uint64_t
+#include <cstring>      // memcpy
+#include <limits>       // quiet_NaN
+#include <numeric>      // iota
+#include <stdexcept>    // runtime_error
+#include <type_traits>  // conditional_t, is_floating_point_v, is_integral_v, is_same_v
+#include <utility>      // pair, swap
+#include <vector>
+#include "ndarray.hpp"
+#include "parallel.hpp"
+
+namespace cnumpy {
+
+    // ordering of numpy: NaN after everything else
+    template<class T>
+    struct sort_less_ {
+        bool operator()(const T &a, const T &b) const {
+            if constexpr (std::is_floating_point_v<T>)
+                return a < b || (b != b && a == a);
+            else
+                return a < b;
+        }
+    };
+
+    template<class T>
+    constexpr bool radix_sortable_ = std::is_integral_v<T> || std::is_same_v<T, float> || std::is_same_v<T, double>;
+
+    template<class T>
+    using radix_key_ = std::conditional_t<sizeof(T) == 1, uint8_t, std::conditional_t<sizeof(T) == 2, uint16_t,
+            std::conditional_t<sizeof(T) == 4, uint32_t, uint64_t>>>;
+
+    // maps values to unsigned keys of the same width that compare in the same order
+    template<class T>
+    radix_key_<T> to_radix_key_(T value) {
+        using K = radix_key_<T>;
+        constexpr K sign = K(1) << (sizeof(K) * 8 - 1);
+        K key;
+        std::memcpy(&key, &value, sizeof(T));
+        if constexpr (std::is_floating_point_v<T>) {
+            if (value != value)
+                key &= K(~sign);
+            return key & sign ? K(~key) : K(key | sign);
+        } else if constexpr (std::is_signed_v<T>) {
+            return K(key ^ sign);
+        } else {
+            return key;
+        }
+    }
+
+    template<class T>
+    T from_radix_key_(radix_key_<T> key) {
+        using K = radix_key_<T>;
+        constexpr K sign = K(1) << (sizeof(K) * 8 - 1);
+        if constexpr (std::is_floating_point_v<T>)
+            key = key & sign ? K(key & ~sign) : K(~key);
+        else if constexpr (std::is_signed_v<T>)
+            key = K(key ^ sign);
+        T value;
+        std::memcpy(&value, &key, sizeof(T));
+        return value;
+    }
+
+    // Stable LSD radix sort of keys, one byte per pass, carrying index along if it is not null. Every pass counts the
+    // digits of contiguous chunks in parallel and scatters each chunk to its own precomputed offsets; passes in which
+    // all keys share the same digit are skipped.
+    template<class K>
+    void radix_sort_(K *keys, size_t *index, size_t n) {
+        size_t nchunks = std::max(size_t(1), std::min(get_num_threads(), n / 65536));
+        std::vector<K> key_buffer(n);
+        std::vector<size_t> index_buffer(index ? n : 0);
+        std::vector<std::array<size_t, 256>> counts(nchunks);
+        K *src = keys, *dst = key_buffer.data();
+        size_t *isrc = index, *idst = index_buffer.data();
+        auto chunk = [&](size_t c) { return std::pair<size_t, size_t>(c * n / nchunks, (c + 1) * n / nchunks); };
+
+        for (size_t shift = 0; shift < sizeof(K) * 8; shift += 8) {
+            parallel_for(0, nchunks, 1, [&](size_t begin, size_t end) {
+                for (size_t c = begin; c < end; c++) {
+                    counts[c].fill(0);
+                    auto [first, last] = chunk(c);
+                    for (size_t i = first; i < last; i++)
+                        counts[c][(src[i] >> shift) & 0xff]++;
+                }
+            }, nchunks);
+
+            bool trivial = false;
+            size_t sum = 0;
+            for (size_t d = 0; d < 256; d++) {
+                size_t total = 0;
+                for (size_t c = 0; c < nchunks; c++) {
+                    size_t count = counts[c][d];
+                    counts[c][d] = sum + total;
+                    total += count;
+                }
+                trivial |= total == n;
+                sum += total;
+            }
+            if (trivial)
+                continue;
+
+            parallel_for(0, nchunks, 1, [&](size_t begin, size_t end) {
+                for (size_t c = begin; c < end; c++) {
+                    auto &offsets = counts[c];
+                    auto [first, last] = chunk(c);
+                    for (size_t i = first; i < last; i++) {
+                        size_t pos = offsets[(src[i] >> shift) & 0xff]++;
+                        dst[pos] = src[i];
+                        if (index)
+                            idst[pos] = isrc[i];
+                    }
+                }
+            }, nchunks);
+            std::swap(src, dst);
+            std::swap(isrc, idst);
+        }
+        if (src != keys) {
+            std::copy(src, src + n, keys);
+            if (index)
+                std::copy(isrc, isrc + n, index);
+        }
+    }
+
+    inline constexpr size_t network_max_ = 32;      // longest line sorted by a sorting network
+    inline constexpr size_t network_width_ = 64;    // lines sorted side by side
+    inline constexpr size_t radix_min_ = 1 << 15;   // shortest 1-D array sorted by parallel radix sort
+    inline constexpr size_t radix_row_min_ = 512;   // shortest line of many sorted by radix sort
+
+    // Comparators of Batcher's odd-even merge sort for n elements. Comparators reaching past n are dropped, which is
+    // the same as padding the input with infinitely large elements.
+    inline const std::vector<std::pair<uint8_t, uint8_t>> &sorting_network_(size_t n) {
+        static const auto networks = [] {
+            std::array<std::vector<std::pair<uint8_t, uint8_t>>, network_max_ + 1> networks;
+            for (size_t n = 2; n <= network_max_; n++) {
+                size_t size = 1;
+                while (size < n)
+                    size <<= 1;
+                for (size_t p = 1; p < size; p <<= 1)
+                    for (size_t k = p; k >= 1; k >>= 1)
+                        for (size_t j = k % p; j + k < size; j += 2 * k)
+                            for (size_t i = 0; i < std::min(k, size - j - k); i++)
+                                if ((i + j) / (2 * p) == (i + j + k) / (2 * p) && i + j + k < n)
+                                    networks[n].emplace_back(i + j, i + j + k);
+            }
+            return networks;
+        }();
+        return networks[n];
+    }
+
+    // Sorts the short lines [first, last) with a sorting network. Lines are transposed into a block so that every
+    // comparator is a vectorizable min/max over network_width_ lines. Blocks containing NaN fall back to std::sort.
+    template<class T>
+    void network_sort_(T *data, const axis_lines_ &lines, size_t first, size_t last) {
+        const auto &network = sorting_network_(lines.length);
+        size_t n = lines.length, stride = lines.stride;
+        constexpr size_t W = network_width_;
+        std::array<T, network_max_ * W> block;
+        for (size_t line = first; line < last; line += W) {
+            size_t w = std::min(W, last - line);
+            for (size_t r = 0; r < W; r++) {
+                size_t offset = lines.offset(line + (r < w ? r : 0));
+                for (size_t p = 0; p < n; p++)
+                    block[p * W + r] = data[offset + p * stride];
+            }
+
+            bool nan = false;
+            if constexpr (std::is_floating_point_v<T>)
+                for (size_t i = 0; i < n * W; i++)
+                    nan |= block[i] != block[i];
+            if (nan) {
+                std::array<T, network_max_> column;
+                for (size_t r = 0; r < w; r++) {
+                    for (size_t p = 0; p < n; p++)
+                        column[p] = block[p * W + r];
+                    std::sort(column.begin(), column.begin() + ptrdiff_t(n), sort_less_<T>());
+                    for (size_t p = 0; p < n; p++)
+                        block[p * W + r] = column[p];
+                }
+            } else {
+                for (auto [i, j] : network) {
+                    T *x = block.data() + i * W, *y = block.data() + j * W;
+                    for (size_t r = 0; r < W; r++) {
+                        T lo = y[r] < x[r] ? y[r] : x[r];
+                        T hi = y[r] < x[r] ? x[r] : y[r];
+                        x[r] = lo;
+                        y[r] = hi;
+                    }
+                }
+            }
+
+            for (size_t r = 0; r < w; r++) {
+                size_t offset = lines.offset(line + r);
+                for (size_t p = 0; p < n; p++)
+                    data[offset + p * stride] = block[p * W + r];
+            }
+        }
+    }
+
+    // Calls fn(line, pointer to the contiguous elements) for every line, in parallel over lines. Lines that are not
+    // contiguous are gathered into a per-thread buffer before and, if write_back, scattered back after the call.
+    template<class T, class Function>
+    void for_each_line_(T *data, const axis_lines_ &lines, bool write_back, Function &&fn) {
+        size_t grain = std::max(size_t(1), size_t(4096) / std::max(lines.length, size_t(1)));
+        parallel_for(0, lines.count, grain, [&](size_t begin, size_t end) {
+            std::vector<T> buffer(lines.stride == 1 ? 0 : lines.length);
+            for (size_t line = begin; line < end; line++) {
+                T *first = data + lines.offset(line);
+                if (lines.stride == 1) {
+                    fn(line, first);
+                    continue;
+                }
+                for (size_t i = 0; i < lines.length; i++)
+                    buffer[i] = first[i * lines.stride];
+                fn(line, buffer.data());
+                if (write_back)
+                    for (size_t i = 0; i < lines.length; i++)
+                        first[i * lines.stride] = buffer[i];
+            }
+        });
+    }
+
+    template<class T>
+    void sort_lines_(T *data, const axis_lines_ &lines) {
+        if (lines.length <= 1)
+            return;
+        if constexpr (radix_sortable_<T>) {
+            if (lines.count == 1 && lines.length >= radix_min_) {
+                std::vector<radix_key_<T>> keys(lines.length);
+                for (size_t i = 0; i < lines.length; i++)
+                    keys[i] = to_radix_key_(data[i]);
+                radix_sort_(keys.data(), nullptr, lines.length);
+                for (size_t i = 0; i < lines.length; i++)
+                    data[i] = from_radix_key_<T>(keys[i]);
+                return;
+            }
+        }
+        if constexpr (std::is_arithmetic_v<T>) {
+            if (lines.length <= network_max_) {
+                parallel_for(0, lines.count, network_width_, [&](size_t begin, size_t end) {
+                    network_sort_(data, lines, begin, end);
+                });
+                return;
+            }
+        }
+        if constexpr (radix_sortable_<T>) {
+            if (lines.length >= radix_row_min_) {
+                for_each_line_(data, lines, true, [&](size_t, T *first) {
+                    std::vector<radix_key_<T>> keys(lines.length);
+                    for (size_t i = 0; i < lines.length; i++)
+                        keys[i] = to_radix_key_(first[i]);
+                    radix_sort_(keys.data(), nullptr, lines.length);
+                    for (size_t i = 0; i < lines.length; i++)
+                        first[i] = from_radix_key_<T>(keys[i]);
+                });
+                return;
+            }
+        }
+        for_each_line_(data, lines, true, [&](size_t, T *first) {
+            T *last = first + lines.length;
+            if constexpr (std::is_floating_point_v<T>)
+                last = std::partition(first, last, [](const T &value) { return value == value; });
+            std::sort(first, last);
+        });
+    }
+
+    // Sorted copy of arr along axis. NaNs are sorted to the end.
+    template<class T, class Container>
+    ndarray_impl<T, Container> sort(const ndarray_impl<T, Container> &arr, ptrdiff_t axis = -1) {
+        ndarray_impl<T, Container> out(arr);
+        sort_lines_(out.data(), axis_lines_of_(out.shape(), axis, "sort"));
+        return out;
+    }
+
+    // Indices that sort arr along axis; equal elements keep their order.
+    template<class T, class Container>
+    ndarray_impl<size_t, Container> argsort(const ndarray_impl<T, Container> &arr, ptrdiff_t axis = -1) {
+        auto lines = axis_lines_of_(arr.shape(), axis, "argsort");
+        ndarray_impl<size_t, Container> out(arr.shape());
+        const T *data = arr.data();
+        if constexpr (radix_sortable_<T>) {
+            if (lines.count == 1 && lines.length >= radix_min_) {
+                std::vector<radix_key_<T>> keys(lines.length);
+                for (size_t i = 0; i < lines.length; i++)
+                    keys[i] = to_radix_key_(data[i]);
+                std::iota(out.data(), out.data() + lines.length, size_t(0));
+                radix_sort_(keys.data(), out.data(), lines.length);
+                return out;
+            }
+        }
+        for_each_line_(out.data(), lines, true, [&](size_t line, size_t *index) {
+            const T *first = data + lines.offset(line);
+            std::iota(index, index + lines.length, size_t(0));
+            std::stable_sort(index, index + lines.length, [&](size_t i, size_t j) {
+                return sort_less_<T>()(first[i * lines.stride], first[j * lines.stride]);
+            });
+        });
+        return out;
+    }
+
+    // Copy of arr in which the kth element of every line along axis is the one a sort would put there, with no
+    // larger element before and no smaller element after it.
+    template<class T, class Container>
+    ndarray_impl<T, Container> partition(const ndarray_impl<T, Container> &arr, size_t kth, ptrdiff_t axis = -1) {
+        auto lines = axis_lines_of_(arr.shape(), axis, "partition");
+        if (kth >= lines.length)
+            throw std::runtime_error("partition(): kth out of range");
+        ndarray_impl<T, Container> out(arr);
+        for_each_line_(out.data(), lines, true, [&](size_t, T *first) {
+            std::nth_element(first, first + kth, first + lines.length, sort_less_<T>());
+        });
+        return out;
+    }
+
+    // The k largest (or smallest) elements of every line along axis in order, and their indices. Ties are broken by
+    // the lower index.
+    template<class T, class Container>
+    std::pair<ndarray_impl<T, Container>, ndarray_impl<size_t, Container>>
+    top_k(const ndarray_impl<T, Container> &arr, size_t k, ptrdiff_t axis = -1, bool largest = true) {
+        auto lines = axis_lines_of_(arr.shape(), axis, "top_k");
+        if (k > lines.length)
+            throw std::runtime_error("top_k(): k out of range");
+        Container shape = arr.shape();
+        shape[normalize_axis_(axis, shape.size(), "top_k")] = k;
+        ndarray_impl<T, Container> values(shape);
+        ndarray_impl<size_t, Container> indices(shape);
+        axis_lines_ out_lines{lines.count, k, lines.stride};
+
+        const T *data = arr.data();
+        size_t grain = std::max(size_t(1), size_t(4096) / std::max(lines.length, size_t(1)));
+        parallel_for(0, lines.count, grain, [&](size_t begin, size_t end) {
+            std::vector<size_t> index(lines.length);
+            for (size_t line = begin; line < end; line++) {
+                const T *first = data + lines.offset(line);
+                std::iota(index.begin(), index.end(), size_t(0));
+                std::partial_sort(index.begin(), index.begin() + ptrdiff_t(k), index.end(), [&](size_t i, size_t j) {
+                    const T &a = first[i * lines.stride], &b = first[j * lines.stride];
+                    sort_less_<T> less;
+                    if (largest ? less(b, a) : less(a, b))
+                        return true;
+                    return !(largest ? less(a, b) : less(b, a)) && i < j;
+                });
+                size_t offset = out_lines.offset(line);
+                for (size_t i = 0; i < k; i++) {
+                    values.data()[offset + i * lines.stride] = first[index[i] * lines.stride];
+                    indices.data()[offset + i * lines.stride] = index[i];
+                }
+            }
+        });
+        return {std::move(values), std::move(indices)};
+    }
+
+    template<class Container>
+    struct reduced_container_ {
+        using type = std::vector<size_t>;
+    };
+
+    template<size_t N>
+    struct reduced_container_<std::array<size_t, N>> {
+        using type = std::array<size_t, N ? N - 1 : 0>;
+    };
+
+    // The qth percentile (0 <= q <= 100) of every line along axis, interpolated linearly between the closest ranks
+    // like numpy.percentile. Lines containing NaN, or no elements, give NaN.
+    template<class T, class Container>
+    ndarray_impl<double, typename reduced_container_<Container>::type>
+    percentile(const ndarray_impl<T, Container> &arr, double q, ptrdiff_t axis = -1) {
+        auto lines = axis_lines_of_(arr.shape(), axis, "percentile");
+        if (!(q >= 0 && q <= 100))
+            throw std::runtime_error("percentile(): q out of range");
+        using container_type = typename reduced_container_<Container>::type;
+        container_type shape{};
+        if constexpr (std::is_same<container_type, std::vector<size_t>>())
+            shape.resize(arr.ndim() - 1);
+        size_t a = normalize_axis_(axis, arr.ndim(), "percentile");
+        for (size_t d = 0, r = 0; d < arr.ndim(); d++)
+            if (d != a)
+                shape[r++] = arr.shape()[d];
+        ndarray_impl<double, container_type> out(shape);
+
+        size_t n = lines.length;
+        double pos = q / 100 * (double(n) - 1);
+        size_t lo = n ? size_t(std::floor(pos)) : 0;
+        double frac = pos - double(lo);
+        ndarray_impl<T, Container> copy(arr);
+        for_each_line_(copy.data(), lines, false, [&](size_t line, T *first) {
+            double &result = out.data()[line];
+            result = std::numeric_limits<double>::quiet_NaN();
+            if (n == 0)
+                return;
+            if constexpr (std::is_floating_point_v<T>)
+                for (size_t i = 0; i < n; i++)
+                    if (first[i] != first[i])
+                        return;
+            std::nth_element(first, first + lo, first + n, sort_less_<T>());
+            result = double(first[lo]);
+            if (lo + 1 < n && frac > 0) {
+                double hi = double(*std::min_element(first + lo + 1, first + n, sort_less_<T>()));
+                result += (hi - result) * frac;
+            }
+        });
+        return out;
+    }
+
+}
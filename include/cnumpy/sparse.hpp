@@ -0,0 +1,440 @@
+#pragma once
+
+#include <algorithm>    // copy, fill, is_sorted, max, min, stable_sort
+#include <array>
+#include <cstddef>      // size_t
+#include <cstdint>      // int32_t, int64_t
+#include <stdexcept>    // runtime_error
+#include <string>
+#include <tuple>        // tie
+#include <type_traits>  // is_integral, is_same
+#include <utility>      // in_range, move, pair
+#include <vector>
+#include "ndarray.hpp"
+#include "npy.hpp"
+#include "npz.hpp"
+#include "parallel.hpp"
+
+namespace cnumpy {
+
+    enum class sparse_format { csr, coo };
+
+    // nonzeros (plus rows) per task of the parallel kernels
+    inline constexpr size_t sparse_grain_ = size_t(1) << 14;
+
+    // Splits the rows [0, rows) into chunks with about the same number of nonzeros plus rows, given the row offsets
+    // indptr[0, rows]. Returns the chunk boundaries.
+    template<class Offset>
+    std::vector<size_t> sparse_chunks_(const Offset *indptr, size_t rows) {
+        size_t work = size_t(indptr[rows]) + rows;
+        size_t chunks = std::max(size_t(1), std::min(rows, work / sparse_grain_));
+        std::vector<size_t> bounds(chunks + 1, rows);
+        bounds[0] = 0;
+        for (size_t c = 1; c < chunks; c++) {
+            size_t target = c * work / chunks, lo = bounds[c - 1], hi = rows;
+            while (lo < hi) {
+                size_t mid = lo + (hi - lo) / 2;
+                if (size_t(indptr[mid]) + mid < target)
+                    lo = mid + 1;
+                else
+                    hi = mid;
+            }
+            bounds[c] = lo;
+        }
+        return bounds;
+    }
+
+    // Runs fn(first_row, last_row) over chunks of rows of about equal work, in parallel.
+    template<class Offset, class Function>
+    void sparse_for_rows_(const Offset *indptr, size_t rows, Function &&fn) {
+        std::vector<size_t> bounds = sparse_chunks_(indptr, rows);
+        parallel_for(0, bounds.size() - 1, 1, [&](size_t begin, size_t end) {
+            for (size_t c = begin; c < end; c++)
+                fn(bounds[c], bounds[c + 1]);
+        });
+    }
+
+    // Two-dimensional sparse matrix holding the same arrays as scipy.sparse. In CSR format, row i has the nonzeros
+    // data[indptr[i], indptr[i + 1]) in the columns indices[indptr[i], indptr[i + 1]). In COO format, nonzero k is
+    // data[k] at (row[k], col[k]), and duplicates add up. CSR is the format of the kernels; COO is convenient to
+    // assemble a matrix from triplets.
+    template<class T, class Index = int32_t>
+    class sparse_matrix {
+        static_assert(std::is_integral<Index>());
+
+    public:
+        using value_type = T;
+        using index_type = Index;
+
+        // all-zero matrix in CSR format
+        sparse_matrix(size_t rows, size_t cols) : format_(sparse_format::csr), rows_(rows), cols_(cols),
+                                                  indptr_(rows + 1) {
+            std::fill(indptr_.data(), indptr_.data() + indptr_.size(), Index(0));
+        }
+
+        static sparse_matrix csr(size_t rows, size_t cols, ndarray<T, 1> data, ndarray<Index, 1> indices,
+                                 ndarray<Index, 1> indptr) {
+            size_t nnz = data.size();
+            if (indices.size() != nnz || indptr.size() != rows + 1)
+                throw std::runtime_error("sparse_matrix<T, Index>::csr(): sizes do not match");
+            const Index *ptr = indptr.data();
+            if (ptr[0] != 0 || size_t(ptr[rows]) != nnz)
+                throw std::runtime_error("sparse_matrix<T, Index>::csr(): invalid indptr");
+            for (size_t i = 0; i < rows; i++)
+                if (ptr[i + 1] < ptr[i])
+                    throw std::runtime_error("sparse_matrix<T, Index>::csr(): invalid indptr");
+            check_indices_(indices, cols, "csr");
+
+            sparse_matrix m(sparse_format::csr, rows, cols);
+            m.data_ = std::move(data);
+            m.indices_ = std::move(indices);
+            m.indptr_ = std::move(indptr);
+            return m;
+        }
+
+        static sparse_matrix coo(size_t rows, size_t cols, ndarray<T, 1> data, ndarray<Index, 1> row,
+                                 ndarray<Index, 1> col) {
+            if (row.size() != data.size() || col.size() != data.size())
+                throw std::runtime_error("sparse_matrix<T, Index>::coo(): sizes do not match");
+            check_indices_(row, rows, "coo");
+            check_indices_(col, cols, "coo");
+
+            sparse_matrix m(sparse_format::coo, rows, cols);
+            m.data_ = std::move(data);
+            m.row_ = std::move(row);
+            m.indices_ = std::move(col);
+            return m;
+        }
+
+        // the nonzeros of a two-dimensional array, row by row
+        template<class Container>
+        static sparse_matrix from_dense(const ndarray_impl<T, Container> &arr,
+                                        sparse_format format = sparse_format::csr) {
+            if (arr.ndim() != 2)
+                throw std::runtime_error("sparse_matrix<T, Index>::from_dense(): array must be two-dimensional");
+            size_t rows = arr.shape()[0], cols = arr.shape()[1];
+            if (!std::in_range<Index>(cols))
+                throw std::runtime_error("sparse_matrix<T, Index>::from_dense(): too many columns for Index");
+            size_t grain = std::max(size_t(1), sparse_grain_ / std::max(cols, size_t(1)));
+
+            std::vector<size_t> offsets(rows + 1, 0);
+            parallel_for(0, rows, grain, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; i++) {
+                    const T *src = arr.data() + i * cols;
+                    size_t count = 0;
+                    for (size_t j = 0; j < cols; j++)
+                        count += src[j] != T(0);
+                    offsets[i + 1] = count;
+                }
+            });
+            for (size_t i = 0; i < rows; i++)
+                offsets[i + 1] += offsets[i];
+            if (!std::in_range<Index>(offsets[rows]))
+                throw std::runtime_error("sparse_matrix<T, Index>::from_dense(): too many nonzeros for Index");
+
+            sparse_matrix m(sparse_format::csr, rows, cols);
+            m.data_ = ndarray<T, 1>(offsets[rows]);
+            m.indices_ = ndarray<Index, 1>(offsets[rows]);
+            m.indptr_ = ndarray<Index, 1>(rows + 1);
+            parallel_for(0, rows + 1, grain, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; i++) {
+                    m.indptr_.data()[i] = Index(offsets[i]);
+                    if (i == rows)
+                        continue;
+                    const T *src = arr.data() + i * cols;
+                    size_t p = offsets[i];
+                    for (size_t j = 0; j < cols; j++) {
+                        if (src[j] != T(0)) {
+                            m.data_.data()[p] = src[j];
+                            m.indices_.data()[p++] = Index(j);
+                        }
+                    }
+                }
+            });
+            if (format == sparse_format::coo)
+                return m.to_coo();
+            return m;
+        }
+
+        [[nodiscard]] sparse_format format() const noexcept { return format_; }
+
+        [[nodiscard]] size_t rows() const noexcept { return rows_; }
+
+        [[nodiscard]] size_t cols() const noexcept { return cols_; }
+
+        // number of stored values, including explicit zeros and COO duplicates
+        [[nodiscard]] size_t nnz() const noexcept { return data_.size(); }
+
+        // The values may be changed in place; the structure is fixed.
+        ndarray<T, 1> &data() noexcept { return data_; }
+
+        const ndarray<T, 1> &data() const noexcept { return data_; }
+
+        // CSR only
+        const ndarray<Index, 1> &indices() const noexcept { return indices_; }
+
+        const ndarray<Index, 1> &indptr() const noexcept { return indptr_; }
+
+        // COO only
+        const ndarray<Index, 1> &row() const noexcept { return row_; }
+
+        const ndarray<Index, 1> &col() const noexcept { return indices_; }
+
+        // Same matrix in CSR format, with sorted column indices and duplicates summed, like scipy's tocsr().
+        [[nodiscard]] sparse_matrix to_csr() const {
+            if (format_ == sparse_format::csr)
+                return *this;
+            size_t nnz = data_.size();
+            const Index *row = row_.data(), *col = indices_.data();
+
+            // bucket the entries by row, keeping their order, then sort every row and sum its duplicates
+            std::vector<size_t> offsets(rows_ + 1, 0);
+            for (size_t k = 0; k < nnz; k++)
+                offsets[size_t(row[k]) + 1]++;
+            for (size_t i = 0; i < rows_; i++)
+                offsets[i + 1] += offsets[i];
+            ndarray<Index, 1> indices(nnz);
+            ndarray<T, 1> data(nnz);
+            std::vector<size_t> next(offsets.begin(), offsets.end() - 1);
+            for (size_t k = 0; k < nnz; k++) {
+                size_t p = next[size_t(row[k])]++;
+                indices.data()[p] = col[k];
+                data.data()[p] = data_.data()[k];
+            }
+
+            std::vector<size_t> kept(rows_ + 1, 0);
+            sparse_for_rows_(offsets.data(), rows_, [&](size_t first, size_t last) {
+                std::vector<std::pair<Index, T>> entries;
+                for (size_t i = first; i < last; i++) {
+                    Index *cols = indices.data();
+                    T *values = data.data();
+                    size_t begin = offsets[i], end = offsets[i + 1];
+                    if (!std::is_sorted(cols + begin, cols + end)) {
+                        entries.clear();
+                        for (size_t p = begin; p < end; p++)
+                            entries.emplace_back(cols[p], values[p]);
+                        std::stable_sort(entries.begin(), entries.end(), [](const auto &a, const auto &b) {
+                            return a.first < b.first;
+                        });
+                        for (size_t p = begin; p < end; p++)
+                            std::tie(cols[p], values[p]) = entries[p - begin];
+                    }
+                    size_t w = begin;
+                    for (size_t p = begin; p < end; p++) {
+                        if (w > begin && cols[w - 1] == cols[p]) {
+                            values[w - 1] += values[p];
+                        } else {
+                            cols[w] = cols[p];
+                            values[w++] = values[p];
+                        }
+                    }
+                    kept[i + 1] = w - begin;
+                }
+            });
+            for (size_t i = 0; i < rows_; i++)
+                kept[i + 1] += kept[i];
+
+            sparse_matrix m(sparse_format::csr, rows_, cols_);
+            m.indptr_ = ndarray<Index, 1>(rows_ + 1);
+            for (size_t i = 0; i <= rows_; i++)
+                m.indptr_.data()[i] = Index(kept[i]);
+            if (kept[rows_] == nnz) {
+                m.data_ = std::move(data);
+                m.indices_ = std::move(indices);
+                return m;
+            }
+            m.data_ = ndarray<T, 1>(kept[rows_]);
+            m.indices_ = ndarray<Index, 1>(kept[rows_]);
+            sparse_for_rows_(kept.data(), rows_, [&](size_t first, size_t last) {
+                for (size_t i = first; i < last; i++) {
+                    std::copy(indices.data() + offsets[i], indices.data() + offsets[i] + (kept[i + 1] - kept[i]),
+                              m.indices_.data() + kept[i]);
+                    std::copy(data.data() + offsets[i], data.data() + offsets[i] + (kept[i + 1] - kept[i]),
+                              m.data_.data() + kept[i]);
+                }
+            });
+            return m;
+        }
+
+        // Same matrix in COO format, in row-major order.
+        [[nodiscard]] sparse_matrix to_coo() const {
+            if (format_ == sparse_format::coo)
+                return *this;
+            sparse_matrix m(sparse_format::coo, rows_, cols_);
+            m.data_ = data_;
+            m.indices_ = indices_;
+            m.row_ = ndarray<Index, 1>(data_.size());
+            sparse_for_rows_(indptr_.data(), rows_, [&](size_t first, size_t last) {
+                for (size_t i = first; i < last; i++)
+                    std::fill(m.row_.data() + size_t(indptr_.data()[i]), m.row_.data() + size_t(indptr_.data()[i + 1]),
+                              Index(i));
+            });
+            return m;
+        }
+
+        [[nodiscard]] ndarray<T, 2> to_dense() const {
+            ndarray<T, 2> out(rows_, cols_);
+            if (format_ == sparse_format::coo) {
+                std::fill(out.data(), out.data() + out.size(), T(0));
+                for (size_t k = 0; k < data_.size(); k++)
+                    out.data()[size_t(row_.data()[k]) * cols_ + size_t(indices_.data()[k])] += data_.data()[k];
+                return out;
+            }
+            sparse_for_rows_(indptr_.data(), rows_, [&](size_t first, size_t last) {
+                std::fill(out.data() + first * cols_, out.data() + last * cols_, T(0));
+                for (size_t i = first; i < last; i++)
+                    for (auto p = size_t(indptr_.data()[i]); p < size_t(indptr_.data()[i + 1]); p++)
+                        out.data()[i * cols_ + size_t(indices_.data()[p])] += data_.data()[p];
+            });
+            return out;
+        }
+
+    private:
+        sparse_matrix(sparse_format format, size_t rows, size_t cols) : format_(format), rows_(rows), cols_(cols) {}
+
+        static void check_indices_(const ndarray<Index, 1> &indices, size_t bound, const char *name) {
+            for (size_t k = 0; k < indices.size(); k++)
+                if (!std::in_range<size_t>(indices.data()[k]) || size_t(indices.data()[k]) >= bound)
+                    throw std::runtime_error(std::string("sparse_matrix<T, Index>::") + name +
+                                             "(): index out of range");
+        }
+
+        sparse_format format_;
+        size_t rows_, cols_;
+        ndarray<T, 1> data_;
+        ndarray<Index, 1> indices_, indptr_, row_;
+    };
+
+    // Product of the sparse matrix a with the vector or matrix x, like scipy's a @ x. Rows of a CSR matrix are
+    // spread over threads in chunks of about equal numbers of nonzeros; for a matrix x the inner loop runs along the
+    // rows of x, so that it vectorizes. COO products run on a single thread; convert repeated operands to CSR.
+    template<class T, class Index, class Container>
+    ndarray_impl<T, Container> dot(const sparse_matrix<T, Index> &a, const ndarray_impl<T, Container> &x) {
+        if (x.ndim() != 1 && x.ndim() != 2)
+            throw std::runtime_error("dot(): operand must be one- or two-dimensional");
+        if (x.shape()[0] != a.cols())
+            throw std::runtime_error("dot(): shapes do not match");
+        Container shape = x.shape();
+        shape[0] = a.rows();
+        ndarray_impl<T, Container> y(shape);
+        size_t k = x.ndim() == 2 ? x.shape()[1] : 1;
+        const T *data = a.data().data(), *src = x.data();
+        const Index *indices = a.indices().data();
+        T *dst = y.data();
+
+        if (a.format() == sparse_format::coo) {
+            std::fill(dst, dst + y.size(), T(0));
+            const Index *row = a.row().data(), *col = a.col().data();
+            for (size_t p = 0; p < a.nnz(); p++)
+                for (size_t j = 0; j < k; j++)
+                    dst[size_t(row[p]) * k + j] += data[p] * src[size_t(col[p]) * k + j];
+            return y;
+        }
+
+        const Index *indptr = a.indptr().data();
+        sparse_for_rows_(indptr, a.rows(), [&](size_t first, size_t last) {
+            for (size_t i = first; i < last; i++) {
+                auto begin = size_t(indptr[i]), end = size_t(indptr[i + 1]);
+                if (k == 1) {
+                    T sum = T(0);
+                    for (size_t p = begin; p < end; p++)
+                        sum += data[p] * src[size_t(indices[p])];
+                    dst[i] = sum;
+                    continue;
+                }
+                T *out = dst + i * k;
+                std::fill(out, out + k, T(0));
+                for (size_t p = begin; p < end; p++) {
+                    T value = data[p];
+                    const T *in = src + size_t(indices[p]) * k;
+                    for (size_t j = 0; j < k; j++)
+                        out[j] += value * in[j];
+                }
+            }
+        });
+        return y;
+    }
+
+    // Writes m in the layout of scipy.sparse.save_npz(filename, m, compressed=False), so that
+    // scipy.sparse.load_npz() reads it back.
+    template<class T, class Index>
+    void save_npz(const std::string &filename, const sparse_matrix<T, Index> &m) {
+        NPZ npz(filename, 'w');
+        if (m.format() == sparse_format::csr) {
+            npz.save("indices", m.indices());
+            npz.save("indptr", m.indptr());
+            npz.save("format", "csr");
+        } else {
+            npz.save("row", m.row());
+            npz.save("col", m.col());
+            npz.save("format", "coo");
+        }
+        ndarray<int64_t, 1> shape(2);
+        shape(0) = int64_t(m.rows());
+        shape(1) = int64_t(m.cols());
+        npz.save("shape", shape);
+        npz.save("data", m.data());
+        npz.close();
+    }
+
+    // Loads a member holding 32- or 64-bit integers as Index, checking that the values fit.
+    template<class Index>
+    ndarray<Index> sparse_load_indices_(NPZ &npz, const std::string &name) {
+        auto [buffer, size] = npz.read(name);
+        std::string descr = NPY::inspect(buffer, size).descr;
+        auto convert = [&]<class I>(I) {
+            ndarray<I> arr = NPY(buffer, size, 'r').load<I>();
+            if constexpr (std::is_same<I, Index>()) {
+                return arr;
+            } else {
+                ndarray<Index> out(arr.shape());
+                for (size_t i = 0; i < arr.size(); i++) {
+                    if (!std::in_range<Index>(arr.data()[i]))
+                        throw std::runtime_error("load_npz(): " + name + " does not fit the index type");
+                    out.data()[i] = Index(arr.data()[i]);
+                }
+                return out;
+            }
+        };
+        if (descr.length() == 3 && descr[1] == 'i' && descr[2] == '4')
+            return convert(int32_t());
+        if (descr.length() == 3 && descr[1] == 'i' && descr[2] == '8')
+            return convert(int64_t());
+        throw std::runtime_error("load_npz(): unsupported data type of " + name);
+    }
+
+    // Reads a CSR or COO matrix written by scipy.sparse.save_npz() or save_npz(), either compressed or not.
+    template<class T, class Index = int32_t>
+    sparse_matrix<T, Index> load_npz(const std::string &filename) {
+        NPZ npz(filename, 'r');
+        std::string format = npz.load_string("format");
+        ndarray<int64_t> shape = sparse_load_indices_<int64_t>(npz, "shape");
+        if (shape.size() != 2 || shape.data()[0] < 0 || shape.data()[1] < 0)
+            throw std::runtime_error("load_npz(): invalid shape");
+        auto rows = size_t(shape.data()[0]), cols = size_t(shape.data()[1]);
+        auto flat = [](auto arr) {
+            return arr.make_shared(std::array<size_t, 1>{arr.size()});
+        };
+        ndarray<T> data = npz.load<T>("data");
+
+        if (format == "csr")
+            return sparse_matrix<T, Index>::csr(rows, cols, flat(data),
+                                                flat(sparse_load_indices_<Index>(npz, "indices")),
+                                                flat(sparse_load_indices_<Index>(npz, "indptr")));
+        if (format != "coo")
+            throw std::runtime_error("load_npz(): unsupported format " + format);
+        if (!npz.contains("coords"))
+            return sparse_matrix<T, Index>::coo(rows, cols, flat(data), flat(sparse_load_indices_<Index>(npz, "row")),
+                                                flat(sparse_load_indices_<Index>(npz, "col")));
+        // newer scipy versions store the coordinates as one (2, nnz) array
+        ndarray<Index> coords = sparse_load_indices_<Index>(npz, "coords");
+        if (coords.ndim() != 2 || coords.shape()[0] != 2)
+            throw std::runtime_error("load_npz(): invalid coords");
+        size_t nnz = coords.shape()[1];
+        ndarray<Index, 1> row(nnz), col(nnz);
+        std::copy(coords.data(), coords.data() + nnz, row.data());
+        std::copy(coords.data() + nnz, coords.data() + 2 * nnz, col.data());
+        return sparse_matrix<T, Index>::coo(rows, cols, flat(data), std::move(row), std::move(col));
+    }
+
+}
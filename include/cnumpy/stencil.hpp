@@ -0,0 +1,278 @@
+#pragma once
+
+#include <algorithm>    // clamp, copy, equal, fill, max, min
+#include <cstddef>      // ptrdiff_t, size_t
+#include <cstdlib>      // abs
+#include <stdexcept>    // runtime_error
+#include <string>
+#include <vector>
+#include "ndarray.hpp"
+#include "parallel.hpp"
+
+namespace cnumpy {
+
+    // How values outside the array are defined, following scipy.ndimage: constant pads with a value, wrap repeats the
+    // array periodically and reflect mirrors it about its edges, repeating the edge elements (d c b a | a b c d).
+    enum class boundary {
+        constant, wrap, reflect
+    };
+
+    // A set of neighbour offsets with a weight each. Applied to an array, a stencil computes at every element the
+    // weighted sum of the elements at the offsets from it.
+    template<class T>
+    class stencil {
+    public:
+        explicit stencil(size_t ndim) : ndim_(ndim) {
+            if (ndim == 0)
+                throw std::runtime_error("stencil<T>::stencil(): need at least one dimension");
+        }
+
+        // Every nonzero element of weights, with the offset of its index from the centre shape / 2, like the weights
+        // of scipy.ndimage.correlate. Flip the weights for a convolution.
+        template<class Container>
+        explicit stencil(const ndarray_impl<T, Container> &weights) : stencil(weights.ndim()) {
+            std::vector<ptrdiff_t> offset(ndim_);
+            for (size_t i = 0; i < weights.size(); i++) {
+                if (weights.data()[i] == T(0))
+                    continue;
+                for (size_t d = ndim_, rest = i; d-- > 0; rest /= weights.shape()[d])
+                    offset[d] = ptrdiff_t(rest % weights.shape()[d]) - ptrdiff_t(weights.shape()[d] / 2);
+                add(offset, weights.data()[i]);
+            }
+        }
+
+        // adds weight to the neighbour at offset
+        stencil &add(const std::vector<ptrdiff_t> &offset, T weight = T(1)) {
+            if (offset.size() != ndim_)
+                throw std::runtime_error("stencil<T>::add(): offset does not match the number of dimensions");
+            for (size_t k = 0; k < weights_.size(); k++) {
+                if (std::equal(offset.begin(), offset.end(), offsets_.begin() + ptrdiff_t(k * ndim_))) {
+                    weights_[k] += weight;
+                    return *this;
+                }
+            }
+            offsets_.insert(offsets_.end(), offset.begin(), offset.end());
+            weights_.push_back(weight);
+            return *this;
+        }
+
+        [[nodiscard]] size_t ndim() const noexcept { return ndim_; }
+
+        // number of neighbours
+        [[nodiscard]] size_t size() const noexcept { return weights_.size(); }
+
+        [[nodiscard]] const ptrdiff_t *offset(size_t k) const { return offsets_.data() + k * ndim_; }
+
+        [[nodiscard]] const std::vector<T> &weights() const noexcept { return weights_; }
+
+        // largest distance of a neighbour along each axis
+        [[nodiscard]] std::vector<size_t> radius() const {
+            std::vector<size_t> radius(ndim_, 0);
+            for (size_t k = 0; k < size(); k++)
+                for (size_t d = 0; d < ndim_; d++)
+                    radius[d] = std::max(radius[d], size_t(std::abs(offset(k)[d])));
+            return radius;
+        }
+
+    private:
+        size_t ndim_;
+        std::vector<ptrdiff_t> offsets_;
+        std::vector<T> weights_;
+    };
+
+    inline constexpr size_t stencil_tile_x_ = 512;   // longest run of elements along the last axis per kernel call
+
+    // Calls kernel(sources, out, width) for runs of up to tile_x consecutive elements along the last axis, where
+    // out points to the run in the result and sources[k] to the values of the kth neighbour of every element of the
+    // run. Away from the edges sources point straight into arr, at offsets precomputed from the strides; runs within
+    // the stencil radius of an edge gather the neighbours into a scratch buffer according to mode instead, so there is
+    // no padded copy of the array. Runs are grouped into tiles of tile_y rows, which sweep through the leading axes
+    // so that the neighbouring rows stay in cache; the tiles are spread over threads.
+    template<class T, class Container, class Kernel>
+    ndarray_impl<T, Container> stencil_apply_(const ndarray_impl<T, Container> &arr, const stencil<T> &st,
+                                              boundary mode, T cval, Kernel &&kernel, const char *name) {
+        constexpr size_t tile_x = stencil_tile_x_, tile_y = 16;
+        size_t ndim = arr.ndim(), size = st.size();
+        if (st.ndim() != ndim)
+            throw std::runtime_error(std::string(name) + "(): stencil does not match the number of dimensions");
+        ndarray_impl<T, Container> out(arr.shape());
+        if (out.size() == 0)
+            return out;
+
+        // source index of every index within the radius around each axis, -1 for the constant
+        std::vector<size_t> radius = st.radius();
+        std::vector<std::vector<ptrdiff_t>> maps(ndim);
+        for (size_t d = 0; d < ndim; d++) {
+            auto n = ptrdiff_t(arr.shape()[d]), r = ptrdiff_t(radius[d]);
+            for (ptrdiff_t i = -r; i < n + r; i++) {
+                ptrdiff_t j = i;
+                if (i < 0 || i >= n) {
+                    if (mode == boundary::constant) {
+                        j = -1;
+                    } else if (mode == boundary::wrap) {
+                        j = (i % n + n) % n;
+                    } else {
+                        j = (i % (2 * n) + 2 * n) % (2 * n);
+                        j = j < n ? j : 2 * n - 1 - j;
+                    }
+                }
+                maps[d].push_back(j);
+            }
+        }
+        std::vector<ptrdiff_t> offsets(size, 0);
+        for (size_t k = 0; k < size; k++)
+            for (size_t d = 0; d < ndim; d++)
+                offsets[k] += st.offset(k)[d] * ptrdiff_t(arr.strides()[d]);
+
+        // the array as (outer, y, x), with x the contiguous axis
+        size_t nx = arr.shape()[ndim - 1], ny = ndim > 1 ? arr.shape()[ndim - 2] : 1;
+        size_t nouter = out.size() / (nx * ny), rx = radius[ndim - 1];
+        size_t inner_first = std::min(rx, nx), inner_last = nx > rx ? std::max(nx - rx, inner_first) : inner_first;
+
+        size_t tiles_x = (nx + tile_x - 1) / tile_x, tiles_y = (ny + tile_y - 1) / tile_y;
+        size_t tiles = tiles_x * tiles_y;
+        size_t outer_chunks = std::min(nouter, std::max(size_t(1), 4 * get_num_threads() / tiles));
+        std::vector<ptrdiff_t> shifts(size);
+        for (size_t k = 0; k < size; k++)
+            shifts[k] = st.offset(k)[ndim - 1];
+        parallel_for(0, tiles * outer_chunks, 1, [&](size_t begin, size_t end) {
+            std::vector<T> scratch(size * tile_x), edges(size * tile_x), edge_out(tile_x);
+            std::vector<size_t> edge_pos(tile_x), coords(ndim);
+            std::vector<const T *> sources(size);
+            size_t pending = 0;
+            // the elements of interior rows near the ends of the last axis are collected over the tile and computed
+            // in one run, rather than in runs of a few elements per row
+            auto flush = [&]() {
+                if (pending == 0)
+                    return;
+                for (size_t k = 0; k < size; k++)
+                    sources[k] = edges.data() + k * tile_x;
+                kernel(sources.data(), edge_out.data(), pending);
+                for (size_t i = 0; i < pending; i++)
+                    out.data()[edge_pos[i]] = edge_out[i];
+                pending = 0;
+            };
+            for (size_t task = begin; task < end; task++) {
+                size_t chunk = task / tiles, tile = task % tiles;
+                size_t y0 = tile / tiles_x * tile_y, x0 = tile % tiles_x * tile_x;
+                size_t y1 = std::min(ny, y0 + tile_y), x1 = std::min(nx, x0 + tile_x);
+                for (size_t o = chunk * nouter / outer_chunks; o < (chunk + 1) * nouter / outer_chunks; o++) {
+                    for (size_t d = ndim > 1 ? ndim - 2 : 0, rest = o; d-- > 0; rest /= arr.shape()[d])
+                        coords[d] = rest % arr.shape()[d];
+                    for (size_t y = y0; y < y1; y++) {
+                        if (ndim > 1)
+                            coords[ndim - 2] = y;
+                        bool interior = true;
+                        ptrdiff_t base = 0;
+                        for (size_t d = 0; d + 1 < ndim; d++) {
+                            interior &= coords[d] >= radius[d] && coords[d] + radius[d] < arr.shape()[d];
+                            base += ptrdiff_t(coords[d] * arr.strides()[d]);
+                        }
+                        size_t row = (o * ny + y) * nx;
+                        size_t first = std::max(x0, inner_first), last = std::min(x1, inner_last);
+
+                        if (interior && first < last) {
+                            for (size_t k = 0; k < size; k++)
+                                sources[k] = arr.data() + base + ptrdiff_t(first) + offsets[k];
+                            kernel(sources.data(), out.data() + row + first, last - first);
+                            auto collect = [&](size_t x) {
+                                if (pending == tile_x)
+                                    flush();
+                                for (size_t k = 0; k < size; k++) {
+                                    ptrdiff_t j = maps[ndim - 1][size_t(ptrdiff_t(x + rx) + shifts[k])];
+                                    edges[k * tile_x + pending] =
+                                            j < 0 ? cval : arr.data()[base + offsets[k] - shifts[k] + j];
+                                }
+                                edge_pos[pending++] = row + x;
+                            };
+                            for (size_t x = x0; x < first; x++)
+                                collect(x);
+                            for (size_t x = last; x < x1; x++)
+                                collect(x);
+                            continue;
+                        }
+
+                        // rows near the other edges gather every neighbour row, copying the part that lies inside
+                        // the array and mapping the rest
+                        for (size_t k = 0; k < size; k++) {
+                            const ptrdiff_t *offset = st.offset(k);
+                            ptrdiff_t src = interior ? base + offsets[k] - shifts[k] : 0;
+                            for (size_t d = 0; d + 1 < ndim && !interior && src >= 0; d++) {
+                                ptrdiff_t j = maps[d][size_t(ptrdiff_t(coords[d] + radius[d]) + offset[d])];
+                                src = j < 0 ? -1 : src + j * ptrdiff_t(arr.strides()[d]);
+                            }
+                            T *line = scratch.data() + k * tile_x;
+                            sources[k] = line;
+                            if (src < 0) {
+                                std::fill(line, line + (x1 - x0), cval);
+                                continue;
+                            }
+                            ptrdiff_t shift = shifts[k];
+                            auto inside_first = size_t(std::clamp(-shift, ptrdiff_t(x0), ptrdiff_t(x1)));
+                            auto inside_last = size_t(std::clamp(ptrdiff_t(nx) - shift, ptrdiff_t(inside_first),
+                                                                 ptrdiff_t(x1)));
+                            const T *neighbours = arr.data() + src + shift;
+                            std::copy(neighbours + inside_first, neighbours + inside_last, line + (inside_first - x0));
+                            for (size_t x = x0; x < inside_first; x++) {
+                                ptrdiff_t j = maps[ndim - 1][size_t(ptrdiff_t(x + rx) + shift)];
+                                line[x - x0] = j < 0 ? cval : arr.data()[src + j];
+                            }
+                            for (size_t x = inside_last; x < x1; x++) {
+                                ptrdiff_t j = maps[ndim - 1][size_t(ptrdiff_t(x + rx) + shift)];
+                                line[x - x0] = j < 0 ? cval : arr.data()[src + j];
+                            }
+                        }
+                        kernel(sources.data(), out.data() + row + x0, x1 - x0);
+                    }
+                }
+            }
+            flush();
+        });
+        return out;
+    }
+
+    // Weighted sum of the neighbours given by st at every element of arr. The inner loop runs over consecutive
+    // elements of the last axis and adds four neighbours at a time, so that it vectorizes.
+    template<class T, class Container>
+    ndarray_impl<T, Container> apply_stencil(const ndarray_impl<T, Container> &arr, const stencil<T> &st,
+                                             boundary mode = boundary::constant, T cval = T(0)) {
+        const T *weights = st.weights().data();
+        size_t size = st.size();
+        return stencil_apply_(arr, st, mode, cval, [&](const T *const *sources, T *out, size_t width) {
+            // a local accumulator cannot alias the sources, which lets the loops vectorize without runtime checks
+            T sum[stencil_tile_x_];
+            std::fill(sum, sum + width, T(0));
+            size_t k = 0;
+            for (; k + 4 <= size; k += 4) {
+                const T *s0 = sources[k], *s1 = sources[k + 1], *s2 = sources[k + 2], *s3 = sources[k + 3];
+                T w0 = weights[k], w1 = weights[k + 1], w2 = weights[k + 2], w3 = weights[k + 3];
+                for (size_t x = 0; x < width; x++)
+                    sum[x] += w0 * s0[x] + w1 * s1[x] + w2 * s2[x] + w3 * s3[x];
+            }
+            for (; k < size; k++) {
+                const T *src = sources[k];
+                T weight = weights[k];
+                for (size_t x = 0; x < width; x++)
+                    sum[x] += weight * src[x];
+            }
+            std::copy(sum, sum + width, out);
+        }, "apply_stencil");
+    }
+
+    // fn(values) at every element of arr, where values points to the neighbours given by st in the order they were
+    // added; the weights of st are ignored. For filters that are not weighted sums, like a local maximum.
+    template<class T, class Container, class Function>
+    ndarray_impl<T, Container> map_stencil(const ndarray_impl<T, Container> &arr, const stencil<T> &st, Function &&fn,
+                                           boundary mode = boundary::constant, T cval = T(0)) {
+        size_t size = st.size();
+        return stencil_apply_(arr, st, mode, cval, [&](const T *const *sources, T *out, size_t width) {
+            std::vector<T> values(size);
+            for (size_t x = 0; x < width; x++) {
+                for (size_t k = 0; k < size; k++)
+                    values[k] = sources[k][x];
+                out[x] = fn(static_cast<const T *>(values.data()));
+            }
+        }, "map_stencil");
+    }
+
+}
@@ -0,0 +1,216 @@
+#pragma once
+
+#include <cstdint>      // uint64_t
+
+namespace cnumpy::random {
+
+    // Tables of the 256-layer ziggurat for the standard normal distribution, identical to those of numpy's Generator
+    // so that the samples match numpy's bit for bit. ki are the acceptance thresholds of the 52-bit magnitudes, wi
+    // the widths of the layers divided by 2^52 and fi the density at the layer edges.
+
+    inline constexpr uint64_t ziggurat_ki_[256] = {
+            0x000EF33D8025EF6A, 0x0000000000000000, 0x000C08BE98FBC6A8, 0x000DA354FABD8142,
+            0x000E51F67EC1EEEA, 0x000EB255E9D3F77E, 0x000EEF4B817ECAB9, 0x000F19470AFA44AA,
+            0x000F37ED61FFCB18, 0x000F4F469561255C, 0x000F61A5E41BA396, 0x000F707A755396A4,
+            0x000F7CB2EC28449A, 0x000F86F10C6357D3, 0x000F8FA6578325DE, 0x000F9724C74DD0DA,
+            0x000F9DA907DBF509, 0x000FA360F581FA74, 0x000FA86FDE5B4BF8, 0x000FACF160D354DC,
+            0x000FB0FB6718B90F, 0x000FB49F8D5374C6, 0x000FB7EC2366FE77, 0x000FBAECE9A1E50E,
+            0x000FBDAB9D040BED, 0x000FC03060FF6C57, 0x000FC2821037A248, 0x000FC4A67AE25BD1,
+            0x000FC6A2977AEE31, 0x000FC87AA92896A4, 0x000FCA325E4BDE85, 0x000FCBCCE902231A,
+            0x000FCD4D12F839C4, 0x000FCEB54D8FEC99, 0x000FD007BF1DC930, 0x000FD1464DD6C4E6,
+            0x000FD272A8E2F450, 0x000FD38E4FF0C91E, 0x000FD49A9990B478, 0x000FD598B8920F53,
+            0x000FD689C08E99EC, 0x000FD76EA9C8E832, 0x000FD848547B08E8, 0x000FD9178BAD2C8C,
+            0x000FD9DD07A7ADD2, 0x000FDA9970105E8C, 0x000FDB4D5DC02E20, 0x000FDBF95C5BFCD0,
+            0x000FDC9DEBB99A7D, 0x000FDD3B8118729D, 0x000FDDD288342F90, 0x000FDE6364369F64,
+            0x000FDEEE708D514E, 0x000FDF7401A6B42E, 0x000FDFF46599ED40, 0x000FE06FE4BC24F2,
+            0x000FE0E6C225A258, 0x000FE1593C28B84C, 0x000FE1C78CBC3F99, 0x000FE231E9DB1CAA,
+            0x000FE29885DA1B91, 0x000FE2FB8FB54186, 0x000FE35B33558D4A, 0x000FE3B799D0002A,
+            0x000FE410E99EAD7F, 0x000FE46746D47734, 0x000FE4BAD34C095C, 0x000FE50BAED29524,
+            0x000FE559F74EBC78, 0x000FE5A5C8E41212, 0x000FE5EF3E138689, 0x000FE6366FD91078,
+            0x000FE67B75C6D578, 0x000FE6BE661E11AA, 0x000FE6FF55E5F4F2, 0x000FE73E5900A702,
+            0x000FE77B823E9E39, 0x000FE7B6E37070A2, 0x000FE7F08D774243, 0x000FE8289053F08C,
+            0x000FE85EFB35173A, 0x000FE893DC840864, 0x000FE8C741F0CEBC, 0x000FE8F9387D4EF6,
+            0x000FE929CC879B1D, 0x000FE95909D388EA, 0x000FE986FB939AA2, 0x000FE9B3AC714866,
+            0x000FE9DF2694B6D5, 0x000FEA0973ABE67C, 0x000FEA329CF166A4, 0x000FEA5AAB32952C,
+            0x000FEA81A6D5741A, 0x000FEAA797DE1CF0, 0x000FEACC85F3D920, 0x000FEAF07865E63C,
+            0x000FEB13762FEC13, 0x000FEB3585FE2A4A, 0x000FEB56AE3162B4, 0x000FEB76F4E284FA,
+            0x000FEB965FE62014, 0x000FEBB4F4CF9D7C, 0x000FEBD2B8F449D0, 0x000FEBEFB16E2E3E,
+            0x000FEC0BE31EBDE8, 0x000FEC2752B15A15, 0x000FEC42049DAFD3, 0x000FEC5BFD29F196,
+            0x000FEC75406CEEF4, 0x000FEC8DD2500CB4, 0x000FECA5B6911F12, 0x000FECBCF0C427FE,
+            0x000FECD38454FB15, 0x000FECE97488C8B3, 0x000FECFEC47F91B7, 0x000FED1377358528,
+            0x000FED278F844903, 0x000FED3B10242F4C, 0x000FED4DFBAD586E, 0x000FED605498C3DD,
+            0x000FED721D414FE8, 0x000FED8357E4A982, 0x000FED9406A42CC8, 0x000FEDA42B85B704,
+            0x000FEDB3C8746AB4, 0x000FEDC2DF416652, 0x000FEDD171A46E52, 0x000FEDDF813C8AD3,
+            0x000FEDED0F909980, 0x000FEDFA1E0FD414, 0x000FEE06AE124BC4, 0x000FEE12C0D95A06,
+            0x000FEE1E579006E0, 0x000FEE29734B6524, 0x000FEE34150AE4BC, 0x000FEE3E3DB89B3C,
+            0x000FEE47EE2982F4, 0x000FEE51271DB086, 0x000FEE59E9407F41, 0x000FEE623528B42E,
+            0x000FEE6A0B5897F1, 0x000FEE716C3E077A, 0x000FEE7858327B82, 0x000FEE7ECF7B06BA,
+            0x000FEE84D2484AB2, 0x000FEE8A60B66343, 0x000FEE8F7ACCC851, 0x000FEE94207E25DA,
+            0x000FEE9851A829EA, 0x000FEE9C0E13485C, 0x000FEE9F557273F4, 0x000FEEA22762CCAE,
+            0x000FEEA4836B42AC, 0x000FEEA668FC2D71, 0x000FEEA7D76ED6FA, 0x000FEEA8CE04FA0A,
+            0x000FEEA94BE8333B, 0x000FEEA950296410, 0x000FEEA8D9C0075E, 0x000FEEA7E7897654,
+            0x000FEEA678481D24, 0x000FEEA48AA29E83, 0x000FEEA21D22E4DA, 0x000FEE9F2E352024,
+            0x000FEE9BBC26AF2E, 0x000FEE97C524F2E4, 0x000FEE93473C0A3A, 0x000FEE8E40557516,
+            0x000FEE88AE369C7A, 0x000FEE828E7F3DFD, 0x000FEE7BDEA7B888, 0x000FEE749BFF37FF,
+            0x000FEE6CC3A9BD5E, 0x000FEE64529E007E, 0x000FEE5B45A32888, 0x000FEE51994E57B6,
+            0x000FEE474A0006CF, 0x000FEE3C53E12C50, 0x000FEE30B2E02AD8, 0x000FEE2462AD8205,
+            0x000FEE175EB83C5A, 0x000FEE09A22A1447, 0x000FEDFB27E349CC, 0x000FEDEBEA76216C,
+            0x000FEDDBE422047E, 0x000FEDCB0ECE39D3, 0x000FEDB964042CF4, 0x000FEDA6DCE938C9,
+            0x000FED937237E98D, 0x000FED7F1C38A836, 0x000FED69D2B9C02B, 0x000FED538D06AE00,
+            0x000FED3C41DEA422, 0x000FED23E76A2FD8, 0x000FED0A732FE644, 0x000FECEFDA07FE34,
+            0x000FECD4100EB7B8, 0x000FECB708956EB4, 0x000FEC98B61230C1, 0x000FEC790A0DA978,
+            0x000FEC57F50F31FE, 0x000FEC356686C962, 0x000FEC114CB4B335, 0x000FEBEB948E6FD0,
+            0x000FEBC429A0B692, 0x000FEB9AF5EE0CDC, 0x000FEB6FE1C98542, 0x000FEB42D3AD1F9E,
+            0x000FEB13B00B2D4B, 0x000FEAE2591A02E9, 0x000FEAAEAE992257, 0x000FEA788D8EE326,
+            0x000FEA3FCFFD73E5, 0x000FEA044C8DD9F6, 0x000FE9C5D62F563B, 0x000FE9843BA947A4,
+            0x000FE93F471D4728, 0x000FE8F6BD76C5D6, 0x000FE8AA5DC4E8E6, 0x000FE859E07AB1EA,
+            0x000FE804F690A940, 0x000FE7AB488233C0, 0x000FE74C751F6AA5, 0x000FE6E8102AA202,
+            0x000FE67DA0B6ABD8, 0x000FE60C9F38307E, 0x000FE5947338F742, 0x000FE51470977280,
+            0x000FE48BD436F458, 0x000FE3F9BFFD1E37, 0x000FE35D35EEB19C, 0x000FE2B5122FE4FE,
+            0x000FE20003995557, 0x000FE13C82788314, 0x000FE068C4EE67B0, 0x000FDF82B02B71AA,
+            0x000FDE87C57EFEAA, 0x000FDD7509C63BFD, 0x000FDC46E529BF13, 0x000FDAF8F82E0282,
+            0x000FD985E1B2BA75, 0x000FD7E6EF48CF04, 0x000FD613ADBD650B, 0x000FD40149E2F012,
+            0x000FD1A1A7B4C7AC, 0x000FCEE204761F9E, 0x000FCBA8D85E11B2, 0x000FC7D26ECD2D22,
+            0x000FC32B2F1E22ED, 0x000FBD6581C0B83A, 0x000FB606C4005434, 0x000FAC40582A2874,
+            0x000F9E971E014598, 0x000F89FA48A41DFC, 0x000F66C5F7F0302C, 0x000F1A5A4B331C4A
+    };
+
+    inline constexpr double ziggurat_wi_[256] = {
+            8.6836270608013062e-16, 4.7793301757277368e-17, 6.3543524174052623e-17, 7.4548704812476963e-17,
+            8.3293668157930997e-17, 9.0680604050594823e-17, 9.7148600765677618e-17, 1.0294750314241019e-16,
+            1.0823430288447684e-16, 1.1311470196109031e-16, 1.1766359457022921e-16, 1.2193617278714363e-16,
+            1.2597439914637093e-16, 1.2981099886264032e-16, 1.3347203736824123e-16, 1.3697864842571203e-16,
+            1.4034823001242382e-16, 1.4359529452056943e-16, 1.4673208742364422e-16, 1.4976904668391037e-16,
+            1.5271515003596198e-16, 1.5557818169460764e-16, 1.5836494009290885e-16, 1.6108140175274928e-16,
+            1.6373285203969853e-16, 1.6632399058420835e-16, 1.6885901708676596e-16, 1.7134170176559661e-16,
+            1.7377544365864859e-16, 1.7616331923000996e-16, 1.7850812316976727e-16, 1.8081240285799152e-16,
+            1.830784876482675e-16, 1.8530851388618019e-16, 1.8750444639373882e-16, 1.896680970077476e-16,
+            1.918011406483862e-16, 1.9390512930625104e-16, 1.9598150426628824e-16, 1.9803160683128174e-16,
+            2.000566877627333e-16, 2.0205791562071654e-16, 2.0403638415480212e-16, 2.0599311887403706e-16,
+            2.079290829041402e-16, 2.0984518222370352e-16, 2.1174227035760342e-16, 2.1362115259449868e-16,
+            2.1548258978581458e-16, 2.1732730177564367e-16, 2.1915597050427271e-16, 2.2096924282235318e-16,
+            2.2276773304789553e-16, 2.2455202529414355e-16, 2.2632267559285679e-16, 2.2808021383450171e-16,
+            2.2982514554424684e-16, 2.3155795351040804e-16, 2.3327909928004356e-16, 2.3498902453470955e-16,
+            2.3668815235791604e-16, 2.3837688840454243e-16, 2.4005562198135063e-16, 2.4172472704675025e-16,
+            2.4338456313711029e-16, 2.4503547622614954e-16, 2.466777995232705e-16, 2.4831185421610877e-16,
+            2.4993795016204524e-16, 2.5155638653296579e-16, 2.5316745241713583e-16, 2.5477142738169442e-16,
+            2.5636858199893968e-16, 2.5795917833928672e-16, 2.5954347043351707e-16, 2.6112170470670194e-16,
+            2.6269412038597256e-16, 2.6426094988411895e-16, 2.6582241916083068e-16, 2.6737874806323633e-16,
+            2.6893015064726159e-16, 2.7047683548119952e-16, 2.7201900593277321e-16, 2.7355686044086791e-16,
+            2.7509059277301666e-16, 2.7662039226963903e-16, 2.7814644407595441e-16, 2.7966892936242301e-16,
+            2.8118802553450207e-16, 2.8270390643244792e-16, 2.8421674252184061e-16, 2.8572670107546015e-16,
+            2.8723394634709799e-16, 2.8873863973784819e-16, 2.9024093995538423e-16, 2.9174100316669455e-16,
+            2.9323898314471816e-16, 2.9473503140929349e-16, 2.9622929736280665e-16, 2.9772192842090289e-16,
+            2.9921307013860131e-16, 3.007028663321331e-16, 3.0219145919680615e-16, 3.0367898942118018e-16,
+            3.0516559629782192e-16, 3.0665141783089545e-16, 3.0813659084082972e-16, 3.0962125106629225e-16,
+            3.111055332636893e-16, 3.1258957130439989e-16, 3.1407349826994462e-16, 3.1555744654528006e-16,
+            3.1704154791040285e-16, 3.1852593363044065e-16, 3.2001073454440114e-16, 3.214960811527447e-16,
+            3.2298210370394156e-16, 3.2446893228016978e-16, 3.2595669688230784e-16, 3.2744552751437067e-16,
+            3.2893555426753697e-16, 3.3042690740391284e-16, 3.3191971744017523e-16, 3.3341411523123725e-16,
+            3.3491023205407785e-16, 3.3640819969187651e-16, 3.3790815051859498e-16, 3.3941021758414891e-16,
+            3.409145347003126e-16, 3.4242123652750182e-16, 3.4393045866258313e-16, 3.454423377278584e-16,
+            3.4695701146137835e-16, 3.4847461880874137e-16, 3.499953000165381e-16, 3.5151919672760744e-16,
+            3.5304645207827401e-16, 3.5457721079774357e-16, 3.5611161930983884e-16, 3.5764982583726505e-16,
+            3.5919198050860299e-16, 3.6073823546823514e-16, 3.6228874498941915e-16, 3.6384366559073444e-16,
+            3.65403156156137e-16, 3.6696737805887009e-16, 3.685364952894914e-16, 3.7011067458828983e-16,
+            3.716900855823823e-16, 3.7327490092779435e-16, 3.7486529645684887e-16, 3.7646145133120287e-16,
+            3.7806354820089604e-16, 3.7967177336979443e-16, 3.8128631696783774e-16, 3.8290737313052432e-16,
+            3.8453514018609596e-16, 3.8616982085091493e-16, 3.8781162243355872e-16, 3.8946075704819262e-16,
+            3.9111744183782054e-16, 3.9278189920805415e-16, 3.9445435707208771e-16, 3.9613504910761354e-16,
+            3.9782421502646826e-16, 3.995221008578565e-16, 4.0122895924606291e-16, 4.0294504976363279e-16,
+            4.04670639241075e-16, 4.0640600211422504e-16, 4.0815142079049387e-16, 4.0990718603532664e-16,
+            4.1167359738030257e-16, 4.134509635544236e-16, 4.1523960294026883e-16, 4.1703984405683159e-16,
+            4.1885202607101123e-16, 4.2067649933990151e-16, 4.2251362598620494e-16, 4.243637805093078e-16,
+            4.2622735043477981e-16, 4.2810473700531167e-16, 4.2999635591638323e-16, 4.3190263810026294e-16,
+            4.3382403056227908e-16, 4.357609972736849e-16, 4.3771402012585875e-16, 4.3968359995105214e-16,
+            4.4167025761542035e-16, 4.4367453519065673e-16, 4.4569699721120431e-16, 4.4773823202475339e-16,
+            4.4979885324455497e-16, 4.5187950131300588e-16, 4.539808451870034e-16, 4.5610358415674221e-16,
+            4.5824844981095667e-16, 4.6041620816311528e-16, 4.6260766195478457e-16, 4.6482365315432074e-16,
+            4.6706506567126306e-16, 4.6933282830933289e-16, 4.7162791798383513e-16, 4.7395136323258672e-16,
+            4.7630424805331374e-16, 4.7868771610487228e-16, 4.8110297531474172e-16, 4.8355130294115252e-16,
+            4.860340511450812e-16, 4.8855265313536034e-16, 4.9110862995952696e-16, 4.9370359802403345e-16,
+            4.9633927744039873e-16, 4.9901750130918225e-16, 5.0174022607180895e-16, 5.0450954308187275e-16,
+            5.0732769157335421e-16, 5.1019707323415618e-16, 5.1312026863067837e-16, 5.1610005577432282e-16,
+            5.1913943117576986e-16, 5.2224163380002343e-16, 5.2541017241775973e-16, 5.2864885695049451e-16,
+            5.3196183453384004e-16, 5.3535363118164969e-16, 5.3882920013340532e-16, 5.4239397822017123e-16,
+            5.4605395190747804e-16, 5.4981573508928141e-16, 5.536866612467876e-16, 5.5767489329265765e-16,
+            5.6178955535554167e-16, 5.6604089200824222e-16, 5.7044046212913891e-16, 5.7500137689198952e-16,
+            5.7973859457245937e-16, 5.846692893455479e-16, 5.8981331764778994e-16, 5.9519381496414442e-16,
+            6.0083796962719083e-16, 6.0677804093334485e-16, 6.1305272087252816e-16, 6.1970898945816256e-16,
+            6.2680469633012844e-16, 6.344122407127506e-16, 6.4262396595480554e-16, 6.5156033173449936e-16,
+            6.6138278850976642e-16, 6.7231504625055866e-16, 6.8468034175642588e-16, 6.98971833638762e-16,
+            7.1599949348306642e-16, 7.3724243017987989e-16, 7.6589363708055728e-16, 8.1138493376564842e-16
+    };
+
+    inline constexpr double ziggurat_fi_[256] = {
+            1, 0.9771017012676716, 0.95987909180010667, 0.94519895344229965,
+            0.93206007595923046, 0.91999150503934701, 0.90872644005213088, 0.89809592189834342,
+            0.88798466075583338, 0.8783096558089174, 0.86900868803685705, 0.86003362119633153,
+            0.85134625845867795, 0.84291565311220418, 0.83471629298688343, 0.82672683394622137,
+            0.81892919160370237, 0.81130787431265627, 0.80384948317096427, 0.79654233042295897,
+            0.78937614356602459, 0.7823418326548025, 0.77543130498118717, 0.76863731579848626,
+            0.76195334683679539, 0.75537350650709612, 0.74889244721915682, 0.74250529634015106,
+            0.73620759812686265, 0.72999526456147623, 0.72386453346863022, 0.71781193263072196,
+            0.71183424887824842, 0.70592850133275431, 0.70009191813651162, 0.69432191612611671,
+            0.68861608300467181, 0.68297216164499486, 0.67738803621877353, 0.6718617198970821,
+            0.6663913439087501, 0.66097514777666311, 0.65561147057969726, 0.6502987431108167,
+            0.64503548082082229, 0.63982027745305659, 0.63465179928762361, 0.62952877992483669,
+            0.6244500155470265, 0.61941436060583432, 0.61442072388891389, 0.60946806492577343,
+            0.60455539069746778, 0.59968175261912526, 0.59484624376798745, 0.59004799633282601,
+            0.58528617926337145, 0.5805599961007909, 0.57586868297235372, 0.57121150673525323,
+            0.56658776325616445, 0.56199677581452434, 0.55743789361876595, 0.55291049042583229,
+            0.54841396325526581, 0.54394773119002626, 0.53951123425695213, 0.53510393238045761,
+            0.53072530440366206, 0.52637484717168448, 0.52205207467232184, 0.51775651722975635,
+            0.51348772074732696, 0.50924524599574794, 0.50502866794346812, 0.50083757512614868,
+            0.49667156905248971, 0.49253026364386854, 0.48841328470545803, 0.48432026942668333,
+            0.48025086590904675, 0.47620473271950586, 0.4721815384677302, 0.4681809614056936,
+            0.46420268904817436, 0.46024641781284287, 0.45631185267871643, 0.45239870686184852,
+            0.44850670150720306, 0.4446355653957394, 0.44078503466580399, 0.43695485254798555,
+            0.43314476911265226, 0.42935454102944143, 0.42558393133802197, 0.42183270922949589,
+            0.41810064983784823, 0.41438753404089113, 0.41069314827018816, 0.40701728432947337,
+            0.40335973922111451, 0.39972031498019722, 0.39609881851583245, 0.39249506145931562,
+            0.38890886001878872, 0.38534003484007728, 0.38178841087339366, 0.37825381724561918,
+            0.37473608713789114, 0.3712350576682395, 0.36775056977903259, 0.36428246812900406,
+            0.36083060098964803, 0.3573948201457805, 0.35397498080007678, 0.35057094148140611,
+            0.34718256395679364, 0.34380971314685072, 0.34045225704452187, 0.33711006663700605,
+            0.33378301583071845, 0.33047098137916359, 0.3271738428136014, 0.32389148237639109,
+            0.32062378495690536, 0.31737063802991361, 0.31413193159633718, 0.31090755812628651,
+            0.30769741250429206, 0.30450139197664999, 0.30131939610080305, 0.29815132669668548,
+            0.29499708779996181, 0.29185658561709521, 0.28872972848218292, 0.28561642681550176,
+            0.28251659308370758, 0.27943014176163794, 0.27635698929566832, 0.27329705406857707,
+            0.27025025636587546, 0.26721651834356147, 0.26419576399726119, 0.26118791913272121,
+            0.25819291133761924, 0.25521066995466196, 0.25224112605594218, 0.24928421241852852,
+            0.24633986350126383, 0.24340801542275031, 0.24048860594050059, 0.23758157443123809,
+            0.23468686187233001, 0.23180441082433872, 0.22893416541468034, 0.22607607132238028,
+            0.22323007576391748, 0.220396127480152, 0.21757417672433113, 0.21476417525117358,
+            0.21196607630703018, 0.20917983462112508, 0.2064054063978808, 0.20364274931033491,
+            0.20089182249465659, 0.19815258654577514, 0.1954250035141343, 0.19270903690358918,
+            0.19000465167046499, 0.1873118142238003, 0.18463049242679927, 0.18196065559952251,
+            0.17930227452284758, 0.17665532144373486, 0.17401977008183855, 0.17139559563750575,
+            0.16878277480121129, 0.16618128576448191, 0.16359110823236558, 0.16101222343751101,
+            0.15844461415592428, 0.1558882647244792, 0.15334316106026286, 0.15080929068184568,
+            0.14828664273257455, 0.14577520800599403, 0.14327497897351346, 0.1407859498144447,
+            0.13830811644855073, 0.13584147657125376, 0.13338602969166916, 0.13094177717364436,
+            0.12850872227999957, 0.12608687022018589, 0.12367622820159657, 0.12127680548479031,
+            0.11888861344291006, 0.11651166562561087, 0.11414597782783849, 0.11179156816383809,
+            0.1094484571468118, 0.1071166677746838, 0.10479622562248707, 0.10248715894193525,
+            0.10018949876881002, 0.097903279038862465, 0.095628536713008999, 0.093365311912691012,
+            0.091113648066373759, 0.088873592068275886, 0.086645194450558072, 0.084428509570353472,
+            0.082223595813202904, 0.08003051581466307, 0.077849336702096122, 0.075680130358927178,
+            0.073522973713981324, 0.071377949058890403, 0.069245144397006755, 0.067124653827788497,
+            0.065016577971242898, 0.062921024437758141, 0.060838108349539878, 0.058767952920933737,
+            0.056710690106202902, 0.054666461324888921, 0.05263541827679219, 0.050617723860947782,
+            0.048613553215868542, 0.046623094901930381, 0.044646552251294463, 0.042684144916474459,
+            0.040736110655940939, 0.038802707404526147, 0.036884215688567305, 0.034980941461716125,
+            0.033093219458578578, 0.0312214171919203, 0.029365939758133359, 0.027527235669603113,
+            0.02570580400854891, 0.023902203305795879, 0.02211706270730885, 0.02035109623004451,
+            0.018605121275724622, 0.016880083152543142, 0.015177088307935309, 0.013497450601739867,
+            0.011842757857907879, 0.010214971439701459, 0.0086165827693987264, 0.0070508754713732224,
+            0.0055224032992509916, 0.0040379725933630236, 0.0026090727461021593, 0.001260285930498598
+    };
+
+    inline constexpr double ziggurat_r_ = 3.6541528853610088;
+
+    inline constexpr double ziggurat_inv_r_ = 0.27366123732975828;
+
+}
@@ -0,0 +1,160 @@
+#include <cassert>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <utility>
+#include <variant>
+#include <vector>
+#include "cnumpy/any_ndarray.hpp"
+#include "cnumpy/ndarray.hpp"
+#include "cnumpy/npy.hpp"
+#include "cnumpy/npz.hpp"
+#include "cnumpy/parallel.hpp"
+#include "throws.hpp"
+
+using namespace std;
+using namespace cnumpy;
+
+template<class T>
+ndarray<T> pattern() {
+    ndarray<T> arr(vector<size_t>{2, 3});
+    for (size_t k = 0; k < arr.size(); k++)
+        arr.data()[k] = convert_<T>(int(k % (is_same_v<T, bool> ? 2 : 7)));
+    return arr;
+}
+
+// every element type through a file and the kernels
+template<class T>
+void check_type(NPZ &npz) {
+    string name = dtype_name_<T>();
+    {
+        NPY npy("any_" + name + ".npy", 'w');
+        npy.save(pattern<T>());
+    }
+    NPY npy("any_" + name + ".npy", 'r');
+    any_ndarray arr = npy.load_any();
+    assert(arr.holds<T>() && arr.dtype() == name && arr.itemsize() == sizeof(T));
+    assert(arr.shape() == vector<size_t>({2, 3}) && arr.ndim() == 2 && arr.size() == 6);
+    assert(arr.nbytes() == 6 * sizeof(T));
+    const ndarray<T> &typed = arr.get<T>();
+    assert(arr.data() == typed.data() && arr.get_if<T>() == &typed);
+    for (size_t k = 0; k < 6; k++)
+        assert(typed.data()[k] == pattern<T>().data()[k]);
+
+    auto doubles = arr.astype<double>();
+    double expected = is_same_v<T, bool> ? 3 : 15;
+    assert(doubles(1, 2) == (is_same_v<T, bool> ? 1 : 5));
+    assert(arr.sum<complex<double>>() == complex<double>(expected, 0));
+    if constexpr (!is_complex_<T>::value) {
+        assert(arr.sum() == expected && arr.min() == 0 && arr.max() == (is_same_v<T, bool> ? 1 : 5));
+        assert(arr.max<T>() == pattern<T>()(1, 2));
+    } else {
+        assert(throws([&]() { return arr.sum(); }));
+        assert(throws([&]() { return arr.max(); }));
+    }
+    npz.save(name, arr);
+}
+
+int main() {
+    {
+        NPZ npz("any.npz", 'w');
+        [&]<size_t... I>(index_sequence<I...>) {
+            (check_type<typename variant_alternative_t<I, any_ndarray::variant_type>::value_type>(npz), ...);
+        }(make_index_sequence<variant_size_v<any_ndarray::variant_type>>());
+    }
+
+    // NPZ members, checksums, and aliasing of loads from memory
+    {
+        NPZ npz("any.npz", 'r');
+        any_ndarray c = npz.load_any("complex64"), i = npz.load_any("uint16");
+        assert(c.holds<complex<float>>() && i.get<uint16_t>()(1, 1) == 4);
+
+        NPY out("any_checked.npy", 'w');
+        out.enable_checksum();
+        out.save(i);
+        out.close();
+        NPY in("any_checked.npy", 'r');
+        assert(in.load_any(out.checksum()).holds<uint16_t>());
+        NPY corrupted("any_checked.npy", 'r');
+        assert(throws([&]() { return corrupted.load_any(out.checksum() ^ 1); }));
+
+        size_t size = NPY::nbytes(i.get<uint16_t>());
+        shared_ptr<char[]> buffer(new char[size]);
+        NPY(buffer, size, 'w').save(i);
+        any_ndarray aliased = NPY(buffer, size, 'r').load_any();
+        assert(static_cast<const char *>(aliased.data()) == buffer.get() + size - 12);
+    }
+
+    // big-endian data is swapped, types any_ndarray doesn't hold are refused
+    {
+        auto write = [](const string &file, const string &descr, const string &data) {
+            string header = NPY::header(descr, vector<size_t>{data.size() / 4});
+            ofstream(file, ios::binary) << header << data;
+        };
+        write("any_big_endian.npy", ">i4", string("\x00\x00\x01\x02\xff\xff\xff\xfe", 8));
+        any_ndarray big = NPY("any_big_endian.npy", 'r').load_any();
+        assert(big.get<int32_t>()(0) == 258 && big.get<int32_t>()(1) == -2);
+        write("any_half.npy", "<f2", string(8, '\0'));
+        write("any_bytes.npy", "|S4", string(8, 'a'));
+        assert(throws([&]() { return NPY("any_half.npy", 'r').load_any(); }));
+        assert(throws([&]() { return NPY("any_bytes.npy", 'r').load_any(); }));
+    }
+
+    // construction from typed arrays, access with the wrong type, and user kernels through visit
+    {
+        ndarray<float, 2> fixed(2, 2);
+        fixed(0, 0) = 1.5f, fixed(0, 1) = -2, fixed(1, 0) = 0, fixed(1, 1) = 3.75f;
+        const float *buffer = std::as_const(fixed).data();
+        any_ndarray arr = std::move(fixed);
+        assert(arr.dtype() == "float32" && arr.shape() == vector<size_t>({2, 2}) && arr.data() == buffer);
+        assert(throws([&]() { return arr.get<double>(); }) && arr.get_if<double>() == nullptr);
+        assert(throws([&]() { return std::as_const(arr).get<double>(); }));
+        assert(std::as_const(arr).get<float>().data() == buffer);
+
+        size_t nonzero = arr.visit([](const auto &typed) {
+            using T = typename remove_cvref_t<decltype(typed)>::value_type;
+            size_t count = 0;
+            for (size_t k = 0; k < typed.size(); k++)
+                count += typed.data()[k] != T(0);
+            return count;
+        });
+        assert(nonzero == 3);
+        arr.visit([](auto &typed) { typed.data()[2] = 7; });
+        assert(arr.get<float>()(1, 0) == 7);
+
+        auto ints = arr.astype<int32_t>();
+        auto flags = arr.astype<bool>();
+        assert(ints(0, 0) == 1 && ints(0, 1) == -2 && ints(1, 1) == 3 && flags(1, 0) && flags(0, 1));
+        any_ndarray spectrum = ndarray<complex<double>>(vector<size_t>{1});
+        spectrum.get<complex<double>>()(0) = complex<double>(2, -1);
+        assert(spectrum.astype<float>()(0) == 2 && spectrum.astype<complex<float>>()(0) == complex<float>(2, -1));
+
+        any_ndarray empty;
+        assert(empty.dtype() == "float64" && empty.size() == 0 && empty.sum() == 0);
+        assert(throws([&]() { return empty.min(); }));
+    }
+
+    // NaN propagates through min and max, reductions don't depend on the number of threads
+    {
+        ndarray<double> values(vector<size_t>{100000});
+        for (size_t k = 0; k < values.size(); k++)
+            values.data()[k] = sin(double(k)) * 1e3;
+        any_ndarray arr = values;
+        set_num_threads(1);
+        double serial = arr.sum(), low = arr.min(), high = arr.max();
+        set_num_threads(4);
+        assert(arr.sum() == serial && arr.min() == low && arr.max() == high);
+        set_num_threads(0);
+        assert(low >= -1e3 && low < -999 && high > 999);
+
+        values.data()[500] = numeric_limits<double>::quiet_NaN();
+        any_ndarray with_nan = values;
+        assert(isnan(with_nan.min()) && isnan(with_nan.max()) && isnan(with_nan.sum()));
+    }
+
+    return 0;
+}
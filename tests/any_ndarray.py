@@ -0,0 +1,13 @@
+import os
+import sys
+import numpy as np
+
+
+with np.load(os.path.join(sys.argv[1], 'any.npz')) as npz:
+    assert len(npz.files) == 15
+    for name in npz.files:
+        arr = npz[name]
+        assert arr.dtype.name == name
+        expected = np.arange(6).reshape(2, 3) % (2 if name == 'bool' else 7)
+        assert np.array_equal(arr, expected.astype(name))
+        assert np.array_equal(np.load(os.path.join(sys.argv[1], 'any_' + name + '.npy')), arr)
@@ -0,0 +1,146 @@
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+#include "cnumpy/arithmetic.hpp"
+#include "cnumpy/instrument.hpp"
+#include "cnumpy/ndarray.hpp"
+#include "throws.hpp"
+
+using namespace std;
+using namespace cnumpy;
+
+uint64_t allocations() {
+    return instrument::snapshot()[instrument::counter::allocations];
+}
+
+int main() {
+    ndarray<double, 2> a(3, 4), b(3, 4);
+    for (size_t i = 0; i < a.size(); i++) {
+        a.data()[i] = double(i) + 1;
+        b.data()[i] = 0.5 * double(i);
+    }
+
+    // results of lvalue operands get their own memory and leave the operands alone
+    {
+        uint64_t before = allocations();
+        auto sum = a + b;
+        auto scaled = 2.0 * a - 1;
+        auto quotient = a / b;
+        auto negated = -a;
+        assert(allocations() == before + 4);
+        for (size_t i = 0; i < a.size(); i++) {
+            assert(sum.data()[i] == 1.5 * double(i) + 1);
+            assert(scaled.data()[i] == 2 * double(i) + 1);
+            assert(quotient.data()[i] == a.data()[i] / b.data()[i]);
+            assert(negated.data()[i] == -a.data()[i]);
+        }
+        assert(isinf(quotient.data()[0]) && a.data()[0] == 1 && b.data()[1] == 0.5);
+        assert(sum.shape() == a.shape());
+    }
+
+    // chains of expiring operands reuse one buffer
+    {
+        ndarray<double, 2> x = a;
+        const double *buffer = x.data();
+        uint64_t before = allocations();
+        auto c = std::move(x) + b;
+        c = std::move(c) * b;
+        c = 3.0 - std::move(c) / 2;
+        c = b * std::move(c);
+        c = exp(-std::move(c)) + 1.0;
+        c = sqrt(abs(std::move(c)));
+        c += b;
+        c *= 0.5;
+        assert(allocations() == before);
+        assert(std::as_const(c).data() == buffer && x.size() == 0);
+        for (size_t i = 0; i < a.size(); i++) {
+            double va = double(i) + 1, vb = 0.5 * double(i);
+            double expected = (sqrt(abs(exp(-(vb * (3 - (va + vb) * vb / 2))) + 1)) + vb) * 0.5;
+            assert(abs(std::as_const(c).data()[i] - expected) < 1e-12);
+        }
+    }
+
+    // an rvalue whose buffer is shared with a view or a copy falls back to allocating
+    {
+        ndarray<double, 2> x = a;
+        auto view = x.make_shared(vector<size_t>{12});
+        uint64_t before = allocations();
+        auto c = std::move(x) + 1.0;
+        assert(allocations() == before + 1);
+        assert(std::as_const(view).data()[0] == 1 && c.data()[0] == 2);
+        assert(std::as_const(x).data() == std::as_const(view).data());
+
+        // a copy may share its buffer when built with copy-on-write, a fresh result never does
+        auto y = a * 1.0;
+        const double *buffer = std::as_const(y).data();
+        auto d = b + std::move(y);
+        assert(std::as_const(d).data() == buffer);
+        auto first = a * 1.0, second = b * 1.0;
+        auto e = std::move(first) * std::move(second);
+        assert(e(2, 3) == a(2, 3) * b(2, 3) && first.size() == 0 && second.size() == 12);
+    }
+
+    // compound assignment writes in place, so views see the result
+    {
+        ndarray<double, 2> x = a;
+        auto view = x.make_shared(vector<size_t>{12});
+        x -= a;
+        x += 2;
+        assert(std::as_const(view).data()[11] == 2);
+        x /= x;
+        assert(x(1, 1) == 1);
+    }
+
+    // math functions, including NaN propagation in maximum and minimum, and integer arrays
+    {
+        auto p = pow(a, 2.0), q = pow(2.0, a), r = pow(a, b);
+        assert(p(1, 2) == 49 && q(0, 3) == 16 && abs(r(0, 1) - sqrt(2.0)) < 1e-15);
+        auto s = sin(a) * sin(a) + cos(a) * cos(a);
+        for (size_t i = 0; i < s.size(); i++)
+            assert(abs(s.data()[i] - 1) < 1e-12);
+        assert(abs(tanh(a)(0, 0) - tanh(1.0)) < 1e-15 && abs(log(exp(a))(2, 3) - 12) < 1e-12);
+
+        ndarray<double, 1> u(3), v(3);
+        double nan = numeric_limits<double>::quiet_NaN();
+        u(0) = 1, u(1) = nan, u(2) = 5;
+        v(0) = 2, v(1) = 0, v(2) = nan;
+        auto hi = maximum(u, v), lo = minimum(u, v), clipped = minimum(maximum(u, 1.5), 3.0);
+        assert(hi(0) == 2 && isnan(hi(1)) && isnan(hi(2)) && lo(0) == 1 && isnan(lo(1)) && isnan(lo(2)));
+        assert(clipped(0) == 1.5 && isnan(clipped(1)) && clipped(2) == 3);
+
+        ndarray<int32_t, 1> i(4);
+        for (size_t k = 0; k < i.size(); k++)
+            i(k) = int32_t(k) - 2;
+        auto j = abs(i) * 3 + i / 2;
+        assert(j(0) == 5 && j(1) == 3 && j(2) == 0 && j(3) == 3);
+        ndarray<uint8_t, 1> bytes(2);
+        bytes(0) = 200, bytes(1) = 7;
+        auto wrapped = abs(bytes) + 100;
+        assert(wrapped(0) == 44 && wrapped(1) == 107);
+    }
+
+    // variable-rank arrays, and mismatched shapes
+    {
+        ndarray<float> x(vector<size_t>{2, 3}), y(vector<size_t>{3, 2}), z(vector<size_t>{2, 3});
+        assert(throws([&]() { return x + y; }));
+        assert(throws([&]() { return maximum(std::move(x), y); }));
+        assert(x.size() == 6);
+        assert(throws([&]() { x += y; }));
+        auto w = std::move(x) + z;
+        assert(w.shape() == z.shape());
+
+        ndarray<double> large(vector<size_t>{300000});
+        for (size_t k = 0; k < large.size(); k++)
+            large.data()[k] = double(k);
+        set_num_threads(4);
+        auto twice = std::move(large) * 2.0;
+        set_num_threads(0);
+        for (size_t k = 0; k < twice.size(); k++)
+            assert(std::as_const(twice).data()[k] == 2 * double(k));
+    }
+
+    return 0;
+}
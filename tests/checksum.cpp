@@ -0,0 +1,132 @@
+#include <cassert>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+#include "cnumpy/checksum.hpp"
+#include "cnumpy/ndarray.hpp"
+#include "cnumpy/npy.hpp"
+#include "cnumpy/npz.hpp"
+#include "cnumpy/parallel.hpp"
+#include "throws.hpp"
+
+using namespace std;
+using namespace cnumpy;
+
+// bit by bit, straight from the definition
+uint32_t reference(uint32_t poly, const unsigned char *p, size_t size) {
+    uint32_t crc = ~uint32_t(0);
+    for (size_t i = 0; i < size; i++) {
+        crc ^= p[i];
+        for (int k = 0; k < 8; k++)
+            crc = crc & 1 ? poly ^ (crc >> 1) : crc >> 1;
+    }
+    return ~crc;
+}
+
+vector<char> read_file(const string &filename) {
+    ifstream in(filename, ios::binary);
+    return {istreambuf_iterator<char>(in), istreambuf_iterator<char>()};
+}
+
+int main() {
+    // check values of the catalogue of parametrised CRC algorithms
+    assert(crc32(0, "123456789", 9) == 0xCBF43926 && crc32c(0, "123456789", 9) == 0xE3069283);
+    assert(crc32(0, nullptr, 0) == 0 && crc32c(0, nullptr, 0) == 0);
+
+    vector<unsigned char> data(5 << 20);
+    uint32_t state = 1;
+    for (auto &byte: data) {
+        state = state * 1664525u + 1013904223u;
+        byte = uint8_t(state >> 24);
+    }
+
+    // every length and alignment around the 16- and 64-byte blocks of the accelerated paths, and the tables
+    for (size_t offset = 0; offset < 8; offset++)
+        for (size_t size = 0; size < 300; size++) {
+            const unsigned char *p = data.data() + offset;
+            assert(crc32(0, p, size) == reference(crc32_polynomial, p, size));
+            assert(crc32c(0, p, size) == reference(crc32c_polynomial, p, size));
+            assert(~crc_<crc32_polynomial>::software(~0u, p, size) == reference(crc32_polynomial, p, size));
+            assert(~crc_<crc32c_polynomial>::software(~0u, p, size) == reference(crc32c_polynomial, p, size));
+        }
+
+    // incremental updates and combination agree with a single pass, including parallel chunks of large inputs
+    {
+        uint32_t whole = ~crc_<crc32_polynomial>::software(~0u, data.data(), data.size());
+        uint32_t whole_c = ~crc_<crc32c_polynomial>::software(~0u, data.data(), data.size());
+        set_num_threads(4);
+        assert(crc32(0, data.data(), data.size()) == whole && crc32c(0, data.data(), data.size()) == whole_c);
+        set_num_threads(1);
+        assert(crc32(0, data.data(), data.size()) == whole && crc32c(0, data.data(), data.size()) == whole_c);
+        set_num_threads(0);
+
+        size_t split = 1234567;
+        uint32_t first = crc32(0, data.data(), split), second = crc32(0, data.data() + split, data.size() - split);
+        assert(crc32(first, data.data() + split, data.size() - split) == whole);
+        assert(crc32_combine(first, second, data.size() - split) == whole);
+        uint32_t first_c = crc32c(0, data.data(), split);
+        uint32_t second_c = crc32c(0, data.data() + split, data.size() - split);
+        assert(crc32c_combine(first_c, second_c, data.size() - split) == whole_c);
+        assert(crc32_combine(first, 0, 0) == first);
+        static_assert(crc32_combine(0xCBF43926, 0, 0) == 0xCBF43926);
+    }
+
+    // NPY checksums cover the whole file, and match the CRC an archive records for the same array
+    {
+        ndarray<double, 2> arr(700, 500);
+        for (size_t i = 0; i < arr.size(); i++)
+            arr.data()[i] = double(i) * 0.25;
+
+        NPY out("checksum.npy", 'w');
+        out.enable_checksum();
+        out.save(arr);
+        out.close();
+        auto bytes = read_file("checksum.npy");
+        uint32_t crc = out.checksum();
+        assert(crc == crc32(0, bytes.data(), bytes.size()));
+        NPY::save_checksum("checksum.npy", crc);
+        assert(NPY::load_checksum("checksum.npy") == crc);
+
+        NPZ archive("checksum.npz", 'w');
+        archive.save("arr", arr);
+        archive.close();
+        fstream zip("checksum.npz", ios::binary | ios::in);
+        auto members = zip_::directory(zip);
+        assert(members.size() == 1 && members[0].crc == crc);
+
+        NPY in("checksum.npy", 'r');
+        auto loaded = in.load<double>(NPY::load_checksum("checksum.npy"));
+        assert(in.checksum() == crc && loaded(699, 499) == arr(699, 499));
+
+        shared_ptr<char[]> buffer(new char[bytes.size()]);
+        copy(bytes.begin(), bytes.end(), buffer.get());
+        NPY from_buffer(buffer, bytes.size(), 'r');
+        from_buffer.load<double>(crc);
+
+        shared_ptr<char[]> target(new char[bytes.size()]);
+        NPY to_buffer(target, bytes.size(), 'w');
+        to_buffer.enable_checksum();
+        to_buffer.save(arr);
+        assert(to_buffer.checksum() == crc);
+
+        // a flipped bit anywhere is caught
+        buffer[bytes.size() / 2] ^= 4;
+        assert(throws([&]() { NPY(buffer, bytes.size(), 'r').load<double>(crc); }));
+        bytes[100] ^= 1;
+        ofstream("checksum_bad.npy", ios::binary).write(bytes.data(), streamsize(bytes.size()));
+        NPY bad("checksum_bad.npy", 'r');
+        assert(throws([&]() { bad.load<double>(crc); }));
+
+        NPY plain("checksum.npy", 'r');
+        plain.load<double>();
+        assert(plain.checksum() == 0);
+        assert(throws([]() { NPY::load_checksum("missing.npy"); }));
+        ofstream("checksum_bad.npy.crc32") << "xyz\n";
+        assert(throws([]() { NPY::load_checksum("checksum_bad.npy"); }));
+    }
+
+    return 0;
+}
@@ -0,0 +1,106 @@
+#include <cassert>
+#include <filesystem>
+#include <stdexcept>
+#include <vector>
+#include "cnumpy/chunked.hpp"
+#include "cnumpy/ndarray.hpp"
+
+using namespace std;
+using namespace cnumpy;
+
+int main() {
+    ndarray<int, 3> arr(10, 11, 12);
+    for (size_t i = 0; i < arr.size(); i++)
+        arr.data()[i] = int(i);
+
+    // write through a cache that only holds two tiles
+    {
+        chunked_array<int> chunked("chunked", {10, 11, 12}, {4, 4, 5}, 2 * 4 * 4 * 5 * sizeof(int));
+        assert(chunked.ndim() == 3);
+        assert(chunked.size() == arr.size());
+        chunked.write({0, 0, 0}, arr);
+        assert(chunked.misses() == 3 * 3 * 3);
+
+        auto part = chunked.read({1, 2, 3}, {9, 10, 11});
+        assert(part.shape() == (vector<size_t>{8, 8, 8}));
+        for (size_t i = 0; i < 8; i++)
+            for (size_t j = 0; j < 8; j++)
+                for (size_t k = 0; k < 8; k++)
+                    assert(part(i, j, k) == arr(i + 1, j + 2, k + 3));
+    }
+
+    // reopen, read everything back
+    {
+        chunked_array<int> chunked("chunked");
+        assert(chunked.shape() == (vector<size_t>{10, 11, 12}));
+        assert(chunked.chunks() == (vector<size_t>{4, 4, 5}));
+        auto all = chunked.read({0, 0, 0}, {10, 11, 12});
+        for (size_t i = 0; i < arr.size(); i++)
+            assert(all.data()[i] == arr.data()[i]);
+
+        // element access and views
+        assert(chunked.get({9, 10, 11}) == arr(9, 10, 11));
+        chunked.set({9, 10, 11}, -1);
+        auto view = chunked.slice({8, 8, 8}, {10, 11, 12});
+        assert(view.shape() == (vector<size_t>{2, 3, 4}));
+        assert(view(1, 2, 3) == -1);
+        assert(view(0, 0, 0) == arr(8, 8, 8));
+        view.set(-2, 0, 0, 0);
+        auto copy = view.read();
+        assert(copy(0, 0, 0) == -2 && copy(1, 2, 3) == -1 && copy(1, 0, 0) == arr(9, 8, 8));
+
+        // repeated access of a cached tile is a hit
+        size_t hits = chunked.hits();
+        chunked.get({9, 10, 10});
+        assert(chunked.hits() == hits + 1);
+    }
+
+    // changes were written back on destruction
+    {
+        chunked_array<int> chunked("chunked", 0);
+        assert(chunked.get({9, 10, 11}) == -1);
+        assert(chunked.get({8, 8, 8}) == -2);
+    }
+
+    // tiles that were never written read as zeros and are not stored
+    {
+        chunked_array<double> chunked("chunked_sparse", {100, 100}, {10, 10});
+        chunked.set({55, 55}, 1.5);
+        auto part = chunked.read({50, 50}, {60, 60});
+        for (size_t i = 0; i < part.size(); i++)
+            assert(part.data()[i] == (i == 55 ? 1.5 : 0.0));
+        chunked.flush();
+        size_t files = 0;
+        for (const auto &file : filesystem::directory_iterator("chunked_sparse"))
+            files += file.path().filename().string().starts_with("c.");
+        assert(files == 1);
+    }
+
+    // assigning over an array writes its dirty tiles back first
+    {
+        chunked_array<double> first("chunked_first", {4, 4}, {2, 2});
+        first.set({1, 1}, 42);
+        first = chunked_array<double>("chunked_second", {3, 3}, {2, 2});
+        assert(first.shape() == (vector<size_t>{3, 3}) && first.get({1, 1}) == 0);
+        first.set({2, 2}, 7);
+    }
+    {
+        assert(chunked_array<double>("chunked_first").get({1, 1}) == 42);
+        assert(chunked_array<double>("chunked_second").get({2, 2}) == 7);
+    }
+
+    // arrays of another rank are refused
+    {
+        chunked_array<int> chunked("chunked_rank", {8, 5, 6}, {4, 4, 4});
+        ndarray<int, 1> line(3);
+        bool thrown = false;
+        try {
+            chunked.write({0, 0, 0}, line);
+        } catch (const runtime_error &) {
+            thrown = true;
+        }
+        assert(thrown);
+    }
+
+    return 0;
+}
@@ -0,0 +1,157 @@
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include "cnumpy/compressed.hpp"
+#include "cnumpy/ndarray.hpp"
+#include "cnumpy/npy.hpp"
+#include "throws.hpp"
+
+using namespace std;
+using namespace cnumpy;
+
+void lz_roundtrip(const vector<uint8_t> &in) {
+    vector<uint8_t> packed, out(in.size());
+    lz_compress_(in.data(), in.size(), packed);
+    lz_decompress_(packed.data(), packed.size(), out.data(), out.size());
+    assert(out == in);
+}
+
+int main() {
+    // the LZ codec on short inputs, long runs (overlapping matches) and long literals
+    {
+        lz_roundtrip({});
+        lz_roundtrip({7});
+        lz_roundtrip({1, 2, 3, 1, 2, 3, 1, 2});
+        lz_roundtrip(vector<uint8_t>(100000, 42));
+        vector<uint8_t> mixed(70000);
+        uint32_t state = 1;
+        for (size_t i = 0; i < mixed.size(); i++) {
+            state = state * 1664525u + 1013904223u;
+            mixed[i] = i % 1000 < 300 ? uint8_t(state >> 24) : uint8_t(i % 7);
+        }
+        lz_roundtrip(mixed);
+
+        vector<uint8_t> packed, out(mixed.size());
+        lz_compress_(mixed.data(), mixed.size(), packed);
+        assert(throws([&]() { lz_decompress_(packed.data(), packed.size() - 1, out.data(), out.size()); }));
+        assert(throws([&]() { lz_decompress_(packed.data(), packed.size(), out.data(), out.size() - 1); }));
+        packed[0] = 0x0f;
+        assert(throws([&]() { lz_decompress_(packed.data(), packed.size(), out.data(), out.size()); }));
+    }
+
+    ndarray<double, 3> arr(30, 40, 50);
+    for (size_t i = 0; i < arr.size(); i++)
+        arr.data()[i] = sin(double(i) * 1e-3) * 100;
+
+    // both codecs are lossless, including blocks that do not compress
+    for (auto codec: {compressed_codec::shuffle, compressed_codec::delta}) {
+        compressed_array<double> packed(arr, {codec, -1, 4096});
+        assert(packed.shape() == (vector<size_t>{30, 40, 50}) && packed.ndim() == 3 && packed.size() == arr.size());
+        assert(packed.compressed_bytes() < arr.size() * sizeof(double));
+        auto all = packed.to_ndarray();
+        for (size_t i = 0; i < arr.size(); i++)
+            assert(all.data()[i] == arr.data()[i]);
+    }
+    {
+        ndarray<uint32_t, 1> noise(10000);
+        uint32_t state = 7;
+        for (size_t i = 0; i < noise.size(); i++)
+            noise(i) = state = state * 1664525u + 1013904223u;
+        compressed_array<uint32_t> packed(noise, {compressed_codec::shuffle, -1, 1000});
+        assert(packed.compressed_bytes() <= noise.size() * sizeof(uint32_t) + 10);
+        auto all = packed.to_ndarray();
+        for (size_t i = 0; i < noise.size(); i++)
+            assert(all(i) == noise(i));
+    }
+
+    // delta makes ramps nearly free; reduced precision shrinks floating data several-fold
+    {
+        ndarray<int64_t, 1> ramp(1000000);
+        for (size_t i = 0; i < ramp.size(); i++)
+            ramp(i) = int64_t(i) * 3 - 5;
+        compressed_array<int64_t> packed(ramp, {compressed_codec::delta});
+        assert(packed.compressed_bytes() * 100 < ramp.size() * sizeof(int64_t));
+        assert(packed.get({999999}) == 2999992);
+
+        compressed_array<double> lossy(arr, {compressed_codec::shuffle, 8});
+        assert(lossy.compressed_bytes() * 3 < arr.size() * sizeof(double));
+        auto all = lossy.to_ndarray();
+        for (size_t i = 0; i < arr.size(); i++)
+            assert(abs(all.data()[i] - arr.data()[i]) <= abs(arr.data()[i]) * 0x1p-9);
+
+        ndarray<float, 1> special(4);
+        special(0) = numeric_limits<float>::infinity();
+        special(1) = numeric_limits<float>::quiet_NaN();
+        special(2) = 1.0f + 0x1p-10f;          // ties round to even
+        special(3) = 1.0f + 0x1p-10f + 0x1p-11f;
+        auto rounded = compressed_array<float>(special, {compressed_codec::shuffle, 9}).to_ndarray();
+        assert(isinf(rounded(0)) && isnan(rounded(1)) && rounded(2) == 1.0f && rounded(3) == 1.0f + 0x1p-9f);
+
+        assert(throws([]() { compressed_array<int>({10}, {compressed_codec::shuffle, 8}); }));
+        assert(throws([]() { compressed_array<float>({10}, {compressed_codec::shuffle, 24}); }));
+        assert(throws([]() { compressed_array<float>({10}, {compressed_codec::shuffle, -1, 0}); }));
+        assert(throws([]() { compressed_array<float>({}); }));
+    }
+
+    // element and box access through a cache of two blocks, with write-back on eviction
+    {
+        compressed_array<double> packed(vector<size_t>{30, 40, 50}, {compressed_codec::delta, -1, 1000},
+                                        2 * 1000 * sizeof(double));
+        assert(packed.compressed_bytes() == 0 && packed.get({29, 39, 49}) == 0);
+        packed.write({0, 0, 0}, arr);
+        assert(packed.compressed_bytes() > 0);
+
+        auto part = packed.read({1, 2, 3}, {29, 38, 47});
+        assert(part.shape() == (vector<size_t>{28, 36, 44}));
+        for (size_t i = 0; i < 28; i++)
+            for (size_t j = 0; j < 36; j++)
+                for (size_t k = 0; k < 44; k++)
+                    assert(part(i, j, k) == arr(i + 1, j + 2, k + 3));
+
+        packed.set({0, 0, 1}, -1);
+        size_t hits = packed.hits();
+        assert(packed.get({0, 0, 2}) == arr(0, 0, 2) && packed.hits() == hits + 1);
+        packed.set({29, 39, 49}, -2);
+        packed.get({15, 0, 0});
+        assert(packed.get({0, 0, 1}) == -1 && packed.get({29, 39, 49}) == -2);
+        assert(throws([&]() { packed.get({30, 0, 0}); }));
+        assert(throws([&]() { packed.read({0, 0, 0}, {31, 1, 1}); }));
+        ndarray<double, 1> line(3);
+        assert(throws([&]() { packed.write({0, 0, 0}, line); }));
+        assert(throws([&]() { packed.write({0, 0, 49}, line); }));
+
+        // export streams the blocks, including unflushed changes, as a .npy file
+        packed.save("compressed.npy");
+        NPY npy("compressed.npy", 'r');
+        auto loaded = npy.load<double>();
+        npy.close();
+        assert(loaded.shape() == packed.shape());
+        assert(loaded(0, 0, 1) == -1 && loaded(29, 39, 49) == -2 && loaded(3, 4, 5) == arr(3, 4, 5));
+
+        packed.flush();
+        auto all = packed.to_ndarray();
+        for (size_t i = 0; i < all.size(); i++)
+            assert(all.data()[i] == loaded.data()[i]);
+    }
+
+    // import from a .npy file a few blocks at a time
+    {
+        auto packed = compressed_array<double>::load("compressed.npy", {compressed_codec::shuffle, -1, 777});
+        assert(packed.shape() == (vector<size_t>{30, 40, 50}));
+        assert(packed.get({0, 0, 1}) == -1 && packed.get({29, 39, 49}) == -2 && packed.get({7, 8, 9}) == arr(7, 8, 9));
+        assert(throws([]() { compressed_array<float>::load("compressed.npy"); }));
+
+        ndarray<uint8_t, 1> bytes(5);
+        for (size_t i = 0; i < bytes.size(); i++)
+            bytes(i) = uint8_t(i * 50);
+        NPY out("compressed_u1.npy", 'w');
+        out.save(bytes);
+        out.close();
+        auto small = compressed_array<uint8_t>::load("compressed_u1.npy");
+        assert(small.size() == 5 && small.get({4}) == 200);
+    }
+
+    return 0;
+}
@@ -0,0 +1,140 @@
+#include <array>
+#include <cassert>
+#include <utility>
+#include <vector>
+#include "cnumpy/indexing.hpp"
+#include "cnumpy/instrument.hpp"
+#include "cnumpy/manipulation.hpp"
+#include "cnumpy/ndarray.hpp"
+#include "cnumpy/parallel.hpp"
+#include "cnumpy/random.hpp"
+
+using namespace std;
+using namespace cnumpy;
+using instrument::counter;
+
+// built with CNUMPY_COPY_ON_WRITE and CNUMPY_INSTRUMENTATION
+
+double sum(ndarray<double, 1> arr) {
+    double total = 0;
+    for (size_t i = 0; i < arr.size(); i++)
+        total += as_const(arr)(i);
+    return total;
+}
+
+int main() {
+    static_assert(copy_on_write && instrument::enabled);
+
+    ndarray<double, 1> a(1000);
+    for (size_t i = 0; i < a.size(); i++)
+        a(i) = double(i);
+
+    // copies share the buffer until one of them is modified
+    {
+        auto before = instrument::snapshot();
+        ndarray<double, 1> b(a);
+        vector<ndarray<double, 1>> stored(10, a);
+        assert(sum(a) == 999 * 1000 / 2);
+        assert(as_const(b).data() == as_const(a).data() && as_const(stored[9]).data() == as_const(a).data());
+        auto diff = instrument::snapshot() - before;
+        assert(diff[counter::allocations] == 0 && diff[counter::deep_copies] == 0);
+
+        b(0) = -1;
+        assert(as_const(b).data() != as_const(a).data() && as_const(a)(0) == 0 && b(0) == -1 && b(999) == 999);
+        const double *own = as_const(b).data();
+        b(1) = -2;
+        assert(as_const(b).data() == own);
+        stored[3].data()[0] = 7;
+        assert(as_const(a)(0) == 0 && as_const(stored[4])(0) == 0 && stored[3](0) == 7);
+        diff = instrument::snapshot() - before;
+        assert(diff[counter::deep_copies] == 2 && diff[counter::copied_bytes] == 2 * 8000);
+
+        // non-const access counts as a write, even when it only reads
+        stored[5](0);
+        assert(as_const(stored[5]).data() != as_const(a).data());
+    }
+
+    // the last holder writes in place
+    {
+        ndarray<double, 1> b(a);
+        b = ndarray<double, 1>(5);
+        const double *own = as_const(a).data();
+        a(0) = 0;
+        assert(as_const(a).data() == own);
+    }
+
+    // views keep aliasing their base, and copies of viewed buffers are made right away
+    {
+        ndarray<double, 1> shared(a);
+        auto view = a.make_shared(array<size_t, 2>{10, 100});
+        assert(as_const(shared).data() != as_const(a).data());
+        view(0, 0) = 5;
+        a(1) = 6;
+        assert(a(0) == 5 && view(0, 1) == 6 && shared(0) == 0 && shared(1) == 1);
+
+        ndarray<double, 1> copy(a);
+        assert(as_const(copy).data() != as_const(a).data());
+        copy(0) = 9;
+        assert(a(0) == 5 && view(0, 0) == 5);
+
+        auto window = a.make_shared(vector<size_t>{10}, 990);
+        ndarray<double> window_copy(window);
+        window(9) = -3;
+        assert(a(999) == -3 && window_copy(9) == 999);
+    }
+
+    // copies detach independently in parallel
+    {
+        ndarray<double, 1> source(1000);
+        for (size_t i = 0; i < source.size(); i++)
+            source(i) = double(i);
+        vector<ndarray<double, 1>> copies(8, source);
+        parallel_for(0, copies.size(), 1, [&](size_t begin, size_t end) {
+            for (size_t c = begin; c < end; c++)
+                for (size_t i = 0; i < copies[c].size(); i++)
+                    copies[c](i) += double(c);
+        }, 4);
+        for (size_t c = 0; c < copies.size(); c++)
+            assert(copies[c](10) == 10 + double(c));
+        assert(source(10) == 10);
+    }
+
+    // parallel kernels on arrays that share their buffer detach once, before the threads start
+    {
+        set_num_threads(8);
+        ndarray<double, 1> noise(size_t(1) << 17);
+        for (size_t i = 0; i < noise.size(); i++)
+            noise(i) = 0;
+        ndarray<double, 1> kept(noise);
+        random::philox gen(42);
+        random::standard_normal(gen, noise);
+        assert(as_const(kept)(5) == 0 && as_const(noise)(5) != 0);
+        ndarray<double, 1> scaled(noise);
+        random::uniform(gen, scaled, 2.0, 3.0);
+        assert(as_const(scaled)(7) >= 2 && as_const(noise)(7) < 2);
+
+        ndarray<int> grid(vector<size_t>{16, 8, 512});
+        for (size_t i = 0; i < grid.size(); i++)
+            grid.data()[i] = int(i);
+        ndarray<int> snapshot(grid);
+        auto before = instrument::snapshot();
+        auto pieces = split(grid, 4, 1);
+        assert(pieces.size() == 4 && pieces[3].shape() == vector<size_t>({16, 2, 512}));
+        assert(pieces[1](15, 1, 511) == as_const(grid)(15, 3, 511));
+        assert((instrument::snapshot() - before)[counter::deep_copies] == 0);
+
+        ndarray<size_t, 1> rows(2);
+        rows(0) = 1, rows(1) = 6;
+        ndarray<int> values(vector<size_t>{16, 2, 512});
+        for (size_t i = 0; i < values.size(); i++)
+            values.data()[i] = -1;
+        put(grid, rows, values, 1);
+        assert(as_const(grid)(15, 6, 511) == -1 && as_const(snapshot)(15, 6, 511) != -1);
+        ndarray<int> wide(vector<size_t>{2, 8, 4096}), wide_copy(wide);
+        put(wide, rows, ndarray<int>(vector<size_t>{2, 2, 4096}), 1);
+        assert(as_const(wide).data() != as_const(wide_copy).data());
+        set_num_threads(0);
+    }
+
+    return 0;
+}
@@ -0,0 +1,118 @@
+#include <cassert>
+#include <cmath>
+#include <vector>
+#include "cnumpy/einsum.hpp"
+#include "cnumpy/ndarray.hpp"
+
+using namespace std;
+using namespace cnumpy;
+
+template<class T>
+ndarray<T> filled(const vector<size_t> &shape, size_t seed) {
+    ndarray<T> arr(shape);
+    for (size_t i = 0; i < arr.size(); i++)
+        arr.data()[i] = T(int((i * 7919 + seed * 104729) % 17) - 8);
+    return arr;
+}
+
+template<class T>
+bool close(T a, T b) {
+    return abs(a - b) <= 1e-4 * (1 + abs(b));
+}
+
+int main() {
+    // batched matrix product
+    {
+        auto a = filled<double>({3, 4, 5}, 1), b = filled<double>({3, 5, 6}, 2);
+        auto c = einsum("bij,bjk->bik", a, b);
+        assert((c.shape() == vector<size_t>{3, 4, 6}));
+        for (size_t p = 0; p < 3; p++)
+            for (size_t i = 0; i < 4; i++)
+                for (size_t k = 0; k < 6; k++) {
+                    double sum = 0;
+                    for (size_t j = 0; j < 5; j++)
+                        sum += a(p, i, j) * b(p, j, k);
+                    assert(close(c(p, i, k), sum));
+                }
+    }
+
+    // tensor-vector contraction, transposed operand, implicit output
+    {
+        auto a = filled<float>({4, 3, 7}, 3), v = filled<float>({7}, 4);
+        auto c = einsum("ijk,k->ij", a, v);
+        auto t = einsum("kji,i", a, v);
+        assert((c.shape() == vector<size_t>{4, 3}));
+        assert((t.shape() == vector<size_t>{3, 4}));
+        for (size_t i = 0; i < 4; i++)
+            for (size_t j = 0; j < 3; j++) {
+                float sum = 0;
+                for (size_t k = 0; k < 7; k++)
+                    sum += a(i, j, k) * v(k);
+                assert(close(c(i, j), sum));
+                assert(close(t(j, i), sum));
+            }
+        auto d = einsum("ij,ik->jk", filled<float>({5, 3}, 5), filled<float>({5, 2}, 6));
+        auto e = einsum("ji,ik->jk", einsum("ij->ji", filled<float>({5, 3}, 5)), filled<float>({5, 2}, 6));
+        for (size_t i = 0; i < d.size(); i++)
+            assert(d.data()[i] == e.data()[i]);
+    }
+
+    // trace, diagonal, sum, transpose, outer product
+    {
+        auto m = filled<int>({5, 5}, 7);
+        int trace = 0, total = 0;
+        for (size_t i = 0; i < 5; i++) {
+            trace += m(i, i);
+            for (size_t j = 0; j < 5; j++)
+                total += m(i, j);
+        }
+        assert(einsum("ii", m).ndim() == 0);
+        assert(einsum("ii", m).data()[0] == trace);
+        assert(einsum("ij->", m).data()[0] == total);
+        auto diag = einsum("ii->i", m);
+        auto trans = einsum("ij->ji", m);
+        for (size_t i = 0; i < 5; i++) {
+            assert(diag(i) == m(i, i));
+            for (size_t j = 0; j < 5; j++)
+                assert(trans(j, i) == m(i, j));
+        }
+
+        auto x = filled<int>({3}, 8), y = filled<int>({4}, 9);
+        auto outer = einsum("i,j->ij", x, y);
+        for (size_t i = 0; i < 3; i++)
+            for (size_t j = 0; j < 4; j++)
+                assert(outer(i, j) == x(i) * y(j));
+    }
+
+    // chained product over several operands, repeated with the cached plan
+    for (int repeat = 0; repeat < 2; repeat++) {
+        auto a = filled<double>({2, 30}, 10), b = filled<double>({30, 40}, 11), c = filled<double>({40, 3}, 12);
+        auto r = einsum("ij,jk,kl->il", a, b, c);
+        auto s = einsum("ik,kl->il", einsum("ij,jk->ik", a, b), c);
+        assert((r.shape() == vector<size_t>{2, 3}));
+        for (size_t i = 0; i < r.size(); i++)
+            assert(close(r.data()[i], s.data()[i]));
+        auto dot = einsum("i,i,i->", filled<double>({10}, 13), filled<double>({10}, 14), filled<double>({10}, 15));
+        double sum = 0;
+        auto p = filled<double>({10}, 13), q = filled<double>({10}, 14), u = filled<double>({10}, 15);
+        for (size_t i = 0; i < 10; i++)
+            sum += p(i) * q(i) * u(i);
+        assert(close(dot.data()[0], sum));
+    }
+
+    // invalid subscripts
+    auto fails = [](auto &&f) {
+        try {
+            f();
+        } catch (const std::runtime_error &) {
+            return true;
+        }
+        return false;
+    };
+    auto m = filled<double>({2, 3}, 0);
+    assert(fails([&] { einsum("ijk", m); }));
+    assert(fails([&] { einsum("ij,jk", m, m); }));
+    assert(fails([&] { einsum("ij->ik", m); }));
+    assert(fails([&] { einsum("ii", m); }));
+    assert(fails([&] { einsum("...", m); }));
+}
@@ -0,0 +1,190 @@
+#include <cassert>
+#include <cmath>
+#include <complex>
+#include <numbers>
+#include <vector>
+#include "cnumpy/fft.hpp"
+#include "cnumpy/ndarray.hpp"
+#include "cnumpy/npz.hpp"
+#include "cnumpy/parallel.hpp"
+#include "throws.hpp"
+
+using namespace std;
+using namespace cnumpy;
+
+// direct DFT in long double
+template<class T>
+vector<complex<long double>> dft(const complex<T> *x, size_t n, bool inverse) {
+    vector<complex<long double>> out(n), roots(n);
+    long double sign = inverse ? 1 : -1;
+    for (size_t k = 0; k < n; k++)
+        roots[k] = polar(1.0L, sign * 2 * numbers::pi_v<long double> * (long double) k / (long double) n);
+    for (size_t k = 0; k < n; k++) {
+        complex<long double> sum;
+        for (size_t j = 0; j < n; j++)
+            sum += complex<long double>(x[j]) * roots[j * k % n];
+        out[k] = inverse ? sum / (long double) n : sum;
+    }
+    return out;
+}
+
+// largest error relative to the largest magnitude
+template<class T, class U>
+double error(const complex<T> *a, const complex<U> *b, size_t n) {
+    long double err = 0, scale = 1e-30L;
+    for (size_t k = 0; k < n; k++) {
+        err = max(err, abs(complex<long double>(a[k]) - complex<long double>(b[k])));
+        scale = max(scale, abs(complex<long double>(b[k])));
+    }
+    return double(err / scale);
+}
+
+template<class T>
+ndarray<complex<T>> signal(const vector<size_t> &shape) {
+    ndarray<complex<T>> x(shape);
+    for (size_t k = 0; k < x.size(); k++)
+        x.data()[k] = complex<T>(T(sin(0.7 * double(k)) + 0.1 * double(k % 5)), T(cos(1.3 * double(k))));
+    return x;
+}
+
+template<class T>
+void check_lengths(double tolerance) {
+    // radices 2 to 5, generic odd primes, and large primes through Bluestein
+    vector<size_t> lengths;
+    for (size_t n = 1; n <= 70; n++)
+        lengths.push_back(n);
+    for (size_t n: {97, 128, 194, 243, 625, 1000, 1024, 1001, 3072, 127 * 16, 4099})
+        lengths.push_back(n);
+    for (size_t n: lengths) {
+        auto x = signal<T>({n});
+        auto y = fft(x), z = ifft(x);
+        assert(y.shape() == x.shape());
+        assert(error(y.data(), dft(x.data(), n, false).data(), n) < tolerance);
+        assert(error(z.data(), dft(x.data(), n, true).data(), n) < tolerance);
+        auto back = ifft(y);
+        assert(error(back.data(), x.data(), n) < tolerance);
+    }
+}
+
+template<class T>
+void check_real(double tolerance) {
+    for (size_t n: {1, 2, 3, 4, 5, 6, 7, 8, 15, 16, 30, 97, 100, 101, 194, 1024}) {
+        ndarray<T> x(vector<size_t>{n});
+        ndarray<complex<T>> c(vector<size_t>{n});
+        for (size_t k = 0; k < n; k++)
+            c.data()[k] = x.data()[k] = T(sin(0.3 * double(k * k)) + 0.5);
+        auto spectrum = rfft(x), full = fft(c);
+        assert(spectrum.size() == n / 2 + 1);
+        assert(error(spectrum.data(), full.data(), n / 2 + 1) < tolerance);
+
+        auto back = irfft(spectrum, n);
+        assert(back.size() == n);
+        for (size_t k = 0; k < n; k++)
+            assert(abs(back.data()[k] - x.data()[k]) < tolerance * 10);
+    }
+
+    // the imaginary parts of the zero and Nyquist frequencies are ignored, missing frequencies are zeros
+    ndarray<complex<T>> s(vector<size_t>{3});
+    s(0) = complex<T>(4, 9), s(1) = complex<T>(1, 1), s(2) = complex<T>(2, 7);
+    auto even = irfft(s);
+    assert(even.size() == 4);
+    T expected[] = {2, 0, 1, 1};
+    for (size_t k = 0; k < 4; k++)
+        assert(abs(even(k) - expected[k]) < tolerance);
+    auto padded = irfft(s, 8), odd = irfft(s, 3);
+    assert(padded.size() == 8 && odd.size() == 3);
+    assert(abs(padded(0) - T(1.25)) < tolerance && abs(odd(0) - T(2)) < tolerance);
+}
+
+int main() {
+    check_lengths<double>(1e-13);
+    check_lengths<float>(2e-5);
+    check_real<double>(1e-13);
+    check_real<float>(2e-5);
+
+    // every axis of a 3-D array, including strided ones, against transforms of copied lines
+    auto x = signal<double>({6, 35, 20});
+    for (ptrdiff_t axis = -3; axis < 3; axis++) {
+        auto y = fft(x, axis);
+        size_t a = size_t(axis < 0 ? axis + 3 : axis), n = x.shape()[a];
+        size_t stride = a == 2 ? 1 : a == 1 ? 20 : 700;
+        for (size_t line = 0; line < x.size() / n; line++) {
+            size_t offset = line / stride * n * stride + line % stride;
+            vector<complex<double>> in(n), out(n);
+            for (size_t i = 0; i < n; i++) {
+                in[i] = x.data()[offset + i * stride];
+                out[i] = y.data()[offset + i * stride];
+            }
+            assert(error(out.data(), dft(in.data(), n, false).data(), n) < 1e-13);
+        }
+    }
+
+    // N-D transforms equal transforms axis by axis, results don't depend on the number of threads
+    {
+        auto all = fftn(x), some = fftn(x, {0, -1});
+        auto expected = fft(fft(fft(x, 0), 1), 2), expected_some = fft(fft(x, 2), 0);
+        assert(error(all.data(), expected.data(), x.size()) < 1e-13);
+        assert(error(some.data(), expected_some.data(), x.size()) < 1e-13);
+        auto back = ifftn(all);
+        assert(error(back.data(), x.data(), x.size()) < 1e-13);
+        assert(fftn(x, {}).shape() == x.shape());
+
+        auto big = signal<float>({64, 48, 30});
+        set_num_threads(1);
+        auto serial = fftn(big);
+        auto real_serial = rfft(irfft(serial, 58, 1), 1);
+        set_num_threads(4);
+        auto parallel = fftn(big);
+        auto real_parallel = rfft(irfft(parallel, 58, 1), 1);
+        set_num_threads(0);
+        for (size_t k = 0; k < big.size(); k++)
+            assert(serial.data()[k] == parallel.data()[k]);
+        assert(real_serial.shape() == real_parallel.shape() && real_serial.shape()[1] == 30);
+        for (size_t k = 0; k < real_serial.size(); k++)
+            assert(real_serial.data()[k] == real_parallel.data()[k]);
+    }
+
+    // fixed-rank arrays, empty and invalid axes
+    {
+        ndarray<complex<double>, 2> m(4, 6);
+        for (size_t k = 0; k < m.size(); k++)
+            m.data()[k] = double(k);
+        auto spectrum = fft(m, 0);
+        assert(spectrum(0, 1) == complex<double>(1 + 7 + 13 + 19, 0));
+        ndarray<double, 2> r(3, 4);
+        auto half = rfft(r);
+        assert(half.shape()[0] == 3 && half.shape()[1] == 3);
+
+        ndarray<complex<double>> empty(vector<size_t>{0, 5});
+        assert(fft(empty).size() == 0);
+        assert(throws([&]() { return fft(empty, 0); }));
+        assert(throws([&]() { return fft(m, 2); }));
+        assert(throws([&]() { return fftn(m, {-3}); }));
+        ndarray<complex<double>> one(vector<size_t>{1});
+        assert(throws([&]() { return irfft(one); }));
+        assert(irfft(one, 1).size() == 1);
+    }
+
+    // for comparison with numpy.fft
+    {
+        NPZ npz("fft.npz", 'w');
+        npz.save("x", x);
+        npz.save("fft", fft(x));
+        npz.save("ifft_axis0", ifft(x, 0));
+        npz.save("fftn", fftn(x));
+        npz.save("ifftn_axes", ifftn(x, {0, 1}));
+        ndarray<double> real(vector<size_t>{5, 97});
+        for (size_t k = 0; k < real.size(); k++)
+            real.data()[k] = cos(0.01 * double(k * k));
+        npz.save("real", real);
+        npz.save("rfft", rfft(real));
+        npz.save("rfft_axis0", rfft(real, 0));
+        npz.save("irfft", irfft(rfft(real)));
+        npz.save("irfft_odd", irfft(rfft(real), 97));
+        auto xf = signal<float>({1000});
+        npz.save("xf", xf);
+        npz.save("fft_float", fft(xf));
+    }
+
+    return 0;
+}
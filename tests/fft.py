@@ -0,0 +1,17 @@
+import os
+import sys
+import numpy as np
+
+
+with np.load(os.path.join(sys.argv[1], 'fft.npz')) as npz:
+    x, real, xf = npz['x'], npz['real'], npz['xf']
+    assert np.allclose(npz['fft'], np.fft.fft(x), rtol=0, atol=1e-11)
+    assert np.allclose(npz['ifft_axis0'], np.fft.ifft(x, axis=0), rtol=0, atol=1e-13)
+    assert np.allclose(npz['fftn'], np.fft.fftn(x), rtol=0, atol=1e-9)
+    assert np.allclose(npz['ifftn_axes'], np.fft.ifftn(x, axes=(0, 1)), rtol=0, atol=1e-13)
+    assert np.allclose(npz['rfft'], np.fft.rfft(real), rtol=0, atol=1e-11)
+    assert np.allclose(npz['rfft_axis0'], np.fft.rfft(real, axis=0), rtol=0, atol=1e-12)
+    assert np.allclose(npz['irfft'], np.fft.irfft(np.fft.rfft(real)), rtol=0, atol=1e-13)
+    assert np.allclose(npz['irfft_odd'], real, rtol=0, atol=1e-13)
+    assert npz['fft_float'].dtype == np.complex64
+    assert np.allclose(npz['fft_float'], np.fft.fft(xf.astype(np.complex128)), rtol=0, atol=1e-3)
@@ -0,0 +1,120 @@
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <vector>
+#include "cnumpy/histogram.hpp"
+#include "cnumpy/ndarray.hpp"
+#include "cnumpy/parallel.hpp"
+
+using namespace std;
+using namespace cnumpy;
+
+// bin of value by linear search, size() if outside
+size_t reference_bin(const histogram_bins &bins, double value) {
+    const auto &edges = bins.edges();
+    if (!(value >= edges.front() && value <= edges.back()))
+        return bins.size();
+    for (size_t i = 0; i + 1 < edges.size(); i++)
+        if (value < edges[i + 1])
+            return i;
+    return bins.size() - 1;
+}
+
+int main() {
+    mt19937_64 rng(7);
+    ndarray<double, 1> x(300000), y(300000);
+    for (size_t i = 0; i < x.size(); i++) {
+        x(i) = normal_distribution<double>(0, 2)(rng);
+        y(i) = uniform_real_distribution<double>(-1, 1)(rng);
+    }
+    // values exactly on edges, outside, and NaN
+    x(0) = -3, x(1) = 3, x(2) = 0.5, x(3) = numeric_limits<double>::quiet_NaN(), x(4) = 1e300;
+
+    for (size_t nthreads : {1, 4}) {
+        set_num_threads(nthreads);
+
+        for (const auto &bins : {histogram_bins(12, -3, 3), histogram_bins(7, -2.5, 4.25),
+                                 histogram_bins({-3, -1, -0.5, 0, 0.5, 0.75, 2, 3}), histogram_bins({-1, 1})}) {
+            vector<size_t> ref(bins.size() + 1, 0);
+            vector<double> sums(bins.size() + 1, 0);
+            for (size_t i = 0; i < x.size(); i++) {
+                size_t b = reference_bin(bins, x(i));
+                ref[b]++;
+                sums[b] += y(i);
+            }
+            auto counts = histogram(x, bins);
+            auto sum = binned_sum(x, y, bins);
+            auto mean = binned_mean(x, y, bins);
+            for (size_t b = 0; b < bins.size(); b++) {
+                assert(counts(b) == ref[b]);
+                assert(abs(sum(b) - sums[b]) < 1e-8 * (1 + abs(sums[b])));
+                assert(ref[b] == 0 ? isnan(mean(b)) : abs(mean(b) - sums[b] / double(ref[b])) < 1e-10);
+            }
+        }
+
+        // automatic range, like numpy.histogram(a, 4)
+        ndarray<int, 2> small(2, 3);
+        int values[] = {1, 2, 2, 3, 5, 5};
+        copy(values, values + 6, small.data());
+        auto [counts, edges] = histogram(small, 4);
+        assert(counts(0) == 1 && counts(1) == 2 && counts(2) == 1 && counts(3) == 2);
+        assert(edges(0) == 1 && edges(1) == 2 && edges(4) == 5);
+        ndarray<float, 1> constant(3);
+        fill(constant.data(), constant.data() + 3, 2.0f);
+        auto [ccounts, cedges] = histogram(constant, 2);
+        assert(cedges(0) == 1.5 && cedges(2) == 2.5 && ccounts(1) == 3);
+
+        // 2-D
+        histogram_bins xbins(5, -2, 2), ybins({-1, -0.2, 0.3, 1});
+        auto h2 = histogram2d(x, y, xbins, ybins);
+        assert((h2.shape() == array<size_t, 2>{5, 3}));
+        vector<size_t> ref2(15, 0);
+        for (size_t i = 0; i < x.size(); i++) {
+            size_t bx = reference_bin(xbins, x(i)), by = reference_bin(ybins, y(i));
+            if (bx < 5 && by < 3)
+                ref2[bx * 3 + by]++;
+        }
+        for (size_t i = 0; i < 15; i++)
+            assert(h2.data()[i] == ref2[i]);
+
+        // bincount
+        ndarray<uint16_t, 1> ids(100000);
+        ndarray<float, 1> weights(100000);
+        vector<size_t> ref_counts(1000, 0);
+        vector<double> ref_weights(1000, 0);
+        for (size_t i = 0; i < ids.size(); i++) {
+            ids(i) = uint16_t(rng() % 997);
+            weights(i) = float(i % 3);
+            ref_counts[ids(i)]++;
+            ref_weights[ids(i)] += weights(i);
+        }
+        auto bc = bincount(ids, 1000);
+        auto bw = bincount(ids, weights);
+        assert(bc.size() == 1000 && bw.size() == 997);
+        for (size_t i = 0; i < 997; i++)
+            assert(bc(i) == ref_counts[i] && bw(i) == ref_weights[i]);
+        assert(bincount(ndarray<int, 1>(0)).size() == 0);
+    }
+    set_num_threads(0);
+
+    // invalid arguments
+    auto fails = [](auto &&f) {
+        try {
+            f();
+        } catch (const std::runtime_error &) {
+            return true;
+        }
+        return false;
+    };
+    assert(fails([] { histogram_bins(0, 0, 1); }));
+    assert(fails([] { histogram_bins(3, 1, 1); }));
+    assert(fails([] { histogram_bins(vector<double>{0, 1, 1}); }));
+    assert(fails([] { histogram_bins(vector<double>{0}); }));
+    ndarray<int, 1> negative(3);
+    negative(0) = 1, negative(1) = -1, negative(2) = 0;
+    assert(fails([&] { bincount(negative); }));
+    assert(fails([&] { histogram2d(x, negative, histogram_bins(2, 0, 1), histogram_bins(2, 0, 1)); }));
+}
@@ -0,0 +1,147 @@
+#include <cassert>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+#include "cnumpy/indexing.hpp"
+#include "cnumpy/ndarray.hpp"
+#include "cnumpy/parallel.hpp"
+
+using namespace std;
+using namespace cnumpy;
+
+template<class T>
+ndarray<T, 1> array1d(const vector<T> &values) {
+    ndarray<T, 1> arr(values.size());
+    copy(values.begin(), values.end(), arr.data());
+    return arr;
+}
+
+template<class T>
+void check_compress(size_t n) {
+    ndarray<T, 1> arr(n);
+    ndarray<bool, 1> mask(n);
+    for (size_t i = 0; i < n; i++) {
+        arr(i) = T(i);
+        mask(i) = (i * 2654435761u) % 7 < 3;
+    }
+    auto selected = compress(mask, arr);
+    auto index = flatnonzero(mask);
+    assert(selected.size() == index.size());
+    size_t count = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (mask(i)) {
+            assert(selected(count) == T(i));
+            assert(index(count) == i);
+            count++;
+        }
+    }
+    assert(count == selected.size());
+}
+
+int main() {
+    for (size_t nthreads : {1, 3}) {
+        set_num_threads(nthreads);
+
+        // take along every axis, with negative and repeated indices
+        ndarray<int, 3> arr(4, 5, 6);
+        for (size_t i = 0; i < arr.size(); i++)
+            arr.data()[i] = int(i);
+        auto idx = array1d<int>({3, -1, 0, 3});
+        auto t0 = take(arr, idx, 0);
+        auto t1 = take(arr, idx, 1);
+        auto t2 = take(arr, idx, -1);
+        static_assert(is_same<decltype(t0), ndarray<int, 3>>());
+        assert((t0.shape() == array<size_t, 3>{4, 5, 6}));
+        assert((t1.shape() == array<size_t, 3>{4, 4, 6}));
+        assert((t2.shape() == array<size_t, 3>{4, 5, 4}));
+        size_t w0[] = {3, 3, 0, 3}, w2[] = {3, 5, 0, 3};
+        for (size_t i = 0; i < 4; i++)
+            for (size_t j = 0; j < 5; j++)
+                for (size_t k = 0; k < 4; k++) {
+                    assert(t0(k, j, i) == arr(w0[k], j, i));
+                    assert(t2(i, j, k) == arr(i, j, w2[k]));
+                }
+        assert(t1(2, 1, 5) == arr(2, 4, 5));
+
+        // a two-dimensional index array replaces the axis by two axes
+        ndarray<size_t, 2> idx2(2, 2);
+        idx2(0, 0) = 1, idx2(0, 1) = 2, idx2(1, 0) = 4, idx2(1, 1) = 0;
+        auto t3 = take(arr, idx2, 1);
+        assert((t3.shape() == array<size_t, 4>{4, 2, 2, 6}));
+        assert(t3(3, 1, 0, 2) == arr(3, 4, 2));
+        auto flat = take(arr, idx2);
+        assert((flat.shape() == array<size_t, 2>{2, 2}));
+        assert(flat(1, 0) == 4);
+
+        // large gather
+        ndarray<double, 1> big(100000);
+        ndarray<uint32_t, 1> perm(100000);
+        for (size_t i = 0; i < big.size(); i++) {
+            big(i) = double(i);
+            perm(i) = uint32_t((i * 7919) % 100000);
+        }
+        auto gathered = take(big, perm, 0);
+        for (size_t i = 0; i < big.size(); i++)
+            assert(gathered(i) == double(perm(i)));
+
+        // put, flat and along an axis
+        ndarray<int, 2> m(3, 4);
+        fill(m.data(), m.data() + m.size(), 0);
+        put(m, array1d<long>({0, -1, 5, 5}), array1d<int>({7, 8}));
+        assert(m(0, 0) == 7 && m(2, 3) == 8 && m(1, 1) == 8);
+        auto rows = take(arr, array1d<size_t>({1, 2}), 1);
+        for (size_t i = 0; i < rows.size(); i++)
+            rows.data()[i] = -int(i);
+        auto copy = arr;
+        put(copy, array1d<size_t>({2, 1}), rows, 1);
+        auto back = take(copy, array1d<size_t>({2, 1}), 1);
+        for (size_t i = 0; i < back.size(); i++)
+            assert(back.data()[i] == rows.data()[i]);
+        assert(copy(0, 0, 0) == arr(0, 0, 0) && copy(3, 4, 5) == arr(3, 4, 5));
+        // the last of repeated indices wins
+        ndarray<int, 2> dup(2, 3);
+        for (size_t i = 0; i < dup.size(); i++)
+            dup.data()[i] = int(i);
+        auto dm = dup;
+        put(dm, array1d<size_t>({1, 1}), take(dup, array1d<size_t>({0, 2}), 1), 1);
+        assert(dm(0, 1) == 2 && dm(1, 1) == 5);
+
+        // compression and nonzero, around the edges of the SIMD and chunk sizes
+        for (size_t n : {0, 1, 7, 8, 17, 100, 65536, 200003}) {
+            check_compress<int>(n);
+            check_compress<double>(n);
+            check_compress<int16_t>(n);
+        }
+        ndarray<float, 2> sparse(3, 4);
+        fill(sparse.data(), sparse.data() + sparse.size(), 0.0f);
+        sparse(0, 2) = 1, sparse(2, 0) = -1, sparse(2, 3) = 0.5;
+        auto nz = nonzero(sparse);
+        assert(nz.size() == 2 && nz[0].size() == 3);
+        assert(nz[0](0) == 0 && nz[1](0) == 2);
+        assert(nz[0](1) == 2 && nz[1](1) == 0);
+        assert(nz[0](2) == 2 && nz[1](2) == 3);
+        auto columns = compress(array1d<bool>({true, false, false, true}), sparse, 1);
+        assert((columns.shape() == array<size_t, 2>{3, 2}));
+        assert(columns(2, 0) == -1 && columns(2, 1) == 0.5f);
+        auto masked = compress(sparse, sparse);
+        assert(masked.size() == 3 && masked(0) == 1 && masked(2) == 0.5f);
+    }
+    set_num_threads(0);
+
+    // invalid arguments
+    auto fails = [](auto &&f) {
+        try {
+            f();
+        } catch (const std::runtime_error &) {
+            return true;
+        }
+        return false;
+    };
+    ndarray<int, 2> m(2, 3);
+    assert(fails([&] { take(m, array1d<int>({3}), 1); }));
+    assert(fails([&] { take(m, array1d<int>({-3}), 0); }));
+    assert(fails([&] { take(m, array1d<int>({0}), 2); }));
+    assert(fails([&] { put(m, array1d<int>({6}), array1d<int>({1})); }));
+    assert(fails([&] { put(m, array1d<int>({0}), m, 0); }));
+    assert(fails([&] { compress(array1d<bool>({true, true, true}), m, 0); }));
+}
@@ -0,0 +1,111 @@
+#include <array>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "cnumpy/instrument.hpp"
+#include "cnumpy/ndarray.hpp"
+#include "cnumpy/npy.hpp"
+#include "cnumpy/parallel.hpp"
+
+using namespace std;
+using namespace cnumpy;
+using instrument::counter;
+
+// built with and without CNUMPY_INSTRUMENTATION; all counters stay zero without it
+int main() {
+    instrument::reset();
+    uint64_t on = instrument::enabled ? 1 : 0;
+
+    // allocations, deep copies and shares
+    {
+        auto before = instrument::snapshot();
+        ndarray<double, 2> a(10, 10);
+        ndarray<double, 2> b(a);
+        ndarray<double, 2> c(2, 2);
+        c = a;
+        auto view = a.make_shared(array<size_t, 1>{100});
+        auto window = a.make_shared(vector<size_t>{50}, 25);
+        ndarray<double, 2> moved(std::move(b));
+        auto diff = instrument::snapshot() - before;
+        if (copy_on_write) {
+            // b and c share a's buffer until the first make_shared detaches a
+            assert(diff[counter::allocations] == 3 * on);
+            assert(diff[counter::allocated_bytes] == (800 + 32 + 800) * on);
+            assert(diff[counter::deep_copies] == on && diff[counter::copied_bytes] == 800 * on);
+            assert(diff[counter::shares] == 4 * on);
+        } else {
+            assert(diff[counter::allocations] == 4 * on);
+            assert(diff[counter::allocated_bytes] == (800 + 800 + 32 + 800) * on);
+            assert(diff[counter::deep_copies] == 2 * on && diff[counter::copied_bytes] == 1600 * on);
+            assert(diff[counter::shares] == 2 * on);
+        }
+    }
+
+    // NPY loads and saves, with and without byte swapping
+    {
+        ndarray<int32_t, 1> arr(1000);
+        for (size_t i = 0; i < arr.size(); i++)
+            arr(i) = int32_t(i);
+        size_t nbytes = NPY::nbytes(arr);
+        shared_ptr<char[]> buffer(new char[nbytes]);
+
+        auto before = instrument::snapshot();
+        NPY out(buffer, nbytes, 'w');
+        out.save(arr);
+        NPY in(buffer, nbytes, 'r');
+        auto aliased = in.load<int32_t>();
+        auto diff = instrument::snapshot() - before;
+        assert(diff[counter::npy_saves] == on && diff[counter::npy_save_bytes] == 4000 * on);
+        assert(diff[counter::npy_loads] == on && diff[counter::npy_load_bytes] == 4000 * on);
+        assert(diff[counter::shares] == on && diff[counter::allocations] == 0 && diff[counter::byteswaps] == 0);
+
+        size_t header = NPY::header(arr).size();
+        char &order = buffer[string(buffer.get(), header).find("'descr': '") + 10];
+        order = order == '<' ? '>' : '<';
+        before = instrument::snapshot();
+        NPY swapped(buffer, nbytes, 'r');
+        auto copy = swapped.load<int32_t>();
+        diff = instrument::snapshot() - before;
+        assert(diff[counter::allocations] == on && diff[counter::npy_loads] == on);
+        assert(diff[counter::byteswaps] == on && diff[counter::byteswap_bytes] == 4000 * on);
+        assert(diff[counter::byteswap_ns] <= diff[counter::npy_load_ns]);
+    }
+
+    // counters are exact across threads
+    {
+        auto before = instrument::snapshot();
+        parallel_for(0, 1000, 1, [](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++)
+                ndarray<float, 1> arr(4);
+        }, 4);
+        auto diff = instrument::snapshot() - before;
+        assert(diff[counter::allocations] == 1000 * on && diff[counter::allocated_bytes] == 16000 * on);
+    }
+
+    // scoped timers feed counters or callbacks
+    {
+        size_t calls = 0;
+        {
+            instrument::scoped_timer timer([&](chrono::nanoseconds ns) {
+                assert(ns.count() >= 0);
+                calls++;
+            });
+        }
+        assert(calls == on);
+
+        map<string, uint64_t> exported;
+        instrument::snapshot().for_each([&](const char *name, uint64_t value) { exported[name] = value; });
+        assert(exported.size() == size_t(counter::count_));
+        assert(exported["allocations"] == instrument::snapshot()[counter::allocations]);
+        assert(instrument::enabled == (exported["allocations"] > 0));
+
+        instrument::reset();
+        assert(instrument::snapshot()[counter::allocations] == 0);
+    }
+
+    return 0;
+}
@@ -0,0 +1,127 @@
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "cnumpy/ndarray.hpp"
+#include "cnumpy/npy.hpp"
+#include "throws.hpp"
+
+using namespace std;
+using namespace cnumpy;
+
+// Arrays of more than 2^32 elements, backed by address space reserved with mmap (or by sparse files), so only the
+// pages that are touched take memory or disk.
+
+// fails the test when a system call fails, also where assert is compiled out
+void require(bool ok, const char *call) {
+    if (!ok) {
+        perror(call);
+        exit(EXIT_FAILURE);
+    }
+}
+
+template<class T>
+shared_ptr<T[]> reserve(size_t bytes) {
+    void *p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    require(p != MAP_FAILED, "mmap");
+    return shared_ptr<T[]>((T *) p, [bytes](T *q) { munmap(q, bytes); });
+}
+
+int main() {
+    // sizes that do not fit in memory are rejected instead of wrapping around
+    {
+        assert(throws([]() { ndarray<char, 2>(size_t(1) << 32, size_t(1) << 32); }));
+        assert(throws([]() { ndarray<double, 1>(size_t(1) << 61); }));
+        assert(throws([]() { ndarray<int, 2>(-1, 2); }));
+        ndarray<double> empty(vector<size_t>{size_t(1) << 40, size_t(1) << 40, 0});
+        assert(empty.size() == 0);
+        ndarray<char> small(16);
+        assert(throws([&]() { small.reshape(size_t(1) << 32, size_t(1) << 32, 16); }));
+        assert(throws([&]() { small.make_shared(array<size_t, 2>{size_t(1) << 63, 4}); }));
+    }
+
+    // shapes, strides and offsets beyond 2^32 elements
+    {
+        size_t n = 65537, size = n * n;
+        ndarray<uint8_t, 2> arr({n, n}, reserve<uint8_t>(size));
+        assert(arr.size() == size && arr.strides()[0] == n);
+        arr(n - 1, n - 1) = 7;
+        arr(n - 1, 0) = 5;
+        assert(arr.data()[size - 1] == 7 && arr.data()[size - n] == 5);
+        assert((arr[{n - 1, n - 1}]) == 7);
+
+        auto tail = arr.make_shared(array<size_t, 1>{n}, size - n);
+        assert(tail(0) == 5 && tail(n - 1) == 7);
+        auto flat = arr.make_shared(vector<size_t>{size});
+        assert(flat(size - 1) == 7 && flat(size - n) == 5);
+        flat.reshape(n, 1, n);
+        assert(flat.strides()[0] == n && flat(n - 1, 0, n - 1) == 7);
+
+        // strides of 2^31 elements used to overflow an int
+        size_t m = size_t(1) << 30;
+        ndarray<float, 3> floats({3, m, 2}, reserve<float>(3 * m * 2 * sizeof(float)));
+        assert(floats.strides()[0] == size_t(1) << 31 && floats.strides()[1] == 2);
+        floats(2, m - 1, 1) = 1.5f;
+        assert(floats.data()[floats.size() - 1] == 1.5f);
+    }
+
+    // loading from a buffer aliases the data without copying
+    {
+        size_t count = (size_t(1) << 32) + 5;
+        string header = NPY::header(NPY::descr<uint8_t>(), vector<size_t>{count});
+        size_t total = header.size() + count;
+        auto buffer = reserve<char>(total);
+        copy(header.begin(), header.end(), buffer.get());
+        buffer[total - 1] = 9;
+
+        NPY npy(buffer, total, 'r');
+        auto arr = npy.load<uint8_t>();
+        assert(arr.size() == count && arr.shape()[0] == count);
+        assert(arr(count - 1) == 9 && (void *) arr.data() == buffer.get() + header.size());
+    }
+
+    // a sparse .npy file of 8 GiB: inspect, then map the data
+    {
+        size_t rows = (size_t(1) << 31) + 3, bytes = rows * 2 * sizeof(int16_t);
+        string header = NPY::header(NPY::descr<int16_t>(), vector<size_t>{rows, 2});
+        size_t total = header.size() + bytes;
+        int fd = open("large_arrays.npy", O_RDWR | O_CREAT | O_TRUNC, 0644);
+        require(fd >= 0, "open");
+        ssize_t written = pwrite(fd, header.data(), header.size(), 0);
+        require(written == ssize_t(header.size()), "pwrite");
+        require(ftruncate(fd, off_t(total)) == 0, "ftruncate");
+        int16_t last = -3;
+        written = pwrite(fd, &last, sizeof(last), off_t(total - sizeof(last)));
+        require(written == ssize_t(sizeof(last)), "pwrite");
+
+        auto info = NPY::inspect("large_arrays.npy");
+        assert(info.shape == (vector<size_t>{rows, 2}) && info.offset == header.size());
+        void *p = mmap(nullptr, total, PROT_READ, MAP_SHARED, fd, 0);
+        require(p != MAP_FAILED, "mmap");
+        shared_ptr<char[]> file((char *) p, [total](char *q) { munmap(q, total); });
+        ndarray<int16_t, 2> arr(array<size_t, 2>{rows, 2},
+                                shared_ptr<int16_t[]>(file, (int16_t *) (file.get() + info.offset)));
+        assert(arr(rows - 1, 1) == -3 && arr(rows - 1, 0) == 0);
+
+        // a header promising more data than the file holds is rejected before allocating
+        require(ftruncate(fd, off_t(header.size() + 100)) == 0, "ftruncate");
+        close(fd);
+        NPY npy("large_arrays.npy", 'r');
+        assert(throws([&]() { npy.load<int16_t>(); }));
+        npy.close();
+        unlink("large_arrays.npy");
+
+        // as is a shape whose size does not fit in 64 bits
+        assert(throws([]() { NPY::parse_header("{'descr': '<f8', 'fortran_order': False, "
+                                               "'shape': (1099511627776, 1099511627776), }"); }));
+    }
+
+    return 0;
+}
@@ -0,0 +1,133 @@
+#include <cassert>
+#include <cmath>
+#include <vector>
+#include "cnumpy/linalg.hpp"
+#include "cnumpy/ndarray.hpp"
+
+using namespace std;
+using namespace cnumpy;
+
+template<class T>
+void fill(T *data, size_t size, size_t seed) {
+    for (size_t i = 0; i < size; i++)
+        data[i] = T(int((i * 7919 + seed * 104729) % 17) - 8);
+}
+
+template<class T>
+void check_gemm(size_t m, size_t n, size_t k, bool ta, bool tb, size_t nthreads) {
+    vector<T> a(m * k), b(k * n), c(m * n * 2), ref(m * n);
+    fill(a.data(), a.size(), 1);
+    fill(b.data(), b.size(), 2);
+    fill(c.data(), c.size(), 3);
+    // A is stored transposed if ta, B if tb, C with a column stride of 2
+    auto A = [&](size_t i, size_t p) { return ta ? a[p * m + i] : a[i * k + p]; };
+    auto B = [&](size_t p, size_t j) { return tb ? b[j * k + p] : b[p * n + j]; };
+    for (size_t i = 0; i < m; i++)
+        for (size_t j = 0; j < n; j++) {
+            T sum = 0;
+            for (size_t p = 0; p < k; p++)
+                sum += A(i, p) * B(p, j);
+            ref[i * n + j] = T(2) * sum + T(3) * c[(i * n + j) * 2];
+        }
+    gemm<T>(m, n, k, T(2), a.data(), ta ? 1 : ptrdiff_t(k), ta ? ptrdiff_t(m) : 1,
+            b.data(), tb ? 1 : ptrdiff_t(n), tb ? ptrdiff_t(k) : 1, T(3), c.data(), ptrdiff_t(2 * n), 2, nthreads);
+    for (size_t i = 0; i < m * n; i++)
+        assert(abs(c[i * 2] - ref[i]) <= 1e-4 * (1 + abs(ref[i])));
+}
+
+int main() {
+    // block edges of every loop, transposed operands, several threads
+    for (size_t nthreads : {1, 3}) {
+        for (bool ta : {false, true}) {
+            for (bool tb : {false, true}) {
+                check_gemm<double>(130, 37, 300, ta, tb, nthreads);
+                check_gemm<float>(5, 2100, 17, ta, tb, nthreads);
+                check_gemm<int>(33, 9, 260, ta, tb, nthreads);
+            }
+        }
+    }
+    check_gemm<double>(1, 1, 1, false, false, 1);
+    check_gemm<double>(7, 3, 0, false, false, 1);
+
+    // 2-D and batched matmul
+    {
+        ndarray<double, 2> a(3, 4), b(4, 5);
+        fill(a.data(), a.size(), 1);
+        fill(b.data(), b.size(), 2);
+        ndarray<double, 2> c = matmul(a, b);
+        assert(c.shape()[0] == 3 && c.shape()[1] == 5);
+        for (size_t i = 0; i < 3; i++)
+            for (size_t j = 0; j < 5; j++) {
+                double sum = 0;
+                for (size_t p = 0; p < 4; p++)
+                    sum += a(i, p) * b(p, j);
+                assert(c(i, j) == sum);
+            }
+
+        // transposed operands are not copied
+        ndarray<double, 2> at(4, 3), bt(5, 4);
+        for (size_t i = 0; i < 3; i++)
+            for (size_t p = 0; p < 4; p++)
+                at(p, i) = a(i, p);
+        for (size_t p = 0; p < 4; p++)
+            for (size_t j = 0; j < 5; j++)
+                bt(j, p) = b(p, j);
+        auto ct = matmul(at, bt, true, true);
+        for (size_t i = 0; i < c.size(); i++)
+            assert(ct.data()[i] == c.data()[i]);
+    }
+
+    {
+        ndarray<float> a(6, 3, 4), b(6, 4, 2);
+        fill(a.data(), a.size(), 1);
+        fill(b.data(), b.size(), 2);
+        auto c = matmul(a, b);
+        assert(c.shape() == (vector<size_t>{6, 3, 2}));
+        for (size_t s = 0; s < 6; s++)
+            for (size_t i = 0; i < 3; i++)
+                for (size_t j = 0; j < 2; j++) {
+                    float sum = 0;
+                    for (size_t p = 0; p < 4; p++)
+                        sum += a(s, i, p) * b(s, p, j);
+                    assert(c(s, i, j) == sum);
+                }
+
+        bool thrown = false;
+        try {
+            matmul(a, ndarray<float>(5, 4, 2));
+        } catch (const runtime_error &) {
+            thrown = true;
+        }
+        assert(thrown);
+    }
+
+    // dot
+    {
+        ndarray<double, 1> x(4), y(4);
+        fill(x.data(), 4, 1);
+        fill(y.data(), 4, 2);
+        ndarray<double, 0> xy = dot(x, y);
+        assert(xy() == x(0) * y(0) + x(1) * y(1) + x(2) * y(2) + x(3) * y(3));
+
+        ndarray<double, 2> a(3, 4);
+        fill(a.data(), a.size(), 3);
+        ndarray<double, 1> ax = dot(a, x);
+        for (size_t i = 0; i < 3; i++)
+            assert(ax(i) == a(i, 0) * x(0) + a(i, 1) * x(1) + a(i, 2) * x(2) + a(i, 3) * x(3));
+
+        ndarray<double> b(2, 4, 5);
+        fill(b.data(), b.size(), 4);
+        auto ab = dot(a, b);
+        assert(ab.shape() == (vector<size_t>{3, 2, 5}));
+        for (size_t i = 0; i < 3; i++)
+            for (size_t j = 0; j < 2; j++)
+                for (size_t l = 0; l < 5; l++) {
+                    double sum = 0;
+                    for (size_t p = 0; p < 4; p++)
+                        sum += a(i, p) * b(j, p, l);
+                    assert(ab(i, j, l) == sum);
+                }
+    }
+
+    return 0;
+}
@@ -0,0 +1,116 @@
+#include <cassert>
+#include <stdexcept>
+#include <vector>
+#include "cnumpy/manipulation.hpp"
+#include "cnumpy/ndarray.hpp"
+#include "cnumpy/parallel.hpp"
+
+using namespace std;
+using namespace cnumpy;
+
+ndarray<int, 3> iota(size_t n0, size_t n1, size_t n2, int start) {
+    ndarray<int, 3> arr(n0, n1, n2);
+    for (size_t i = 0; i < arr.size(); i++)
+        arr.data()[i] = start + int(i);
+    return arr;
+}
+
+int main() {
+    for (size_t nthreads : {1, 4}) {
+        set_num_threads(nthreads);
+
+        // concatenate along every axis
+        vector<ndarray<int, 3>> parts = {iota(2, 3, 4, 0), iota(2, 3, 4, 100), iota(2, 3, 4, 200)};
+        for (size_t axis = 0; axis < 3; axis++) {
+            auto out = concatenate(parts, ptrdiff_t(axis));
+            auto shape = parts[0].shape();
+            shape[axis] *= 3;
+            assert(out.shape() == shape);
+            for (size_t i = 0; i < shape[0]; i++)
+                for (size_t j = 0; j < shape[1]; j++)
+                    for (size_t k = 0; k < shape[2]; k++) {
+                        array<size_t, 3> idx{i, j, k};
+                        size_t part = idx[axis] / parts[0].shape()[axis];
+                        idx[axis] %= parts[0].shape()[axis];
+                        assert(out(i, j, k) == parts[part][idx]);
+                    }
+        }
+        vector<ndarray<int, 3>> uneven = {iota(2, 1, 4, 0), iota(2, 0, 4, 0), iota(2, 5, 4, 50)};
+        auto joined = concatenate(uneven, -2);
+        assert((joined.shape() == array<size_t, 3>{2, 6, 4}));
+        assert(joined(1, 0, 3) == uneven[0](1, 0, 3) && joined(1, 5, 2) == uneven[2](1, 4, 2));
+
+        // stack along every axis, including the new last one
+        for (ptrdiff_t axis : {0, 1, 2, 3, -1}) {
+            auto out = stack(parts, axis);
+            static_assert(is_same<decltype(out), ndarray<int, 4>>());
+            size_t a = axis < 0 ? 3 : size_t(axis);
+            assert(out.shape()[a] == 3);
+            for (size_t p = 0; p < 3; p++)
+                for (size_t i = 0; i < parts[p].size(); i++) {
+                    size_t rest = i;
+                    array<size_t, 3> idx3{};
+                    for (size_t d = 3; d-- > 0;) {
+                        idx3[d] = rest % parts[p].shape()[d];
+                        rest /= parts[p].shape()[d];
+                    }
+                    array<size_t, 4> idx4{};
+                    for (size_t d = 0, r = 0; d < 4; d++)
+                        idx4[d] = d == a ? p : idx3[r++];
+                    assert(out[idx4] == parts[p].data()[i]);
+                }
+        }
+        ndarray<double> dyn(vector<size_t>{5});
+        auto dyn_stack = stack(vector<ndarray<double>>{dyn, dyn}, 1);
+        assert((dyn_stack.shape() == vector<size_t>{5, 2}));
+
+        // split along the first axis gives views, along the others copies
+        auto arr = iota(6, 4, 2, 0);
+        auto views = split(arr, 3);
+        assert(views.size() == 3);
+        assert(views[1].data() == arr.data() + 2 * 4 * 2);
+        assert((views[2].shape() == array<size_t, 3>{2, 4, 2}));
+        views[1](0, 0, 0) = -1;
+        assert(arr(2, 0, 0) == -1);
+        auto back = concatenate(views);
+        for (size_t i = 0; i < arr.size(); i++)
+            assert(back.data()[i] == arr.data()[i]);
+
+        auto columns = array_split(arr, 3, 1);
+        assert(columns[0].shape()[1] == 2 && columns[1].shape()[1] == 1 && columns[2].shape()[1] == 1);
+        assert(columns[2](5, 0, 1) == arr(5, 3, 1));
+        back = concatenate(columns, 1);
+        for (size_t i = 0; i < arr.size(); i++)
+            assert(back.data()[i] == arr.data()[i]);
+
+        ndarray<int, 3> row = iota(1, 10, 3, 0);
+        auto row_views = split(row, vector<size_t>{3, 8, 20}, 1);
+        assert(row_views.size() == 4);
+        assert(row_views[1].data() == row.data() + 9);
+        assert(row_views[1].shape()[1] == 5 && row_views[2].shape()[1] == 2 && row_views[3].shape()[1] == 0);
+        auto decreasing = split(row, vector<size_t>{5, 2}, 1);
+        assert(decreasing[0].shape()[1] == 5 && decreasing[1].shape()[1] == 0 && decreasing[2].shape()[1] == 8);
+        assert(decreasing[2](0, 0, 0) == row(0, 2, 0));
+    }
+    set_num_threads(0);
+
+    // invalid arguments
+    auto fails = [](auto &&f) {
+        try {
+            f();
+        } catch (const std::runtime_error &) {
+            return true;
+        }
+        return false;
+    };
+    auto arr = iota(6, 4, 2, 0);
+    assert(fails([&] { concatenate(vector<ndarray<int, 3>>{}); }));
+    assert(fails([&] { concatenate(vector<ndarray<int, 3>>{arr, iota(6, 3, 2, 0)}, 0); }));
+    assert(fails([&] { concatenate(vector<ndarray<int>>{ndarray<int>(vector<size_t>{2}),
+                                                         ndarray<int>(vector<size_t>{2, 1})}); }));
+    assert(fails([&] { stack(vector<ndarray<int, 3>>{arr, iota(6, 3, 2, 0)}); }));
+    assert(fails([&] { stack(vector<ndarray<int, 3>>{arr}, 4); }));
+    assert(fails([&] { split(arr, 4); }));
+    assert(fails([&] { array_split(arr, 0); }));
+    assert(fails([&] { split(arr, 2, 3); }));
+}
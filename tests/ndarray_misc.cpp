@@ -84,5 +84,17 @@ int main() {
         }
     }
 
+    // assignment from temporaries and lvalues
+    {
+        ndarray<int> arr1(2, 3);
+        arr1 = ndarray<int>(4, 5);
+        assert(arr1.size() == 20);
+        ndarray<int> arr2(6);
+        arr2 = arr1;
+        assert(arr2.size() == 20 && arr2.data() != arr1.data());
+        arr2 = std::move(arr1);
+        assert(arr2.size() == 20);
+    }
+
     return 0;
 }
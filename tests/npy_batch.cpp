@@ -0,0 +1,83 @@
+#include <cassert>
+#include <string>
+#include "cnumpy/batch.hpp"
+#include "cnumpy/ndarray.hpp"
+#include "cnumpy/npy.hpp"
+#include "throws.hpp"
+
+using namespace std;
+using namespace cnumpy;
+
+int main() {
+    ndarray<int, 3> arr1(10, 11, 12);
+    for (size_t i = 0; i < arr1.size(); i++)
+        arr1.data()[i] = int(i);
+    ndarray<double> arr2(7, 5);
+    for (size_t i = 0; i < arr2.size(); i++)
+        arr2.data()[i] = double(i);
+    ndarray<int, 0> arr3;
+    arr3() = 0;
+    vector<ndarray<float, 1>> many;
+    for (size_t n = 0; n < 20; n++) {
+        many.emplace_back(n * 100);
+        for (size_t i = 0; i < many.back().size(); i++)
+            many.back().data()[i] = float(i);
+    }
+
+    NPYBatch batch(4);
+    batch.add("batch_int", arr1);
+    batch.add("batch_double", arr2, {2, 0});
+    batch.add("batch_zero_dimension", arr3);
+    for (size_t n = 0; n < many.size(); n++)
+        batch.add("batch_float_" + to_string(n), many[n]);
+    assert(batch.size() == 23);
+    assert(throws([&]() { batch.add("batch_int", arr2); }) && throws([&]() { batch.add("", arr2); }));
+    assert(batch.size() == 23);
+
+    // one .npy file per array
+    {
+        auto stats = batch.save("batch");
+        assert(stats.files == 23);
+        assert(stats.bytes > arr1.size() * sizeof(int) + arr2.size() * sizeof(double));
+        assert(stats.throughput() >= 0);
+
+        NPY npy1("batch/batch_int.npy", 'r');
+        auto out1 = npy1.load<int>();
+        npy1.close();
+        assert(out1.shape() == (vector<size_t>{10, 11, 12}));
+        for (size_t i = 0; i < out1.size(); i++)
+            assert(out1.data()[i] == int(i));
+
+        NPY npy2("batch/batch_double.npy", 'r');
+        auto out2 = npy2.load<double>();
+        npy2.close();
+        assert(out2.shape() == (vector<size_t>{7, 5}));
+        for (size_t i = 0; i < out2.size(); i++)
+            assert(out2.data()[i] == double(i));
+
+        for (size_t n = 0; n < many.size(); n++) {
+            NPY npy("batch/batch_float_" + to_string(n) + ".npy", 'r');
+            auto out = npy.load<float>();
+            npy.close();
+            assert(out.size() == n * 100);
+            for (size_t i = 0; i < out.size(); i++)
+                assert(out.data()[i] == float(i));
+        }
+    }
+
+    // single .npz archive, checked by npy_batch.py
+    {
+        auto stats = batch.savez("batch.npz");
+        assert(stats.files == 1);
+        assert(stats.bytes > arr1.size() * sizeof(int) + arr2.size() * sizeof(double));
+    }
+
+    // an empty batch still produces a valid archive
+    {
+        NPYBatch empty;
+        auto stats = empty.savez("batch_empty.npz");
+        assert(stats.bytes == 22);
+    }
+
+    return 0;
+}
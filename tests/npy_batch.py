@@ -0,0 +1,20 @@
+import os
+import sys
+import numpy as np
+
+
+with np.load(os.path.join(sys.argv[1], 'batch.npz')) as npz:
+    assert len(npz.files) == 23
+    assert npz['batch_int'].shape == (10, 11, 12)
+    assert npz['batch_double'].shape == (7, 5)
+    assert npz['batch_zero_dimension'].shape == ()
+    for f in npz.files:
+        out = npz[f]
+        assert np.all(np.arange(out.size) == out.flat)
+
+for f in os.listdir(os.path.join(sys.argv[1], 'batch')):
+    out = np.load(os.path.join(sys.argv[1], 'batch', f))
+    assert np.all(np.arange(out.size) == out.flat)
+
+with np.load(os.path.join(sys.argv[1], 'batch_empty.npz')) as npz:
+    assert len(npz.files) == 0
@@ -0,0 +1,120 @@
+#include <cassert>
+#include <cstring>
+#include <memory>
+#include <string>
+#include "cnumpy/ndarray.hpp"
+#include "cnumpy/npy.hpp"
+
+using namespace std;
+using namespace cnumpy;
+
+int main() {
+    // save into a buffer, load back aliasing the buffer
+    {
+        ndarray<int, 3> arr(10, 11, 12);
+        for (size_t i = 0; i < arr.size(); i++)
+            arr.data()[i] = int(i);
+
+        size_t nbytes = NPY::nbytes(arr);
+        assert(nbytes == 128 + arr.size() * sizeof(int));
+        shared_ptr<char[]> buffer(new char[nbytes]);
+        NPY out(buffer, nbytes, 'w');
+        out.save(arr);
+        out.close();
+
+        NPY in(buffer, nbytes, 'r');
+        auto loaded = in.load<int>();
+        in.close();
+        assert(loaded.shape() == (vector<size_t>{10, 11, 12}));
+        assert((const char *) loaded.data() == buffer.get() + 128);
+        for (size_t i = 0; i < loaded.size(); i++)
+            assert(loaded.data()[i] == int(i));
+
+        // the array keeps the buffer alive
+        weak_ptr<char[]> weak = buffer;
+        buffer.reset();
+        assert(!weak.expired());
+        assert(loaded(9, 10, 11) == int(arr.size() - 1));
+    }
+
+    // the buffer matches the file written by the stream path
+    {
+        ndarray<double> arr(7, 5);
+        for (size_t i = 0; i < arr.size(); i++)
+            arr.data()[i] = double(i);
+        NPY file("buffer_double.npy", 'w');
+        file.save(arr, {2, 0});
+        file.close();
+
+        size_t nbytes = NPY::nbytes(arr, {2, 0});
+        shared_ptr<char[]> buffer(new char[nbytes]);
+        NPY out(buffer, nbytes, 'w');
+        out.save(arr, {2, 0});
+        out.close();
+
+        ifstream ifstrm("buffer_double.npy", ios::binary);
+        string content((istreambuf_iterator<char>(ifstrm)), istreambuf_iterator<char>());
+        assert(content.length() == nbytes);
+        assert(memcmp(content.data(), buffer.get(), nbytes) == 0);
+
+        auto segs = NPY::serialize(arr, {2, 0});
+        assert(segs.header.length() + segs.data.size() == nbytes);
+        assert(segs.data.data() == (const char *) arr.data());
+        assert(memcmp(segs.header.data(), buffer.get(), segs.header.length()) == 0);
+    }
+
+    // several arrays back to back in one buffer, the second one misaligned
+    {
+        ndarray<char, 1> arr1(3);
+        for (size_t i = 0; i < arr1.size(); i++)
+            arr1.data()[i] = char(i);
+        ndarray<double, 2> arr2(4, 4);
+        for (size_t i = 0; i < arr2.size(); i++)
+            arr2.data()[i] = double(i);
+
+        size_t nbytes = NPY::nbytes(arr1) + NPY::nbytes(arr2);
+        shared_ptr<char[]> buffer(new char[nbytes]);
+        NPY out(buffer, nbytes, 'w');
+        out.save(arr1);
+        out.save(arr2);
+        bool thrown = false;
+        try {
+            out.save(arr1);
+        } catch (const runtime_error &) {
+            thrown = true;
+        }
+        assert(thrown);
+        out.close();
+
+        NPY in(buffer, nbytes, 'r');
+        auto loaded1 = in.load<char>();
+        auto loaded2 = in.load<double>();
+        in.close();
+        assert(loaded1.size() == 3 && loaded1(2) == 2);
+        assert(loaded2.shape() == (vector<size_t>{4, 4}));
+        assert((const char *) loaded2.data() < buffer.get() || (const char *) loaded2.data() >= buffer.get() + nbytes);
+        for (size_t i = 0; i < loaded2.size(); i++)
+            assert(loaded2.data()[i] == double(i));
+    }
+
+    // truncated buffers are rejected
+    {
+        ndarray<int> arr(5);
+        size_t nbytes = NPY::nbytes(arr);
+        shared_ptr<char[]> buffer(new char[nbytes]);
+        NPY out(buffer, nbytes, 'w');
+        out.save(arr);
+        out.close();
+
+        NPY in(buffer, nbytes - 1, 'r');
+        bool thrown = false;
+        try {
+            in.load<int>();
+        } catch (const runtime_error &) {
+            thrown = true;
+        }
+        assert(thrown);
+    }
+
+    return 0;
+}
@@ -0,0 +1,91 @@
+#include <cassert>
+#include <cstring>
+#include <memory>
+#include <string>
+#include "cnumpy/ndarray.hpp"
+#include "cnumpy/npy.hpp"
+#include "throws.hpp"
+
+using namespace std;
+using namespace cnumpy;
+
+int main() {
+    // header written by numpy
+    {
+        auto info = NPY::parse_header("{'descr': '<f8', 'fortran_order': False, 'shape': (10, 11, 12), }");
+        assert(info.descr == "<f8");
+        assert(!info.fortran_order);
+        assert(info.shape == (vector<size_t>{10, 11, 12}));
+    }
+
+    // arbitrary key order, quotes and whitespace
+    {
+        auto info = NPY::parse_header("{ \"shape\" :(3,)  ,\n'fortran_order':True,'descr':\"|u1\"}   \n");
+        assert(info.descr == "|u1");
+        assert(info.fortran_order);
+        assert(info.shape == vector<size_t>{3});
+    }
+
+    // scalars, Python 2 long literals and 64-bit dimensions
+    {
+        auto info = NPY::parse_header("{'descr': '<i4', 'fortran_order': False, 'shape': (), }");
+        assert(info.shape.empty());
+        info = NPY::parse_header("{'descr': '<i4', 'fortran_order': False, 'shape': (2L, 3L), }");
+        assert(info.shape == (vector<size_t>{2, 3}));
+        info = NPY::parse_header("{'descr': '<i4', 'fortran_order': False, 'shape': (4294967296, 3), }");
+        assert(info.shape == (vector<size_t>{size_t(1) << 32, 3}));
+        assert(throws([]() {
+            NPY::parse_header("{'descr': '<i4', 'fortran_order': False, 'shape': (99999999999999999999999,), }");
+        }));
+    }
+
+    // structured descr is kept as its literal
+    {
+        auto info = NPY::parse_header(
+                "{'descr': [('x', '<f8'), ('y', '<i4', (2,)), ('z,)]', '|u1')], 'fortran_order': False, "
+                "'shape': (5,), }");
+        assert(info.descr == "[('x', '<f8'), ('y', '<i4', (2,)), ('z,)]', '|u1')]");
+        assert(info.shape == vector<size_t>{5});
+    }
+
+    // malformed headers
+    {
+        assert(throws([]() { NPY::parse_header("{'descr': '<f8', 'shape': (1,), }"); }));
+        assert(throws([]() { NPY::parse_header("{'descr': '<f8', 'fortran_order': Maybe, 'shape': (1,), }"); }));
+        assert(throws([]() { NPY::parse_header("{'descr': '<f8', 'fortran_order': False, 'shape': (1 2), }"); }));
+        assert(throws([]() { NPY::parse_header("{'descr': '<f8, 'fortran_order': False, 'shape': (1,), }"); }));
+        assert(throws([]() { NPY::parse_header("'descr': '<f8', 'fortran_order': False, 'shape': (1,)"); }));
+    }
+
+    // v3.0 round trip
+    {
+        ndarray<short, 2> arr(3, 4);
+        for (size_t i = 0; i < arr.size(); i++)
+            arr.data()[i] = short(i);
+        NPY out("version_3_0_short.npy", 'w');
+        out.save(arr, {3, 0});
+        out.close();
+
+        NPY in("version_3_0_short.npy", 'r');
+        auto loaded = in.load<short>();
+        in.close();
+        assert(loaded.shape() == (vector<size_t>{3, 4}));
+        for (size_t i = 0; i < loaded.size(); i++)
+            assert(loaded.data()[i] == short(i));
+    }
+
+    // a structured array does not load as a plain type
+    {
+        string header = "{'descr': [('x', '<i4')], 'fortran_order': False, 'shape': (1,), }";
+        header.append(63 - ((10 + header.length()) & 63), ' ');
+        header += '\n';
+        string file = string("\x93NUMPY\x01\x00", 8) + char(header.length() & 255) + char(header.length() >> 8) +
+                      header + string(4, '\0');
+        shared_ptr<char[]> buffer(new char[file.length()]);
+        memcpy(buffer.get(), file.data(), file.length());
+        NPY in(buffer, file.length(), 'r');
+        assert(throws([&]() { in.load<int>(); }));
+    }
+
+    return 0;
+}
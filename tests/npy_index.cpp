@@ -0,0 +1,104 @@
+#include <cassert>
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include "cnumpy/ndarray.hpp"
+#include "cnumpy/npy.hpp"
+#include "cnumpy/npy_index.hpp"
+#include "throws.hpp"
+
+using namespace std;
+using namespace cnumpy;
+
+template<class NDArray>
+void save(const string &filename, const NDArray &arr) {
+    NPY npy(filename, 'w');
+    npy.save(arr);
+    npy.close();
+}
+
+int main() {
+    filesystem::remove_all("index");
+    filesystem::create_directories("index/sub");
+    save("index/a.npy", ndarray<int, 2>(3, 4));
+    save("index/b.npy", ndarray<double>(5));
+    save("index/sub/c.npy", ndarray<float, 3>(2, 3, 4));
+    { ofstream("index/garbage.npy") << "not an npy file"; }
+    { ofstream("index/oversized.npy", ios::binary) << string("\x93NUMPY\x02\x00", 8) << string(8192, '\xff'); }
+    { ofstream("index/notes.txt") << "ignored"; }
+
+    // inspect reads the header only
+    {
+        auto info = NPY::inspect("index/a.npy");
+        assert(info.descr.substr(1) == "i4");
+        assert(!info.fortran_order);
+        assert(info.shape == (vector<size_t>{3, 4}));
+        assert(info.offset == 128);
+        assert(filesystem::file_size("index/a.npy") == info.offset + 3 * 4 * sizeof(int));
+    }
+
+    // headers longer than the first read
+    {
+        ndarray<char> arr(vector<size_t>(2000, 1));
+        NPY npy("long_header.npy", 'w');
+        npy.save(arr, {2, 0});
+        npy.close();
+        auto info = NPY::inspect("long_header.npy");
+        assert(info.shape.size() == 2000);
+        assert(info.offset > 4096 && info.offset % 64 == 0);
+    }
+
+    // a header length is not trusted without the magic and version, nor beyond the end of the file
+    {
+        string junk(8192, '\xff');
+        { ofstream("junk.npy", ios::binary) << junk; }
+        assert(throws([]() { NPY::inspect("junk.npy"); }));
+        junk.replace(0, 8, string("\x93NUMPY\x02\x00", 8));
+        { ofstream("junk.npy", ios::binary) << junk; }
+        assert(throws([]() { NPY::inspect("junk.npy"); }));
+    }
+
+    // initial scan, invalid files are skipped
+    NPYIndex index;
+    assert(index.scan("index", true, 2) == 5);
+    assert(index.size() == 3);
+    assert(index.find("index/sub/c.npy")->info.shape == (vector<size_t>{2, 3, 4}));
+    assert(index.find("index/b.npy")->info.descr.substr(1) == "f8");
+    assert(!index.find("index/garbage.npy") && !index.find("index/oversized.npy"));
+
+    // unchanged files are not inspected again
+    assert(index.scan("index") == 2);
+
+    // persist and reload
+    index.save("index.txt");
+    NPYIndex reloaded("index.txt");
+    assert(reloaded.size() == 3);
+    for (const auto &[path, entry] : index.entries()) {
+        auto other = reloaded.find(path);
+        assert(other);
+        assert(other->mtime == entry.mtime && other->size == entry.size);
+        assert(other->info.descr == entry.info.descr);
+        assert(other->info.shape == entry.info.shape);
+        assert(other->info.offset == entry.info.offset);
+    }
+    assert(NPYIndex("missing_index.txt").size() == 0);
+
+    // modified and removed files
+    save("index/a.npy", ndarray<int, 1>(7));
+    filesystem::last_write_time("index/a.npy", filesystem::last_write_time("index/a.npy") + chrono::seconds(10));
+    filesystem::remove("index/sub/c.npy");
+    filesystem::remove("index/garbage.npy");
+    filesystem::remove("index/oversized.npy");
+    assert(reloaded.scan("index") == 1);
+    assert(reloaded.size() == 2);
+    assert(reloaded.find("index/a.npy")->info.shape == vector<size_t>{7});
+    assert(!reloaded.find("index/sub/c.npy"));
+
+    // a non-recursive scan keeps entries of subdirectories
+    save("index/sub/d.npy", ndarray<int>(2));
+    assert(reloaded.scan("index") == 1);
+    assert(reloaded.scan("index", false) == 0);
+    assert(reloaded.find("index/sub/d.npy"));
+
+    return 0;
+}
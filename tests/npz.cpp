@@ -0,0 +1,180 @@
+#include <cassert>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "cnumpy/batch.hpp"
+#include "cnumpy/ndarray.hpp"
+#include "cnumpy/npz.hpp"
+#include "throws.hpp"
+
+using namespace std;
+using namespace cnumpy;
+
+// zip archive written by Python's zipfile with the members
+//   a.npy: (np.arange(2000) % 37).astype('<i4'), deflated with dynamic Huffman codes
+//   s.npy: np.array(b'csr'), deflated with fixed Huffman codes
+//   r.npy: np.random.default_rng(1).integers(0, 256, 40, dtype=np.uint8), deflated as stored blocks
+//   u.npy: np.array('coo'), stored
+const unsigned char deflated[] = {
+        0x50, 0x4b, 0x03, 0x04, 0x14, 0x00, 0x00, 0x00, 0x08, 0x00, 0x71, 0x1f, 0x53, 0x5d, 0x51, 0x83,
+        0xbc, 0x59, 0xd0, 0x00, 0x00, 0x00, 0xc0, 0x1f, 0x00, 0x00, 0x05, 0x00, 0x00, 0x00, 0x61, 0x2e,
+        0x6e, 0x70, 0x79, 0xed, 0xce, 0xbd, 0x4e, 0x02, 0x41, 0x18, 0x85, 0xe1, 0x5d, 0xfe, 0x04, 0x01,
+        0x51, 0x10, 0x05, 0x45, 0x19, 0xd0, 0x64, 0x20, 0xd9, 0x62, 0x63, 0xa8, 0x88, 0xb5, 0x1d, 0x86,
+        0x86, 0x82, 0x8a, 0x6c, 0x64, 0x8c, 0x24, 0x44, 0xc8, 0x2c, 0xa1, 0x21, 0x5e, 0x85, 0x37, 0xec,
+        0x4b, 0xbc, 0x03, 0x0b, 0xab, 0x73, 0x92, 0xa7, 0x98, 0x2f, 0x53, 0xbc, 0xdf, 0xaf, 0xb3, 0xc9,
+        0x74, 0x1e, 0x06, 0xfb, 0xe0, 0x60, 0x97, 0x2e, 0x7d, 0xf3, 0x76, 0x6c, 0xec, 0xf3, 0x6a, 0x64,
+        0x23, 0x63, 0xdf, 0x37, 0x7e, 0xe7, 0x93, 0xcf, 0xc5, 0xc6, 0x2f, 0xdd, 0xf1, 0xfe, 0x92, 0xac,
+        0x53, 0xc7, 0x3d, 0xfd, 0x48, 0xb6, 0x8e, 0xf7, 0xe0, 0x29, 0x8e, 0xe3, 0x68, 0x18, 0x99, 0x2f,
+        0xf3, 0xd7, 0x9d, 0x06, 0x2c, 0x44, 0x06, 0x59, 0xe4, 0x90, 0x47, 0x01, 0x27, 0x28, 0xa2, 0x84,
+        0xe3, 0xc7, 0x32, 0x2a, 0xa8, 0xe2, 0x0c, 0x35, 0x9c, 0xe3, 0x02, 0x75, 0x34, 0x70, 0x89, 0x26,
+        0xae, 0x70, 0x8d, 0x16, 0xda, 0xb8, 0xc1, 0x2d, 0x3a, 0xb8, 0xc3, 0x3d, 0xba, 0x30, 0xe8, 0xa1,
+        0x8f, 0x07, 0x3c, 0x06, 0xbf, 0x53, 0x93, 0x9a, 0xd4, 0xa4, 0x26, 0x35, 0xa9, 0x49, 0x4d, 0x6a,
+        0x52, 0x93, 0x9a, 0xd4, 0xa4, 0x26, 0x35, 0xa9, 0x49, 0x4d, 0x6a, 0x52, 0x93, 0x9a, 0xd4, 0xa4,
+        0x26, 0x35, 0xa9, 0x49, 0x4d, 0x6a, 0x52, 0x93, 0x9a, 0xd4, 0xa4, 0x26, 0x35, 0xa9, 0xe9, 0x3f,
+        0x9b, 0x7e, 0x00, 0x50, 0x4b, 0x03, 0x04, 0x14, 0x00, 0x00, 0x00, 0x08, 0x00, 0x71, 0x1f, 0x53,
+        0x5d, 0xa3, 0xc3, 0x74, 0x97, 0x45, 0x00, 0x00, 0x00, 0x83, 0x00, 0x00, 0x00, 0x05, 0x00, 0x00,
+        0x00, 0x73, 0x2e, 0x6e, 0x70, 0x79, 0x9b, 0xec, 0x17, 0xea, 0x1b, 0x10, 0xc9, 0xc8, 0x50, 0xc6,
+        0x50, 0xad, 0x9e, 0x92, 0x5a, 0x9c, 0x5c, 0xa4, 0x6e, 0xa5, 0xa0, 0x5e, 0x13, 0x6c, 0xac, 0xae,
+        0xa3, 0xa0, 0x9e, 0x96, 0x5f, 0x54, 0x52, 0x94, 0x98, 0x17, 0x9f, 0x5f, 0x94, 0x92, 0x0a, 0x12,
+        0x77, 0x4b, 0xcc, 0x29, 0x4e, 0x05, 0x8a, 0x17, 0x67, 0x24, 0x16, 0xa4, 0x02, 0xf9, 0x1a, 0x9a,
+        0x3a, 0x0a, 0xb5, 0x0a, 0x14, 0x01, 0xae, 0xe4, 0xe2, 0x22, 0x00, 0x50, 0x4b, 0x03, 0x04, 0x14,
+        0x00, 0x00, 0x00, 0x08, 0x00, 0x71, 0x1f, 0x53, 0x5d, 0xb6, 0x35, 0x8a, 0x80, 0xad, 0x00, 0x00,
+        0x00, 0xa8, 0x00, 0x00, 0x00, 0x05, 0x00, 0x00, 0x00, 0x72, 0x2e, 0x6e, 0x70, 0x79, 0x01, 0xa8,
+        0x00, 0x57, 0xff, 0x93, 0x4e, 0x55, 0x4d, 0x50, 0x59, 0x01, 0x00, 0x76, 0x00, 0x7b, 0x27, 0x64,
+        0x65, 0x73, 0x63, 0x72, 0x27, 0x3a, 0x20, 0x27, 0x7c, 0x75, 0x31, 0x27, 0x2c, 0x20, 0x27, 0x66,
+        0x6f, 0x72, 0x74, 0x72, 0x61, 0x6e, 0x5f, 0x6f, 0x72, 0x64, 0x65, 0x72, 0x27, 0x3a, 0x20, 0x46,
+        0x61, 0x6c, 0x73, 0x65, 0x2c, 0x20, 0x27, 0x73, 0x68, 0x61, 0x70, 0x65, 0x27, 0x3a, 0x20, 0x28,
+        0x34, 0x30, 0x2c, 0x29, 0x2c, 0x20, 0x7d, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,
+        0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,
+        0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,
+        0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,
+        0x20, 0x20, 0x0a, 0xff, 0xe4, 0x22, 0x79, 0xf3, 0xbd, 0x06, 0x83, 0x66, 0xa8, 0x52, 0xc1, 0xbb,
+        0x96, 0x51, 0xf3, 0xcd, 0x18, 0xec, 0x08, 0xf6, 0xa4, 0xe7, 0x24, 0xd2, 0x6f, 0xac, 0xd2, 0xae,
+        0xb0, 0xda, 0xf2, 0xa9, 0x72, 0xcd, 0x3f, 0xa0, 0x2f, 0xd4, 0x4f, 0x50, 0x4b, 0x03, 0x04, 0x14,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x71, 0x1f, 0x53, 0x5d, 0x77, 0x6a, 0xc9, 0xff, 0x8c, 0x00, 0x00,
+        0x00, 0x8c, 0x00, 0x00, 0x00, 0x05, 0x00, 0x00, 0x00, 0x75, 0x2e, 0x6e, 0x70, 0x79, 0x93, 0x4e,
+        0x55, 0x4d, 0x50, 0x59, 0x01, 0x00, 0x76, 0x00, 0x7b, 0x27, 0x64, 0x65, 0x73, 0x63, 0x72, 0x27,
+        0x3a, 0x20, 0x27, 0x3c, 0x55, 0x33, 0x27, 0x2c, 0x20, 0x27, 0x66, 0x6f, 0x72, 0x74, 0x72, 0x61,
+        0x6e, 0x5f, 0x6f, 0x72, 0x64, 0x65, 0x72, 0x27, 0x3a, 0x20, 0x46, 0x61, 0x6c, 0x73, 0x65, 0x2c,
+        0x20, 0x27, 0x73, 0x68, 0x61, 0x70, 0x65, 0x27, 0x3a, 0x20, 0x28, 0x29, 0x2c, 0x20, 0x7d, 0x20,
+        0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,
+        0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,
+        0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,
+        0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x0a, 0x63, 0x00,
+        0x00, 0x00, 0x6f, 0x00, 0x00, 0x00, 0x6f, 0x00, 0x00, 0x00, 0x50, 0x4b, 0x01, 0x02, 0x14, 0x03,
+        0x14, 0x00, 0x00, 0x00, 0x08, 0x00, 0x71, 0x1f, 0x53, 0x5d, 0x51, 0x83, 0xbc, 0x59, 0xd0, 0x00,
+        0x00, 0x00, 0xc0, 0x1f, 0x00, 0x00, 0x05, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x80, 0x01, 0x00, 0x00, 0x00, 0x00, 0x61, 0x2e, 0x6e, 0x70, 0x79, 0x50, 0x4b, 0x01,
+        0x02, 0x14, 0x03, 0x14, 0x00, 0x00, 0x00, 0x08, 0x00, 0x71, 0x1f, 0x53, 0x5d, 0xa3, 0xc3, 0x74,
+        0x97, 0x45, 0x00, 0x00, 0x00, 0x83, 0x00, 0x00, 0x00, 0x05, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x80, 0x01, 0xf3, 0x00, 0x00, 0x00, 0x73, 0x2e, 0x6e, 0x70, 0x79,
+        0x50, 0x4b, 0x01, 0x02, 0x14, 0x03, 0x14, 0x00, 0x00, 0x00, 0x08, 0x00, 0x71, 0x1f, 0x53, 0x5d,
+        0xb6, 0x35, 0x8a, 0x80, 0xad, 0x00, 0x00, 0x00, 0xa8, 0x00, 0x00, 0x00, 0x05, 0x00, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x80, 0x01, 0x5b, 0x01, 0x00, 0x00, 0x72, 0x2e,
+        0x6e, 0x70, 0x79, 0x50, 0x4b, 0x01, 0x02, 0x14, 0x03, 0x14, 0x00, 0x00, 0x00, 0x00, 0x00, 0x71,
+        0x1f, 0x53, 0x5d, 0x77, 0x6a, 0xc9, 0xff, 0x8c, 0x00, 0x00, 0x00, 0x8c, 0x00, 0x00, 0x00, 0x05,
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x80, 0x01, 0x2b, 0x02, 0x00,
+        0x00, 0x75, 0x2e, 0x6e, 0x70, 0x79, 0x50, 0x4b, 0x05, 0x06, 0x00, 0x00, 0x00, 0x00, 0x04, 0x00,
+        0x04, 0x00, 0xcc, 0x00, 0x00, 0x00, 0xda, 0x02, 0x00, 0x00, 0x00, 0x00,
+};
+
+int main() {
+    ndarray<int, 3> arr1(4, 5, 6);
+    for (size_t i = 0; i < arr1.size(); i++)
+        arr1.data()[i] = int(i);
+    ndarray<double> arr2(7, 3);
+    for (size_t i = 0; i < arr2.size(); i++)
+        arr2.data()[i] = double(i) / 2;
+    ndarray<long, 0> arr3;
+    arr3() = -42;
+
+    // written stored, checked by npz.py
+    {
+        NPZ npz("npz_saved.npz", 'w');
+        npz.save("ints", arr1);
+        npz.save("doubles", arr2);
+        npz.save("scalar", arr3);
+        npz.save("format", "csr");
+        npz.save("empty", string());
+        assert(throws([&]() { npz.save("ints", arr1); }));
+        assert(throws([&]() { npz.load<int>("ints"); }));
+    }
+    {
+        NPZ npz("npz_saved.npz", 'r');
+        assert(npz.files() == (vector<string>{"ints", "doubles", "scalar", "format", "empty"}));
+        assert(npz.contains("doubles") && !npz.contains("doubles.npy") && !npz.contains("missing"));
+        auto out1 = npz.load<int>("ints");
+        assert(out1.shape() == (vector<size_t>{4, 5, 6}));
+        for (size_t i = 0; i < out1.size(); i++)
+            assert(out1.data()[i] == int(i));
+        auto out2 = npz.load<double>("doubles");
+        assert(out2.shape() == (vector<size_t>{7, 3}));
+        for (size_t i = 0; i < out2.size(); i++)
+            assert(out2.data()[i] == double(i) / 2);
+        auto out3 = npz.load<long>("scalar");
+        assert(out3.ndim() == 0 && out3.data()[0] == -42);
+        assert(npz.inspect("doubles").shape == (vector<size_t>{7, 3}));
+        assert(npz.load_string("format") == "csr");
+        assert(npz.load_string("empty").empty());
+        assert(throws([&]() { npz.load<int>("missing"); }));
+        assert(throws([&]() { npz.load<float>("ints"); }));
+        assert(throws([&]() { npz.load_string("ints"); }));
+        assert(throws([&]() { npz.save("more", arr1); }));
+    }
+
+    // written by zipfile, with deflated members
+    {
+        ofstream("npz_deflated.npz", ios::binary).write((const char *) deflated, sizeof(deflated));
+        NPZ npz("npz_deflated.npz", 'r');
+        assert(npz.files() == (vector<string>{"a", "s", "r", "u"}));
+        auto a = npz.load<int32_t>("a");
+        assert(a.shape() == (vector<size_t>{2000}));
+        for (size_t i = 0; i < a.size(); i++)
+            assert(a.data()[i] == int32_t(i % 37));
+        assert(npz.load_string("s") == "csr");
+        auto r = npz.load<uint8_t>("r");
+        assert(r.size() == 40 && r.data()[0] == 255 && r.data()[1] == 228);
+        size_t sum = 0;
+        for (size_t i = 0; i < r.size(); i++)
+            sum += r.data()[i];
+        assert(sum == 6125);
+        assert(npz.load_string("u") == "coo");
+    }
+
+    // truncated and corrupted archives
+    {
+        ofstream("npz_truncated.npz", ios::binary).write((const char *) deflated, sizeof(deflated) - 30);
+        assert(throws([]() { NPZ npz("npz_truncated.npz", 'r'); }));
+        vector<char> corrupted(deflated, deflated + sizeof(deflated));
+        for (size_t i = 100; i < 140; i++)
+            corrupted[i] = char(0xff);
+        ofstream("npz_corrupted.npz", ios::binary).write(corrupted.data(), streamsize(corrupted.size()));
+        NPZ npz("npz_corrupted.npz", 'r');
+        assert(throws([&]() { npz.load<int32_t>("a"); }));
+        assert(throws([]() { NPZ npz("npz_missing.npz", 'r'); }));
+
+        // the stored member u.npy occupies bytes [590, 730) of the archive
+        corrupted.assign(deflated, deflated + sizeof(deflated));
+        corrupted[700]++;
+        ofstream("npz_corrupted.npz", ios::binary).write(corrupted.data(), streamsize(corrupted.size()));
+        NPZ npz2("npz_corrupted.npz", 'r');
+        assert(npz2.load_string("s") == "csr");
+        assert(throws([&]() { npz2.load_string("u"); }));
+    }
+
+    // archives written by NPYBatch
+    {
+        NPYBatch batch;
+        batch.add("ints", arr1);
+        batch.add("doubles", arr2, {2, 0});
+        batch.savez("npz_batch.npz");
+        NPZ npz("npz_batch.npz", 'r');
+        assert(npz.files().size() == 2);
+        auto out = npz.load<double>("doubles");
+        for (size_t i = 0; i < out.size(); i++)
+            assert(out.data()[i] == arr2.data()[i]);
+    }
+
+    return 0;
+}
@@ -0,0 +1,12 @@
+import os
+import sys
+import numpy as np
+
+
+with np.load(os.path.join(sys.argv[1], 'npz_saved.npz')) as npz:
+    assert npz.files == ['ints', 'doubles', 'scalar', 'format', 'empty']
+    assert np.array_equal(npz['ints'], np.arange(120, dtype=np.int32).reshape(4, 5, 6))
+    assert np.array_equal(npz['doubles'], np.arange(21).reshape(7, 3) / 2)
+    assert npz['scalar'].shape == () and npz['scalar'] == -42
+    assert npz['format'].dtype == np.dtype('S3') and npz['format'].item() == b'csr'
+    assert npz['empty'].item() == b''
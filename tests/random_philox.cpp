@@ -0,0 +1,170 @@
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include "cnumpy/ndarray.hpp"
+#include "cnumpy/npz.hpp"
+#include "cnumpy/parallel.hpp"
+#include "cnumpy/random.hpp"
+#include "throws.hpp"
+
+using namespace std;
+using namespace cnumpy;
+
+template<class T, class Container>
+bool equal(const ndarray_impl<T, Container> &a, const ndarray_impl<T, Container> &b) {
+    if (a.size() != b.size())
+        return false;
+    for (size_t i = 0; i < a.size(); i++)
+        if (a.data()[i] != b.data()[i])
+            return false;
+    return true;
+}
+
+template<class T, class Draw>
+ndarray<T, 1> draws(size_t n, Draw &&draw) {
+    ndarray<T, 1> out(n);
+    for (size_t i = 0; i < n; i++)
+        out(i) = draw();
+    return out;
+}
+
+template<class T>
+pair<double, double> moments(const ndarray<T, 1> &arr) {
+    double mean = 0, var = 0;
+    for (size_t i = 0; i < arr.size(); i++)
+        mean += double(arr(i));
+    mean /= double(arr.size());
+    for (size_t i = 0; i < arr.size(); i++)
+        var += (double(arr(i)) - mean) * (double(arr(i)) - mean);
+    return {mean, var / double(arr.size())};
+}
+
+int main() {
+    // streams compared against numpy by random.py
+    {
+        NPZ npz("random.npz", 'w');
+
+        random::philox raw(1234);
+        npz.save("raw", draws<uint64_t>(10, [&]() { return raw.next_uint64(); }));
+        ndarray<uint64_t, 1> keys(4);
+        keys(0) = random::philox(0).key()[0], keys(1) = random::philox(0).key()[1];
+        keys(2) = random::philox((uint64_t(1) << 40) + 5).key()[0];
+        keys(3) = random::philox((uint64_t(1) << 40) + 5).key()[1];
+        npz.save("keys", keys);
+
+        random::philox gen(42);
+        npz.save("double_before", draws<uint64_t>(3, [&]() { return gen.next_uint64(); }));
+        ndarray<double, 1> doubles(10001);
+        random::random(gen, doubles);
+        npz.save("double", doubles);
+        npz.save("double_after", draws<uint64_t>(2, [&]() { return gen.next_uint64(); }));
+
+        gen = random::philox(43);
+        npz.save("float_before", draws<uint32_t>(1, [&]() { return gen.next_uint32(); }));
+        ndarray<float, 1> floats(1001);
+        random::random(gen, floats);
+        npz.save("float", floats);
+        npz.save("float_after", draws<uint32_t>(3, [&]() { return gen.next_uint32(); }));
+
+        gen = random::philox(44);
+        ndarray<double, 1> normals(5000);
+        random::standard_normal(gen, normals);
+        npz.save("normal", normals);
+        npz.save("normal_after", draws<double>(3, [&]() { return gen.standard_normal(); }));
+        ndarray<double, 1> shifted(100);
+        random::normal(gen, shifted, 2.0, 3.0);
+        npz.save("normal_shifted", shifted);
+        npz.save("normal_raw", draws<uint64_t>(1, [&]() { return gen.next_uint64(); }));
+
+        gen = random::philox(45);
+        ndarray<int64_t, 1> i64(3000);
+        random::integers(gen, i64, int64_t(-5), int64_t(17));
+        npz.save("int64", i64);
+        ndarray<int32_t, 1> i32(2000);
+        random::integers(gen, i32, 0, 1000);
+        npz.save("int32", i32);
+        ndarray<uint8_t, 1> u8(1001);
+        random::integers(gen, u8, uint8_t(0), uint8_t(200));
+        npz.save("uint8", u8);
+        ndarray<int16_t, 1> i16(999);
+        random::integers(gen, i16, int16_t(-300), int16_t(300));
+        npz.save("int16", i16);
+        ndarray<int64_t, 1> wide(500);
+        random::integers(gen, wide, int64_t(0), int64_t(1) << 40);
+        npz.save("int64_wide", wide);
+        npz.save("int64_scalar", draws<int64_t>(5, [&]() { return gen.integers(int64_t(0), int64_t(10)); }));
+
+        random::philox advanced(7);
+        advanced.advance(12345);
+        npz.save("advance", draws<uint64_t>(5, [&]() { return advanced.next_uint64(); }));
+
+        gen = random::philox(46);
+        ndarray<double, 1> large(100003);
+        random::random(gen, large);
+        npz.save("large", large);
+    }
+
+    // fills do not depend on the number of threads
+    {
+        size_t threads = get_num_threads();
+        auto fill = [](size_t nthreads) {
+            set_num_threads(nthreads);
+            random::philox gen(99);
+            ndarray<double, 1> normals(100000), uniforms(100001);
+            ndarray<int32_t, 1> ints(70000);
+            random::standard_normal(gen, normals);
+            random::random(gen, uniforms);
+            random::integers(gen, ints, -1000, 1000);
+            return make_tuple(normals, uniforms, ints, gen.next_uint64());
+        };
+        auto [n1, u1, i1, r1] = fill(1);
+        auto [n4, u4, i4, r4] = fill(4);
+        assert(equal(n1, n4) && equal(u1, u4) && equal(i1, i4) && r1 == r4);
+        set_num_threads(threads);
+
+        auto [mean, var] = moments(n1);
+        assert(abs(mean) < 0.02 && abs(var - 1) < 0.02);
+        tie(mean, var) = moments(u1);
+        assert(abs(mean - 0.5) < 0.01 && abs(var - 1.0 / 12) < 0.01);
+        tie(mean, var) = moments(i1);
+        assert(abs(mean + 0.5) < 10);
+        for (size_t i = 0; i < i1.size(); i++)
+            assert(i1(i) >= -1000 && i1(i) < 1000);
+        for (size_t i = 0; i < u1.size(); i++)
+            assert(u1(i) >= 0 && u1(i) < 1);
+    }
+
+    // blocks of a fill are distinct streams, and the generator moves past all of them
+    {
+        random::philox gen(5);
+        ndarray<double, 1> normals(3 * random::block_);
+        random::standard_normal(gen, normals);
+        assert(normals(0) != normals(random::block_) && normals(1) != normals(random::block_ + 1));
+        assert(gen.counter()[1] == 3);
+
+        ndarray<float, 1> uniforms(7);
+        random::uniform(gen, uniforms, -2.0f, -1.0f);
+        for (size_t i = 0; i < uniforms.size(); i++)
+            assert(uniforms(i) >= -2 && uniforms(i) < -1);
+        ndarray<uint16_t, 1> full(10);
+        random::integers(gen, full, uint16_t(7), uint16_t(8));
+        for (size_t i = 0; i < full.size(); i++)
+            assert(full(i) == 7);
+        assert(throws([&]() { random::integers(gen, full, uint16_t(8), uint16_t(8)); }));
+        assert(throws([&]() { gen.integers(3, 2); }));
+    }
+
+    // explicit keys and counters
+    {
+        random::philox gen({1, 2}, {~uint64_t(0), 0, 0, 0});
+        gen.next_uint64();
+        assert(gen.counter()[0] == 0 && gen.counter()[1] == 1);
+        auto words = random::philox::block({0, 1, 0, 0}, {1, 2});
+        gen = random::philox({1, 2}, {~uint64_t(0), 0, 0, 0});
+        for (size_t w = 0; w < 4; w++)
+            assert(gen.next_uint64() == words[w]);
+    }
+
+    return 0;
+}
@@ -0,0 +1,43 @@
+import os
+import sys
+import numpy as np
+
+
+Philox, Generator = np.random.Philox, np.random.Generator
+
+with np.load(os.path.join(sys.argv[1], 'random.npz')) as npz:
+    assert np.array_equal(npz['raw'], Philox(1234).random_raw(10))
+    assert np.array_equal(npz['keys'][:2], Philox(0).state['state']['key'])
+    assert np.array_equal(npz['keys'][2:], Philox(2 ** 40 + 5).state['state']['key'])
+
+    bg = Philox(42)
+    g = Generator(bg)
+    assert np.array_equal(npz['double_before'], bg.random_raw(3))
+    assert np.array_equal(npz['double'], g.random(10001))
+    assert np.array_equal(npz['double_after'], bg.random_raw(2))
+
+    g = Generator(Philox(43))
+    assert npz['float_before'][0] == g.integers(0, 2 ** 32, dtype=np.uint32)
+    assert np.array_equal(npz['float'], g.random(1001, dtype=np.float32))
+    assert np.array_equal(npz['float_after'], [g.integers(0, 2 ** 32, dtype=np.uint32) for _ in range(3)])
+
+    bg = Philox(44)
+    g = Generator(bg)
+    assert np.array_equal(npz['normal'], g.standard_normal(5000))
+    assert np.array_equal(npz['normal_after'], [g.standard_normal() for _ in range(3)])
+    assert np.array_equal(npz['normal_shifted'], g.normal(2.0, 3.0, 100))
+    assert np.array_equal(npz['normal_raw'], bg.random_raw(1))
+
+    g = Generator(Philox(45))
+    assert np.array_equal(npz['int64'], g.integers(-5, 17, 3000))
+    assert np.array_equal(npz['int32'], g.integers(0, 1000, 2000, dtype=np.int32))
+    assert np.array_equal(npz['uint8'], g.integers(0, 200, 1001, dtype=np.uint8))
+    assert np.array_equal(npz['int16'], g.integers(-300, 300, 999, dtype=np.int16))
+    assert np.array_equal(npz['int64_wide'], g.integers(0, 2 ** 40, 500))
+    assert np.array_equal(npz['int64_scalar'], [g.integers(0, 10) for _ in range(5)])
+
+    bg = Philox(7)
+    bg.advance(12345)
+    assert np.array_equal(npz['advance'], bg.random_raw(5))
+
+    assert np.array_equal(npz['large'], Generator(Philox(46)).random(100003))
@@ -0,0 +1,148 @@
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include "cnumpy/ndarray.hpp"
+#include "cnumpy/parallel.hpp"
+#include "cnumpy/scan.hpp"
+#include "throws.hpp"
+
+using namespace std;
+using namespace cnumpy;
+
+// sequential scan along axis 1 of an array viewed as (outer, length, inner)
+template<class T, class Op>
+vector<T> reference(const T *in, size_t outer, size_t length, size_t inner, Op op) {
+    vector<T> out(outer * length * inner);
+    for (size_t o = 0; o < outer; o++)
+        for (size_t j = 0; j < inner; j++) {
+            T acc = in[o * length * inner + j];
+            out[o * length * inner + j] = acc;
+            for (size_t i = 1; i < length; i++) {
+                size_t k = (o * length + i) * inner + j;
+                out[k] = acc = op(acc, in[k]);
+            }
+        }
+    return out;
+}
+
+template<class T>
+void check_axes(const ndarray<T> &arr, double tolerance) {
+    auto &shape = arr.shape();
+    for (size_t axis = 0; axis < shape.size(); axis++) {
+        size_t outer = 1, inner = 1;
+        for (size_t d = 0; d < axis; d++)
+            outer *= shape[d];
+        for (size_t d = axis + 1; d < shape.size(); d++)
+            inner *= shape[d];
+        auto sums = cumsum(arr, ptrdiff_t(axis));
+        auto maxima = cummax(arr, ptrdiff_t(axis) - ptrdiff_t(shape.size()));
+        auto expected_sums = reference(arr.data(), outer, shape[axis], inner, [](T a, T b) { return T(a + b); });
+        auto expected_maxima = reference(arr.data(), outer, shape[axis], inner, [](T a, T b) { return max(a, b); });
+        assert(sums.shape() == shape && maxima.shape() == shape);
+        for (size_t i = 0; i < arr.size(); i++) {
+            assert(abs(double(sums.data()[i]) - double(expected_sums[i])) <=
+                   tolerance * (1 + abs(double(expected_sums[i]))));
+            assert(maxima.data()[i] == expected_maxima[i]);
+        }
+    }
+}
+
+int main() {
+    // every axis of small arrays, lengths around the width of the in-register prefix
+    for (size_t n: {1, 3, 4, 7, 8, 9, 17}) {
+        ndarray<double> d(vector<size_t>{3, n, 5});
+        ndarray<float> f(vector<size_t>{n, 4});
+        ndarray<int32_t> i(vector<size_t>{2, 3, n});
+        for (size_t k = 0; k < d.size(); k++)
+            d.data()[k] = sin(double(k)) * 10;
+        for (size_t k = 0; k < f.size(); k++)
+            f.data()[k] = float(k % 7) - 3.5f;
+        for (size_t k = 0; k < i.size(); k++)
+            i.data()[k] = int32_t(k * 7919 % 101) - 50;
+        check_axes(d, 1e-13);
+        check_axes(f, 1e-5);
+        check_axes(i, 0);
+    }
+
+    // long lines take the blocked parallel scan, with any number of threads
+    for (size_t nthreads: {1, 3, 8}) {
+        set_num_threads(nthreads);
+        ndarray<int64_t, 1> ramp(1000003);
+        for (size_t k = 0; k < ramp.size(); k++)
+            ramp(k) = int64_t(k % 1000) - 400;
+        auto sums = cumsum(ramp);
+        int64_t acc = 0;
+        for (size_t k = 0; k < ramp.size(); k++)
+            assert(sums(k) == (acc += ramp(k)));
+
+        ndarray<double, 2> series(2, 300000);
+        for (size_t k = 0; k < series.size(); k++)
+            series.data()[k] = 1.0 / double(k % 97 + 1);
+        check_axes(series.make_shared(vector<size_t>{2, 300000}), 1e-12);
+        auto peaks = cummax(series, 1);
+        assert(peaks(1, 299999) == 1);
+
+        ndarray<double> wide(vector<size_t>{50, 3000});
+        for (size_t k = 0; k < wide.size(); k++)
+            wide.data()[k] = double(k % 13);
+        check_axes(wide, 1e-12);
+    }
+    set_num_threads(0);
+
+    // products, NaN in running maxima, unsigned types, empty arrays, bad axes
+    {
+        ndarray<double, 2> a(2, 4);
+        for (size_t k = 0; k < a.size(); k++)
+            a.data()[k] = double(k + 1);
+        auto p = cumprod(a, 1), q = cumprod(a, 0);
+        assert(p(0, 3) == 24 && p(1, 3) == 5 * 6 * 7 * 8 && q(1, 2) == 21);
+
+        ndarray<double, 1> v(5);
+        double nan = numeric_limits<double>::quiet_NaN();
+        v(0) = 1, v(1) = nan, v(2) = 5, v(3) = -1, v(4) = 2;
+        auto m = cummax(v);
+        assert(m(0) == 1 && isnan(m(1)) && isnan(m(4)));
+        v(1) = -numeric_limits<double>::infinity();
+        m = cummax(v);
+        assert(m(1) == 1 && m(3) == 5 && m(4) == 5);
+
+        ndarray<uint8_t, 1> bytes(3);
+        bytes(0) = 200, bytes(1) = 100, bytes(2) = 0;
+        auto wrapped = cumsum(bytes), top = cummax(bytes);
+        assert(wrapped(1) == 44 && wrapped(2) == 44 && top(2) == 200);
+
+        ndarray<float> empty(vector<size_t>{0, 3});
+        assert(cumsum(empty, 0).size() == 0 && cumsum(empty, 1).shape() == empty.shape());
+        assert(throws([&]() { cumsum(a, 2); }));
+        assert(throws([&]() { cummax(a, -3); }));
+    }
+
+    // differences of any order along either axis
+    {
+        ndarray<int32_t, 2> a(3, 5);
+        for (size_t r = 0; r < 3; r++)
+            for (size_t c = 0; c < 5; c++)
+                a(r, c) = int32_t(c * c + 10 * r);
+        auto d1 = diff(a), d2 = diff(a, 2), d3 = diff(a, 3), rows = diff(a, 1, 0), none = diff(a, 0);
+        assert(d1.shape() == (array<size_t, 2>{3, 4}) && d1(2, 3) == 7 && d1(0, 0) == 1);
+        assert(d2.shape() == (array<size_t, 2>{3, 3}) && d2(1, 2) == 2);
+        assert(d3(0, 0) == 0 && d3(2, 1) == 0);
+        assert(rows.shape() == (array<size_t, 2>{2, 5}) && rows(1, 4) == 10);
+        assert(none.shape() == a.shape() && none(2, 4) == a(2, 4));
+        assert(diff(a, 5).shape() == (array<size_t, 2>{3, 0}) && diff(a, 100, 0).shape() == (array<size_t, 2>{0, 5}));
+
+        ndarray<double> x(vector<size_t>{4, 200000});
+        for (size_t k = 0; k < x.size(); k++)
+            x.data()[k] = double(k);
+        auto dx = diff(cumsum(x, 0), 1, 0), dy = diff(x, 1, 1);
+        for (size_t k = 0; k < dx.size(); k++)
+            assert(dx.data()[k] == x.data()[k + 200000]);
+        for (size_t k = 0; k < dy.size(); k++)
+            assert(dy.data()[k] == 1);
+        assert(throws([&]() { diff(x, 1, 2); }));
+    }
+
+    return 0;
+}
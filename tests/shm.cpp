@@ -0,0 +1,106 @@
+#include <cassert>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "cnumpy/ndarray.hpp"
+#include "cnumpy/shm.hpp"
+#include "throws.hpp"
+
+using namespace std;
+using namespace cnumpy;
+
+int main() {
+    string name = "/cnumpy_test_" + to_string(getpid());
+
+    // an attachment recovers type and shape, and aliases the same memory
+    {
+        auto producer = shm_array<double>::create(name, {3, 4});
+        assert(producer.array().shape() == (vector<size_t>{3, 4}) && producer.version() == 0);
+        for (size_t i = 0; i < producer.array().size(); i++)
+            producer.array().data()[i] = double(i);
+        assert(uintptr_t(producer.array().data()) % 64 == 0);
+
+        auto consumer = shm_array<double>::attach(name);
+        assert(consumer.array().shape() == producer.array().shape());
+        assert(consumer.array()(2, 3) == 11);
+        consumer.array()(0, 0) = -1;
+        assert(producer.array()(0, 0) == -1);
+
+        assert(throws([&]() { shm_array<double>::create(name, {1}); }));
+        assert(throws([&]() { shm_array<float>::attach(name); }));
+        assert(throws([&]() { shm_array<int64_t>::attach(name); }));
+
+        auto reader = shm_array<double>::attach(name, false);
+        assert(reader.array()(1, 1) == 5);
+        assert(throws([&]() { reader.write([](ndarray<double> &) {}); }));
+
+        // views and the mapping outlive the name and the shm_array
+        auto view = consumer.array().make_shared(vector<size_t>{12});
+        shm_array<double>::unlink(name);
+        assert(throws([&]() { shm_array<double>::attach(name); }));
+        assert(throws([&]() { shm_array<double>::unlink(name); }));
+        { auto gone = std::move(consumer); }
+        assert(std::as_const(view).data()[11] == 11);
+    }
+
+    // another process attaches and writes under the seqlock
+    {
+        auto segment = shm_array<int32_t>::create(name, {1000});
+        pid_t pid = fork();
+        if (pid == 0) {
+            auto child = shm_array<int32_t>::attach(name);
+            for (int32_t round = 1; round <= 5; round++)
+                child.write([&](ndarray<int32_t> &arr) {
+                    for (size_t i = 0; i < arr.size(); i++)
+                        arr(i) = round * int32_t(i);
+                });
+            _exit(0);
+        }
+        int status = 0;
+        waitpid(pid, &status, 0);
+        assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+        assert(segment.version() == 5);
+        int64_t sum = segment.read([](const ndarray<int32_t> &arr) {
+            int64_t sum = 0;
+            for (size_t i = 0; i < arr.size(); i++)
+                sum += arr(i);
+            return sum;
+        });
+        assert(sum == 5 * 999 * 1000 / 2);
+
+        shm_array<int32_t>::unlink(name);
+    }
+
+    // readers never see a partial write
+    {
+        auto segment = shm_array<uint64_t>::create(name, {4096});
+        auto writer_side = shm_array<uint64_t>::attach(name);
+        shm_array<uint64_t>::unlink(name);
+        std::thread writer([&]() {
+            for (uint64_t round = 1; round <= 2000; round++)
+                writer_side.write([&](ndarray<uint64_t> &arr) {
+                    for (size_t i = 0; i < arr.size(); i++)
+                        arr(i) = round;
+                });
+        });
+        uint64_t last = 0;
+        while (last < 2000) {
+            auto [first, consistent] = segment.read([](const ndarray<uint64_t> &arr) {
+                bool same = true;
+                for (size_t i = 1; i < arr.size(); i++)
+                    same &= arr(i) == arr(0);
+                return pair<uint64_t, bool>(arr(0), same);
+            });
+            assert(consistent && first >= last);
+            last = first;
+        }
+        writer.join();
+        assert(segment.version() == 2000);
+    }
+
+    return 0;
+}
@@ -0,0 +1,157 @@
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+#include "cnumpy/ndarray.hpp"
+#include "cnumpy/parallel.hpp"
+#include "cnumpy/sort.hpp"
+
+using namespace std;
+using namespace cnumpy;
+
+template<class T>
+ndarray<T> random_array(const vector<size_t> &shape, size_t seed) {
+    mt19937_64 rng(seed);
+    ndarray<T> arr(shape);
+    for (size_t i = 0; i < arr.size(); i++) {
+        if constexpr (is_floating_point_v<T>)
+            arr.data()[i] = T(normal_distribution<double>(0, 100)(rng));
+        else
+            arr.data()[i] = T(rng() % 1000) - T(is_signed_v<T> ? 500 : 0);
+    }
+    return arr;
+}
+
+// every line along the axis of sorted is the sorted line of arr
+template<class T>
+void check_sort(const ndarray<T> &arr, ptrdiff_t axis) {
+    auto sorted = sort(arr, axis);
+    auto index = argsort(arr, axis);
+    auto lines = axis_lines_of_(arr.shape(), axis, "check");
+    for (size_t line = 0; line < lines.count; line++) {
+        size_t offset = lines.offset(line);
+        vector<T> ref(lines.length);
+        for (size_t i = 0; i < lines.length; i++)
+            ref[i] = arr.data()[offset + i * lines.stride];
+        vector<T> copy = ref;
+        stable_sort(ref.begin(), ref.end(), sort_less_<T>());
+        for (size_t i = 0; i < lines.length; i++) {
+            T value = sorted.data()[offset + i * lines.stride];
+            assert(value == ref[i] || (value != value && ref[i] != ref[i]));
+            size_t j = index.data()[offset + i * lines.stride];
+            assert(copy[j] == ref[i] || (copy[j] != copy[j] && ref[i] != ref[i]));
+            if (i > 0) {
+                size_t prev = index.data()[offset + (i - 1) * lines.stride];
+                assert(copy[prev] != copy[j] || prev < j);
+            }
+        }
+    }
+}
+
+template<class T>
+void check_type() {
+    // short lines (sorting network), long lines, every axis
+    for (auto shape : {vector<size_t>{1000, 7}, vector<size_t>{100, 32}, vector<size_t>{33, 100},
+                       vector<size_t>{5, 6, 70}, vector<size_t>{3, 600}, vector<size_t>{3, 0}})
+        for (ptrdiff_t axis = -1; axis < ptrdiff_t(shape.size()); axis++)
+            check_sort(random_array<T>(shape, shape[0]), axis);
+    // large 1-D arrays (radix sort)
+    check_sort(random_array<T>({100000}, 1), 0);
+}
+
+int main() {
+    for (size_t nthreads : {1, 4}) {
+        set_num_threads(nthreads);
+        check_type<int>();
+        check_type<int64_t>();
+        check_type<uint16_t>();
+        check_type<uint8_t>();
+        check_type<float>();
+        check_type<double>();
+    }
+    set_num_threads(0);
+
+    // NaN goes last, also in the sorting networks and the radix sort
+    {
+        double nan = numeric_limits<double>::quiet_NaN();
+        for (size_t n : {size_t(10), size_t(200000)}) {
+            auto arr = random_array<double>({n}, 2);
+            arr(3) = nan;
+            arr(n - 2) = -nan;
+            arr(0) = -0.0;
+            check_sort(arr, 0);
+            auto sorted = sort(arr);
+            assert(isnan(sorted(n - 1)) && isnan(sorted(n - 2)) && !isnan(sorted(n - 3)));
+        }
+    }
+
+    // partition
+    {
+        auto arr = random_array<int>({50, 40}, 3);
+        for (ptrdiff_t axis : {0, 1}) {
+            size_t kth = 17;
+            auto part = partition(arr, kth, axis);
+            auto sorted = sort(arr, axis);
+            auto lines = axis_lines_of_(arr.shape(), axis, "check");
+            for (size_t line = 0; line < lines.count; line++) {
+                const int *p = part.data() + lines.offset(line);
+                int pivot = p[kth * lines.stride];
+                assert(pivot == sorted.data()[lines.offset(line) + kth * lines.stride]);
+                for (size_t i = 0; i < lines.length; i++)
+                    assert(i < kth ? p[i * lines.stride] <= pivot : p[i * lines.stride] >= pivot);
+            }
+        }
+    }
+
+    // top_k
+    {
+        ndarray<int> arr(vector<size_t>{2, 6});
+        int values[] = {5, 1, 9, 9, 3, 7, 0, 0, 2, -1, 2, 8};
+        copy(values, values + 12, arr.data());
+        auto [top, index] = top_k(arr, 3);
+        assert((top.shape() == vector<size_t>{2, 3}));
+        assert(top(0, 0) == 9 && top(0, 1) == 9 && top(0, 2) == 7);
+        assert(index(0, 0) == 2 && index(0, 1) == 3 && index(0, 2) == 5);
+        assert(top(1, 0) == 8 && top(1, 1) == 2 && top(1, 2) == 2);
+        assert(index(1, 0) == 5 && index(1, 1) == 2 && index(1, 2) == 4);
+        auto [bottom, bindex] = top_k(arr, 2, 0, false);
+        assert((bottom.shape() == vector<size_t>{2, 6}));
+        assert(bottom(0, 0) == 0 && bindex(0, 0) == 1 && bottom(1, 0) == 5 && bindex(1, 0) == 0);
+    }
+
+    // percentile, same as numpy.percentile
+    {
+        ndarray<int, 2> arr(2, 4);
+        int values[] = {1, 2, 3, 4, 10, 7, 4, 1};
+        copy(values, values + 8, arr.data());
+        auto median = percentile(arr, 50);
+        assert(median.ndim() == 1);
+        assert(median(0) == 2.5 && median(1) == 5.5);
+        auto q25 = percentile(arr, 25);
+        assert(q25(0) == 1.75 && q25(1) == 3.25);
+        auto columns = percentile(arr, 100, 0);
+        assert(columns(0) == 10 && columns(3) == 4);
+        ndarray<double, 1> line(3);
+        line(0) = 1, line(1) = numeric_limits<double>::quiet_NaN(), line(2) = 2;
+        assert(isnan(percentile(line, 10).data()[0]));
+    }
+
+    // invalid arguments
+    auto fails = [](auto &&f) {
+        try {
+            f();
+        } catch (const std::runtime_error &) {
+            return true;
+        }
+        return false;
+    };
+    auto arr = random_array<int>({4, 5}, 4);
+    assert(fails([&] { sort(arr, 2); }));
+    assert(fails([&] { sort(arr, -3); }));
+    assert(fails([&] { partition(arr, 5); }));
+    assert(fails([&] { top_k(arr, 6); }));
+    assert(fails([&] { percentile(arr, 101); }));
+}
@@ -0,0 +1,169 @@
+#include <cassert>
+#include <cstdint>
+#include <random>
+#include <vector>
+#include "cnumpy/ndarray.hpp"
+#include "cnumpy/npy.hpp"
+#include "cnumpy/sparse.hpp"
+#include "throws.hpp"
+
+using namespace std;
+using namespace cnumpy;
+
+template<class T, class Container1, class Container2>
+bool equal(const ndarray_impl<T, Container1> &a, const ndarray_impl<T, Container2> &b) {
+    if (a.size() != b.size())
+        return false;
+    for (size_t i = 0; i < a.size(); i++)
+        if (a.data()[i] != b.data()[i])
+            return false;
+    return true;
+}
+
+// dense matrix with about one nonzero in ten, with a few empty rows
+ndarray<double, 2> random_dense(size_t rows, size_t cols, unsigned seed) {
+    mt19937 gen(seed);
+    uniform_int_distribution<int> value(-5, 5), keep(0, 9);
+    ndarray<double, 2> dense(rows, cols);
+    for (size_t i = 0; i < rows; i++)
+        for (size_t j = 0; j < cols; j++)
+            dense(i, j) = i % 7 != 3 && keep(gen) == 0 ? value(gen) : 0;
+    return dense;
+}
+
+int main() {
+    // conversions
+    {
+        auto dense = random_dense(300, 200, 1);
+        auto csr = sparse_matrix<double>::from_dense(dense);
+        assert(csr.format() == sparse_format::csr && csr.rows() == 300 && csr.cols() == 200);
+        size_t nnz = 0;
+        for (size_t i = 0; i < dense.size(); i++)
+            nnz += dense.data()[i] != 0;
+        assert(csr.nnz() == nnz && csr.indptr().size() == 301 && csr.indptr()(300) == int32_t(nnz));
+        for (size_t i = 0; i < 300; i++)
+            for (auto p = csr.indptr()(i); p < csr.indptr()(i + 1); p++)
+                assert(dense(i, csr.indices()(p)) == csr.data()(p));
+        assert(equal(csr.to_dense(), dense));
+
+        auto coo = sparse_matrix<double>::from_dense(dense, sparse_format::coo);
+        assert(coo.format() == sparse_format::coo && coo.nnz() == nnz);
+        for (size_t k = 0; k < coo.nnz(); k++)
+            assert(dense(coo.row()(k), coo.col()(k)) == coo.data()(k));
+        assert(equal(coo.to_dense(), dense));
+        auto back = coo.to_csr();
+        assert(equal(back.indptr(), csr.indptr()) && equal(back.indices(), csr.indices()));
+        assert(equal(back.data(), csr.data()));
+
+        sparse_matrix<float, int64_t> zero(4, 5);
+        assert(zero.nnz() == 0 && zero.indptr().size() == 5);
+        auto z = zero.to_dense();
+        for (size_t i = 0; i < z.size(); i++)
+            assert(z.data()[i] == 0);
+    }
+
+    // COO with duplicates and unsorted entries: to_csr() sorts the columns and sums the duplicates
+    {
+        ndarray<double, 1> data(6);
+        ndarray<int32_t, 1> row(6), col(6);
+        int32_t r[] = {2, 0, 2, 0, 2, 1}, c[] = {3, 1, 0, 1, 3, 2};
+        for (size_t k = 0; k < 6; k++) {
+            data(k) = double(k + 1);
+            row(k) = r[k];
+            col(k) = c[k];
+        }
+        auto coo = sparse_matrix<double>::coo(3, 4, data, row, col);
+        auto dense = coo.to_dense();
+        assert(dense(0, 1) == 2 + 4 && dense(2, 3) == 1 + 5 && dense(2, 0) == 3 && dense(1, 2) == 6);
+        auto csr = coo.to_csr();
+        assert(csr.nnz() == 4);
+        int32_t indptr[] = {0, 1, 2, 4}, indices[] = {1, 2, 0, 3};
+        double values[] = {6, 6, 3, 6};
+        for (size_t i = 0; i < 4; i++)
+            assert(csr.indptr()(i) == indptr[i] && csr.indices()(i) == indices[i] && csr.data()(i) == values[i]);
+        assert(equal(csr.to_dense(), dense));
+
+        assert(throws([&]() { sparse_matrix<double>::coo(2, 4, data, row, col); }));
+        assert(throws([&]() { sparse_matrix<double>::coo(3, 3, data, row, col); }));
+        assert(throws([&]() { sparse_matrix<double>::coo(3, 4, ndarray<double, 1>(5), row, col); }));
+    }
+
+    // validation of CSR arrays
+    {
+        ndarray<double, 1> data(3);
+        ndarray<int32_t, 1> indices(3), indptr(3);
+        indices(0) = 0, indices(1) = 2, indices(2) = 1;
+        indptr(0) = 0, indptr(1) = 2, indptr(2) = 3;
+        auto m = sparse_matrix<double>::csr(2, 3, data, indices, indptr);
+        assert(m.nnz() == 3);
+        assert(throws([&]() { sparse_matrix<double>::csr(3, 3, data, indices, indptr); }));
+        assert(throws([&]() { sparse_matrix<double>::csr(2, 2, data, indices, indptr); }));
+        indptr(1) = 4;
+        assert(throws([&]() { sparse_matrix<double>::csr(2, 3, data, indices, indptr); }));
+        indptr(1) = 2, indptr(2) = 2;
+        assert(throws([&]() { sparse_matrix<double>::csr(2, 3, data, indices, indptr); }));
+        assert(throws([]() { sparse_matrix<double>::from_dense(ndarray<double, 1>(3)); }));
+        assert(throws([]() { sparse_matrix<double, int8_t>::from_dense(ndarray<double, 2>(2, 300)); }));
+    }
+
+    // products with vectors and matrices, against the dense products
+    for (size_t rows: {0, 1, 57, 3000}) {
+        size_t cols = 410;
+        auto dense = random_dense(rows, cols, unsigned(rows));
+        ndarray<double, 1> x(cols);
+        ndarray<double, 2> b(cols, 5);
+        for (size_t j = 0; j < cols; j++) {
+            x(j) = double(j % 13) - 6;
+            for (size_t k = 0; k < 5; k++)
+                b(j, k) = double((j + 3 * k) % 11) - 5;
+        }
+        ndarray<double, 1> y(rows);
+        ndarray<double, 2> c(rows, 5);
+        for (size_t i = 0; i < rows; i++) {
+            y(i) = 0;
+            for (size_t k = 0; k < 5; k++)
+                c(i, k) = 0;
+            for (size_t j = 0; j < cols; j++) {
+                y(i) += dense(i, j) * x(j);
+                for (size_t k = 0; k < 5; k++)
+                    c(i, k) += dense(i, j) * b(j, k);
+            }
+        }
+        for (auto format: {sparse_format::csr, sparse_format::coo}) {
+            auto m = sparse_matrix<double>::from_dense(dense, format);
+            auto my = dot(m, x);
+            assert(my.shape() == (array<size_t, 1>{rows}) && equal(my, y));
+            auto mc = dot(m, b);
+            assert(mc.shape() == (array<size_t, 2>{rows, 5}) && equal(mc, c));
+            ndarray<double> dynamic(cols);
+            std::copy(x.data(), x.data() + cols, dynamic.data());
+            assert(equal(dot(m, dynamic), y));
+            assert(throws([&]() { dot(m, ndarray<double, 1>(cols + 1)); }));
+            assert(throws([&]() { dot(m, ndarray<double, 3>(cols, 1, 1)); }));
+        }
+    }
+
+    // scipy.sparse.save_npz layout, also read by sparse.py
+    {
+        auto dense = random_dense(40, 30, 7);
+        NPY npy("sparse_dense.npy", 'w');
+        npy.save(dense);
+        npy.close();
+        auto csr = sparse_matrix<double>::from_dense(dense);
+        save_npz("sparse_csr.npz", csr);
+        save_npz("sparse_coo.npz", sparse_matrix<double, int64_t>::from_dense(dense, sparse_format::coo));
+
+        auto csr2 = load_npz<double>("sparse_csr.npz");
+        assert(csr2.format() == sparse_format::csr && csr2.rows() == 40 && csr2.cols() == 30);
+        assert(equal(csr2.to_dense(), dense));
+        auto coo2 = load_npz<double>("sparse_coo.npz");
+        assert(coo2.format() == sparse_format::coo && equal(coo2.to_dense(), dense));
+        auto wide = load_npz<double, int64_t>("sparse_csr.npz");
+        assert(equal(wide.to_dense(), dense));
+        assert(throws([]() { load_npz<float>("sparse_csr.npz"); }));
+        save_npz("sparse_large.npz", sparse_matrix<double>::from_dense(random_dense(50, 200, 8)));
+        assert(throws([]() { load_npz<double, int8_t>("sparse_large.npz"); }));
+    }
+
+    return 0;
+}
@@ -0,0 +1,30 @@
+import os
+import sys
+import numpy as np
+
+
+dense = np.load(os.path.join(sys.argv[1], 'sparse_dense.npy'))
+
+with np.load(os.path.join(sys.argv[1], 'sparse_csr.npz')) as npz:
+    assert sorted(npz.files) == ['data', 'format', 'indices', 'indptr', 'shape']
+    assert npz['format'].item() == b'csr'
+    assert tuple(npz['shape']) == dense.shape
+    out = np.zeros(dense.shape)
+    indptr = npz['indptr']
+    for i in range(dense.shape[0]):
+        out[i, npz['indices'][indptr[i]:indptr[i + 1]]] = npz['data'][indptr[i]:indptr[i + 1]]
+    assert np.array_equal(out, dense)
+
+with np.load(os.path.join(sys.argv[1], 'sparse_coo.npz')) as npz:
+    assert sorted(npz.files) == ['col', 'data', 'format', 'row', 'shape']
+    assert npz['format'].item() == b'coo'
+    out = np.zeros(dense.shape)
+    np.add.at(out, (npz['row'], npz['col']), npz['data'])
+    assert np.array_equal(out, dense)
+
+try:
+    import scipy.sparse
+except ImportError:
+    sys.exit(0)
+for name in ('sparse_csr.npz', 'sparse_coo.npz'):
+    assert np.array_equal(scipy.sparse.load_npz(os.path.join(sys.argv[1], name)).toarray(), dense)
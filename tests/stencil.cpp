@@ -0,0 +1,142 @@
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+#include <vector>
+#include "cnumpy/ndarray.hpp"
+#include "cnumpy/parallel.hpp"
+#include "cnumpy/stencil.hpp"
+
+using namespace std;
+using namespace cnumpy;
+
+// value of arr at an index that may lie outside, following mode
+template<class T, class Container>
+T outside(const ndarray_impl<T, Container> &arr, vector<ptrdiff_t> idx, boundary mode, T cval) {
+    size_t flat = 0;
+    for (size_t d = 0; d < arr.ndim(); d++) {
+        auto n = ptrdiff_t(arr.shape()[d]);
+        ptrdiff_t i = idx[d];
+        if (i < 0 || i >= n) {
+            if (mode == boundary::constant)
+                return cval;
+            if (mode == boundary::wrap) {
+                i = (i % n + n) % n;
+            } else {
+                // reflect one period at a time
+                while (i < 0 || i >= n)
+                    i = i < 0 ? -i - 1 : 2 * n - 1 - i;
+            }
+        }
+        flat += size_t(i) * arr.strides()[d];
+    }
+    return arr.data()[flat];
+}
+
+template<class T, class Container, class Function>
+ndarray_impl<T, Container> reference(const ndarray_impl<T, Container> &arr, const stencil<T> &st, boundary mode,
+                                     T cval, Function fn) {
+    ndarray_impl<T, Container> out(arr.shape());
+    vector<T> values(st.size());
+    for (size_t i = 0; i < arr.size(); i++) {
+        vector<ptrdiff_t> idx(arr.ndim());
+        for (size_t d = arr.ndim(), rest = i; d-- > 0; rest /= arr.shape()[d])
+            idx[d] = ptrdiff_t(rest % arr.shape()[d]);
+        for (size_t k = 0; k < st.size(); k++) {
+            vector<ptrdiff_t> at = idx;
+            for (size_t d = 0; d < arr.ndim(); d++)
+                at[d] += st.offset(k)[d];
+            values[k] = outside(arr, at, mode, cval);
+        }
+        out.data()[i] = fn(values);
+    }
+    return out;
+}
+
+template<class T, class Container>
+void check(const ndarray_impl<T, Container> &arr, const stencil<T> &st) {
+    for (boundary mode : {boundary::constant, boundary::wrap, boundary::reflect}) {
+        auto out = apply_stencil(arr, st, mode, T(1.5));
+        auto ref = reference(arr, st, mode, T(1.5), [&](const vector<T> &values) {
+            T sum = 0;
+            for (size_t k = 0; k < st.size(); k++)
+                sum += st.weights()[k] * values[k];
+            return sum;
+        });
+        for (size_t i = 0; i < arr.size(); i++)
+            assert(abs(out.data()[i] - ref.data()[i]) <= 1e-9 * (1 + abs(ref.data()[i])));
+
+        auto maximum = map_stencil(arr, st, [&](const T *values) {
+            return *max_element(values, values + st.size());
+        }, mode, T(1.5));
+        auto ref_max = reference(arr, st, mode, T(1.5), [](const vector<T> &values) {
+            return *max_element(values.begin(), values.end());
+        });
+        for (size_t i = 0; i < arr.size(); i++)
+            assert(maximum.data()[i] == ref_max.data()[i]);
+    }
+}
+
+int main() {
+    mt19937_64 rng(11);
+    auto random_fill = [&](auto &arr) {
+        for (size_t i = 0; i < arr.size(); i++)
+            arr.data()[i] = uniform_real_distribution<double>(-1, 1)(rng);
+    };
+
+    for (size_t nthreads : {1, 4}) {
+        set_num_threads(nthreads);
+
+        // 7-point Laplacian on 3-D grids, larger than a tile and smaller than the stencil radius
+        stencil<double> laplacian(3);
+        laplacian.add({0, 0, 0}, -6);
+        for (size_t d = 0; d < 3; d++)
+            for (ptrdiff_t s : {-1, 1}) {
+                vector<ptrdiff_t> offset(3, 0);
+                offset[d] = s;
+                laplacian.add(offset);
+            }
+        for (auto shape : {array<size_t, 3>{5, 20, 600}, array<size_t, 3>{3, 1, 2}, array<size_t, 3>{1, 40, 7}}) {
+            ndarray<double, 3> grid(shape);
+            random_fill(grid);
+            check(grid, laplacian);
+        }
+
+        // wide asymmetric stencils in 1-D and 2-D, radius larger than the array
+        stencil<double> wide(1);
+        wide.add({-5}, 0.5).add({3}, 2).add({0}, -1).add({3}, 1);
+        assert(wide.size() == 3 && wide.weights()[1] == 3);
+        ndarray<double, 1> line(4);
+        random_fill(line);
+        check(line, wide);
+        ndarray<double, 1> long_line(2000);
+        random_fill(long_line);
+        check(long_line, wide);
+
+        ndarray<double, 2> kernel(3, 4);
+        random_fill(kernel);
+        kernel(1, 1) = 0;
+        stencil<double> from_weights(kernel);
+        assert(from_weights.size() == 11);
+        assert((from_weights.radius() == vector<size_t>{1, 2}));
+        ndarray<double> image(vector<size_t>{37, 45});
+        random_fill(image);
+        check(image, from_weights);
+    }
+    set_num_threads(0);
+
+    // invalid arguments
+    auto fails = [](auto &&f) {
+        try {
+            f();
+        } catch (const std::runtime_error &) {
+            return true;
+        }
+        return false;
+    };
+    stencil<double> st(2);
+    assert(fails([] { stencil<double>(0); }));
+    assert(fails([&] { st.add({1}); }));
+    assert(fails([&] { apply_stencil(ndarray<double, 3>(2, 2, 2), st); }));
+}
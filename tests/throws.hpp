@@ -0,0 +1,14 @@
+#pragma once
+
+#include <stdexcept>    // runtime_error
+
+// whether f() throws a std::runtime_error
+template<class F>
+bool throws(F f) {
+    try {
+        f();
+    } catch (const std::runtime_error &) {
+        return true;
+    }
+    return false;
+}